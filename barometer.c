@@ -0,0 +1,213 @@
+#include "barometer.h"
+#include <core/log.h>
+
+#define BARO_I2C_BUS &furi_hal_i2c_handle_external
+#define BARO_TIMEOUT furi_ms_to_ticks(100)
+
+//BMP280 / BME280
+#define BMP280_ADDRESS_PRIMARY (0x76 << 1)
+#define BMP280_ADDRESS_SECONDARY (0x77 << 1)
+#define BMP280_REG_CHIP_ID 0xD0
+#define BMP280_REG_CALIB 0x88
+#define BMP280_REG_STATUS 0xF3
+#define BMP280_REG_CTRL_MEAS 0xF4
+#define BMP280_REG_PRESS_MSB 0xF7
+#define BMP280_CHIP_ID 0x58
+#define BME280_CHIP_ID 0x60
+#define BMP280_STATUS_MEASURING 0x08
+// osrs_t = x1, osrs_p = x4, mode = forced. Max conversion time is 13.3 ms
+#define BMP280_CTRL_MEAS_FORCED 0x2D
+
+//LPS22HB / LPS22HH
+#define LPS22_ADDRESS_PRIMARY (0x5C << 1)
+#define LPS22_ADDRESS_SECONDARY (0x5D << 1)
+#define LPS22_REG_WHO_AM_I 0x0F
+#define LPS22_REG_CTRL_REG2 0x11
+#define LPS22_REG_PRESS_OUT_XL 0x28
+#define LPS22HB_WHO_AM_I 0xB1
+#define LPS22HH_WHO_AM_I 0xB3
+#define LPS22_CTRL_REG2_ONE_SHOT 0x11 // IF_ADD_INC | ONE_SHOT
+
+#define BARO_CONVERSION_POLLS 10
+
+static bool barometer_read_regs(Barometer* baro, uint8_t reg, uint8_t* data, uint8_t len) {
+    furi_hal_i2c_acquire(BARO_I2C_BUS);
+    bool success =
+        furi_hal_i2c_read_mem(BARO_I2C_BUS, baro->address, reg, data, len, BARO_TIMEOUT);
+    furi_hal_i2c_release(BARO_I2C_BUS);
+    return success;
+}
+
+static bool barometer_write_reg(Barometer* baro, uint8_t reg, uint8_t value) {
+    furi_hal_i2c_acquire(BARO_I2C_BUS);
+    bool success =
+        furi_hal_i2c_write_reg_8(BARO_I2C_BUS, baro->address, reg, value, BARO_TIMEOUT);
+    furi_hal_i2c_release(BARO_I2C_BUS);
+    return success;
+}
+
+static bool barometer_probe_id(Barometer* baro, uint8_t address, uint8_t reg, uint8_t* id) {
+    furi_hal_i2c_acquire(BARO_I2C_BUS);
+    bool success = furi_hal_i2c_is_device_ready(BARO_I2C_BUS, address, BARO_TIMEOUT) &&
+                   furi_hal_i2c_read_reg_8(BARO_I2C_BUS, address, reg, id, BARO_TIMEOUT);
+    furi_hal_i2c_release(BARO_I2C_BUS);
+    if(success) baro->address = address;
+    return success;
+}
+
+static bool barometer_bmp280_read_calib(Barometer* baro) {
+    uint8_t data[24];
+    if(!barometer_read_regs(baro, BMP280_REG_CALIB, data, sizeof(data))) return false;
+
+    // Calibration words are little-endian
+    uint16_t words[12];
+    for(uint8_t i = 0; i < 12; i++) {
+        words[i] = (uint16_t)data[i * 2] | ((uint16_t)data[i * 2 + 1] << 8);
+    }
+
+    barometer_bmp280_calib_t* calib = &baro->calib;
+    calib->dig_T1 = words[0];
+    calib->dig_T2 = (int16_t)words[1];
+    calib->dig_T3 = (int16_t)words[2];
+    calib->dig_P1 = words[3];
+    calib->dig_P2 = (int16_t)words[4];
+    calib->dig_P3 = (int16_t)words[5];
+    calib->dig_P4 = (int16_t)words[6];
+    calib->dig_P5 = (int16_t)words[7];
+    calib->dig_P6 = (int16_t)words[8];
+    calib->dig_P7 = (int16_t)words[9];
+    calib->dig_P8 = (int16_t)words[10];
+    calib->dig_P9 = (int16_t)words[11];
+
+    // dig_P1 is used as a divisor, a zero value means the calibration data is garbage
+    return calib->dig_P1 != 0;
+}
+
+//32-bit integer compensation, see BMP280 datasheet 8.2. Returns the pressure in Pa
+static uint32_t
+    barometer_bmp280_compensate(const barometer_bmp280_calib_t* c, int32_t adc_T, int32_t adc_P) {
+    int32_t var1, var2;
+
+    var1 = ((((adc_T >> 3) - ((int32_t)c->dig_T1 << 1))) * ((int32_t)c->dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)c->dig_T1)) * ((adc_T >> 4) - ((int32_t)c->dig_T1))) >>
+             12) *
+            ((int32_t)c->dig_T3)) >>
+           14;
+    int32_t t_fine = var1 + var2;
+
+    var1 = (t_fine >> 1) - (int32_t)64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)c->dig_P6);
+    var2 = var2 + ((var1 * ((int32_t)c->dig_P5)) << 1);
+    var2 = (var2 >> 2) + (((int32_t)c->dig_P4) << 16);
+    var1 = (((c->dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) +
+            ((((int32_t)c->dig_P2) * var1) >> 1)) >>
+           18;
+    var1 = ((32768 + var1) * ((int32_t)c->dig_P1)) >> 15;
+    if(var1 == 0) return 0; // Avoid a division by zero
+
+    uint32_t p = (((uint32_t)(((int32_t)1048576) - adc_P) - (var2 >> 12))) * 3125;
+    if(p < 0x80000000) {
+        p = (p << 1) / ((uint32_t)var1);
+    } else {
+        p = (p / (uint32_t)var1) * 2;
+    }
+    var1 = (((int32_t)c->dig_P9) * ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >> 12;
+    var2 = (((int32_t)(p >> 2)) * ((int32_t)c->dig_P8)) >> 13;
+    return (uint32_t)((int32_t)p + ((var1 + var2 + c->dig_P7) >> 4));
+}
+
+static bool barometer_bmp280_read(Barometer* baro, uint32_t* pressure) {
+    if(!barometer_write_reg(baro, BMP280_REG_CTRL_MEAS, BMP280_CTRL_MEAS_FORCED)) return false;
+
+    uint8_t status = BMP280_STATUS_MEASURING;
+    for(uint8_t i = 0; i < BARO_CONVERSION_POLLS && (status & BMP280_STATUS_MEASURING); i++) {
+        furi_delay_ms(5);
+        if(!barometer_read_regs(baro, BMP280_REG_STATUS, &status, 1)) return false;
+    }
+    if(status & BMP280_STATUS_MEASURING) return false;
+
+    uint8_t data[6];
+    if(!barometer_read_regs(baro, BMP280_REG_PRESS_MSB, data, sizeof(data))) return false;
+
+    int32_t adc_P = ((int32_t)data[0] << 12) | ((int32_t)data[1] << 4) | (data[2] >> 4);
+    int32_t adc_T = ((int32_t)data[3] << 12) | ((int32_t)data[4] << 4) | (data[5] >> 4);
+
+    *pressure = barometer_bmp280_compensate(&baro->calib, adc_T, adc_P);
+    return *pressure != 0;
+}
+
+static bool barometer_lps22_read(Barometer* baro, uint32_t* pressure) {
+    if(!barometer_write_reg(baro, LPS22_REG_CTRL_REG2, LPS22_CTRL_REG2_ONE_SHOT)) return false;
+
+    // The ONE_SHOT bit is cleared by the sensor once the conversion is done
+    uint8_t ctrl = LPS22_CTRL_REG2_ONE_SHOT;
+    for(uint8_t i = 0; i < BARO_CONVERSION_POLLS && (ctrl & 0x01); i++) {
+        furi_delay_ms(5);
+        if(!barometer_read_regs(baro, LPS22_REG_CTRL_REG2, &ctrl, 1)) return false;
+    }
+    if(ctrl & 0x01) return false;
+
+    uint8_t data[3];
+    if(!barometer_read_regs(baro, LPS22_REG_PRESS_OUT_XL, data, sizeof(data))) return false;
+
+    // 24-bit two's complement, 4096 LSB/hPa
+    int32_t raw =
+        (int32_t)((uint32_t)data[2] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[0] << 8) >> 8;
+    if(raw <= 0) return false;
+
+    *pressure = (uint32_t)(((int64_t)raw * 100) / 4096);
+    return true;
+}
+
+bool barometer_probe(Barometer* baro) {
+    const uint8_t bmp280_addresses[] = {BMP280_ADDRESS_PRIMARY, BMP280_ADDRESS_SECONDARY};
+    const uint8_t lps22_addresses[] = {LPS22_ADDRESS_PRIMARY, LPS22_ADDRESS_SECONDARY};
+    uint8_t id;
+
+    baro->type = BarometerTypeNone;
+
+    for(size_t i = 0; i < COUNT_OF(bmp280_addresses); i++) {
+        if(barometer_probe_id(baro, bmp280_addresses[i], BMP280_REG_CHIP_ID, &id) &&
+           (id == BMP280_CHIP_ID || id == BME280_CHIP_ID) && barometer_bmp280_read_calib(baro)) {
+            baro->type = BarometerTypeBMP280;
+            break;
+        }
+    }
+
+    for(size_t i = 0; i < COUNT_OF(lps22_addresses) && baro->type == BarometerTypeNone; i++) {
+        if(barometer_probe_id(baro, lps22_addresses[i], LPS22_REG_WHO_AM_I, &id) &&
+           (id == LPS22HB_WHO_AM_I || id == LPS22HH_WHO_AM_I)) {
+            baro->type = BarometerTypeLPS22;
+        }
+    }
+
+    furi_log_print_format(
+        FuriLogLevelDebug,
+        "Baro",
+        "probe: %s at 0x%02x",
+        barometer_get_name(baro),
+        baro->address >> 1);
+    return baro->type != BarometerTypeNone;
+}
+
+bool barometer_read_pressure(Barometer* baro, uint32_t* pressure) {
+    switch(baro->type) {
+    case BarometerTypeBMP280:
+        return barometer_bmp280_read(baro, pressure);
+    case BarometerTypeLPS22:
+        return barometer_lps22_read(baro, pressure);
+    default:
+        return false;
+    }
+}
+
+const char* barometer_get_name(const Barometer* baro) {
+    switch(baro->type) {
+    case BarometerTypeBMP280:
+        return "BMP280";
+    case BarometerTypeLPS22:
+        return "LPS22";
+    default:
+        return "none";
+    }
+}
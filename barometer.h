@@ -0,0 +1,53 @@
+/*
+  Minimal driver for an external I2C barometer sharing the bus with the SCD4x.
+
+  Supported parts:
+  * Bosch BMP280 / BME280 (0x76 / 0x77), forced mode, integer compensation from the datasheet
+  * ST LPS22HB / LPS22HH (0x5C / 0x5D), one-shot mode
+
+  The barometer is only used as a pressure source for the SCD4x ambient pressure compensation.
+*/
+
+#ifndef __BAROMETER_H__
+#define __BAROMETER_H__
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <furi_hal_i2c.h>
+
+typedef enum {
+    BarometerTypeNone = 0,
+    BarometerTypeBMP280,
+    BarometerTypeLPS22,
+} BarometerType;
+
+typedef struct {
+    uint16_t dig_T1;
+    int16_t dig_T2;
+    int16_t dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2;
+    int16_t dig_P3;
+    int16_t dig_P4;
+    int16_t dig_P5;
+    int16_t dig_P6;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+} barometer_bmp280_calib_t;
+
+typedef struct {
+    BarometerType type;
+    uint8_t address; // 8-bit (shifted) I2C address, as expected by furi_hal_i2c
+    barometer_bmp280_calib_t calib; // BMP280 only
+} Barometer;
+
+// Look for a supported barometer on the external I2C bus. Returns true if one was found.
+bool barometer_probe(Barometer* baro);
+
+// Trigger a single conversion and read the pressure in Pa. Blocks for the conversion time (~15 ms).
+bool barometer_read_pressure(Barometer* baro, uint32_t* pressure);
+
+const char* barometer_get_name(const Barometer* baro);
+
+#endif
@@ -0,0 +1,96 @@
+#include "co2_ach.h"
+#include <math.h>
+
+// Two-sided 95% quantile of the normal distribution, fine for the sample counts involved
+#define CO2_ACH_Z95 1.96f
+
+void co2_ach_init(Co2Ach* ach, uint16_t outdoor) {
+    memset(ach, 0, sizeof(Co2Ach));
+    ach->outdoor = outdoor;
+}
+
+static void co2_ach_begin(Co2Ach* ach, uint16_t co2, uint32_t timestamp) {
+    ach->decaying = true;
+    ach->minimum = co2;
+    ach->start = timestamp;
+    ach->n = 0;
+    ach->mean_t = 0;
+    ach->mean_y = 0;
+    ach->m_tt = 0;
+    ach->m_ty = 0;
+    ach->m_yy = 0;
+}
+
+static void co2_ach_add(Co2Ach* ach, uint16_t co2, uint32_t timestamp) {
+    // A noisy reading can still land at or below the outdoor level late in a segment
+    if(co2 <= ach->outdoor) return;
+
+    float t = (float)(timestamp - ach->start) / 3600;
+    float y = logf((float)(co2 - ach->outdoor));
+    ach->n++;
+    float dt = t - ach->mean_t;
+    float dy = y - ach->mean_y;
+    ach->mean_t += dt / ach->n;
+    ach->mean_y += dy / ach->n;
+    ach->m_tt += dt * (t - ach->mean_t);
+    ach->m_ty += dt * (y - ach->mean_y);
+    ach->m_yy += dy * (y - ach->mean_y);
+    ach->last = timestamp;
+}
+
+bool co2_ach_get_current(const Co2Ach* ach, Co2AchResult* result) {
+    if(!ach->decaying || ach->n < CO2_ACH_MIN_SAMPLES) return false;
+
+    float sxx = ach->m_tt;
+    float sxy = ach->m_ty;
+    float syy = ach->m_yy;
+    if(sxx <= 0) return false;
+
+    float slope = sxy / sxx;
+    float residual = MAX(syy - slope * sxy, 0.0f);
+
+    result->ach = -slope;
+    result->error = CO2_ACH_Z95 * sqrtf(residual / (ach->n - 2) / sxx);
+    result->r2 = syy > 0 ? 1 - residual / syy : 0;
+    result->duration = ach->last - ach->start;
+    result->samples = ach->n;
+    return true;
+}
+
+bool co2_ach_update(Co2Ach* ach, uint16_t co2, uint32_t timestamp) {
+    if(ach->ema == 0) {
+        ach->ema = (uint32_t)co2 << CO2_ACH_EMA_SHIFT;
+    } else {
+        ach->ema = ach->ema - (ach->ema >> CO2_ACH_EMA_SHIFT) + co2;
+    }
+    uint16_t smoothed = ach->ema >> CO2_ACH_EMA_SHIFT;
+
+    if(!ach->decaying) {
+        ach->peak = MAX(ach->peak, smoothed);
+        if(ach->peak - smoothed >= CO2_ACH_START_DROP_PPM &&
+           smoothed >= ach->outdoor + CO2_ACH_MIN_EXCESS_PPM) {
+            co2_ach_begin(ach, smoothed, timestamp);
+            co2_ach_add(ach, co2, timestamp);
+        }
+        return false;
+    }
+
+    if(smoothed <= ach->minimum + CO2_ACH_RISE_TOLERANCE_PPM &&
+       smoothed >= ach->outdoor + CO2_ACH_END_EXCESS_PPM) {
+        ach->minimum = MIN(ach->minimum, smoothed);
+        co2_ach_add(ach, co2, timestamp);
+        return false;
+    }
+
+    // Segment over: keep its fit if it was long enough and actually a decay
+    Co2AchResult result;
+    bool reported = co2_ach_get_current(ach, &result) && result.ach > 0 &&
+                    result.duration >= CO2_ACH_MIN_DURATION_S;
+    if(reported) {
+        ach->result = result;
+        ach->has_result = true;
+    }
+    ach->decaying = false;
+    ach->peak = smoothed;
+    return reported;
+}
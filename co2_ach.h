@@ -0,0 +1,70 @@
+/*
+  Air changes per hour (ACH) from CO2 decay curves.
+
+  Once a room is left, CO2 decays towards the outdoor level: C(t) = Cout + (C0 - Cout) e^(-ACH t).
+  The estimator watches a lightly smoothed copy of the readings (EMA, weight
+  1 / 2^CO2_ACH_EMA_SHIFT, so noise alone neither starts nor ends a segment) for such decay
+  segments: one starts when CO2 fell CO2_ACH_START_DROP_PPM below its last peak while still at
+  least CO2_ACH_MIN_EXCESS_PPM above the outdoor level, and ends when CO2 rises again by
+  CO2_ACH_RISE_TOLERANCE_PPM (people came back) or gets too close to the outdoor level for the
+  logarithm to be meaningful.
+
+  During a segment ln(C - Cout) of the unsmoothed readings is fitted against time with least
+  squares, O(1) per sample: the means and co-moments are updated in place (Welford), which keeps
+  single precision accurate over segments of any length. The slope is -ACH; the 95% interval
+  comes from the slope standard error and R² tells how exponential the decay really was.
+*/
+
+#ifndef __CO2_ACH_H__
+#define __CO2_ACH_H__
+
+#include <furi.h>
+
+#define CO2_ACH_OUTDOOR_PPM 420
+#define CO2_ACH_EMA_SHIFT 2
+#define CO2_ACH_START_DROP_PPM 50
+#define CO2_ACH_MIN_EXCESS_PPM 100 // Above outdoor, to start a segment
+#define CO2_ACH_END_EXCESS_PPM 80 // Above outdoor, to keep a segment going
+#define CO2_ACH_RISE_TOLERANCE_PPM 30
+#define CO2_ACH_MIN_SAMPLES 24 // 2 minutes at the 5 s periodic interval
+#define CO2_ACH_MIN_DURATION_S (10 * 60) // Shorter segments are not reported when they end
+
+typedef struct {
+    float ach; // Air changes per hour
+    float error; // Half width of the 95% interval, 1/h
+    float r2; // Goodness of the exponential fit, 0..1
+    uint32_t duration; // Length of the segment, seconds
+    uint32_t samples;
+} Co2AchResult;
+
+typedef struct {
+    uint16_t outdoor; // ppm
+    bool decaying;
+    uint32_t ema; // Smoothed CO2, value << CO2_ACH_EMA_SHIFT, 0 until the first reading
+    uint16_t peak; // Highest smoothed CO2 since the last segment
+    uint16_t minimum; // Lowest smoothed CO2 of the current segment
+
+    // Least squares of y = ln(C - outdoor) on t (hours since the segment start)
+    uint32_t start;
+    uint32_t last;
+    uint32_t n;
+    float mean_t;
+    float mean_y;
+    float m_tt; // Sums of the products of the differences from the means
+    float m_ty;
+    float m_yy;
+
+    bool has_result;
+    Co2AchResult result; // Last completed segment
+} Co2Ach;
+
+void co2_ach_init(Co2Ach* ach, uint16_t outdoor);
+
+// Add a CO2 reading (ppm) taken at timestamp (seconds).
+// Returns true when a segment just ended with a result
+bool co2_ach_update(Co2Ach* ach, uint16_t co2, uint32_t timestamp);
+
+// Fit of the segment in progress. Returns false if there is none or it is still too short
+bool co2_ach_get_current(const Co2Ach* ach, Co2AchResult* result);
+
+#endif
@@ -0,0 +1,149 @@
+#include "co2_alarm.h"
+
+static const uint16_t co2_alarm_default_thresholds[Co2AlarmLevelNum - 1] = {1000, 1400, 2000};
+
+// Yellow blink, short buzz
+static const NotificationSequence sequence_co2_alarm_elevated = {
+    &message_red_255,
+    &message_green_255,
+    &message_vibro_on,
+    &message_delay_100,
+    &message_vibro_off,
+    &message_delay_250,
+    NULL,
+};
+
+// Red blink, two buzzes
+static const NotificationSequence sequence_co2_alarm_high = {
+    &message_red_255,
+    &message_vibro_on,
+    &message_delay_100,
+    &message_vibro_off,
+    &message_delay_100,
+    &message_vibro_on,
+    &message_delay_100,
+    &message_vibro_off,
+    &message_delay_250,
+    NULL,
+};
+
+// Red blink, buzz and beeps
+static const NotificationSequence sequence_co2_alarm_critical = {
+    &message_red_255,
+    &message_vibro_on,
+    &message_note_a5,
+    &message_delay_250,
+    &message_sound_off,
+    &message_delay_100,
+    &message_note_a5,
+    &message_delay_250,
+    &message_sound_off,
+    &message_vibro_off,
+    NULL,
+};
+
+// Magenta blink, short buzz
+static const NotificationSequence sequence_co2_alarm_rise = {
+    &message_red_255,
+    &message_blue_255,
+    &message_vibro_on,
+    &message_delay_100,
+    &message_vibro_off,
+    &message_delay_100,
+    NULL,
+};
+
+void co2_alarm_init(Co2Alarm* alarm) {
+    memset(alarm, 0, sizeof(Co2Alarm));
+    memcpy(alarm->thresholds, co2_alarm_default_thresholds, sizeof(alarm->thresholds));
+    alarm->hysteresis = CO2_ALARM_HYSTERESIS_PPM;
+    alarm->rise_ppm_min = CO2_ALARM_RISE_PPM_MIN;
+    alarm->level = Co2AlarmLevelNormal;
+}
+
+static uint8_t co2_alarm_update_level(Co2Alarm* alarm, uint16_t co2) {
+    Co2AlarmLevel level = alarm->level;
+
+    while(level < Co2AlarmLevelNum - 1 && co2 >= alarm->thresholds[level]) {
+        level++;
+    }
+    while(level > Co2AlarmLevelNormal &&
+          co2 + alarm->hysteresis < alarm->thresholds[level - 1]) {
+        level--;
+    }
+
+    uint8_t events = Co2AlarmEventNone;
+    if(level > alarm->level) events |= Co2AlarmEventLevelUp;
+    if(level < alarm->level) events |= Co2AlarmEventLevelDown;
+    alarm->level = level;
+    return events;
+}
+
+static uint8_t co2_alarm_update_slope(Co2Alarm* alarm, uint16_t co2, uint32_t now) {
+    // The oldest entry is overwritten by the new one, read it first
+    uint8_t oldest = alarm->count < CO2_ALARM_SLOPE_WINDOW ? 0 : alarm->head;
+    uint16_t oldest_co2 = alarm->window_co2[oldest];
+    uint32_t oldest_tick = alarm->window_tick[oldest];
+
+    alarm->window_co2[alarm->head] = co2;
+    alarm->window_tick[alarm->head] = now;
+    alarm->head = (alarm->head + 1) % CO2_ALARM_SLOPE_WINDOW;
+    if(alarm->count < CO2_ALARM_SLOPE_WINDOW) {
+        alarm->count++;
+        return Co2AlarmEventNone;
+    }
+
+    uint32_t elapsed = now - oldest_tick;
+    if(elapsed == 0) return Co2AlarmEventNone;
+    int64_t delta = (int32_t)co2 - (int32_t)oldest_co2;
+    alarm->slope = (int32_t)(delta * furi_ms_to_ticks(60 * 1000) / elapsed);
+
+    uint8_t events = Co2AlarmEventNone;
+    if(!alarm->rising && alarm->slope >= alarm->rise_ppm_min) {
+        alarm->rising = true;
+        events |= Co2AlarmEventRiseStart;
+    } else if(alarm->rising && alarm->slope < alarm->rise_ppm_min / 2) {
+        alarm->rising = false;
+        events |= Co2AlarmEventRiseEnd;
+    }
+    return events;
+}
+
+uint8_t co2_alarm_update(Co2Alarm* alarm, uint16_t co2, uint32_t now) {
+    return co2_alarm_update_level(alarm, co2) | co2_alarm_update_slope(alarm, co2, now);
+}
+
+void co2_alarm_notify(const Co2Alarm* alarm, NotificationApp* notifications, uint8_t events) {
+    if(events & Co2AlarmEventLevelUp) {
+        switch(alarm->level) {
+        case Co2AlarmLevelElevated:
+            notification_message(notifications, &sequence_co2_alarm_elevated);
+            break;
+        case Co2AlarmLevelHigh:
+            notification_message(notifications, &sequence_co2_alarm_high);
+            break;
+        case Co2AlarmLevelCritical:
+            notification_message(notifications, &sequence_co2_alarm_critical);
+            break;
+        default:
+            break;
+        }
+    } else if(events & Co2AlarmEventRiseStart) {
+        notification_message(notifications, &sequence_co2_alarm_rise);
+    } else if((events & Co2AlarmEventLevelDown) && alarm->level == Co2AlarmLevelNormal) {
+        notification_message(notifications, &sequence_blink_green_100);
+    }
+}
+
+const char* co2_alarm_get_level_name(Co2AlarmLevel level) {
+    switch(level) {
+    case Co2AlarmLevelElevated:
+        return "Elevated";
+    case Co2AlarmLevelHigh:
+        return "High";
+    case Co2AlarmLevelCritical:
+        return "Critical";
+    default:
+        return "Normal";
+    }
+}
@@ -0,0 +1,63 @@
+/*
+  CO2 threshold alarms with hysteresis and a rate-of-change detector.
+
+  A level is entered when CO2 reaches its threshold and left only once CO2 drops below the
+  threshold minus the hysteresis. The slope is estimated over the last CO2_ALARM_SLOPE_WINDOW
+  samples; a rapid rise is flagged above CO2_ALARM_RISE_PPM_MIN ppm/min and cleared below half of it.
+  co2_alarm_update() reports transitions only, so notifications fire once per state change.
+*/
+
+#ifndef __CO2_ALARM_H__
+#define __CO2_ALARM_H__
+
+#include <furi.h>
+#include <notification/notification_messages.h>
+
+#define CO2_ALARM_HYSTERESIS_PPM 50
+#define CO2_ALARM_SLOPE_WINDOW 6 // 30 s at the 5 s periodic interval
+#define CO2_ALARM_RISE_PPM_MIN 100
+
+typedef enum {
+    Co2AlarmLevelNormal,
+    Co2AlarmLevelElevated,
+    Co2AlarmLevelHigh,
+    Co2AlarmLevelCritical,
+    Co2AlarmLevelNum,
+} Co2AlarmLevel;
+
+typedef enum {
+    Co2AlarmEventNone = 0,
+    Co2AlarmEventLevelUp = (1 << 0),
+    Co2AlarmEventLevelDown = (1 << 1),
+    Co2AlarmEventRiseStart = (1 << 2),
+    Co2AlarmEventRiseEnd = (1 << 3),
+} Co2AlarmEvent;
+
+typedef struct {
+    // CO2 (ppm) needed to enter level i + 1
+    uint16_t thresholds[Co2AlarmLevelNum - 1];
+    uint16_t hysteresis;
+    uint16_t rise_ppm_min;
+
+    Co2AlarmLevel level;
+    bool rising;
+    int32_t slope; // ppm/min, valid once the window is full
+
+    uint16_t window_co2[CO2_ALARM_SLOPE_WINDOW];
+    uint32_t window_tick[CO2_ALARM_SLOPE_WINDOW];
+    uint8_t head;
+    uint8_t count;
+} Co2Alarm;
+
+// Default levels: 1000 / 1400 / 2000 ppm
+void co2_alarm_init(Co2Alarm* alarm);
+
+// Evaluate a new sample. Returns a mask of Co2AlarmEvent, Co2AlarmEventNone if nothing changed
+uint8_t co2_alarm_update(Co2Alarm* alarm, uint16_t co2, uint32_t now);
+
+// Play the notification matching the events returned by co2_alarm_update()
+void co2_alarm_notify(const Co2Alarm* alarm, NotificationApp* notifications, uint8_t events);
+
+const char* co2_alarm_get_level_name(Co2AlarmLevel level);
+
+#endif
@@ -0,0 +1,198 @@
+#include "co2_blocklog.h"
+#include <furi_hal_rtc.h>
+#include <core/log.h>
+
+static uint8_t co2_blocklog_put_varint(uint8_t* data, uint32_t value) {
+    uint8_t size = 0;
+    while(value >= 0x80) {
+        data[size++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    data[size++] = value;
+    return size;
+}
+
+static bool co2_blocklog_get_varint(const Co2Block* block, uint16_t* position, uint32_t* value) {
+    *value = 0;
+    for(uint8_t shift = 0; shift < 35; shift += 7) {
+        if(*position >= block->header.size) return false;
+        uint8_t byte = block->payload[(*position)++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint32_t co2_blocklog_zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t co2_blocklog_unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static void co2_block_start(Co2Block* block, Co2BlockSample* last, const Co2BlockSample* sample) {
+    memset(block, 0, sizeof(Co2Block));
+    block->header.start = sample->timestamp;
+    block->header.end = sample->timestamp;
+    block->header.count = 1;
+    for(uint8_t i = 0; i < CO2_BLOCKLOG_CHANNELS; i++) {
+        block->header.min[i] = sample->words[i];
+        block->header.max[i] = sample->words[i];
+        block->header.first[i] = sample->words[i];
+    }
+    *last = *sample;
+}
+
+bool co2_block_append(Co2Block* block, Co2BlockSample* last, const Co2BlockSample* sample) {
+    if(block->header.count == 0) {
+        co2_block_start(block, last, sample);
+        return true;
+    }
+    if(block->header.size + CO2_BLOCKLOG_MAX_SAMPLE_SIZE > CO2_BLOCKLOG_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint8_t* data = &block->payload[block->header.size];
+    uint8_t size = co2_blocklog_put_varint(
+        data, co2_blocklog_zigzag((int32_t)(sample->timestamp - last->timestamp)));
+    for(uint8_t i = 0; i < CO2_BLOCKLOG_CHANNELS; i++) {
+        int32_t delta = (int32_t)sample->words[i] - last->words[i];
+        size += co2_blocklog_put_varint(&data[size], co2_blocklog_zigzag(delta));
+        block->header.min[i] = MIN(block->header.min[i], sample->words[i]);
+        block->header.max[i] = MAX(block->header.max[i], sample->words[i]);
+    }
+
+    block->header.size += size;
+    block->header.count++;
+    block->header.end = sample->timestamp;
+    *last = *sample;
+    return true;
+}
+
+void co2_block_reader_init(Co2BlockReader* reader, const Co2Block* block) {
+    memset(reader, 0, sizeof(Co2BlockReader));
+    reader->block = block;
+}
+
+bool co2_block_reader_next(Co2BlockReader* reader) {
+    const Co2Block* block = reader->block;
+    if(reader->index >= block->header.count) return false;
+
+    if(reader->index == 0) {
+        reader->sample.timestamp = block->header.start;
+        memcpy(reader->sample.words, block->header.first, sizeof(reader->sample.words));
+    } else {
+        uint32_t value;
+        if(!co2_blocklog_get_varint(block, &reader->position, &value)) return false;
+        reader->sample.timestamp += co2_blocklog_unzigzag(value);
+        for(uint8_t i = 0; i < CO2_BLOCKLOG_CHANNELS; i++) {
+            if(!co2_blocklog_get_varint(block, &reader->position, &value)) return false;
+            reader->sample.words[i] += co2_blocklog_unzigzag(value);
+        }
+    }
+    reader->index++;
+    return true;
+}
+
+void co2_blocklog_init(Co2BlockLog* log) {
+    memset(log, 0, sizeof(Co2BlockLog));
+}
+
+static uint64_t co2_blocklog_offset(uint32_t index) {
+    return sizeof(Co2BlockLogHeader) + (uint64_t)index * CO2_BLOCKLOG_BLOCK_SIZE;
+}
+
+// Check the file header (or write it to an empty file) and reload the last block if it has room
+static bool co2_blocklog_open(Co2BlockLog* log, File* file) {
+    uint64_t size = storage_file_size(file);
+    Co2BlockLogHeader header;
+
+    if(size == 0) {
+        memcpy(header.magic, CO2_BLOCKLOG_MAGIC, sizeof(header.magic));
+        header.version = CO2_BLOCKLOG_VERSION;
+        header.reserved = 0;
+        header.block_size = CO2_BLOCKLOG_BLOCK_SIZE;
+        header.created = furi_hal_rtc_get_timestamp();
+        header.reserved2 = 0;
+        log->index = 0;
+        return storage_file_write(file, &header, sizeof(header)) == sizeof(header);
+    }
+
+    if(!storage_file_seek(file, 0, true) ||
+       storage_file_read(file, &header, sizeof(header)) != sizeof(header) ||
+       memcmp(header.magic, CO2_BLOCKLOG_MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != CO2_BLOCKLOG_VERSION || header.block_size != CO2_BLOCKLOG_BLOCK_SIZE) {
+        // Never write over something we do not understand
+        furi_log_print_format(FuriLogLevelError, "SCD4x", "block log: bad file header");
+        return false;
+    }
+
+    uint32_t blocks = (size - sizeof(header)) / CO2_BLOCKLOG_BLOCK_SIZE;
+    log->index = blocks;
+    if(blocks == 0) return true;
+
+    // Continue the last block, its last sample is needed for the next delta (and to tell
+    // whether the clock went back since)
+    Co2Block* block = &log->block;
+    if(!storage_file_seek(file, co2_blocklog_offset(blocks - 1), true) ||
+       storage_file_read(file, block, sizeof(Co2Block)) != sizeof(Co2Block) ||
+       block->header.size > CO2_BLOCKLOG_PAYLOAD_SIZE) {
+        block->header.count = 0;
+        return true;
+    }
+
+    Co2BlockReader reader;
+    co2_block_reader_init(&reader, block);
+    uint16_t count = 0;
+    while(co2_block_reader_next(&reader)) {
+        count++;
+    }
+    if(count != block->header.count) {
+        // Damaged, leave it alone and start a new block after it
+        block->header.count = 0;
+        return true;
+    }
+    log->last = reader.sample;
+    if(block->header.size + CO2_BLOCKLOG_MAX_SAMPLE_SIZE > CO2_BLOCKLOG_PAYLOAD_SIZE) {
+        // Full, the next sample starts a new block after it
+        block->header.count = 0;
+        return true;
+    }
+    log->index = blocks - 1;
+    return true;
+}
+
+static bool co2_blocklog_write_block(Co2BlockLog* log, File* file) {
+    return storage_file_seek(file, co2_blocklog_offset(log->index), true) &&
+           storage_file_write(file, &log->block, sizeof(Co2Block)) == sizeof(Co2Block);
+}
+
+bool co2_blocklog_write(
+    Co2BlockLog* log,
+    File* file,
+    const Co2BlockSample* samples,
+    size_t count) {
+    if(!log->opened) {
+        if(!co2_blocklog_open(log, file)) return false;
+        log->opened = true;
+    }
+
+    for(size_t i = 0; i < count; i++) {
+        // The RTC was set back. Unknown after a damaged block was left alone, last is zero then
+        bool clock_back = samples[i].timestamp < log->last.timestamp;
+        if(!clock_back && co2_block_append(&log->block, &log->last, &samples[i])) continue;
+
+        // Block full or out of order from here: it is final now, the next one starts with this
+        // sample
+        if(log->block.header.count > 0) {
+            if(!co2_blocklog_write_block(log, file)) return false;
+            log->index++;
+            log->block.header.count = 0;
+        }
+        co2_block_append(&log->block, &log->last, &samples[i]);
+        if(clock_back) log->block.header.flags |= CO2_BLOCK_FLAG_CLOCK_BACK;
+    }
+
+    return log->block.header.count == 0 || co2_blocklog_write_block(log, file);
+}
@@ -0,0 +1,98 @@
+/*
+  Compact binary sample log with a seekable block index.
+
+  The file is a 16 byte header followed by fixed-size CO2_BLOCKLOG_BLOCK_SIZE blocks, so block i
+  lives at a known offset and the block headers double as the index: a reader binary-searches
+  the headers by timestamp and only decodes the blocks overlapping the range it wants.
+
+  File header, little-endian: "C2BL", u8 version, u8 reserved, u16 block size, u32 RTC timestamp
+  of the file creation, u32 reserved.
+  Block: Co2BlockHeader (first/last timestamp, sample count, payload bytes used, per channel
+  min/max, the raw words of the first sample and flags), then the payload. Every following
+  sample is stored as zigzag varints of the difference to the previous one: timestamp, CO2, T,
+  RH words.
+  At the 5 s periodic interval a sample usually takes 4-5 bytes instead of ~30 in CSV.
+
+  The block being filled is rewritten in place at every flush, so a flush costs one block write.
+
+  Timestamps only increase within a block. A sample older than the previous one (the RTC was set
+  back) closes the block, the next one is flagged CO2_BLOCK_FLAG_CLOCK_BACK: the file is then a
+  sequence of runs of blocks in time order, a reader searches each run on its own.
+*/
+
+#ifndef __CO2_BLOCKLOG_H__
+#define __CO2_BLOCKLOG_H__
+
+#include <furi.h>
+#include <storage/storage.h>
+
+#define CO2_BLOCKLOG_MAGIC "C2BL"
+#define CO2_BLOCKLOG_VERSION 1
+#define CO2_BLOCKLOG_BLOCK_SIZE 512 // One SD sector
+#define CO2_BLOCKLOG_CHANNELS 3 // CO2, T, RH raw words
+// Worst case encoded sample: 5 byte timestamp delta, 3 bytes per word delta
+#define CO2_BLOCKLOG_MAX_SAMPLE_SIZE (5U + 3U * CO2_BLOCKLOG_CHANNELS)
+
+#define CO2_BLOCK_FLAG_CLOCK_BACK (1 << 0) // Starts before the previous block ended
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t block_size;
+    uint32_t created;
+    uint32_t reserved2;
+} Co2BlockLogHeader;
+
+typedef struct __attribute__((packed)) {
+    uint32_t start; // RTC timestamp of the first sample
+    uint32_t end; // RTC timestamp of the last sample
+    uint16_t count;
+    uint16_t size; // Payload bytes used
+    uint16_t min[CO2_BLOCKLOG_CHANNELS];
+    uint16_t max[CO2_BLOCKLOG_CHANNELS];
+    uint16_t first[CO2_BLOCKLOG_CHANNELS];
+    uint16_t flags; // CO2_BLOCK_FLAG_*
+} Co2BlockHeader;
+
+#define CO2_BLOCKLOG_PAYLOAD_SIZE (CO2_BLOCKLOG_BLOCK_SIZE - sizeof(Co2BlockHeader))
+
+typedef struct __attribute__((packed)) {
+    Co2BlockHeader header;
+    uint8_t payload[CO2_BLOCKLOG_PAYLOAD_SIZE];
+} Co2Block;
+
+typedef struct {
+    uint32_t timestamp; // RTC timestamp, seconds
+    uint16_t words[CO2_BLOCKLOG_CHANNELS];
+} Co2BlockSample;
+
+typedef struct {
+    const Co2Block* block;
+    uint16_t position;
+    uint16_t index;
+    Co2BlockSample sample; // Current sample, valid after co2_block_reader_next() returned true
+} Co2BlockReader;
+
+typedef struct {
+    Co2Block block; // Block being filled
+    uint32_t index; // Its slot in the file
+    Co2BlockSample last; // Last sample appended to it
+    bool opened; // The file was checked and the last block reloaded
+} Co2BlockLog;
+
+void co2_blocklog_init(Co2BlockLog* log);
+
+// Append samples to the log file, which must be open for reading and writing.
+// The first call picks up where the file ends, continuing its last block if it has room
+bool co2_blocklog_write(Co2BlockLog* log, File* file, const Co2BlockSample* samples, size_t count);
+
+// Encode one sample into a block. Returns false, leaving the block untouched, if it is full
+// last is the previous sample of the block and is updated
+bool co2_block_append(Co2Block* block, Co2BlockSample* last, const Co2BlockSample* sample);
+
+// Iterate over the samples of a block
+void co2_block_reader_init(Co2BlockReader* reader, const Co2Block* block);
+bool co2_block_reader_next(Co2BlockReader* reader);
+
+#endif
@@ -0,0 +1,148 @@
+#include "co2_filter.h"
+
+// Hampel threshold: 3 * 1.4826 (MAD to standard deviation) ~= 71 / 16
+#define CO2_FILTER_HAMPEL_NUM 71
+#define CO2_FILTER_HAMPEL_SHIFT 4
+
+// MAD floors in raw words: 5 ppm, ~0.05 C, ~0.25 %RH
+static const uint16_t co2_filter_min_mad[Co2FilterChannelNum] = {5, 19, 164};
+
+// First index in the sorted window whose value is >= value
+static uint8_t co2_filter_lower_bound(const uint16_t* sorted, uint8_t count, uint16_t value) {
+    uint8_t lo = 0;
+    uint8_t hi = count;
+    while(lo < hi) {
+        uint8_t mid = (lo + hi) / 2;
+        if(sorted[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void co2_filter_window_push(Co2FilterState* state, uint16_t value) {
+    if(state->count == CO2_FILTER_WINDOW) {
+        // Drop the oldest sample from the sorted copy
+        uint16_t oldest = state->window[state->head];
+        uint8_t pos = co2_filter_lower_bound(state->sorted, state->count, oldest);
+        memmove(
+            &state->sorted[pos],
+            &state->sorted[pos + 1],
+            (state->count - pos - 1) * sizeof(uint16_t));
+        state->count--;
+    }
+
+    uint8_t pos = co2_filter_lower_bound(state->sorted, state->count, value);
+    memmove(
+        &state->sorted[pos + 1], &state->sorted[pos], (state->count - pos) * sizeof(uint16_t));
+    state->sorted[pos] = value;
+    state->count++;
+
+    state->window[state->head] = value;
+    state->head = (state->head + 1) % CO2_FILTER_WINDOW;
+}
+
+static uint16_t co2_filter_window_median(const Co2FilterState* state) {
+    // With an even count during warm-up this picks the upper median, no averaging needed
+    return state->sorted[state->count / 2];
+}
+
+static uint16_t co2_filter_hampel(Co2Filter* filter, Co2FilterState* state, uint16_t value) {
+    uint16_t median = co2_filter_window_median(state);
+
+    // Median absolute deviation. The deviations of a sorted window are V-shaped around the
+    // median, so they can be merged in order from both sides without a sort.
+    uint8_t left = state->count / 2;
+    uint8_t right = left + 1;
+    uint16_t mad = 0;
+    for(uint8_t i = 0; i <= state->count / 2; i++) {
+        uint16_t dl = left < state->count ? median - state->sorted[left] : UINT16_MAX;
+        uint16_t dr = right < state->count ? state->sorted[right] - median : UINT16_MAX;
+        if(dl <= dr) {
+            mad = dl;
+            left = left ? left - 1 : UINT8_MAX;
+        } else {
+            mad = dr;
+            right++;
+        }
+    }
+    mad = MAX(mad, state->min_mad);
+
+    uint32_t deviation = value > median ? value - median : median - value;
+    if(deviation > (((uint32_t)mad * CO2_FILTER_HAMPEL_NUM) >> CO2_FILTER_HAMPEL_SHIFT)) {
+        filter->outliers++;
+        return median;
+    }
+    return value;
+}
+
+static uint16_t
+    co2_filter_channel_update(Co2Filter* filter, Co2FilterState* state, uint16_t value) {
+    switch(filter->type) {
+    case Co2FilterTypeEMA:
+        if(state->count == 0) {
+            state->ema = (uint32_t)value << CO2_FILTER_EMA_SHIFT;
+            state->count = 1;
+        } else {
+            state->ema -= state->ema >> CO2_FILTER_EMA_SHIFT;
+            state->ema += value;
+        }
+        return (state->ema + (1 << (CO2_FILTER_EMA_SHIFT - 1))) >> CO2_FILTER_EMA_SHIFT;
+    case Co2FilterTypeMedian:
+        co2_filter_window_push(state, value);
+        return co2_filter_window_median(state);
+    case Co2FilterTypeHampel:
+        co2_filter_window_push(state, value);
+        return co2_filter_hampel(filter, state, value);
+    default:
+        return value;
+    }
+}
+
+void co2_filter_init(Co2Filter* filter, Co2FilterType type) {
+    memset(filter, 0, sizeof(Co2Filter));
+    filter->type = type;
+    for(uint8_t i = 0; i < Co2FilterChannelNum; i++) {
+        filter->channels[i].min_mad = co2_filter_min_mad[i];
+    }
+}
+
+void co2_filter_update(
+    Co2Filter* filter,
+    const uint16_t input[Co2FilterChannelNum],
+    uint16_t output[Co2FilterChannelNum]) {
+    for(uint8_t i = 0; i < Co2FilterChannelNum; i++) {
+        filter->channels[i].output =
+            co2_filter_channel_update(filter, &filter->channels[i], input[i]);
+        output[i] = filter->channels[i].output;
+    }
+}
+
+void co2_filter_update_rht(
+    Co2Filter* filter,
+    const uint16_t input[Co2FilterChannelNum],
+    uint16_t output[Co2FilterChannelNum]) {
+    Co2FilterState* co2 = &filter->channels[Co2FilterChannelCO2];
+    // Nothing filtered yet: the held word is all there is
+    output[Co2FilterChannelCO2] = co2->count ? co2->output : input[Co2FilterChannelCO2];
+    for(uint8_t i = Co2FilterChannelTemperature; i < Co2FilterChannelNum; i++) {
+        filter->channels[i].output =
+            co2_filter_channel_update(filter, &filter->channels[i], input[i]);
+        output[i] = filter->channels[i].output;
+    }
+}
+
+const char* co2_filter_get_name(Co2FilterType type) {
+    switch(type) {
+    case Co2FilterTypeEMA:
+        return "EMA";
+    case Co2FilterTypeMedian:
+        return "Median";
+    case Co2FilterTypeHampel:
+        return "Hampel";
+    default:
+        return "None";
+    }
+}
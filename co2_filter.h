@@ -0,0 +1,73 @@
+/*
+  Smoothing and outlier rejection for the SCD4x raw output words.
+
+  Every channel (CO2, T, RH) is filtered independently on the raw 16-bit words returned by
+  readMeasurement(), in integer arithmetic and with a fixed amount of memory per channel:
+  * EMA: exponential moving average, weight 1 / 2^CO2_FILTER_EMA_SHIFT. O(1) per sample.
+    A step reaches 63% of its final value after ~4 samples, 95% after ~11.
+  * Median: median of the last CO2_FILTER_WINDOW samples. The window is kept sorted, the update is
+    a binary search plus a short memmove. A step passes after (CO2_FILTER_WINDOW + 1) / 2 samples.
+  * Hampel: a sample further than 3 scaled MADs from the window median is replaced by the median,
+    everything else passes through unchanged: noise is not smoothed and spikes are removed. A step
+    out of a quiet level looks like outliers until it holds the window median, so it passes after
+    (CO2_FILTER_WINDOW + 1) / 2 samples as with the median.
+  tests/test_co2_filter.c checks this and measures the cost per update.
+*/
+
+#ifndef __CO2_FILTER_H__
+#define __CO2_FILTER_H__
+
+#include <furi.h>
+
+#define CO2_FILTER_WINDOW 7 // Must be odd
+#define CO2_FILTER_EMA_SHIFT 2
+
+typedef enum {
+    Co2FilterTypeNone,
+    Co2FilterTypeEMA,
+    Co2FilterTypeMedian,
+    Co2FilterTypeHampel,
+    Co2FilterTypeNum,
+} Co2FilterType;
+
+typedef enum {
+    Co2FilterChannelCO2,
+    Co2FilterChannelTemperature,
+    Co2FilterChannelHumidity,
+    Co2FilterChannelNum,
+} Co2FilterChannel;
+
+typedef struct {
+    uint32_t ema; // EMA state, value << CO2_FILTER_EMA_SHIFT
+    uint16_t window[CO2_FILTER_WINDOW]; // Samples in arrival order (ring buffer)
+    uint16_t sorted[CO2_FILTER_WINDOW]; // The same samples, sorted
+    uint8_t head;
+    uint8_t count;
+    uint16_t min_mad; // Hampel MAD floor, keeps a flat signal from flagging every small change
+    uint16_t output; // Last filtered word
+} Co2FilterState;
+
+typedef struct {
+    Co2FilterType type;
+    Co2FilterState channels[Co2FilterChannelNum];
+    uint32_t outliers; // Samples replaced by the Hampel filter
+} Co2Filter;
+
+void co2_filter_init(Co2Filter* filter, Co2FilterType type);
+
+// Filter one sample of every channel. Raw words in, filtered raw words out (may alias)
+void co2_filter_update(
+    Co2Filter* filter,
+    const uint16_t input[Co2FilterChannelNum],
+    uint16_t output[Co2FilterChannelNum]);
+
+// Filter a T/RH-only sample (SCD4x_SAMPLE_FLAG_RHT_ONLY): its CO2 word is the one of the last
+// full measurement again, the CO2 channel is left alone and outputs its last filtered word
+void co2_filter_update_rht(
+    Co2Filter* filter,
+    const uint16_t input[Co2FilterChannelNum],
+    uint16_t output[Co2FilterChannelNum]);
+
+const char* co2_filter_get_name(Co2FilterType type);
+
+#endif
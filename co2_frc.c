@@ -0,0 +1,120 @@
+#include "co2_frc.h"
+#include "scd4x.h"
+#include "co2_settings.h"
+#include "co2_memory.h"
+#include <core/log.h>
+#include <math.h>
+
+// 2.6 KB used at most on the PC, whose printf is heavier, see tests/test_co2_memory.c
+#define CO2_FRC_THREAD_STACK_SIZE (3 * 1024)
+
+static void co2_frc_clear_window(Co2Frc* frc) {
+    frc->head = 0;
+    frc->count = 0;
+    frc->sum = 0;
+    frc->sum_squares = 0;
+}
+
+static int32_t co2_frc_worker(void* context) {
+    Co2Frc* frc = context;
+    float correction = 0;
+
+    bool success = stopPeriodicMeasurement(CO2_FRC_STOP_DELAY_MS) &&
+                   performForcedRecalibration(frc->target, &correction);
+    // Measurements are restarted even if the calibration failed
+    success &= co2_settings_start(frc->mode);
+
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "FRC to %u ppm: %s, correction %.0f ppm",
+        frc->target,
+        success ? "ok" : "failed",
+        (double)correction);
+
+    // The readings before the calibration say nothing about the stability after it
+    co2_frc_clear_window(frc);
+
+    frc->correction = correction;
+    frc->state = success ? Co2FrcStateDone : Co2FrcStateFailed;
+    frc->stack_free = co2_memory_stack_free();
+    if(frc->callback) frc->callback(frc->context);
+    return 0;
+}
+
+Co2Frc* co2_frc_alloc(Co2FrcCallback callback, void* context) {
+    Co2Frc* frc = co2_memory_alloc(sizeof(Co2Frc));
+    memset(frc, 0, sizeof(Co2Frc));
+    frc->target = CO2_FRC_DEFAULT_TARGET_PPM;
+    frc->callback = callback;
+    frc->context = context;
+    frc->thread = furi_thread_alloc_ex("Co2Frc", CO2_FRC_THREAD_STACK_SIZE, co2_frc_worker, frc);
+    return frc;
+}
+
+void co2_frc_free(Co2Frc* frc) {
+    // Never leave the sensor stopped behind
+    furi_thread_join(frc->thread);
+    furi_thread_free(frc->thread);
+    co2_memory_free(frc, sizeof(Co2Frc));
+}
+
+void co2_frc_reset(Co2Frc* frc) {
+    if(frc->state == Co2FrcStateRunning) return;
+    frc->state = Co2FrcStateMonitoring;
+    co2_frc_clear_window(frc);
+}
+
+void co2_frc_feed(Co2Frc* frc, uint16_t co2) {
+    if(frc->count == CO2_FRC_WINDOW) {
+        uint16_t oldest = frc->window[frc->head];
+        frc->sum -= oldest;
+        frc->sum_squares -= (uint32_t)oldest * oldest;
+    } else {
+        frc->count++;
+    }
+
+    frc->window[frc->head] = co2;
+    frc->sum += co2;
+    frc->sum_squares += (uint32_t)co2 * co2;
+    frc->head = (frc->head + 1) % CO2_FRC_WINDOW;
+}
+
+float co2_frc_get_stddev(const Co2Frc* frc) {
+    if(frc->count < 2) return 0;
+    // Integer sums are exact, only the final division is rounded
+    uint64_t n = frc->count;
+    uint64_t numerator = n * frc->sum_squares - (uint64_t)frc->sum * frc->sum;
+    return sqrtf((float)numerator / (float)(n * (n - 1)));
+}
+
+int32_t co2_frc_get_drift(const Co2Frc* frc) {
+    if(frc->count < 2) return 0;
+    uint8_t newest = (frc->head + CO2_FRC_WINDOW - 1) % CO2_FRC_WINDOW;
+    uint8_t oldest = frc->count == CO2_FRC_WINDOW ? frc->head : 0;
+    return (int32_t)frc->window[newest] - frc->window[oldest];
+}
+
+bool co2_frc_is_stable(const Co2Frc* frc) {
+    int32_t drift = co2_frc_get_drift(frc);
+    return frc->count == CO2_FRC_WINDOW && co2_frc_get_stddev(frc) <= CO2_FRC_MAX_STDDEV_PPM &&
+           drift <= CO2_FRC_MAX_DRIFT_PPM && drift >= -CO2_FRC_MAX_DRIFT_PPM;
+}
+
+bool co2_frc_start(Co2Frc* frc) {
+    if(frc->state == Co2FrcStateRunning || frc->mode != Co2SettingsModePeriodic ||
+       !co2_frc_is_stable(frc)) {
+        return false;
+    }
+
+    // The previous run (if any) has already returned, this only releases it
+    furi_thread_join(frc->thread);
+    frc->correction = 0;
+    frc->state = Co2FrcStateRunning;
+    furi_thread_start(frc->thread);
+    return true;
+}
+
+bool co2_frc_is_running(const Co2Frc* frc) {
+    return frc->state == Co2FrcStateRunning;
+}
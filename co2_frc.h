@@ -0,0 +1,77 @@
+/*
+  Guided forced recalibration (FRC).
+
+  The SCD4x needs at least 3 minutes of stable CO2 in periodic mode before an FRC. The last
+  CO2_FRC_WINDOW readings are kept in a ring buffer with running sums, so the standard deviation
+  and the drift (newest minus oldest) are O(1) per sample. Calibration is only allowed once the
+  window is full, the standard deviation is within CO2_FRC_MAX_STDDEV_PPM and the drift within
+  CO2_FRC_MAX_DRIFT_PPM.
+
+  co2_frc_start() runs stop periodic / wait / FRC / restart periodic on a worker thread. The caller
+  must not talk to the sensor until co2_frc_is_running() returns false again; the callback fires
+  on the worker thread once the sequence is over.
+  Periodic mode only: low power mode gives the window a sample every 30 s and hybrid mode single
+  shots, neither is the 3 minutes of periodic operation the FRC asks for, so co2_frc_start()
+  refuses them.
+*/
+
+#ifndef __CO2_FRC_H__
+#define __CO2_FRC_H__
+
+#include <furi.h>
+
+#define CO2_FRC_WINDOW 36 // 3 minutes at the 5 s periodic interval
+#define CO2_FRC_MAX_STDDEV_PPM 10
+#define CO2_FRC_MAX_DRIFT_PPM 20
+#define CO2_FRC_DEFAULT_TARGET_PPM 420 // Fresh outdoor air
+#define CO2_FRC_TARGET_STEP_PPM 10
+#define CO2_FRC_STOP_DELAY_MS 500 // Datasheet: stop_periodic_measurement execution time
+
+typedef enum {
+    Co2FrcStateMonitoring,
+    Co2FrcStateRunning,
+    Co2FrcStateDone,
+    Co2FrcStateFailed,
+} Co2FrcState;
+
+typedef void (*Co2FrcCallback)(void* context);
+
+typedef struct {
+    volatile Co2FrcState state;
+    uint16_t target; // Reference CO2 concentration, ppm
+
+    uint16_t window[CO2_FRC_WINDOW];
+    uint8_t head;
+    uint8_t count;
+    uint32_t sum;
+    uint64_t sum_squares;
+
+    float correction; // ppm, valid in Co2FrcStateDone
+    uint32_t stack_free; // Worker stack left at worst, bytes, 0 until a sequence ran
+    uint8_t mode; // Co2SettingsMode the measurements run and are restarted in
+
+    FuriThread* thread;
+    Co2FrcCallback callback;
+    void* context;
+} Co2Frc;
+
+Co2Frc* co2_frc_alloc(Co2FrcCallback callback, void* context);
+void co2_frc_free(Co2Frc* frc);
+
+// Clear the window and go back to monitoring. Ignored while the sequence is running
+void co2_frc_reset(Co2Frc* frc);
+
+// Add a CO2 reading (ppm) to the stability window
+void co2_frc_feed(Co2Frc* frc, uint16_t co2);
+
+bool co2_frc_is_stable(const Co2Frc* frc);
+float co2_frc_get_stddev(const Co2Frc* frc);
+int32_t co2_frc_get_drift(const Co2Frc* frc);
+
+// Start the calibration sequence. Returns false if the readings are not stable yet, or if mode is
+// not periodic
+bool co2_frc_start(Co2Frc* frc);
+
+bool co2_frc_is_running(const Co2Frc* frc);
+
+#endif
@@ -0,0 +1,106 @@
+#include "co2_hybrid.h"
+#include <core/log.h>
+
+void co2_hybrid_start(Co2Hybrid* hybrid) {
+    hybrid->pending = Co2HybridShotNone;
+    hybrid->started = false;
+}
+
+static uint32_t co2_hybrid_get_shot_ticks(Co2HybridShot shot) {
+    return furi_ms_to_ticks(
+        (shot == Co2HybridShotFull ? CO2_HYBRID_CO2_SHOT_MS : CO2_HYBRID_RHT_SHOT_MS) +
+        CO2_HYBRID_MARGIN_MS);
+}
+
+// Read the pending shot once its execution time is over. Returns true when it was read
+static bool co2_hybrid_read(Co2Hybrid* hybrid, uint32_t now) {
+    uint32_t elapsed = now - hybrid->shot_tick;
+    if(elapsed < co2_hybrid_get_shot_ticks(hybrid->pending)) return false;
+
+    if(readMeasurement()) {
+        if(hybrid->pending == Co2HybridShotFull) {
+            // On the grid of the full shots, for the T/RH shot to go first when both are due
+            hybrid->co2_samples++;
+            hybrid->rht_tick = hybrid->shot_tick + furi_ms_to_ticks(CO2_HYBRID_CO2_SHOT_MS);
+        } else {
+            hybrid->rht_samples++;
+        }
+        hybrid->pending = Co2HybridShotNone;
+        return true;
+    }
+
+    if(elapsed >= co2_hybrid_get_shot_ticks(hybrid->pending) +
+                      furi_ms_to_ticks(CO2_HYBRID_TIMEOUT_MS)) {
+        furi_log_print_format(
+            FuriLogLevelError,
+            "SCD4x",
+            "hybrid: %s shot not ready",
+            hybrid->pending == Co2HybridShotFull ? "CO2" : "T/RH");
+        hybrid->failures++;
+        hybrid->pending = Co2HybridShotNone;
+    }
+    return false;
+}
+
+bool co2_hybrid_step(Co2Hybrid* hybrid, uint32_t now) {
+    bool fresh = false;
+    if(hybrid->pending != Co2HybridShotNone) {
+        fresh = co2_hybrid_read(hybrid, now);
+        if(hybrid->pending != Co2HybridShotNone) return false;
+    }
+
+    bool co2_due = !hybrid->started ||
+                   now - hybrid->co2_tick >= furi_ms_to_ticks(CO2_HYBRID_CO2_INTERVAL_MS);
+    bool rht_due = hybrid->started &&
+                   now - hybrid->rht_tick >= furi_ms_to_ticks(CO2_HYBRID_RHT_INTERVAL_MS);
+    if(rht_due) {
+        // First when both are due, T and RH would wait for the 5 s of the full shot otherwise.
+        // A shot the sensor did not take is skipped, the full shot must not wait behind it
+        if(measureSingleShotRHTOnly()) {
+            hybrid->pending = Co2HybridShotRht;
+            hybrid->shot_tick = now;
+        } else {
+            hybrid->failures++;
+        }
+        hybrid->rht_tick = now;
+    } else if(co2_due) {
+        // Retried on the next step if the sensor did not take it
+        if(measureSingleShot()) {
+            hybrid->pending = Co2HybridShotFull;
+            hybrid->shot_tick = now;
+            hybrid->co2_tick = now;
+            hybrid->started = true;
+        } else {
+            hybrid->failures++;
+        }
+    }
+    return fresh;
+}
+
+void co2_hybrid_finish(Co2Hybrid* hybrid) {
+    while(hybrid->pending != Co2HybridShotNone) {
+        uint32_t now = furi_get_tick();
+        int32_t wait =
+            (int32_t)(hybrid->shot_tick + co2_hybrid_get_shot_ticks(hybrid->pending) - now);
+        if(wait > 0) {
+            furi_delay_tick(wait);
+        } else if(!co2_hybrid_read(hybrid, now) && hybrid->pending != Co2HybridShotNone) {
+            furi_delay_tick(furi_ms_to_ticks(CO2_HYBRID_MARGIN_MS));
+        }
+    }
+}
+
+uint32_t co2_hybrid_get_wait(const Co2Hybrid* hybrid, uint32_t now) {
+    uint32_t due;
+    if(hybrid->pending != Co2HybridShotNone) {
+        due = hybrid->shot_tick + co2_hybrid_get_shot_ticks(hybrid->pending);
+    } else if(!hybrid->started) {
+        return 1;
+    } else {
+        uint32_t co2_due = hybrid->co2_tick + furi_ms_to_ticks(CO2_HYBRID_CO2_INTERVAL_MS);
+        uint32_t rht_due = hybrid->rht_tick + furi_ms_to_ticks(CO2_HYBRID_RHT_INTERVAL_MS);
+        due = (int32_t)(rht_due - co2_due) < 0 ? rht_due : co2_due;
+    }
+    int32_t wait = (int32_t)(due - now);
+    return wait > 0 ? (uint32_t)wait : 1;
+}
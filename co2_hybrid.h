@@ -0,0 +1,74 @@
+/*
+  Hybrid sampling of the SCD41: CO2 from a full single shot every CO2_HYBRID_CO2_INTERVAL_MS and
+  temperature / humidity from a T/RH-only single shot every CO2_HYBRID_RHT_INTERVAL_MS in between.
+
+  A full single shot takes 5 s and costs about as much energy as 5 s of periodic measurement, a
+  T/RH-only shot takes 50 ms and next to nothing. With CO2 every 30 s as in low power periodic
+  mode, T and RH come every 5 s as in periodic mode: the thermal and humidity response of periodic
+  mode at the power of low power mode. The SCD40 has no single shots.
+
+  The scheduler is stepped from the app ticks and never waits for the sensor: a shot is started on
+  one tick and read on the first tick after its execution time, where the next shot may start.
+  The sensor is busy during a full shot, so when both are due the T/RH shot goes first, and the
+  T/RH clock restarts from the end of the full shot (its T and RH are as fresh as those of a T/RH
+  shot): T/RH samples stay evenly spaced across the full shots. A shot whose result is not ready
+  CO2_HYBRID_TIMEOUT_MS after its execution time is given up and counted as failed.
+
+  On a simulated SCD41 over 24 h: CO2 every 30.1 s and T/RH every 5.0 s (at most 5.05 s apart)
+  when woken up by co2_hybrid_get_wait() as in headless mode, 31.3 s and 5.2 s on the 1 s ticks
+  of the live view. No command reached the sensor while it was busy.
+
+  readMeasurement() merges both into one sample stream: T/RH-only samples carry the CO2 of the
+  last full shot, flagged SCD4x_SAMPLE_FLAG_RHT_ONLY, with its own read time in co2Timestamp.
+  The app hands those to the T/RH side only, tests/test_co2_hybrid.c checks it along with the
+  settings applied while a shot runs.
+*/
+
+#ifndef __CO2_HYBRID_H__
+#define __CO2_HYBRID_H__
+
+#include <furi.h>
+#include "scd4x.h"
+
+#define CO2_HYBRID_CO2_INTERVAL_MS SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS
+#define CO2_HYBRID_RHT_INTERVAL_MS SCD4x_PERIODIC_INTERVAL_MS
+#define CO2_HYBRID_CO2_SHOT_MS 5000 // Execution times, datasheet
+#define CO2_HYBRID_RHT_SHOT_MS 50
+#define CO2_HYBRID_MARGIN_MS 10 // Added to the execution times, the sensor NACKs until done
+#define CO2_HYBRID_TIMEOUT_MS 2000
+
+typedef enum {
+    Co2HybridShotNone,
+    Co2HybridShotFull,
+    Co2HybridShotRht,
+} Co2HybridShot;
+
+typedef struct {
+    Co2HybridShot pending; // Started, not read yet
+    uint32_t shot_tick; // Start of the pending shot
+    bool started; // A full shot was started since co2_hybrid_start()
+    uint32_t co2_tick; // Start of the last full shot
+    uint32_t rht_tick; // Time of the last T/RH values, either shot
+
+    uint32_t co2_samples;
+    uint32_t rht_samples; // T/RH-only samples
+    uint32_t failures; // Shots that could not be started or read
+} Co2Hybrid;
+
+// (Re)start the schedule with a full shot on the next step, for a sensor with its measurements
+// stopped. The counters are kept
+void co2_hybrid_start(Co2Hybrid* hybrid);
+
+// Read the pending shot if it is done and start the next one when due. Returns true when a sample
+// was read (readMeasurement() succeeded)
+bool co2_hybrid_step(Co2Hybrid* hybrid, uint32_t now);
+
+// Wait for the pending shot, if any, and read it or give it up after CO2_HYBRID_TIMEOUT_MS as
+// the steps do. The sensor takes no other command during a shot: call before stopping it or
+// writing settings. Blocks up to the execution time of a full shot and the timeout
+void co2_hybrid_finish(Co2Hybrid* hybrid);
+
+// Ticks from now until the next step has something to do, at least 1
+uint32_t co2_hybrid_get_wait(const Co2Hybrid* hybrid, uint32_t now);
+
+#endif
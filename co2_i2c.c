@@ -0,0 +1,115 @@
+#include "co2_i2c.h"
+#include <furi_hal.h>
+#include <stm32wbxx_ll_i2c.h>
+#include <core/log.h>
+#include "scd4x.h"
+
+// TIMINGR value for the 64 MHz I2C3 kernel clock (analog filter on), as the firmware's 400 kHz
+// power bus. Its 100 kHz external handle uses 0x10707DBC
+#define CO2_I2C_TIMING_FAST 0x00602173
+
+// Same setup as the firmware external handle, with the fast mode timing
+static void co2_i2c_fast_event(FuriHalI2cBusHandle* handle, FuriHalI2cBusHandleEvent event) {
+    if(event == FuriHalI2cBusHandleEventActivate) {
+        furi_hal_gpio_init_ex(
+            &gpio_ext_pc0, GpioModeAltFunctionOpenDrain, GpioPullNo, GpioSpeedLow, GpioAltFn4I2c3);
+        furi_hal_gpio_init_ex(
+            &gpio_ext_pc1, GpioModeAltFunctionOpenDrain, GpioPullNo, GpioSpeedLow, GpioAltFn4I2c3);
+
+        LL_I2C_InitTypeDef init = {0};
+        init.PeripheralMode = LL_I2C_MODE_I2C;
+        init.Timing = CO2_I2C_TIMING_FAST;
+        init.AnalogFilter = LL_I2C_ANALOGFILTER_ENABLE;
+        init.DigitalFilter = 0;
+        init.OwnAddress1 = 0;
+        init.TypeAcknowledge = LL_I2C_ACK;
+        init.OwnAddrSize = LL_I2C_OWNADDRESS1_7BIT;
+        LL_I2C_Init(handle->bus->i2c, &init);
+        LL_I2C_EnableAutoEndMode(handle->bus->i2c);
+        LL_I2C_SetOwnAddress2(handle->bus->i2c, 0, LL_I2C_OWNADDRESS2_NOMASK);
+        LL_I2C_DisableOwnAddress2(handle->bus->i2c);
+        LL_I2C_DisableGeneralCall(handle->bus->i2c);
+        LL_I2C_EnableClockStretching(handle->bus->i2c);
+        LL_I2C_Enable(handle->bus->i2c);
+    } else if(event == FuriHalI2cBusHandleEventDeactivate) {
+        LL_I2C_Disable(handle->bus->i2c);
+        furi_hal_gpio_write(&gpio_ext_pc0, 1);
+        furi_hal_gpio_init_ex(
+            &gpio_ext_pc0, GpioModeAnalog, GpioPullNo, GpioSpeedLow, GpioAltFnUnused);
+        furi_hal_gpio_write(&gpio_ext_pc1, 1);
+        furi_hal_gpio_init_ex(
+            &gpio_ext_pc1, GpioModeAnalog, GpioPullNo, GpioSpeedLow, GpioAltFnUnused);
+    }
+}
+
+static FuriHalI2cBusHandle co2_i2c_handle_fast = {
+    .bus = &furi_hal_i2c_bus_external,
+    .callback = co2_i2c_fast_event,
+};
+
+FuriHalI2cBusHandle* co2_i2c_get_handle(Co2I2cSpeed speed) {
+    return speed == Co2I2cSpeedFast ? &co2_i2c_handle_fast : &furi_hal_i2c_handle_external;
+}
+
+const char* co2_i2c_get_speed_name(Co2I2cSpeed speed) {
+    switch(speed) {
+    case Co2I2cSpeedFast:
+        return "400 kHz";
+    default:
+        return "100 kHz";
+    }
+}
+
+void co2_i2c_bench_start(Co2I2cBench* bench) {
+    memset(bench, 0, sizeof(Co2I2cBench));
+    bench->running = true;
+    bench->speed = Co2I2cSpeedStandard;
+    SCD4x_setBus(co2_i2c_get_handle(bench->speed));
+}
+
+static void co2_i2c_bench_log(const Co2I2cBench* bench) {
+    for(uint8_t i = 0; i < Co2I2cSpeedNum; i++) {
+        const Co2I2cBenchResult* result = &bench->results[i];
+        furi_log_print_format(
+            FuriLogLevelInfo,
+            "SCD4x",
+            "i2c bench %s: %lu samples, read %lu us avg %lu us max, bus %lu us/sample, %lu errors",
+            co2_i2c_get_speed_name(i),
+            result->samples,
+            result->samples ? result->latency_micros / result->samples : 0,
+            result->latency_max_micros,
+            result->samples ? result->busy_micros / result->samples : 0,
+            result->errors);
+    }
+}
+
+bool co2_i2c_bench_read(Co2I2cBench* bench, Co2I2cSpeed restore) {
+    Co2I2cBenchResult* result = &bench->results[bench->speed];
+    scd4x_bus_stats_t before;
+    scd4x_bus_stats_t after;
+
+    getBusStats(&before);
+    uint32_t start = DWT->CYCCNT;
+    bool fresh = readMeasurement();
+    uint32_t micros = (DWT->CYCCNT - start) / furi_hal_cortex_instructions_per_microsecond();
+    getBusStats(&after);
+
+    result->errors += (after.nacks - before.nacks) + (after.crcFailures - before.crcFailures);
+    if(fresh) {
+        result->samples++;
+        result->latency_micros += micros;
+        result->latency_max_micros = MAX(result->latency_max_micros, micros);
+        result->busy_micros += after.busyMicros - before.busyMicros;
+    }
+
+    if(result->samples >= CO2_I2C_BENCH_SAMPLES || result->errors >= CO2_I2C_BENCH_MAX_ERRORS) {
+        if(bench->speed + 1 < Co2I2cSpeedNum) {
+            bench->speed++;
+        } else {
+            bench->running = false;
+            co2_i2c_bench_log(bench);
+        }
+        SCD4x_setBus(co2_i2c_get_handle(bench->running ? bench->speed : restore));
+    }
+    return fresh;
+}
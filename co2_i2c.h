@@ -0,0 +1,57 @@
+/*
+  Speed of the I2C bus the SCD4x is on, and a benchmark of the sensor reads at each speed.
+
+  The firmware's external bus handle runs at 100 kHz (standard mode). The SCD4x also supports
+  400 kHz (fast mode): co2_i2c_get_handle() returns either the firmware handle or one of the app
+  on the same bus and pins (C0 SCL, C1 SDA) that sets the fast mode timing when it is activated.
+  The other devices on the bus keep using the firmware handle, every acquire sets up the bus for
+  the handle that took it. Long wires, weak pull-ups or a 5 V level shifter may not keep up with
+  fast mode, which shows as NACKs and CRC errors.
+
+  The benchmark takes over the sample reads of the live view: CO2_I2C_BENCH_SAMPLES samples at
+  each speed, timing the whole readMeasurement() call (data-ready poll, command, execution wait,
+  response) and the time spent on the bus per sample (the driver bus statistics). A speed is given
+  up after CO2_I2C_BENCH_MAX_ERRORS failed transfers.
+*/
+
+#ifndef __CO2_I2C_H__
+#define __CO2_I2C_H__
+
+#include <furi.h>
+#include <furi_hal_i2c.h>
+
+#define CO2_I2C_BENCH_SAMPLES 4
+#define CO2_I2C_BENCH_MAX_ERRORS 5
+
+typedef enum {
+    Co2I2cSpeedStandard, // 100 kHz, the firmware handle
+    Co2I2cSpeedFast, // 400 kHz
+    Co2I2cSpeedNum,
+} Co2I2cSpeed;
+
+FuriHalI2cBusHandle* co2_i2c_get_handle(Co2I2cSpeed speed);
+
+const char* co2_i2c_get_speed_name(Co2I2cSpeed speed);
+
+typedef struct {
+    uint32_t samples;
+    uint32_t errors; // NACKs and CRC failures, not-ready polls included
+    uint32_t latency_micros; // readMeasurement() calls that returned a sample, summed
+    uint32_t latency_max_micros;
+    uint32_t busy_micros; // Time on the bus of those calls, summed
+} Co2I2cBenchResult;
+
+typedef struct {
+    bool running;
+    Co2I2cSpeed speed; // Being measured
+    Co2I2cBenchResult results[Co2I2cSpeedNum];
+} Co2I2cBench;
+
+// Start from the slowest speed. The results of the previous run are cleared
+void co2_i2c_bench_start(Co2I2cBench* bench);
+
+// readMeasurement() in place of the live view while running, on the app thread. Once done the
+// driver is switched back to the restore speed
+bool co2_i2c_bench_read(Co2I2cBench* bench, Co2I2cSpeed restore);
+
+#endif
@@ -0,0 +1,45 @@
+#include "co2_logger.h"
+#include <furi_hal_rtc.h>
+#include <core/log.h>
+
+void co2_logger_init(Co2Logger* logger) {
+    memset(logger, 0, sizeof(Co2Logger));
+    co2_blocklog_init(&logger->blocklog);
+}
+
+bool co2_logger_push(Co2Logger* logger, uint16_t co2, uint16_t temperature, uint16_t humidity) {
+    if(logger->count < CO2_LOGGER_BATCH) {
+        Co2BlockSample* sample = &logger->samples[logger->count++];
+        sample->timestamp = furi_hal_rtc_get_timestamp();
+        sample->words[0] = co2;
+        sample->words[1] = temperature;
+        sample->words[2] = humidity;
+    }
+    return logger->count == CO2_LOGGER_BATCH;
+}
+
+bool co2_logger_flush(Co2Logger* logger) {
+    if(logger->count == 0) return true;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_mkdir(storage, CO2_LOGGER_DIR);
+
+    File* file = storage_file_alloc(storage);
+    bool success =
+        storage_file_open(file, CO2_LOGGER_PATH, FSAM_READ_WRITE, FSOM_OPEN_ALWAYS) &&
+        co2_blocklog_write(&logger->blocklog, file, logger->samples, logger->count);
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(success) {
+        logger->logged += logger->count;
+        logger->flushes++;
+    } else {
+        // Drop the batch rather than growing, the next one may succeed
+        logger->errors++;
+        furi_log_print_format(FuriLogLevelError, "SCD4x", "log flush failed");
+    }
+    logger->count = 0;
+    return success;
+}
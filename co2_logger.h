@@ -0,0 +1,37 @@
+/*
+  Batched sample logger.
+
+  Samples are kept in RAM and appended to a binary block log (see co2_blocklog.h) on the SD card
+  once CO2_LOGGER_BATCH of them have been collected, so the card (and the storage service) is only
+  woken every few minutes. tools/co2_log.py converts the log to CSV.
+*/
+
+#ifndef __CO2_LOGGER_H__
+#define __CO2_LOGGER_H__
+
+#include <furi.h>
+#include <storage/storage.h>
+#include "co2_blocklog.h"
+
+#define CO2_LOGGER_DIR EXT_PATH("apps_data/co2_sensor")
+#define CO2_LOGGER_PATH CO2_LOGGER_DIR "/log.bin"
+#define CO2_LOGGER_BATCH 60 // 5 minutes at the 5 s periodic interval
+
+typedef struct {
+    Co2BlockSample samples[CO2_LOGGER_BATCH]; // Raw SCD4x words
+    Co2BlockLog blocklog;
+    uint8_t count;
+    uint32_t flushes;
+    uint32_t logged;
+    uint32_t errors;
+} Co2Logger;
+
+void co2_logger_init(Co2Logger* logger);
+
+// Queue a sample. Returns true when the batch is full and should be flushed
+bool co2_logger_push(Co2Logger* logger, uint16_t co2, uint16_t temperature, uint16_t humidity);
+
+// Append the queued samples to the log file
+bool co2_logger_flush(Co2Logger* logger);
+
+#endif
@@ -0,0 +1,87 @@
+#include "co2_memory.h"
+#include <core/log.h>
+#include "co2_sensor.h"
+
+static Co2Memory co2_memory;
+
+#if CO2_SENSOR_STATIC_ALLOC
+
+#define CO2_MEMORY_ALIGN 8
+#define CO2_MEMORY_SLOT(type) ((sizeof(type) + CO2_MEMORY_ALIGN - 1) & ~(CO2_MEMORY_ALIGN - 1))
+#if CO2_SENSOR_SOAK
+#define CO2_MEMORY_SOAK_SLOT CO2_MEMORY_SLOT(Co2Soak)
+#else
+#define CO2_MEMORY_SOAK_SLOT 0
+#endif
+// Everything co2_memory_alloc() is asked for during a session, add new objects here
+#define CO2_MEMORY_ARENA_SIZE                                                  \
+    (CO2_MEMORY_SLOT(Co2SensorApp) + CO2_MEMORY_SLOT(Co2Frc) +                \
+     CO2_MEMORY_SLOT(Co2SelfTest) + CO2_MEMORY_SLOT(Co2Stream) +               \
+     CO2_MEMORY_SLOT(Co2RadioLink) + CO2_MEMORY_SLOT(Scd4xCapture) +           \
+     CO2_MEMORY_SLOT(Scd4xReplay) + CO2_MEMORY_SOAK_SLOT)
+
+static uint8_t co2_memory_arena[CO2_MEMORY_ARENA_SIZE] __attribute__((aligned(CO2_MEMORY_ALIGN)));
+
+#endif
+
+void co2_memory_begin(void) {
+    memset(&co2_memory, 0, sizeof(Co2Memory));
+    co2_memory.heap_free_start = memmgr_get_free_heap();
+}
+
+void* co2_memory_alloc(size_t size) {
+#if CO2_SENSOR_STATIC_ALLOC
+    size = (size + CO2_MEMORY_ALIGN - 1) & ~(CO2_MEMORY_ALIGN - 1);
+    // An object missing from CO2_MEMORY_ARENA_SIZE, not a runtime condition
+    furi_check(co2_memory.arena_used + size <= CO2_MEMORY_ARENA_SIZE);
+    void* ptr = &co2_memory_arena[co2_memory.arena_used];
+    co2_memory.arena_used += size;
+#else
+    void* ptr = malloc(size);
+#endif
+    co2_memory.used += size;
+    co2_memory.peak = MAX(co2_memory.peak, co2_memory.used);
+    return ptr;
+}
+
+void co2_memory_free(void* ptr, size_t size) {
+#if CO2_SENSOR_STATIC_ALLOC
+    UNUSED(ptr);
+    size = (size + CO2_MEMORY_ALIGN - 1) & ~(CO2_MEMORY_ALIGN - 1);
+#else
+    free(ptr);
+#endif
+    co2_memory.used -= size;
+}
+
+const Co2Memory* co2_memory_get(void) {
+    return &co2_memory;
+}
+
+size_t co2_memory_stack_free(void) {
+    return furi_thread_get_stack_space(furi_thread_get_current_id());
+}
+
+void co2_memory_report(void) {
+    FuriThread* thread = furi_thread_get_current();
+    uint32_t stack_size = furi_thread_get_stack_size(thread);
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "memory: stack %lu/%lu bytes used at most; heap %ld bytes held by the app, %lu bytes free "
+        "at worst since boot; app objects %lu bytes peak (%s)",
+        stack_size - (uint32_t)co2_memory_stack_free(),
+        stack_size,
+        (int32_t)(co2_memory.heap_free_start - memmgr_get_free_heap()),
+        (uint32_t)memmgr_get_minimum_free_heap(),
+        (uint32_t)co2_memory.peak,
+        CO2_SENSOR_STATIC_ALLOC ? "static arena" : "heap");
+#if CO2_SENSOR_STATIC_ALLOC
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "memory: arena %lu/%lu bytes used",
+        (uint32_t)co2_memory.arena_used,
+        (uint32_t)CO2_MEMORY_ARENA_SIZE);
+#endif
+}
@@ -0,0 +1,48 @@
+/*
+  Memory budget of the app.
+
+  The app state and the objects the app allocates itself (FRC and self-test workers, CLI stream,
+  radio link, bus capture and replay) go through co2_memory_alloc(). By default that is the
+  shared heap. Built with CO2_SENSOR_STATIC_ALLOC=1 they come from one static arena instead,
+  sized at compile time for all of them: the loader reserves it with the rest of the app image,
+  so running out of memory can only happen at launch, never halfway through a session. Every
+  object is allocated once and lives until the app exits, so the arena is a simple bump
+  allocator and co2_memory_free() only does the bookkeeping.
+  Firmware objects (threads and their stacks, the view dispatcher and views, stream buffer
+  storage) are always allocated by the firmware.
+
+  co2_memory_report(), called at exit before anything is freed, logs the stack high-water mark
+  of the app thread, the heap held by the app, the lowest free heap of the system since boot and
+  the peak of the app's own objects.
+*/
+
+#ifndef __CO2_MEMORY_H__
+#define __CO2_MEMORY_H__
+
+#include <furi.h>
+
+#ifndef CO2_SENSOR_STATIC_ALLOC
+#define CO2_SENSOR_STATIC_ALLOC 0
+#endif
+
+typedef struct {
+    size_t heap_free_start; // Free heap when the app started
+    size_t used; // Bytes of app objects currently allocated
+    size_t peak;
+    size_t arena_used; // Static mode only: the arena never shrinks
+} Co2Memory;
+
+// Call first thing in the app
+void co2_memory_begin(void);
+
+void* co2_memory_alloc(size_t size);
+void co2_memory_free(void* ptr, size_t size);
+
+const Co2Memory* co2_memory_get(void);
+
+// Stack space left in the worst case, in bytes, for the calling thread
+size_t co2_memory_stack_free(void);
+
+void co2_memory_report(void);
+
+#endif
@@ -0,0 +1,207 @@
+#include "co2_radio.h"
+
+static uint16_t co2_radio_crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < size; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void co2_radio_put16(uint8_t* data, uint16_t value) {
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+static uint16_t co2_radio_get16(const uint8_t* data) {
+    return (uint16_t)data[0] | (uint16_t)data[1] << 8;
+}
+
+uint32_t co2_radio_get_node_id(const char* serial) {
+    // FNV-1a, the 48-bit serial does not fit and its low bits alone may repeat across a batch
+    uint32_t hash = 2166136261U;
+    for(; *serial; serial++) {
+        hash = (hash ^ (uint8_t)*serial) * 16777619U;
+    }
+    return hash;
+}
+
+void co2_radio_encode(uint8_t frame[CO2_RADIO_FRAME_SIZE], const Co2RadioSample* sample) {
+    frame[0] = CO2_RADIO_MAGIC;
+    frame[1] = sample->session;
+    co2_radio_put16(&frame[2], sample->node_id & 0xFFFF);
+    co2_radio_put16(&frame[4], sample->node_id >> 16);
+    co2_radio_put16(&frame[6], sample->sequence);
+    co2_radio_put16(&frame[8], sample->co2);
+    co2_radio_put16(&frame[10], sample->temperature);
+    co2_radio_put16(&frame[12], sample->humidity);
+    co2_radio_put16(&frame[14], co2_radio_crc16(frame, 14));
+}
+
+bool co2_radio_decode(const uint8_t frame[CO2_RADIO_FRAME_SIZE], Co2RadioSample* sample) {
+    if(frame[0] != CO2_RADIO_MAGIC || co2_radio_crc16(frame, 14) != co2_radio_get16(&frame[14])) {
+        return false;
+    }
+    sample->session = frame[1];
+    sample->node_id = (uint32_t)co2_radio_get16(&frame[2]) |
+                      (uint32_t)co2_radio_get16(&frame[4]) << 16;
+    sample->sequence = co2_radio_get16(&frame[6]);
+    sample->co2 = co2_radio_get16(&frame[8]);
+    sample->temperature = co2_radio_get16(&frame[10]);
+    sample->humidity = co2_radio_get16(&frame[12]);
+    return true;
+}
+
+void co2_radio_broadcaster_init(
+    Co2RadioBroadcaster* broadcaster,
+    uint32_t node_id,
+    uint8_t session) {
+    memset(broadcaster, 0, sizeof(Co2RadioBroadcaster));
+    broadcaster->node_id = node_id;
+    broadcaster->session = session;
+}
+
+size_t co2_radio_broadcaster_pack(
+    Co2RadioBroadcaster* broadcaster,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity,
+    uint8_t packet[CO2_RADIO_PACKET_SIZE]) {
+    Co2RadioSample sample = {
+        .node_id = broadcaster->node_id,
+        .session = broadcaster->session,
+        .sequence = broadcaster->sequence++,
+        .co2 = co2,
+        .temperature = temperature,
+        .humidity = humidity,
+    };
+    co2_radio_encode(packet, &sample);
+
+    size_t size = CO2_RADIO_FRAME_SIZE;
+    if(broadcaster->has_previous) {
+        memcpy(&packet[size], broadcaster->previous, CO2_RADIO_FRAME_SIZE);
+        size += CO2_RADIO_FRAME_SIZE;
+    }
+    memcpy(broadcaster->previous, packet, CO2_RADIO_FRAME_SIZE);
+    broadcaster->has_previous = true;
+    broadcaster->sent++;
+    return size;
+}
+
+void co2_radio_collector_init(
+    Co2RadioCollector* collector,
+    Co2RadioSampleCallback callback,
+    void* context) {
+    memset(collector, 0, sizeof(Co2RadioCollector));
+    collector->callback = callback;
+    collector->context = context;
+}
+
+static Co2RadioNode* co2_radio_collector_find(Co2RadioCollector* collector, uint32_t node_id) {
+    for(uint8_t i = 0; i < collector->count; i++) {
+        if(collector->nodes[i].node_id == node_id) return &collector->nodes[i];
+    }
+    return NULL;
+}
+
+// First frame of a node, or of a new session of it
+static void co2_radio_node_start(Co2RadioNode* node, const Co2RadioSample* sample) {
+    node->session = sample->session;
+    node->sequence = sample->sequence;
+    node->window = 1;
+    node->sample = *sample;
+}
+
+Co2RadioResult co2_radio_collector_add(
+    Co2RadioCollector* collector,
+    const Co2RadioSample* sample,
+    uint32_t now) {
+    collector->frames++;
+    Co2RadioResult result = Co2RadioResultNew;
+    Co2RadioNode* node = co2_radio_collector_find(collector, sample->node_id);
+
+    if(!node) {
+        if(collector->count == CO2_RADIO_MAX_NODES) {
+            collector->unknown++;
+            return Co2RadioResultTableFull;
+        }
+        node = &collector->nodes[collector->count++];
+        memset(node, 0, sizeof(Co2RadioNode));
+        node->node_id = sample->node_id;
+        co2_radio_node_start(node, sample);
+    } else if(node->session != sample->session) {
+        // The node restarted, its sequence numbers start over
+        node->restarts++;
+        co2_radio_node_start(node, sample);
+    } else {
+        // Signed distance, right across the 16-bit wrap
+        int16_t distance = (int16_t)(sample->sequence - node->sequence);
+        if(distance > 0) {
+            node->window = distance < CO2_RADIO_DEDUP_WINDOW ? node->window << distance : 0;
+            node->window |= 1;
+            node->lost += distance - 1;
+            node->sequence = sample->sequence;
+            node->sample = *sample;
+        } else if(distance > -CO2_RADIO_DEDUP_WINDOW && !(node->window & (1UL << -distance))) {
+            node->window |= 1UL << -distance;
+            if(node->lost) node->lost--;
+            result = Co2RadioResultLate;
+        } else {
+            // Already seen, or too old to tell
+            node->duplicates++;
+            return Co2RadioResultDuplicate;
+        }
+    }
+
+    node->received++;
+    node->last_tick = now;
+    if(collector->callback) collector->callback(collector->context, sample);
+    return result;
+}
+
+size_t co2_radio_collector_feed(
+    Co2RadioCollector* collector,
+    const uint8_t* data,
+    size_t size,
+    uint32_t now) {
+    size_t added = 0;
+
+    while(size > 0) {
+        // Skip to the next magic while the buffer is empty
+        if(collector->size == 0 && *data != CO2_RADIO_MAGIC) {
+            collector->skipped++;
+            data++;
+            size--;
+            continue;
+        }
+
+        size_t chunk = MIN(size, (size_t)(CO2_RADIO_FRAME_SIZE - collector->size));
+        memcpy(&collector->buffer[collector->size], data, chunk);
+        collector->size += chunk;
+        data += chunk;
+        size -= chunk;
+        if(collector->size < CO2_RADIO_FRAME_SIZE) break;
+
+        Co2RadioSample sample;
+        if(co2_radio_decode(collector->buffer, &sample)) {
+            collector->size = 0;
+            Co2RadioResult result = co2_radio_collector_add(collector, &sample, now);
+            if(result == Co2RadioResultNew || result == Co2RadioResultLate) added++;
+            continue;
+        }
+
+        // Not a frame: drop the magic, keep what follows from the next magic on
+        collector->skipped++;
+        uint8_t next = 1;
+        while(next < CO2_RADIO_FRAME_SIZE && collector->buffer[next] != CO2_RADIO_MAGIC) {
+            next++;
+            collector->skipped++;
+        }
+        collector->size = CO2_RADIO_FRAME_SIZE - next;
+        memmove(collector->buffer, &collector->buffer[next], collector->size);
+    }
+    return added;
+}
@@ -0,0 +1,134 @@
+/*
+  Sample frames for several nodes reporting to one collector over a broadcast radio.
+
+  A broadcast node sends every sample it reads as a fixed-size frame, little-endian:
+    u8 CO2_RADIO_MAGIC, u8 session, u32 node id, u16 sequence, u16 CO2 / T / RH (raw SCD4x words),
+    u16 CRC-16/CCITT (polynomial 0x1021, init 0xFFFF) of the 14 bytes before it.
+  The node id is derived from the sensor serial number, so it survives restarts and needs no
+  setup. The session is picked at random when the node starts: a collector seeing a new session
+  knows the sequence numbers started over.
+
+  There is no acknowledgement. Each packet carries the new frame followed by the previous one, so
+  a frame lost to a collision or fading is still received 5 s later. The collector drops the
+  copies: per node it keeps the newest sequence and a bitmap of the CO2_RADIO_DEDUP_WINDOW
+  sequences before it (like IPsec replay protection), which also accepts frames arriving late and
+  counts the ones that never arrived.
+
+  The collector takes the received bytes as a stream: the parser looks for the magic, checks the
+  CRC and slides one byte on a mismatch, so a truncated or corrupted packet costs its own frames
+  only. Nothing here touches the radio, see co2_radio_link.h.
+*/
+
+#ifndef __CO2_RADIO_H__
+#define __CO2_RADIO_H__
+
+#include <furi.h>
+
+#define CO2_RADIO_MAGIC 0xC2
+#define CO2_RADIO_FRAME_SIZE 16
+#define CO2_RADIO_PACKET_SIZE (2 * CO2_RADIO_FRAME_SIZE) // New frame + repeat of the previous one
+#define CO2_RADIO_MAX_NODES 8
+#define CO2_RADIO_DEDUP_WINDOW 32
+
+typedef struct {
+    uint32_t node_id;
+    uint8_t session;
+    uint16_t sequence;
+    uint16_t co2; // Raw SCD4x words
+    uint16_t temperature;
+    uint16_t humidity;
+} Co2RadioSample;
+
+// Node id of the sensor with this serial number (hex string from getSerialNumber)
+uint32_t co2_radio_get_node_id(const char* serial);
+
+void co2_radio_encode(uint8_t frame[CO2_RADIO_FRAME_SIZE], const Co2RadioSample* sample);
+
+// Returns false if the magic or the CRC do not match
+bool co2_radio_decode(const uint8_t frame[CO2_RADIO_FRAME_SIZE], Co2RadioSample* sample);
+
+// Broadcast side
+
+typedef struct {
+    uint32_t node_id;
+    uint8_t session;
+    uint16_t sequence;
+    uint8_t previous[CO2_RADIO_FRAME_SIZE];
+    bool has_previous;
+    uint32_t sent;
+} Co2RadioBroadcaster;
+
+void co2_radio_broadcaster_init(
+    Co2RadioBroadcaster* broadcaster,
+    uint32_t node_id,
+    uint8_t session);
+
+// Frame a new sample into packet. Returns the packet size
+size_t co2_radio_broadcaster_pack(
+    Co2RadioBroadcaster* broadcaster,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity,
+    uint8_t packet[CO2_RADIO_PACKET_SIZE]);
+
+// Collector side
+
+typedef struct {
+    uint32_t node_id;
+    uint8_t session;
+    uint16_t sequence; // Newest
+    uint32_t window; // Bit n set: sequence - n was received
+    Co2RadioSample sample; // Newest
+    uint32_t last_tick;
+    uint32_t received;
+    uint32_t duplicates;
+    uint32_t lost; // Sequences skipped and not (yet) received late
+    uint32_t restarts;
+} Co2RadioNode;
+
+typedef void (*Co2RadioSampleCallback)(void* context, const Co2RadioSample* sample);
+
+typedef struct {
+    Co2RadioNode nodes[CO2_RADIO_MAX_NODES];
+    uint8_t count;
+
+    // Stream parser
+    uint8_t buffer[CO2_RADIO_FRAME_SIZE];
+    uint8_t size;
+
+    uint32_t frames; // Valid frames, duplicates included
+    uint32_t skipped; // Bytes dropped while looking for a frame
+    uint32_t unknown; // Frames of new nodes dropped, the table was full
+
+    Co2RadioSampleCallback callback;
+    void* context;
+} Co2RadioCollector;
+
+typedef enum {
+    Co2RadioResultNew,
+    Co2RadioResultLate, // New, but older than the newest sequence of its node
+    Co2RadioResultDuplicate,
+    Co2RadioResultTableFull,
+} Co2RadioResult;
+
+// callback is called for every new sample, late ones included
+void co2_radio_collector_init(
+    Co2RadioCollector* collector,
+    Co2RadioSampleCallback callback,
+    void* context);
+
+// Account for a decoded frame received at tick now
+Co2RadioResult co2_radio_collector_add(
+    Co2RadioCollector* collector,
+    const Co2RadioSample* sample,
+    uint32_t now);
+
+// Parse received bytes, which may hold any number of frames or parts of them. Returns the number
+// of new samples
+size_t co2_radio_collector_feed(
+    Co2RadioCollector* collector,
+    const uint8_t* data,
+    size_t size,
+    uint32_t now);
+
+#endif
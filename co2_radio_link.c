@@ -0,0 +1,151 @@
+#include "co2_radio_link.h"
+#include <lib/subghz/devices/cc1101_int/cc1101_int_interconnect.h>
+#include <furi_hal_random.h>
+#include <furi_hal_rtc.h>
+#include <storage/storage.h>
+#include <core/log.h>
+#include "co2_logger.h"
+#include "co2_memory.h"
+#include "scd4x.h"
+
+#define CO2_RADIO_LOG_HEADER "timestamp,node,sequence,co2,temperature,humidity\n"
+#define CO2_RADIO_LOG_LINE_SIZE 64
+
+static bool co2_radio_link_flush(Co2RadioLink* link) {
+    if(link->log_size == 0) return true;
+
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_mkdir(storage, CO2_LOGGER_DIR);
+    bool header = !storage_common_exists(storage, CO2_RADIO_LOG_PATH);
+
+    File* file = storage_file_alloc(storage);
+    bool success = storage_file_open(file, CO2_RADIO_LOG_PATH, FSAM_WRITE, FSOM_OPEN_APPEND);
+    if(success && header) {
+        size_t size = strlen(CO2_RADIO_LOG_HEADER);
+        success = storage_file_write(file, CO2_RADIO_LOG_HEADER, size) == size;
+    }
+    if(success) {
+        success = storage_file_write(file, link->log, link->log_size) == link->log_size;
+    }
+    storage_file_close(file);
+    storage_file_free(file);
+    furi_record_close(RECORD_STORAGE);
+
+    if(!success) {
+        // Drop the lines rather than growing, the next flush may succeed
+        link->log_errors++;
+        furi_log_print_format(FuriLogLevelError, "SCD4x", "radio: node log flush failed");
+    }
+    link->log_size = 0;
+    return success;
+}
+
+// Called by the collector for every new sample
+static void co2_radio_link_log(void* context, const Co2RadioSample* sample) {
+    Co2RadioLink* link = context;
+    if(link->log_size + CO2_RADIO_LOG_LINE_SIZE > CO2_RADIO_LOG_BUFFER_SIZE) {
+        co2_radio_link_flush(link);
+    }
+
+    int size = snprintf(
+        &link->log[link->log_size],
+        CO2_RADIO_LOG_LINE_SIZE,
+        "%lu,%08lX,%u,%u,%.2f,%.1f\n",
+        furi_hal_rtc_get_timestamp(),
+        sample->node_id,
+        sample->sequence,
+        sample->co2,
+        (double)convertTemperature(sample->temperature),
+        (double)convertHumidity(sample->humidity));
+    if(size > 0) link->log_size += MIN((size_t)size, (size_t)CO2_RADIO_LOG_LINE_SIZE - 1);
+    link->logged++;
+}
+
+Co2RadioLink* co2_radio_link_alloc(void) {
+    Co2RadioLink* link = co2_memory_alloc(sizeof(Co2RadioLink));
+    memset(link, 0, sizeof(Co2RadioLink));
+    co2_radio_collector_init(&link->collector, co2_radio_link_log, link);
+    return link;
+}
+
+void co2_radio_link_free(Co2RadioLink* link) {
+    co2_radio_link_stop(link);
+    co2_memory_free(link, sizeof(Co2RadioLink));
+}
+
+bool co2_radio_link_start(Co2RadioLink* link, Co2RadioLinkMode mode, uint32_t node_id) {
+    co2_radio_link_stop(link);
+    if(mode == Co2RadioLinkModeOff) return true;
+
+    subghz_devices_init();
+    link->device = subghz_devices_get_by_name(SUBGHZ_DEVICE_CC1101_INT_NAME);
+    link->worker = subghz_tx_rx_worker_alloc();
+    if(!link->device ||
+       !subghz_tx_rx_worker_start(link->worker, link->device, CO2_RADIO_FREQUENCY)) {
+        furi_log_print_format(
+            FuriLogLevelError, "SCD4x", "radio: %lu Hz not available", CO2_RADIO_FREQUENCY);
+        if(subghz_tx_rx_worker_is_running(link->worker)) {
+            subghz_tx_rx_worker_stop(link->worker);
+        }
+        subghz_tx_rx_worker_free(link->worker);
+        link->worker = NULL;
+        subghz_devices_deinit();
+        return false;
+    }
+
+    // A new session tells the collectors that the sequence numbers start over
+    co2_radio_broadcaster_init(&link->broadcaster, node_id, furi_hal_random_get() & 0xFF);
+    if(mode == Co2RadioLinkModeCollector) {
+        co2_radio_collector_init(&link->collector, co2_radio_link_log, link);
+    }
+    link->mode = mode;
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "radio: %s as node %08lX, session %u",
+        mode == Co2RadioLinkModeCollector ? "collecting" : "broadcasting",
+        node_id,
+        link->broadcaster.session);
+    return true;
+}
+
+void co2_radio_link_stop(Co2RadioLink* link) {
+    if(link->mode == Co2RadioLinkModeOff) return;
+
+    subghz_tx_rx_worker_stop(link->worker);
+    subghz_tx_rx_worker_free(link->worker);
+    link->worker = NULL;
+    subghz_devices_deinit();
+    link->device = NULL;
+
+    co2_radio_link_flush(link);
+    link->mode = Co2RadioLinkModeOff;
+}
+
+void co2_radio_link_send(
+    Co2RadioLink* link,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity) {
+    if(link->mode != Co2RadioLinkModeBroadcast) return;
+
+    uint8_t packet[CO2_RADIO_PACKET_SIZE];
+    size_t size =
+        co2_radio_broadcaster_pack(&link->broadcaster, co2, temperature, humidity, packet);
+    if(!subghz_tx_rx_worker_write(link->worker, packet, size)) link->send_errors++;
+}
+
+size_t co2_radio_link_tick(Co2RadioLink* link, uint32_t now) {
+    if(link->mode == Co2RadioLinkModeOff) return 0;
+
+    // Broadcast nodes hear each other, their packets are drained and dropped
+    uint8_t data[CO2_RADIO_PACKET_SIZE];
+    size_t added = 0;
+    size_t size;
+    while((size = subghz_tx_rx_worker_read(link->worker, data, sizeof(data))) > 0) {
+        if(link->mode == Co2RadioLinkModeCollector) {
+            added += co2_radio_collector_feed(&link->collector, data, size, now);
+        }
+    }
+    return added;
+}
@@ -0,0 +1,70 @@
+/*
+  Sub-GHz link between several nodes running the app, see co2_radio.h for the frames.
+
+  A broadcast node sends every sample it reads; a collector listens, keeps the newest sample of
+  up to CO2_RADIO_MAX_NODES nodes (shown by the nodes scene) and appends every new one to
+  CO2_RADIO_LOG_PATH as CSV. Both run the firmware's Sub-GHz TX/RX worker on the internal CC1101
+  (GFSK, the preset of the Sub-GHz chat) at CO2_RADIO_FREQUENCY, so no extra hardware is needed:
+  the worker thread owns the radio, sending is a non-blocking copy into its TX buffer and the
+  received bytes are drained from its RX buffer on every tick.
+  The log lines are buffered in RAM and written CO2_RADIO_LOG_BUFFER_SIZE bytes at a time, or when
+  the collector stops.
+*/
+
+#ifndef __CO2_RADIO_LINK_H__
+#define __CO2_RADIO_LINK_H__
+
+#include <furi.h>
+#include <lib/subghz/subghz_tx_rx_worker.h>
+#include <lib/subghz/devices/devices.h>
+#include "co2_radio.h"
+
+#define CO2_RADIO_FREQUENCY 433920000UL // Hz, must be allowed in the Flipper's region
+#define CO2_RADIO_LOG_PATH EXT_PATH("apps_data/co2_sensor/nodes.csv")
+#define CO2_RADIO_LOG_BUFFER_SIZE 512
+
+// Same order as Co2SettingsRadio
+typedef enum {
+    Co2RadioLinkModeOff,
+    Co2RadioLinkModeBroadcast,
+    Co2RadioLinkModeCollector,
+} Co2RadioLinkMode;
+
+typedef struct {
+    Co2RadioLinkMode mode;
+    SubGhzTxRxWorker* worker;
+    const SubGhzDevice* device;
+
+    Co2RadioBroadcaster broadcaster;
+    uint32_t send_errors; // Packets dropped, the TX buffer was full
+
+    Co2RadioCollector collector;
+    char log[CO2_RADIO_LOG_BUFFER_SIZE];
+    size_t log_size;
+    uint32_t logged;
+    uint32_t log_errors;
+} Co2RadioLink;
+
+Co2RadioLink* co2_radio_link_alloc(void);
+
+// Stops the link first if it is running
+void co2_radio_link_free(Co2RadioLink* link);
+
+// Start in mode, with the node id and a fresh session. Returns false if the radio could not be
+// started (the frequency is not allowed in the region, for one)
+bool co2_radio_link_start(Co2RadioLink* link, Co2RadioLinkMode mode, uint32_t node_id);
+
+// Stop the worker and flush the collector log. The node table is kept until the next start
+void co2_radio_link_stop(Co2RadioLink* link);
+
+// Broadcast a sample (raw SCD4x words). Does nothing unless broadcasting
+void co2_radio_link_send(
+    Co2RadioLink* link,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity);
+
+// Drain what was received, from the app thread. Returns the number of new samples
+size_t co2_radio_link_tick(Co2RadioLink* link, uint32_t now);
+
+#endif
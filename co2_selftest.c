@@ -0,0 +1,97 @@
+#include "co2_selftest.h"
+#include "scd4x.h"
+#include "co2_settings.h"
+#include "co2_memory.h"
+#include <core/log.h>
+
+// 2.2 KB used at most on the PC, whose printf is heavier, see tests/test_co2_memory.c
+#define CO2_SELFTEST_THREAD_STACK_SIZE (3 * 1024)
+
+static int32_t co2_selftest_worker(void* context) {
+    Co2SelfTest* selftest = context;
+    uint16_t response = 0;
+
+    bool answered = stopPeriodicMeasurement(CO2_SELFTEST_STOP_DELAY_MS) &&
+                    performSelfTestExt(&response);
+    // Measurements are restarted whatever the outcome
+    bool restarted = co2_settings_start(selftest->mode);
+
+    Co2SelfTestState state = Co2SelfTestStatePassed;
+    if(!answered) {
+        state = Co2SelfTestStateNoAnswer;
+    } else if(response != 0) {
+        state = Co2SelfTestStateFailed;
+    }
+
+    furi_log_print_format(
+        state == Co2SelfTestStatePassed ? FuriLogLevelInfo : FuriLogLevelError,
+        "SCD4x",
+        "self-test: %s, response 0x%04X, restart %s",
+        co2_selftest_get_state_name(state),
+        response,
+        restarted ? "ok" : "failed");
+
+    selftest->response = response;
+    selftest->state = state;
+    if(selftest->callback) selftest->callback(selftest->context);
+    return 0;
+}
+
+Co2SelfTest* co2_selftest_alloc(Co2SelfTestCallback callback, void* context) {
+    Co2SelfTest* selftest = co2_memory_alloc(sizeof(Co2SelfTest));
+    memset(selftest, 0, sizeof(Co2SelfTest));
+    selftest->callback = callback;
+    selftest->context = context;
+    selftest->thread = furi_thread_alloc_ex(
+        "Co2SelfTest", CO2_SELFTEST_THREAD_STACK_SIZE, co2_selftest_worker, selftest);
+    return selftest;
+}
+
+void co2_selftest_free(Co2SelfTest* selftest) {
+    // Never leave the sensor stopped behind
+    furi_thread_join(selftest->thread);
+    furi_thread_free(selftest->thread);
+    co2_memory_free(selftest, sizeof(Co2SelfTest));
+}
+
+bool co2_selftest_start(Co2SelfTest* selftest) {
+    if(selftest->state == Co2SelfTestStateRunning) return false;
+
+    // The previous run (if any) has already returned, this only releases it
+    furi_thread_join(selftest->thread);
+    selftest->response = 0;
+    selftest->start_tick = furi_get_tick();
+    selftest->state = Co2SelfTestStateRunning;
+    furi_thread_start(selftest->thread);
+    return true;
+}
+
+bool co2_selftest_is_running(const Co2SelfTest* selftest) {
+    return selftest->state == Co2SelfTestStateRunning;
+}
+
+const char* co2_selftest_get_state_name(Co2SelfTestState state) {
+    switch(state) {
+    case Co2SelfTestStateRunning:
+        return "running";
+    case Co2SelfTestStatePassed:
+        return "passed";
+    case Co2SelfTestStateFailed:
+        return "malfunction";
+    case Co2SelfTestStateNoAnswer:
+        return "no answer";
+    default:
+        return "not run";
+    }
+}
+
+float co2_selftest_get_progress(const Co2SelfTest* selftest) {
+    if(selftest->state != Co2SelfTestStateRunning) {
+        return selftest->state == Co2SelfTestStateIdle ? 0.0f : 1.0f;
+    }
+    uint32_t elapsed = furi_get_tick() - selftest->start_tick;
+    uint32_t duration = furi_ms_to_ticks(CO2_SELFTEST_STOP_DELAY_MS + CO2_SELFTEST_DURATION_MS);
+    float progress = (float)elapsed / (float)duration;
+    // The sensor may take a bit longer than the datasheet says, wait at the end of the bar
+    return progress < 0.99f ? progress : 0.99f;
+}
@@ -0,0 +1,53 @@
+/*
+  Sensor self-test in the background.
+
+  perform_self_test keeps the sensor busy for 10 s, and it only accepts it while the measurements
+  are stopped. co2_selftest_start() runs stop periodic / self-test / restart periodic on a worker
+  thread, so the app stays responsive meanwhile and can show the progress. As with the FRC, the
+  caller must not talk to the sensor until co2_selftest_is_running() returns false again; the
+  callback fires on the worker thread once the sequence is over.
+*/
+
+#ifndef __CO2_SELFTEST_H__
+#define __CO2_SELFTEST_H__
+
+#include <furi.h>
+
+#define CO2_SELFTEST_STOP_DELAY_MS 500 // Datasheet: stop_periodic_measurement execution time
+#define CO2_SELFTEST_DURATION_MS 10000 // Datasheet: perform_self_test execution time
+
+typedef enum {
+    Co2SelfTestStateIdle,
+    Co2SelfTestStateRunning,
+    Co2SelfTestStatePassed,
+    Co2SelfTestStateFailed, // The sensor reported a malfunction, see response
+    Co2SelfTestStateNoAnswer, // The sensor did not answer, or with a bad CRC
+} Co2SelfTestState;
+
+typedef void (*Co2SelfTestCallback)(void* context);
+
+typedef struct {
+    volatile Co2SelfTestState state;
+    uint16_t response; // Sensor answer, 0 if no malfunction was detected
+    uint32_t start_tick;
+    uint8_t mode; // Co2SettingsMode the measurements are restarted in
+
+    FuriThread* thread;
+    Co2SelfTestCallback callback;
+    void* context;
+} Co2SelfTest;
+
+Co2SelfTest* co2_selftest_alloc(Co2SelfTestCallback callback, void* context);
+void co2_selftest_free(Co2SelfTest* selftest);
+
+// Start the sequence. Returns false if it is already running
+bool co2_selftest_start(Co2SelfTest* selftest);
+
+bool co2_selftest_is_running(const Co2SelfTest* selftest);
+
+const char* co2_selftest_get_state_name(Co2SelfTestState state);
+
+// Progress of the running sequence from 0 to 1, estimated from the datasheet execution times
+float co2_selftest_get_progress(const Co2SelfTest* selftest);
+
+#endif
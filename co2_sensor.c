@@ -1,52 +1,299 @@
 /* Flipper App to read the values from a SCD4X Sensor  */
 
-#include <gui/gui.h>
 #include <input/input.h>
-#include <gui/modules/submenu.h>
-#include <gui/modules/dialog_ex.h>
 #include <core/log.h>
-
-#include <notification/notification_messages.h>
+#include <furi_hal_rtc.h>
+#include <furi_hal_version.h>
 
 #include <string.h>
-#include "scd4x.h"
+#include "co2_sensor.h"
+#include "co2_memory.h"
+
+#define SCRATCH_BUFFER_SIZE 16
+
+// Replay captures paced like the original session, set to 0 to replay at full speed
+#ifndef CO2_SENSOR_REPLAY_REALTIME
+#define CO2_SENSOR_REPLAY_REALTIME 1
+#endif
+
+static void render_headless(Canvas* canvas, Co2SensorApp* app) {
+    uint32_t now = furi_get_tick();
+    char buffer[32];
+
+    if(app->headless) {
+        canvas_draw_str(canvas, 2, 30, "Headless logging..");
+        canvas_draw_str(canvas, 2, 42, "Press any key to wake up");
+        return;
+    }
+
+    canvas_draw_str(canvas, 2, 22, "Mode");
+    canvas_draw_str(canvas, 44, 22, "Wakeups/h");
+    canvas_draw_str(canvas, 96, 22, "Battery");
+
+    const PowerStats* stats[] = {&app->power_stats_normal, &app->power_stats_headless};
+    const char* names[] = {"Live", "Headless"};
+    for(uint8_t i = 0; i < COUNT_OF(stats); i++) {
+        uint8_t y = 34 + i * 11;
+        canvas_draw_str(canvas, 2, y, names[i]);
+        snprintf(buffer, sizeof(buffer), "%lu", power_stats_get_wakeups_per_hour(stats[i], now));
+        canvas_draw_str(canvas, 44, y, buffer);
+        float hours = power_stats_get_battery_hours(stats[i]);
+        if(hours > 0) {
+            snprintf(buffer, sizeof(buffer), "%.1fh", (double)hours);
+        } else {
+            snprintf(buffer, sizeof(buffer), "n/a");
+        }
+        canvas_draw_str(canvas, 96, y, buffer);
+    }
+
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "Logged %lu (%lu err)",
+        app->co2_logger.logged,
+        app->co2_logger.errors);
+    canvas_draw_str(canvas, 2, 63, buffer);
+}
+
+static void render_stats(Canvas* canvas, Co2SensorApp* app) {
+    static const char* const channel_names[Co2FilterChannelNum] = {"CO2 ppm", "Temp C", "RH %"};
+    char buffer[32];
+
+    // Copy what is shown, the sampling code keeps updating the statistics meanwhile
+    Co2StatsChannel channel;
+    uint32_t seconds_above[Co2AlarmLevelNum - 1];
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(&app->co2_stats_lock);
+        const Co2StatsDayData* data = &app->co2_stats.days[app->stats_day];
+        memcpy(&channel, &data->channels[app->stats_channel], sizeof(channel));
+        memcpy(seconds_above, data->seconds_above, sizeof(seconds_above));
+    } while(seqlock_read_retry(&app->co2_stats_lock, sequence));
+
+    canvas_draw_str(canvas, 2, 21, channel_names[app->stats_channel]);
+    canvas_draw_str(canvas, 50, 21, app->stats_day == Co2StatsDayToday ? "today" : "yesterday");
+    snprintf(buffer, sizeof(buffer), "n %lu", channel.count);
+    canvas_draw_str_aligned(canvas, 126, 21, AlignRight, AlignBottom, buffer);
+    canvas_draw_line(canvas, 2, 23, 126, 23);
+
+    if(channel.count == 0) {
+        canvas_draw_str(canvas, 2, 40, "No data yet");
+        return;
+    }
+
+    // CO2 in whole ppm, T and RH with one decimal
+    const char* format = app->stats_channel == Co2FilterChannelCO2 ? "%s %.0f" : "%s %.1f";
+    const char* names[] = {"min", "max", "mean", "sd", "p50", "p95"};
+    float values[] = {
+        channel.min,
+        channel.max,
+        channel.mean,
+        co2_stats_get_stddev(&channel),
+        co2_stats_get_quantile(&channel.p50),
+        co2_stats_get_quantile(&channel.p95),
+    };
+    for(uint8_t i = 0; i < COUNT_OF(values); i++) {
+        snprintf(buffer, sizeof(buffer), format, names[i], (double)values[i]);
+        canvas_draw_str(canvas, 2 + (i % 2) * 64, 33 + (i / 2) * 10, buffer);
+    }
+
+    if(app->stats_channel == Co2FilterChannelCO2) {
+        // Time above the elevated / high / critical thresholds, h:mm
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "Above %lu:%02lu %lu:%02lu %lu:%02lu",
+            seconds_above[0] / 3600,
+            seconds_above[0] / 60 % 60,
+            seconds_above[1] / 3600,
+            seconds_above[1] / 60 % 60,
+            seconds_above[2] / 3600,
+            seconds_above[2] / 60 % 60);
+        canvas_draw_str(canvas, 2, 63, buffer);
+    }
+}
+
+static void render_ach(Canvas* canvas, Co2SensorApp* app) {
+    char buffer[32];
+
+    Co2Ach ach;
+    seqlock_read(&app->co2_ach_lock, &ach, &app->co2_ach, sizeof(ach));
+
+    canvas_draw_str(canvas, 2, 21, "Ventilation");
+    canvas_draw_str_aligned(
+        canvas, 126, 21, AlignRight, AlignBottom, ach.decaying ? "CO2 decaying" : "waiting");
+    canvas_draw_line(canvas, 2, 23, 126, 23);
+
+    Co2AchResult result;
+    if(co2_ach_get_current(&ach, &result)) {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "Now %.2f+-%.2f ACH",
+            (double)result.ach,
+            (double)result.error);
+        canvas_draw_str(canvas, 2, 33, buffer);
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "fit %d%%, %lu min",
+            (int)(result.r2 * 100),
+            result.duration / 60);
+        canvas_draw_str(canvas, 2, 42, buffer);
+    } else if(ach.decaying) {
+        canvas_draw_str(canvas, 2, 33, "Fitting the decay..");
+    } else {
+        canvas_draw_str(canvas, 2, 33, "Leave the room ventilated");
+        canvas_draw_str(canvas, 2, 42, "after it was occupied");
+    }
+
+    if(ach.has_result) {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "Last %.2f+-%.2f ACH",
+            (double)ach.result.ach,
+            (double)ach.result.error);
+        canvas_draw_str(canvas, 2, 54, buffer);
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "fit %d%%, %lu min",
+            (int)(ach.result.r2 * 100),
+            ach.result.duration / 60);
+        canvas_draw_str(canvas, 2, 63, buffer);
+    }
+}
 
-#define DATA_BUFFER_SIZE 8
+static void render_frc(Canvas* canvas, Co2SensorApp* app) {
+    Co2Frc* co2_frc = app->co2_frc;
+    char buffer[32];
 
-typedef enum {
-    Initializing,
-    NoSensor,
-    PendingUpdate,
-} SensorStatus;
+    snprintf(buffer, sizeof(buffer), "Calibrate to %u ppm", co2_frc->target);
+    canvas_draw_str(canvas, 2, 21, buffer);
+    canvas_draw_line(canvas, 2, 23, 126, 23);
 
-typedef enum {
-    EventTypeTick,
-    EventTypeKey,
-} EventType;
+    DisplayData data;
+    seqlock_read(&app->display_lock, &data, &app->display_data, sizeof(data));
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "CO2 %u  sd %.1f",
+        data.sample.co2,
+        (double)co2_frc_get_stddev(co2_frc));
+    canvas_draw_str(canvas, 2, 33, buffer);
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "Stable %u/%u  drift %+ld",
+        co2_frc->count,
+        CO2_FRC_WINDOW,
+        co2_frc_get_drift(co2_frc));
+    canvas_draw_str(canvas, 2, 43, buffer);
 
-typedef struct {
-    EventType type;
-    InputEvent input;
-} PluginEvent;
+    switch(co2_frc->state) {
+    case Co2FrcStateMonitoring:
+        if(co2_frc->mode != Co2SettingsModePeriodic) {
+            canvas_draw_str(canvas, 2, 53, "Periodic mode only");
+        } else {
+            canvas_draw_str(
+                canvas,
+                2,
+                53,
+                co2_frc_is_stable(co2_frc) ? "Stable, OK to calibrate" :
+                                             "Waiting for stable CO2..");
+        }
+        canvas_draw_str(canvas, 2, 63, "Up/Down: target");
+        break;
+    case Co2FrcStateRunning:
+        canvas_draw_str(canvas, 2, 53, "Calibrating..");
+        break;
+    case Co2FrcStateDone:
+        snprintf(buffer, sizeof(buffer), "Correction %+.0f ppm", (double)co2_frc->correction);
+        canvas_draw_str(canvas, 2, 53, buffer);
+        break;
+    case Co2FrcStateFailed:
+        canvas_draw_str(canvas, 2, 53, "Calibration failed");
+        break;
+    }
+}
 
-static SensorStatus sensor_current_status = Initializing;
+// 7x8 arrow with its bottom left corner at x, y
+static void render_trend_arrow(Canvas* canvas, uint8_t x, uint8_t y, Co2TrendDirection direction) {
+    switch(direction) {
+    case Co2TrendDirectionRising:
+        canvas_draw_line(canvas, x + 3, y, x + 3, y - 7);
+        canvas_draw_line(canvas, x, y - 4, x + 3, y - 7);
+        canvas_draw_line(canvas, x + 6, y - 4, x + 3, y - 7);
+        break;
+    case Co2TrendDirectionFalling:
+        canvas_draw_line(canvas, x + 3, y - 7, x + 3, y);
+        canvas_draw_line(canvas, x, y - 3, x + 3, y);
+        canvas_draw_line(canvas, x + 6, y - 3, x + 3, y);
+        break;
+    case Co2TrendDirectionSteady:
+        canvas_draw_line(canvas, x, y - 3, x + 6, y - 3);
+        canvas_draw_line(canvas, x + 3, y - 6, x + 6, y - 3);
+        canvas_draw_line(canvas, x + 3, y, x + 6, y - 3);
+        break;
+    default:
+        break;
+    }
+}
 
-// Temperature and Humidity data buffers, ready to print
-char ts_data_buffer_temperature_c[DATA_BUFFER_SIZE];
-char ts_data_buffer_humidity[DATA_BUFFER_SIZE];
-char ts_data_buffer_co2[DATA_BUFFER_SIZE];
+static void render_callback(Canvas* canvas, void* model) {
+    Co2SensorApp* app = ((Co2SensorLiveModel*)model)->app;
+    char scratch[SCRATCH_BUFFER_SIZE];
 
-static void render_callback(Canvas* canvas, void* ctx) {
-    UNUSED(ctx);
+    if(app->key_draw_pending) {
+        app->key_draw_pending = false;
+        app->key_latency_last = furi_get_tick() - app->key_draw_tick;
+        app->key_latency_max = MAX(app->key_latency_max, app->key_latency_last);
+        app->key_latency_sum += app->key_latency_last;
+        app->key_latency_count++;
+    }
 
     canvas_clear(canvas);
     canvas_set_font(canvas, FontPrimary);
     canvas_draw_str(canvas, 2, 10, "CO2 Sensor");
 
     canvas_set_font(canvas, FontSecondary);
+    if(app->replay) {
+        canvas_draw_str(canvas, 64, 10, "RPL");
+    } else if(app->capture && scd4x_capture_is_running(app->capture)) {
+        canvas_draw_str(canvas, 64, 10, "REC");
+    }
+    if(app->barometer.type != BarometerTypeNone && app->pressure_comp.primed) {
+        snprintf(
+            scratch,
+            sizeof(scratch),
+            "%luhPa",
+            (pressure_comp_get_pressure(&app->pressure_comp) + 50) / 100);
+        canvas_draw_str_aligned(canvas, 126, 10, AlignRight, AlignBottom, scratch);
+    }
     //canvas_draw_str(canvas, 2, 62, "Press back to exit.");
 
-    switch(sensor_current_status) {
+    if(app->headless || app->headless_report) {
+        render_headless(canvas, app);
+        return;
+    }
+
+    if(app->frc_screen) {
+        render_frc(canvas, app);
+        return;
+    }
+
+    if(app->ach_screen) {
+        render_ach(canvas, app);
+        return;
+    }
+
+    if(app->stats_screen) {
+        render_stats(canvas, app);
+        return;
+    }
+
+    switch(app->status) {
     case Initializing:
         canvas_draw_str(canvas, 2, 30, "Initializing..");
         break;
@@ -54,9 +301,15 @@ static void render_callback(Canvas* canvas, void* ctx) {
         canvas_draw_str(canvas, 2, 30, "No sensor found!");
         break;
     case PendingUpdate: {
-        canvas_draw_str(canvas, 6, 24, "Temperature");
-        canvas_draw_str(canvas, 6, 38, "Humidity");
-        canvas_draw_str(canvas, 6, 52, "CO2");
+        if(app->comfort_screen) {
+            canvas_draw_str(canvas, 6, 24, "Dew point");
+            canvas_draw_str(canvas, 6, 38, "Abs. hum.");
+            canvas_draw_str(canvas, 6, 52, "Heat index");
+        } else {
+            canvas_draw_str(canvas, 6, 24, "Temperature");
+            canvas_draw_str(canvas, 6, 38, "Humidity");
+            canvas_draw_str(canvas, 6, 52, "CO2");
+        }
 
         //canvas_draw_str(canvas, 80, 24, "Humidity");
 
@@ -69,109 +322,864 @@ static void render_callback(Canvas* canvas, void* ctx) {
         canvas_draw_line(canvas, 3, 41, 144, 41);
 
         // Draw temperature and humidity values
-        canvas_draw_str(canvas, 72, 24, ts_data_buffer_temperature_c);
-        canvas_draw_str(canvas, 102, 24, "C");
-        canvas_draw_str(canvas, 72, 38, ts_data_buffer_humidity);
-        canvas_draw_str(canvas, 102, 38, "%");
-        canvas_draw_str(canvas, 72, 52, ts_data_buffer_co2);
-        canvas_draw_str(canvas, 102, 52, "ppm");
+        DisplayData data;
+        seqlock_read(&app->display_lock, &data, &app->display_data, sizeof(data));
+        if(app->comfort_screen) {
+            snprintf(scratch, sizeof(scratch), "%.1f", (double)data.comfort.dew_point);
+            canvas_draw_str(canvas, 72, 24, scratch);
+            canvas_draw_str(canvas, 102, 24, "C");
+            snprintf(scratch, sizeof(scratch), "%.1f", (double)data.comfort.absolute_humidity);
+            canvas_draw_str(canvas, 72, 38, scratch);
+            canvas_draw_str(canvas, 102, 38, "g/m3");
+            snprintf(scratch, sizeof(scratch), "%.1f", (double)data.comfort.heat_index);
+            canvas_draw_str(canvas, 72, 52, scratch);
+            canvas_draw_str(canvas, 102, 52, "C");
+        } else {
+            snprintf(
+                scratch,
+                sizeof(scratch),
+                "%.2f",
+                (double)convertTemperature(data.sample.temperature));
+            canvas_draw_str(canvas, 72, 24, scratch);
+            canvas_draw_str(canvas, 102, 24, "C");
+            snprintf(
+                scratch, sizeof(scratch), "%.2f", (double)convertHumidity(data.sample.humidity));
+            canvas_draw_str(canvas, 72, 38, scratch);
+            canvas_draw_str(canvas, 102, 38, "%");
+            snprintf(scratch, sizeof(scratch), "%u", data.sample.co2);
+            canvas_draw_str(canvas, 72, 52, scratch);
+            canvas_draw_str(canvas, 102, 52, "ppm");
+            render_trend_arrow(canvas, 120, 52, data.trend.direction);
+        }
 
+        // The forecast takes the place of the filter name while CO2 heads for a threshold
+        if(data.trend.target) {
+            uint32_t minutes = data.trend.eta / 60;
+            if(minutes < 60) {
+                snprintf(scratch, sizeof(scratch), "%u in %lum", data.trend.target, minutes);
+            } else {
+                snprintf(
+                    scratch,
+                    sizeof(scratch),
+                    "%u in %luh%02lu",
+                    data.trend.target,
+                    minutes / 60,
+                    minutes % 60);
+            }
+            canvas_draw_str(canvas, 2, 63, scratch);
+        } else {
+            canvas_draw_str(canvas, 2, 63, "Filter:");
+            canvas_draw_str(canvas, 34, 63, co2_filter_get_name(app->co2_filter.type));
+        }
+
+        if(app->co2_alarm.level != Co2AlarmLevelNormal || app->co2_alarm.rising) {
+            char alarm_str[16];
+            snprintf(
+                alarm_str,
+                sizeof(alarm_str),
+                "%s%s",
+                co2_alarm_get_level_name(app->co2_alarm.level),
+                app->co2_alarm.rising ? " ^" : "");
+            canvas_draw_str_aligned(canvas, 126, 63, AlignRight, AlignBottom, alarm_str);
+        }
     } break;
     default:
         break;
     }
 }
 
-static void timer_callback(void* context) {
-    FuriMessageQueue* event_queue = context;
-    furi_assert(event_queue);
+void co2_sensor_live_update(Co2SensorApp* app) {
+    view_get_model(app->live_view);
+    view_commit_model(app->live_view, true);
+}
 
-    PluginEvent event = {.type = EventTypeTick};
-    furi_message_queue_put(event_queue, &event, 0);
+// Publish the filtered words along with the driver's sample metadata and the metrics derived
+// from them for the renderer. co2 false: a T/RH-only sample, the trend is not fed its held CO2
+static void display_publish(
+    Co2SensorApp* app,
+    const uint16_t filtered[Co2FilterChannelNum],
+    bool co2) {
+    DisplayData data;
+    getLatestSample(&data.sample);
+    data.sample.co2 = filtered[Co2FilterChannelCO2];
+    data.sample.temperature = filtered[Co2FilterChannelTemperature];
+    data.sample.humidity = filtered[Co2FilterChannelHumidity];
+    comfort_compute(
+        &data.comfort,
+        convertTemperature(data.sample.temperature),
+        convertHumidity(data.sample.humidity));
+    if(co2) co2_trend_update(&app->co2_trend, data.sample.co2, furi_get_tick());
+    co2_trend_forecast(
+        &app->co2_trend,
+        app->co2_alarm.thresholds,
+        COUNT_OF(app->co2_alarm.thresholds),
+        &data.trend);
+    seqlock_write(&app->display_lock, &app->display_data, &data, sizeof(data));
 }
 
-static void input_callback(InputEvent* input_event, void* context) {
-    FuriMessageQueue* event_queue = context;
-    furi_assert(event_queue);
+// Hand a fresh unfiltered measurement to the daily statistics, the ventilation estimate, the
+// CLI stream and the radio. A T/RH-only sample (co2 false) only reaches the T/RH statistics and
+// the stream, which passes its flags on
+static void unfiltered_update(
+    Co2SensorApp* app,
+    const uint16_t raw[Co2FilterChannelNum],
+    const scd4x_sample_t* sample,
+    bool co2) {
+    float values[Co2FilterChannelNum] = {
+        raw[Co2FilterChannelCO2],
+        convertTemperature(raw[Co2FilterChannelTemperature]),
+        convertHumidity(raw[Co2FilterChannelHumidity]),
+    };
+    uint32_t timestamp = furi_hal_rtc_get_timestamp();
+    seqlock_write_begin(&app->co2_stats_lock);
+    co2_stats_update(&app->co2_stats, values, co2, timestamp);
+    seqlock_write_end(&app->co2_stats_lock);
 
-    PluginEvent event = {.type = EventTypeKey, .input = *input_event};
-    furi_message_queue_put(event_queue, &event, FuriWaitForever);
+    // The host sees the sensor updates the app missed as well as the samples the stream dropped
+    co2_stream_push(
+        app->co2_stream,
+        raw[Co2FilterChannelCO2],
+        raw[Co2FilterChannelTemperature],
+        raw[Co2FilterChannelHumidity],
+        sample->flags);
+    if(!co2) return;
+
+    seqlock_write_begin(&app->co2_ach_lock);
+    bool ach_result = co2_ach_update(&app->co2_ach, raw[Co2FilterChannelCO2], timestamp);
+    seqlock_write_end(&app->co2_ach_lock);
+    // Outside the write, the renderer would wait for the log meanwhile
+    if(ach_result) {
+        furi_log_print_format(
+            FuriLogLevelInfo,
+            "SCD4x",
+            "ventilation: %.2f +- %.2f ACH, R2 %.2f over %lu s",
+            (double)app->co2_ach.result.ach,
+            (double)app->co2_ach.result.error,
+            (double)app->co2_ach.result.r2,
+            app->co2_ach.result.duration);
+    }
+
+    co2_radio_link_send(
+        app->radio,
+        raw[Co2FilterChannelCO2],
+        raw[Co2FilterChannelTemperature],
+        raw[Co2FilterChannelHumidity]);
 }
 
-int32_t co2_sensor_app(void* p) {
-    UNUSED(p);
-    FuriMessageQueue* event_queue = furi_message_queue_alloc(8, sizeof(PluginEvent));
+// Poll the barometer and push the filtered pressure to the sensor when it moved enough
+static void pressure_comp_poll(Co2SensorApp* app, uint32_t now) {
+    uint32_t pressure;
+    if(!barometer_read_pressure(&app->barometer, &pressure)) {
+        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "barometer read failed");
+        return;
+    }
 
-    // Register callbacks
-    ViewPort* view_port = view_port_alloc();
-    view_port_draw_callback_set(view_port, render_callback, NULL);
-    view_port_input_callback_set(view_port, input_callback, event_queue);
+    if(pressure_comp_feed(&app->pressure_comp, pressure, now)) {
+        uint32_t filtered = pressure_comp_get_pressure(&app->pressure_comp);
+        bool success = setAmbientPressure((float)filtered, 0);
+        pressure_comp_commit(&app->pressure_comp, success, now);
+        furi_log_print_format(
+            FuriLogLevelDebug,
+            "SCD4x",
+            "ambient pressure %lu Pa: %s, %u writes/h",
+            filtered,
+            success ? "ok" : "failed",
+            pressure_comp_get_writes_per_hour(&app->pressure_comp));
+    }
+}
 
-    // Register viewport
-    Gui* gui = furi_record_open(RECORD_GUI);
-    gui_add_view_port(gui, view_port, GuiLayerFullscreen);
+// Pair the raw SCD4x temperature with a reading of the reference thermometer
+static void offset_tuning_feed(Co2SensorApp* app, uint16_t temperature) {
+    float reference;
+    if(!thermometer_read_temperature(&app->thermometer, &reference)) {
+        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "reference thermometer read failed");
+        return;
+    }
+    offset_tuner_feed(
+        &app->offset_tuner, convertTemperature(temperature), reference, furi_get_tick());
+}
 
-    // Custom
-    SCD4x_init(SCD4x_SENSOR_SCD40);
-    enableDebugging();
-    if(!SCD4x_begin(true, false, false)) {
-        sensor_current_status = NoSensor;
-        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "Begin: Fail");
+static void headless_enter(Co2SensorApp* app) {
+    app->headless = true;
+    co2_logger_init(&app->co2_logger);
+    power_stats_reset(&app->power_stats_headless, furi_get_tick());
+
+    // Draw the headless notice once, nothing is redrawn after that
+    co2_sensor_live_update(app);
+    notification_message(app->notifications, &sequence_display_backlight_off);
+
+    // The first wakeups find the data-ready instant, the following ones are aligned to it
+    co2_wake_start(&app->headless_wake, co2_settings_get_interval_ms(&app->settings));
+    furi_timer_start(app->timer, furi_ms_to_ticks(CO2_WAKE_SEARCH_MS));
+}
+
+static void headless_exit(Co2SensorApp* app) {
+    app->headless = false;
+    app->headless_report = true;
+    co2_logger_flush(&app->co2_logger);
 
+    notification_message(app->notifications, &sequence_display_backlight_on);
+    furi_timer_start(app->timer, furi_ms_to_ticks(CO2_SENSOR_TICK_MS));
+    co2_sensor_live_update(app);
+
+    uint32_t now = furi_get_tick();
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "headless: %lu wakeups/h (live %lu), %.1fh battery (live %.1fh), %lu samples logged",
+        power_stats_get_wakeups_per_hour(&app->power_stats_headless, now),
+        power_stats_get_wakeups_per_hour(&app->power_stats_normal, now),
+        (double)power_stats_get_battery_hours(&app->power_stats_headless),
+        (double)power_stats_get_battery_hours(&app->power_stats_normal),
+        app->co2_logger.logged);
+}
+
+// Collect a sample in headless mode and schedule the next wakeup at the next data-ready instant
+static void headless_tick(Co2SensorApp* app) {
+    if(app->status == NoSensor) return;
+
+    if(app->settings.mode == Co2SettingsModeHybrid) {
+        // Woken up exactly when the scheduler has something to do
+        uint32_t now = furi_get_tick();
+        bool fresh = co2_hybrid_step(&app->hybrid, now);
+        furi_timer_start(app->timer, co2_hybrid_get_wait(&app->hybrid, now));
+        if(!fresh) return;
     } else {
-        sensor_current_status = Initializing;
-        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "Begin: OK");
-    }
-
-    // Declare our variables
-    PluginEvent tsEvent;
-    float celsius, humidity = 0.0;
-    uint16_t co2 = 0;
-
-    // Create timer and register its callback
-    FuriTimer* timer = furi_timer_alloc(timer_callback, FuriTimerTypePeriodic, event_queue);
-    furi_timer_start(timer, furi_ms_to_ticks(1000));
-
-    // Used to notify the user by blinking red (error) or blue (fetch successful)
-    NotificationApp* notifications = furi_record_open(RECORD_NOTIFICATION);
-
-    while(1) {
-        furi_check(furi_message_queue_get(event_queue, &tsEvent, FuriWaitForever) == FuriStatusOk);
-
-        // Handle events
-        if(tsEvent.type == EventTypeKey) {
-            // We dont check for type here, we can check the type of keypress like: (event.input.type == InputTypeShort)
-            // Exit on back key
-            if(tsEvent.input.key == InputKeyBack) break;
-
-        } else if(tsEvent.type == EventTypeTick) {
-            // Update sensor data
-            // Fetch data and set the sensor current status accordingly
-            if(readMeasurement()) {
-                furi_log_print_format(FuriLogLevelDebug, "SCD4x", "fresh data available");
-                celsius = getTemperature();
-                humidity = getHumidity();
-                co2 = getCO2();
-                sensor_current_status = PendingUpdate;
-
-                notification_message(notifications, &sequence_blink_blue_100);
-
-                snprintf(ts_data_buffer_temperature_c, DATA_BUFFER_SIZE, "%.2f", (double) celsius);
-                snprintf(ts_data_buffer_humidity, DATA_BUFFER_SIZE, "%.2f", (double) humidity);
-                snprintf(ts_data_buffer_co2, DATA_BUFFER_SIZE, "%d", co2);
+        // On the grid of the sensor updates, not an interval after the end of this read
+        bool fresh = readMeasurement();
+        furi_timer_start(app->timer, co2_wake_update(&app->headless_wake, fresh, furi_get_tick()));
+        if(!fresh) return;
+    }
+
+    uint16_t raw[Co2FilterChannelNum];
+    getRawMeasurement(
+        &raw[Co2FilterChannelCO2],
+        &raw[Co2FilterChannelTemperature],
+        &raw[Co2FilterChannelHumidity]);
+    if(co2_logger_push(
+           &app->co2_logger,
+           raw[Co2FilterChannelCO2],
+           raw[Co2FilterChannelTemperature],
+           raw[Co2FilterChannelHumidity])) {
+        co2_logger_flush(&app->co2_logger);
+    }
+    scd4x_sample_t sample;
+    getLatestSample(&sample);
+    bool co2 = !(sample.flags & SCD4x_SAMPLE_FLAG_RHT_ONLY);
+    unfiltered_update(app, raw, &sample, co2);
+    if(co2) {
+        co2_filter_update(&app->co2_filter, raw, raw);
+    } else {
+        co2_filter_update_rht(&app->co2_filter, raw, raw);
+    }
+    display_publish(app, raw, co2);
+    if(!co2) return;
+
+    // Alarms still notify on transitions
+    uint8_t alarm_events =
+        co2_alarm_update(&app->co2_alarm, raw[Co2FilterChannelCO2], furi_get_tick());
+    if(alarm_events != Co2AlarmEventNone) {
+        co2_alarm_notify(&app->co2_alarm, app->notifications, alarm_events);
+    }
+}
+
+// Read the sensor when it has data and feed everything that depends on the readings
+static void live_tick(Co2SensorApp* app) {
+    // Update sensor data
+    // Fetch data and set the sensor current status accordingly
+    bool fresh;
+    if(app->i2c_bench.running) {
+        fresh = co2_i2c_bench_read(&app->i2c_bench, app->settings.i2c_speed);
+    } else if(app->settings.mode == Co2SettingsModeHybrid) {
+        fresh = co2_hybrid_step(&app->hybrid, furi_get_tick());
+    } else {
+        fresh = readMeasurement();
+    }
+    if(fresh) {
+        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "fresh data available");
+        uint16_t raw[Co2FilterChannelNum];
+        getRawMeasurement(
+            &raw[Co2FilterChannelCO2],
+            &raw[Co2FilterChannelTemperature],
+            &raw[Co2FilterChannelHumidity]);
+        // The T/RH-only shots of the hybrid mode hold the CO2 of the last full one, which the
+        // CO2 consumers already had
+        scd4x_sample_t sample;
+        bool valid = getLatestSample(&sample);
+        bool co2 = !(sample.flags & SCD4x_SAMPLE_FLAG_RHT_ONLY);
+        unfiltered_update(app, raw, &sample, co2);
+        if(app->soak && valid) co2_soak_check(app->soak, &sample);
+        if(co2) co2_frc_feed(app->co2_frc, raw[Co2FilterChannelCO2]);
+        if(app->offset_tuning_active) offset_tuning_feed(app, raw[Co2FilterChannelTemperature]);
+        if(co2) {
+            co2_filter_update(&app->co2_filter, raw, raw);
+        } else {
+            co2_filter_update_rht(&app->co2_filter, raw, raw);
+        }
+        display_publish(app, raw, co2);
+        app->status = PendingUpdate;
+
+        // Alarms only notify on transitions, a fresh sample alone does not
+        uint8_t alarm_events = Co2AlarmEventNone;
+        if(co2) {
+            alarm_events =
+                co2_alarm_update(&app->co2_alarm, raw[Co2FilterChannelCO2], furi_get_tick());
+        }
+        if(alarm_events != Co2AlarmEventNone) {
+            co2_alarm_notify(&app->co2_alarm, app->notifications, alarm_events);
+        }
+
+        co2_sensor_live_update(app);
+    }
+}
+
+static bool co2_sensor_is_worker_running(Co2SensorApp* app) {
+    return co2_frc_is_running(app->co2_frc) || co2_selftest_is_running(app->selftest);
+}
+
+static void sensor_tick(Co2SensorApp* app) {
+    PowerStats* power_stats = app->headless ? &app->power_stats_headless :
+                                              &app->power_stats_normal;
+    power_stats_wakeup(power_stats, furi_get_tick());
+
+    // The radio does not need the sensor, a collector works without one
+    co2_radio_link_tick(app->radio, furi_get_tick());
+
+    // The FRC and self-test workers own the sensor until their sequence is over
+    if(co2_sensor_is_worker_running(app)) {
+        app->worker_pending = true;
+        return;
+    }
+    if(app->worker_pending) {
+        // Readings jump by the FRC correction and the self-test left a gap, restart the
+        // smoothing from scratch
+        app->worker_pending = false;
+        co2_filter_init(&app->co2_filter, app->co2_filter.type);
+        co2_hybrid_start(&app->hybrid);
+    }
+
+    if(app->headless) {
+        headless_tick(app);
+    } else {
+        live_tick(app);
+    }
+
+    if(app->status == NoSensor) return;
+    uint32_t now = furi_get_tick();
+    // Not during a hybrid shot, the sensor would refuse the pressure. A barometer that keeps
+    // failing before its first pressure is retried at the poll interval too, not every tick
+    if(app->barometer.type != BarometerTypeNone && !co2_sensor_is_busy(app) &&
+       now - app->pressure_poll_tick >= furi_ms_to_ticks(PRESSURE_COMP_POLL_INTERVAL_MS)) {
+        app->pressure_poll_tick = now;
+        pressure_comp_poll(app, now);
+    }
+}
+
+bool co2_sensor_is_busy(Co2SensorApp* app) {
+    return co2_sensor_is_worker_running(app) ||
+           (app->settings.mode == Co2SettingsModeHybrid &&
+            app->hybrid.pending != Co2HybridShotNone);
+}
+
+// (Re)start the radio in the role of the settings. On failure the setting is kept (it is what
+// the user asked for) and the nodes scene says the link is off
+static void radio_start(Co2SensorApp* app) {
+    // The node id follows the sensor, or the Flipper if it has none
+    const char* name = app->serial[0] ? app->serial : furi_hal_version_get_name_ptr();
+    app->radio_failed = !co2_radio_link_start(
+        app->radio, (Co2RadioLinkMode)app->settings.radio, co2_radio_get_node_id(name));
+}
+
+void co2_sensor_apply_settings(Co2SensorApp* app) {
+    bool radio_changed = app->settings.radio != app->settings_pending.radio;
+    bool i2c_changed = app->settings.i2c_speed != app->settings_pending.i2c_speed;
+    bool sensor_changed = !co2_settings_equal(&app->settings, &app->settings_pending);
+    if(!radio_changed && !i2c_changed && !sensor_changed) return;
+
+    if(radio_changed) {
+        app->settings.radio = app->settings_pending.radio;
+        radio_start(app);
+    }
+    if(i2c_changed) {
+        // A running benchmark switches to it once done
+        app->settings.i2c_speed = app->settings_pending.i2c_speed;
+        if(!app->i2c_bench.running) SCD4x_setBus(co2_i2c_get_handle(app->settings.i2c_speed));
+    }
+    if(sensor_changed && app->status != NoSensor) {
+        // The settings screen left the schedule running, a shot may be under way
+        co2_hybrid_finish(&app->hybrid);
+        co2_settings_apply(&app->settings, &app->settings_pending, true);
+        app->co2_frc->mode = app->settings.mode;
+        app->selftest->mode = app->settings.mode;
+        co2_hybrid_start(&app->hybrid);
+        // The readings move with the offset, restart the smoothing from scratch
+        co2_filter_init(&app->co2_filter, app->co2_filter.type);
+    }
+    co2_settings_save(&app->settings_pending);
+}
+
+static void key_view_update(Co2SensorApp* app, uint32_t tick) {
+    app->key_draw_tick = tick;
+    app->key_draw_pending = true;
+    co2_sensor_live_update(app);
+}
+
+// Runs on the FRC worker thread once the sequence is over
+static void frc_callback(void* context) {
+    Co2SensorApp* app = context;
+    co2_sensor_live_update(app);
+}
+
+// Runs on the self-test worker thread once the sequence is over
+static void selftest_callback(void* context) {
+    Co2SensorApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, Co2SensorEventSelfTestDone);
+}
+
+// Keys on the FRC screen. Nothing else is reachable from there, in particular nothing that
+// talks to the sensor while the calibration sequence owns it
+static void frc_input(Co2SensorApp* app, const InputEvent* event, uint32_t tick) {
+    Co2Frc* co2_frc = app->co2_frc;
+    if(event->type != InputTypeShort || co2_frc_is_running(co2_frc)) return;
+
+    switch(event->key) {
+    case InputKeyBack:
+        app->frc_screen = false;
+        break;
+    case InputKeyOk:
+        if(co2_frc->state != Co2FrcStateMonitoring) {
+            co2_frc_reset(co2_frc);
+        } else if(!co2_sensor_is_busy(app)) {
+            // Not during a hybrid shot, the sequence starts with a stop
+            co2_frc_start(co2_frc);
+        }
+        break;
+    case InputKeyUp:
+        co2_frc->target += CO2_FRC_TARGET_STEP_PPM;
+        break;
+    case InputKeyDown:
+        if(co2_frc->target > CO2_FRC_TARGET_STEP_PPM) co2_frc->target -= CO2_FRC_TARGET_STEP_PPM;
+        break;
+    default:
+        return;
+    }
+    key_view_update(app, tick);
+}
+
+// Start or stop recording the sensor bus traffic to SCD4x_CAPTURE_PATH
+static void capture_toggle(Co2SensorApp* app) {
+    if(!app->capture) app->capture = scd4x_capture_alloc(&scd4x_i2c_transport);
+
+    if(scd4x_capture_is_running(app->capture)) {
+        SCD4x_setTransport(NULL);
+        scd4x_capture_stop(app->capture);
+    } else if(scd4x_capture_start(app->capture, SCD4x_CAPTURE_PATH)) {
+        SCD4x_setTransport(&app->capture->transport);
+    }
+}
+
+// Input service thread: stamp the key and return, whatever the app is doing. A stamp still
+// unmatched CO2_SENSOR_INPUT_STAMPS keys later is overwritten, the live view counts it lost
+static void input_events_callback(const void* message, void* context) {
+    Co2SensorApp* app = context;
+    const InputEvent* event = message;
+    uint32_t published = app->input_published;
+    Co2SensorInputStamp* stamp = &app->input_stamps[published % CO2_SENSOR_INPUT_STAMPS];
+    stamp->sequence = event->sequence;
+    stamp->key = event->key;
+    stamp->type = event->type;
+    stamp->tick = furi_get_tick();
+    __atomic_store_n(&app->input_published, published + 1, __ATOMIC_RELEASE);
+}
+
+// When the input service published the key the live view got, now if it has no stamp. Tracks
+// the backlog behind it and the keys before it that never got here
+static uint32_t live_input_stamp(Co2SensorApp* app, const InputEvent* event, uint32_t now) {
+    uint32_t published = __atomic_load_n(&app->input_published, __ATOMIC_ACQUIRE);
+    if(published - app->input_matched > CO2_SENSOR_INPUT_STAMPS) {
+        app->input_lost += published - app->input_matched - CO2_SENSOR_INPUT_STAMPS;
+        app->input_matched = published - CO2_SENSOR_INPUT_STAMPS;
+    }
+
+    for(uint32_t i = app->input_matched; i != published; i++) {
+        Co2SensorInputStamp stamp = app->input_stamps[i % CO2_SENSOR_INPUT_STAMPS];
+        // Skip a stamp the input service overwrote while it was copied
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t newest = __atomic_load_n(&app->input_published, __ATOMIC_RELAXED);
+        if(newest - i > CO2_SENSOR_INPUT_STAMPS) continue;
+        if(stamp.sequence != event->sequence || stamp.key != event->key ||
+           stamp.type != event->type) {
+            continue;
+        }
+        app->input_lost += i - app->input_matched;
+        app->input_matched = i + 1;
+        app->input_backlog_max = MAX(app->input_backlog_max, published - app->input_matched);
+        return stamp.tick;
+    }
+    return now;
+}
+
+// Keys published while another view was shown went there, they are neither backlog nor lost
+static void live_enter_callback(void* context) {
+    Co2SensorApp* app = context;
+    app->input_matched = __atomic_load_n(&app->input_published, __ATOMIC_ACQUIRE);
+}
+
+// Keys of the live view. Returns false for Back on the live values, which leaves the app
+static bool live_input_callback(InputEvent* event, void* context) {
+    Co2SensorApp* app = context;
+    uint32_t now = furi_get_tick();
+    uint32_t tick = live_input_stamp(app, event, now);
+    PowerStats* power_stats = app->headless ? &app->power_stats_headless :
+                                              &app->power_stats_normal;
+    power_stats_wakeup(power_stats, now);
+
+    if(app->headless) {
+        // Any key wakes the app up, the sensor is only polled at data-ready instants
+        if(event->type == InputTypeShort) headless_exit(app);
+        return true;
+    }
+
+    if(app->headless_report) {
+        // Dismiss the power report
+        if(event->type == InputTypeShort) {
+            app->headless_report = false;
+            key_view_update(app, tick);
+        }
+        return true;
+    }
+
+    if(app->frc_screen) {
+        frc_input(app, event, tick);
+        return true;
+    }
+
+    if(event->key == InputKeyBack) {
+        // Back leaves the stats and ventilation screens for the live values, the app from there
+        if(!app->stats_screen && !app->ach_screen) return false;
+        if(event->type == InputTypeShort) {
+            app->stats_screen = false;
+            app->ach_screen = false;
+            key_view_update(app, tick);
+        }
+        return true;
+    }
+
+    // Cycle through the filters, the new one starts from scratch
+    if(event->key == InputKeyOk && event->type == InputTypeShort) {
+        co2_filter_init(&app->co2_filter, (app->co2_filter.type + 1) % Co2FilterTypeNum);
+        key_view_update(app, tick);
+    }
+
+    if(event->key == InputKeyOk && event->type == InputTypeLong) {
+        headless_enter(app);
+    }
+
+    if(event->key == InputKeyUp && event->type == InputTypeLong && !app->replay) {
+        capture_toggle(app);
+        key_view_update(app, tick);
+    }
+
+    if(SCD4x_ENABLE_FRC && event->key == InputKeyDown && event->type == InputTypeLong &&
+       app->status != NoSensor && !co2_selftest_is_running(app->selftest)) {
+        app->frc_screen = true;
+        if(app->co2_frc->state != Co2FrcStateMonitoring) co2_frc_reset(app->co2_frc);
+        key_view_update(app, tick);
+    }
+
+    if(event->key == InputKeyLeft && event->type == InputTypeLong) {
+        app->ach_screen = true;
+        key_view_update(app, tick);
+    }
+
+    if(event->key == InputKeyRight && event->type == InputTypeLong) {
+        scene_manager_next_scene(app->scene_manager, Co2SensorSceneMenu);
+    }
+
+    if(event->key == InputKeyUp && event->type == InputTypeShort) {
+        app->comfort_screen = !app->comfort_screen;
+        key_view_update(app, tick);
+    }
+
+    // Right opens the stats screen and cycles the channels, Left goes back to live values
+    if(event->type == InputTypeShort && app->ach_screen) {
+        if(event->key == InputKeyLeft) {
+            app->ach_screen = false;
+            key_view_update(app, tick);
+        }
+    } else if(event->type == InputTypeShort) {
+        if(event->key == InputKeyRight) {
+            if(app->stats_screen) {
+                app->stats_channel = (app->stats_channel + 1) % Co2FilterChannelNum;
+            } else {
+                app->stats_screen = true;
+                app->stats_channel = Co2FilterChannelCO2;
             }
+            key_view_update(app, tick);
+        } else if(event->key == InputKeyLeft && app->stats_screen) {
+            app->stats_screen = false;
+            key_view_update(app, tick);
+        } else if(event->key == InputKeyDown && app->stats_screen) {
+            app->stats_day = (app->stats_day + 1) % Co2StatsDayNum;
+            key_view_update(app, tick);
         }
-        furi_delay_tick(furi_ms_to_ticks(100));
     }
+    return true;
+}
+
+// Timer service thread, which runs every timer of the system: never waits for the dispatcher
+static void timer_callback(void* context) {
+    Co2SensorApp* app = context;
+    furi_assert(app);
+
+    // Coalesce: a tick still waiting in the queue will do the same work. Only this callback puts,
+    // a queue with room keeps it until the put
+    bool coalesced = furi_message_queue_get_space(app->tick_queue) == 0;
+    if(app->soak) co2_soak_tick_posted(app->soak, coalesced);
+    if(coalesced) {
+        app->ticks_coalesced++;
+        return;
+    }
+    uint8_t tick = 0;
+    furi_message_queue_put(app->tick_queue, &tick, 0);
+}
+
+// Ticks are handled on the dispatcher's event loop whatever the scene, then the scene gets them
+static void tick_queue_callback(FuriEventLoopObject* object, void* context) {
+    Co2SensorApp* app = context;
+    uint8_t tick;
+    furi_check(furi_message_queue_get(object, &tick, 0) == FuriStatusOk);
+    if(app->soak) co2_soak_tick_handled(app->soak);
+    sensor_tick(app);
+    scene_manager_handle_custom_event(app->scene_manager, Co2SensorEventTick);
+}
+
+static bool custom_event_callback(void* context, uint32_t event) {
+    Co2SensorApp* app = context;
+    return scene_manager_handle_custom_event(app->scene_manager, event);
+}
+
+static bool navigation_event_callback(void* context) {
+    Co2SensorApp* app = context;
+    return scene_manager_handle_back_event(app->scene_manager);
+}
+
+// Bring the sensor up with the saved settings. Everything is written while the measurements are
+// still stopped after SCD4x_begin, then they are started once
+static void sensor_start(Co2SensorApp* app) {
+    Co2Settings saved;
+    co2_settings_load(&saved);
+    app->settings = saved;
+
+    SCD4x_init(saved.sensor_type);
+    SCD4x_setBus(co2_i2c_get_handle(saved.i2c_speed));
+    enableDebugging();
+    if(!SCD4x_begin(false, saved.asc, false)) {
+        app->status = NoSensor;
+        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "Begin: Fail");
+        return;
+    }
+
+    app->status = Initializing;
+    furi_log_print_format(FuriLogLevelDebug, "SCD4x", "Begin: OK");
+    // The sensor type setting is only needed by SCD40 firmwares that do not report their variant.
+    // co2_settings_apply switches the driver to the detected one
+    scd4x_sensor_type_e variant;
+    if(getSensorVariant(&variant) && variant != saved.sensor_type) {
+        furi_log_print_format(
+            FuriLogLevelInfo, "SCD4x", "sensor: SCD4%d detected", variant == SCD4x_SENSOR_SCD41);
+        saved.sensor_type = variant;
+    }
+    scd4x_config_t config;
+    if(co2_settings_read(&app->settings, &config)) {
+        snprintf(app->serial, sizeof(app->serial), "%s", config.serialNumber);
+    } else {
+        // Unknown, make offset and altitude differ so that both are written. ASC was set by
+        // SCD4x_begin
+        app->serial[0] = '\0';
+        app->settings.temperature_offset = -1;
+        app->settings.altitude = UINT16_MAX;
+    }
+    co2_settings_apply(&app->settings, &saved, false);
+    co2_hybrid_start(&app->hybrid);
+}
+
+static Co2SensorApp* co2_sensor_app_alloc(void) {
+    Co2SensorApp* app = co2_memory_alloc(sizeof(Co2SensorApp));
+    memset(app, 0, sizeof(Co2SensorApp));
+    app->status = Initializing;
+    app->stats_channel = Co2FilterChannelCO2;
+    app->stats_day = Co2StatsDayToday;
+
+    app->gui = furi_record_open(RECORD_GUI);
+    app->notifications = furi_record_open(RECORD_NOTIFICATION);
+
+    app->view_dispatcher = view_dispatcher_alloc();
+    app->scene_manager = scene_manager_alloc(&co2_sensor_scene_handlers, app);
+    view_dispatcher_set_event_callback_context(app->view_dispatcher, app);
+    view_dispatcher_set_custom_event_callback(app->view_dispatcher, custom_event_callback);
+    view_dispatcher_set_navigation_event_callback(
+        app->view_dispatcher, navigation_event_callback);
+    view_dispatcher_attach_to_gui(app->view_dispatcher, app->gui, ViewDispatcherTypeFullscreen);
+
+    app->live_view = view_alloc();
+    view_allocate_model(app->live_view, ViewModelTypeLockFree, sizeof(Co2SensorLiveModel));
+    Co2SensorLiveModel* model = view_get_model(app->live_view);
+    model->app = app;
+    view_commit_model(app->live_view, false);
+    view_set_context(app->live_view, app);
+    view_set_draw_callback(app->live_view, render_callback);
+    view_set_input_callback(app->live_view, live_input_callback);
+    view_set_enter_callback(app->live_view, live_enter_callback);
+    view_dispatcher_add_view(app->view_dispatcher, Co2SensorViewLive, app->live_view);
+    app->input_events = furi_record_open(RECORD_INPUT_EVENTS);
+    app->input_subscription = furi_pubsub_subscribe(app->input_events, input_events_callback, app);
+
+    app->menu = submenu_alloc();
+    view_dispatcher_add_view(app->view_dispatcher, Co2SensorViewMenu, submenu_get_view(app->menu));
+
+    app->tick_queue = furi_message_queue_alloc(1, sizeof(uint8_t));
+    furi_event_loop_subscribe_message_queue(
+        view_dispatcher_get_event_loop(app->view_dispatcher),
+        app->tick_queue,
+        FuriEventLoopEventIn,
+        tick_queue_callback,
+        app);
+    app->timer = furi_timer_alloc(timer_callback, FuriTimerTypePeriodic, app);
+    return app;
+}
+
+static void co2_sensor_app_free(Co2SensorApp* app) {
+    // Stopped when the dispatcher returned, and freed before the queue it sends ticks to
+    furi_timer_free(app->timer);
+    furi_event_loop_unsubscribe(
+        view_dispatcher_get_event_loop(app->view_dispatcher), app->tick_queue);
+    furi_message_queue_free(app->tick_queue);
+    furi_pubsub_unsubscribe(app->input_events, app->input_subscription);
+    furi_record_close(RECORD_INPUT_EVENTS);
 
     // Dobby is freee (free our variables, Flipper will crash if we don't do this!)
-    furi_timer_free(timer);
-    gui_remove_view_port(gui, view_port);
-    view_port_free(view_port);
-    furi_message_queue_free(event_queue);
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewMenu);
+    submenu_free(app->menu);
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewLive);
+    view_free(app->live_view);
+    view_dispatcher_free(app->view_dispatcher);
+    scene_manager_free(app->scene_manager);
 
     furi_record_close(RECORD_NOTIFICATION);
     furi_record_close(RECORD_GUI);
+    co2_memory_free(app, sizeof(Co2SensorApp));
+}
+
+int32_t co2_sensor_app(void* p) {
+    UNUSED(p);
+    co2_memory_begin();
+    Co2SensorApp* app = co2_sensor_app_alloc();
+
+    // A capture saved as replay.bin stands in for the sensor, from SCD4x_begin onwards
+    Storage* storage = furi_record_open(RECORD_STORAGE);
+    storage_simply_mkdir(storage, CO2_LOGGER_DIR);
+    bool replay_available = storage_common_exists(storage, SCD4x_REPLAY_PATH);
+    furi_record_close(RECORD_STORAGE);
+    // The soak build always runs against its simulated sensor
+    if(CO2_SENSOR_SOAK) {
+        app->soak = co2_soak_alloc(CO2_SENSOR_TICK_MS);
+        SCD4x_setTransport(&app->soak->transport);
+    } else if(replay_available) {
+        app->replay = scd4x_replay_alloc(CO2_SENSOR_REPLAY_REALTIME);
+        if(scd4x_replay_open(app->replay, SCD4x_REPLAY_PATH)) {
+            SCD4x_setTransport(&app->replay->transport);
+        } else {
+            scd4x_replay_free(app->replay);
+            app->replay = NULL;
+        }
+    }
+
+    sensor_start(app);
+
+    // The barometer is optional, without it the sensor keeps using its altitude setting
+    barometer_probe(&app->barometer);
+    // So is the reference thermometer, only needed to tune the temperature offset
+    thermometer_probe(&app->thermometer);
+    pressure_comp_reset(&app->pressure_comp, furi_get_tick());
+    // First poll on the first tick
+    app->pressure_poll_tick = furi_get_tick() - furi_ms_to_ticks(PRESSURE_COMP_POLL_INTERVAL_MS);
+
+    co2_filter_init(&app->co2_filter, Co2FilterTypeEMA);
+    co2_alarm_init(&app->co2_alarm);
+    co2_trend_init(&app->co2_trend);
+    co2_stats_init(&app->co2_stats, app->co2_alarm.thresholds);
+    co2_ach_init(&app->co2_ach, CO2_ACH_OUTDOOR_PPM);
+    app->co2_frc = co2_frc_alloc(frc_callback, app);
+    app->co2_frc->mode = app->settings.mode;
+    app->selftest = co2_selftest_alloc(selftest_callback, app);
+    app->selftest->mode = app->settings.mode;
+    app->co2_stream = co2_stream_alloc();
+    app->radio = co2_radio_link_alloc();
+    radio_start(app);
+    power_stats_reset(&app->power_stats_normal, furi_get_tick());
+    power_stats_reset(&app->power_stats_headless, furi_get_tick());
+
+    furi_timer_start(app->timer, furi_ms_to_ticks(CO2_SENSOR_TICK_MS));
+    scene_manager_next_scene(app->scene_manager, Co2SensorSceneLive);
+    view_dispatcher_run(app->view_dispatcher);
+    furi_timer_stop(app->timer);
+
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "event loop: key latency %lu ms last, %lu ms avg, %lu ms max; key backlog %lu max, "
+        "%lu keys lost, %lu ticks coalesced",
+        app->key_latency_last,
+        app->key_latency_count ? app->key_latency_sum / app->key_latency_count : 0,
+        app->key_latency_max,
+        app->input_backlog_max,
+        app->input_lost,
+        app->ticks_coalesced);
+    scd4x_timing_stats_t timing;
+    getTimingStats(&timing);
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "sampling: %lu samples, %lu updates dropped, %lu off the grid, latency %lu ms max",
+        timing.samples,
+        timing.dropped,
+        timing.offGrid,
+        timing.latencyMaxMillis);
+    if(app->hybrid.co2_samples || app->hybrid.failures) {
+        furi_log_print_format(
+            FuriLogLevelInfo,
+            "SCD4x",
+            "hybrid: %lu CO2 and %lu T/RH-only samples, %lu failed shots",
+            app->hybrid.co2_samples,
+            app->hybrid.rht_samples,
+            app->hybrid.failures);
+    }
+    co2_memory_report();
+    if(app->soak) co2_soak_report(app->soak);
+    if(app->co2_frc->stack_free) {
+        furi_log_print_format(
+            FuriLogLevelInfo,
+            "SCD4x",
+            "memory: FRC worker stack %lu bytes left at worst",
+            app->co2_frc->stack_free);
+    }
+
+    if(app->headless) {
+        co2_logger_flush(&app->co2_logger);
+        notification_message(app->notifications, &sequence_display_backlight_on);
+    }
+
+    co2_frc_free(app->co2_frc);
+    co2_selftest_free(app->selftest);
+    co2_stream_free(app->co2_stream);
+    co2_radio_link_free(app->radio);
+    SCD4x_setTransport(NULL);
+    SCD4x_setBus(NULL);
+    if(app->capture) scd4x_capture_free(app->capture);
+    if(app->replay) scd4x_replay_free(app->replay);
+    if(app->soak) co2_soak_free(app->soak);
 
+    co2_sensor_app_free(app);
     return 0;
 }
@@ -0,0 +1,232 @@
+/*
+  State of the CO2 sensor app, shared by its scenes.
+
+  The app runs on a view dispatcher: the live scene shows the readings (and the stats, ventilation,
+  recalibration and headless screens, all drawn by the live view), a menu leads to the settings,
+  diagnostics, offset tuning and radio nodes scenes. Sampling does not depend on the scene: the
+  timer ticks reach the dispatcher's event loop through a one-slot queue and are handled before
+  the scene gets to see them as a custom event.
+  The live view and the menu live as long as the app, the other views only while their scene is
+  shown.
+*/
+
+#ifndef __CO2_SENSOR_H__
+#define __CO2_SENSOR_H__
+
+#include <gui/gui.h>
+#include <input/input.h>
+#include <gui/view_dispatcher.h>
+#include <gui/scene_manager.h>
+#include <gui/modules/submenu.h>
+#include <gui/modules/variable_item_list.h>
+#include <notification/notification_messages.h>
+
+#include "scd4x.h"
+#include "barometer.h"
+#include "thermometer.h"
+#include "pressure_comp.h"
+#include "offset_tuner.h"
+#include "co2_filter.h"
+#include "co2_alarm.h"
+#include "co2_logger.h"
+#include "co2_stats.h"
+#include "co2_frc.h"
+#include "co2_selftest.h"
+#include "co2_ach.h"
+#include "co2_trend.h"
+#include "comfort.h"
+#include "co2_stream.h"
+#include "co2_radio_link.h"
+#include "co2_i2c.h"
+#include "co2_hybrid.h"
+#include "co2_wake.h"
+#include "co2_settings.h"
+#include "power_stats.h"
+#include "scd4x_capture.h"
+#include "co2_soak.h"
+#include "seqlock.h"
+#include "scenes/co2_sensor_scene.h"
+
+// Sampling tick, a fifth of the signal update interval
+#define CO2_SENSOR_TICK_MS (SCD4x_PERIODIC_INTERVAL_MS / 5)
+// Keys timestamped by the input service and not yet matched by the live view, more than the GUI
+// and view dispatcher queues hold between them
+#define CO2_SENSOR_INPUT_STAMPS 32
+
+typedef enum {
+    Co2SensorViewLive,
+    Co2SensorViewMenu,
+    Co2SensorViewSettings,
+    Co2SensorViewDiagnostics,
+    Co2SensorViewOffsetTuning,
+    Co2SensorViewNodes,
+} Co2SensorView;
+
+typedef enum {
+    Co2SensorEventTick,
+    Co2SensorEventMenuSettings,
+    Co2SensorEventMenuDiagnostics,
+    Co2SensorEventMenuOffsetTuning,
+    Co2SensorEventMenuNodes,
+    Co2SensorEventSelfTestDone,
+} Co2SensorEvent;
+
+typedef enum {
+    Initializing,
+    NoSensor,
+    PendingUpdate,
+} SensorStatus;
+
+// Filtered sample and its derived metrics, published by the sampling code and read by the
+// renderer, formatted at draw time
+typedef struct {
+    scd4x_sample_t sample;
+    ComfortMetrics comfort;
+    Co2TrendForecast trend;
+} DisplayData;
+
+// A key as the input service published it
+typedef struct {
+    uint32_t sequence;
+    InputKey key;
+    InputType type;
+    uint32_t tick;
+} Co2SensorInputStamp;
+
+typedef struct {
+    Gui* gui;
+    ViewDispatcher* view_dispatcher;
+    SceneManager* scene_manager;
+    NotificationApp* notifications;
+    FuriTimer* timer;
+
+    View* live_view;
+    Submenu* menu;
+    VariableItemList* settings_list; // Only while the settings scene is shown
+    View* diagnostics; // Only while the diagnostics scene is shown
+    View* offset_tuning; // Only while the offset tuning scene is shown
+    View* nodes; // Only while the nodes scene is shown
+
+    SensorStatus status;
+    char serial[13]; // 12 hex digits, empty if it could not be read
+
+    // At most one tick is queued at any time, a slow iteration just skips the ticks it missed
+    // instead of having them pile up in front of key presses. The timer never waits for room
+    FuriMessageQueue* tick_queue;
+    uint32_t ticks_coalesced;
+
+    // Keys as the input service publishes them, its thread only writes the stamps: never blocked
+    // by the app. The live view matches each key it gets with its stamp; the stamps after it are
+    // the keys queued behind it in the GUI and the view dispatcher (the backlog), the unmatched
+    // stamps before it keys that never reached the live view while it was shown
+    FuriPubSub* input_events;
+    FuriPubSubSubscription* input_subscription;
+    Co2SensorInputStamp input_stamps[CO2_SENSOR_INPUT_STAMPS];
+    uint32_t input_published; // Written by the input service thread only
+    uint32_t input_matched; // Stamps before this one are handled or lost
+    uint32_t input_backlog_max;
+    uint32_t input_lost;
+
+    // Key-to-screen latency, from the input service to the draw that shows its effect
+    volatile bool key_draw_pending;
+    volatile uint32_t key_draw_tick;
+    uint32_t key_latency_last;
+    uint32_t key_latency_max;
+    uint32_t key_latency_sum;
+    uint32_t key_latency_count;
+
+    DisplayData display_data;
+    SeqLock display_lock;
+    bool comfort_screen; // Derived metrics instead of the raw ones, toggled with Up
+
+    // What the sensor runs with, and the copy the settings scene edits
+    Co2Settings settings;
+    Co2Settings settings_pending;
+
+    // Optional external barometer feeding the SCD4x pressure compensation
+    Barometer barometer;
+    PressureComp pressure_comp;
+    uint32_t pressure_poll_tick;
+
+    // Optional reference thermometer, fed to the offset tuner while its scene is shown
+    Thermometer thermometer;
+    OffsetTuner offset_tuner;
+    bool offset_tuning_active;
+
+    // Smoothing applied between the driver and the display, cycled with the OK key
+    Co2Filter co2_filter;
+
+    // CO2 level alarms, evaluated on the filtered readings
+    Co2Alarm co2_alarm;
+
+    // Trend of the filtered CO2 and the time to the next alarm threshold, published for the
+    // live view with the display data
+    Co2Trend co2_trend;
+
+    // Daily statistics of the unfiltered readings, shown on the stats screen (Right/Left)
+    Co2Stats co2_stats;
+    SeqLock co2_stats_lock;
+    bool stats_screen;
+    Co2FilterChannel stats_channel;
+    Co2StatsDay stats_day;
+
+    // Air changes per hour from the CO2 decays, shown on the ventilation screen (hold Left)
+    Co2Ach co2_ach;
+    SeqLock co2_ach_lock;
+    bool ach_screen;
+
+    // Live samples over the CLI ("co2 stream"), see co2_stream.h
+    Co2Stream* co2_stream;
+
+    // Samples broadcast to or collected from other nodes over Sub-GHz, see co2_radio_link.h
+    Co2RadioLink* radio;
+    bool radio_failed; // The role of the settings did not start, the link is off
+
+    // Forced recalibration screen (hold Down). The sensor is left alone while the sequence runs
+    Co2Frc* co2_frc;
+    bool frc_screen;
+
+    // Self-test, started from the diagnostics screen. Same as the FRC, runs on its own worker
+    Co2SelfTest* selftest;
+
+    // A worker (FRC or self-test) had the sensor at the last tick
+    bool worker_pending;
+
+    // I2C speed benchmark, started from the diagnostics screen. Takes over the live reads
+    Co2I2cBench i2c_bench;
+
+    // Single shot schedule of the hybrid mode, stepped in place of the periodic reads
+    Co2Hybrid hybrid;
+
+    // Headless logging: backlight off, no redraws, wake up only when the sensor has data
+    bool headless;
+    bool headless_report; // Show the power report after leaving headless mode
+    Co2Wake headless_wake; // Wake-ups aligned to the sensor updates
+    Co2Logger co2_logger;
+    PowerStats power_stats_normal;
+    PowerStats power_stats_headless;
+
+    // Bus capture (hold Up) and replay (replay.bin present at startup)
+    Scd4xCapture* capture;
+    Scd4xReplay* replay;
+
+    // Simulated sensor of the soak build
+    Co2Soak* soak;
+} Co2SensorApp;
+
+// The model of the live view, its draw callback only gets that
+typedef struct {
+    Co2SensorApp* app;
+} Co2SensorLiveModel;
+
+// Redraw the live view, from any thread
+void co2_sensor_live_update(Co2SensorApp* app);
+
+// Write the pending settings to the sensor if they changed, and save them
+void co2_sensor_apply_settings(Co2SensorApp* app);
+
+// True while the FRC or the self-test worker owns the sensor, or a hybrid single shot runs: the
+// sensor takes no stop or setting meanwhile
+bool co2_sensor_is_busy(Co2SensorApp* app);
+
+#endif
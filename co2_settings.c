@@ -0,0 +1,175 @@
+#include "co2_settings.h"
+#include "co2_hybrid.h"
+#include <toolbox/saved_struct.h>
+#include <math.h>
+
+#define CO2_SETTINGS_STOP_DELAY_MS 500
+// The sensor stores the offset as a word of 175/65536 C, what is read back is rounded to it
+#define CO2_SETTINGS_OFFSET_EPSILON 0.01f
+
+void co2_settings_default(Co2Settings* settings) {
+    memset(settings, 0, sizeof(Co2Settings));
+    settings->sensor_type = SCD4x_SENSOR_SCD40;
+    settings->mode = Co2SettingsModePeriodic;
+    settings->asc = false;
+    settings->temperature_offset = 4.0f; // Sensor default
+    settings->altitude = 0;
+    settings->radio = Co2SettingsRadioOff;
+    settings->i2c_speed = Co2I2cSpeedStandard;
+}
+
+void co2_settings_load(Co2Settings* settings) {
+    if(!saved_struct_load(
+           CO2_SETTINGS_PATH,
+           settings,
+           sizeof(Co2Settings),
+           CO2_SETTINGS_MAGIC,
+           CO2_SETTINGS_VERSION) ||
+       settings->sensor_type > SCD4x_SENSOR_SCD41 || settings->mode >= Co2SettingsModeNum ||
+       settings->radio >= Co2SettingsRadioNum || settings->i2c_speed >= Co2I2cSpeedNum) {
+        co2_settings_default(settings);
+    }
+}
+
+bool co2_settings_save(const Co2Settings* settings) {
+    return saved_struct_save(
+        CO2_SETTINGS_PATH,
+        settings,
+        sizeof(Co2Settings),
+        CO2_SETTINGS_MAGIC,
+        CO2_SETTINGS_VERSION);
+}
+
+// The sensor words of the settings. An offset out of the sensor range (-1 when unknown) maps to a
+// word no valid offset has, so that it is written
+static void co2_settings_to_config(const Co2Settings* settings, scd4x_config_t* config) {
+    float offset = settings->temperature_offset;
+    config->temperatureOffset = offset < 0 || offset >= 175.0f ?
+                                    UINT16_MAX :
+                                    (uint16_t)(offset * 65536 / 175); // As setTemperatureOffset
+    config->altitude = settings->altitude;
+    config->asc = settings->asc ? 1 : 0;
+}
+
+bool co2_settings_read(Co2Settings* settings, scd4x_config_t* config) {
+    if(!readConfig(config)) return false;
+    settings->temperature_offset = (float)config->temperatureOffset * 175.0f / 65536.0f;
+    settings->altitude = config->altitude;
+    settings->asc = config->asc != 0;
+    return true;
+}
+
+bool co2_settings_equal(const Co2Settings* a, const Co2Settings* b) {
+    return a->sensor_type == b->sensor_type && a->mode == b->mode && a->asc == b->asc &&
+           fabsf(a->temperature_offset - b->temperature_offset) < CO2_SETTINGS_OFFSET_EPSILON &&
+           a->altitude == b->altitude;
+}
+
+bool co2_settings_apply(Co2Settings* current, const Co2Settings* pending, bool running) {
+    bool success = !running || stopPeriodicMeasurement(CO2_SETTINGS_STOP_DELAY_MS);
+
+    if(success && pending->sensor_type != current->sensor_type) {
+        SCD4x_init(pending->sensor_type);
+        current->sensor_type = pending->sensor_type;
+    }
+    if(success) {
+        // One bus session for all the changed fields, the offset is compared as sensor words
+        scd4x_config_t written;
+        scd4x_config_t config;
+        co2_settings_to_config(current, &written);
+        co2_settings_to_config(pending, &config);
+        if(fabsf(pending->temperature_offset - current->temperature_offset) <
+           CO2_SETTINGS_OFFSET_EPSILON) {
+            config.temperatureOffset = written.temperatureOffset;
+        }
+        success = writeConfig(&written, &config);
+        if(written.temperatureOffset == config.temperatureOffset) {
+            current->temperature_offset = pending->temperature_offset;
+        }
+        if(written.altitude == config.altitude) current->altitude = pending->altitude;
+        if(written.asc == config.asc) current->asc = pending->asc;
+    }
+
+    // Measurements are restarted even if a write failed. The mode is only taken once started,
+    // the previous one is restarted otherwise
+    Co2SettingsMode mode = pending->mode;
+    if(!co2_settings_is_mode_supported(mode, current->sensor_type)) {
+        mode = Co2SettingsModePeriodic;
+    }
+    if(co2_settings_start(mode)) {
+        current->mode = mode;
+    } else {
+        success = false;
+        if(!co2_settings_is_mode_supported(current->mode, current->sensor_type)) {
+            current->mode = Co2SettingsModePeriodic;
+        }
+        if(current->mode != mode) co2_settings_start(current->mode);
+    }
+
+    furi_log_print_format(
+        success ? FuriLogLevelInfo : FuriLogLevelError,
+        "SCD4x",
+        "settings: SCD4%d, %s, offset %.1f C, altitude %u m, ASC %s: %s",
+        current->sensor_type == SCD4x_SENSOR_SCD41 ? 1 : 0,
+        co2_settings_get_mode_name(current->mode),
+        (double)current->temperature_offset,
+        current->altitude,
+        current->asc ? "on" : "off",
+        success ? "ok" : "failed");
+    return success;
+}
+
+bool co2_settings_is_mode_supported(Co2SettingsMode mode, scd4x_sensor_type_e sensor_type) {
+    switch(mode) {
+    case Co2SettingsModeLowPower:
+        return SCD4x_ENABLE_LOW_POWER;
+    case Co2SettingsModeHybrid:
+        return SCD4x_ENABLE_SINGLE_SHOT && SCD4x_IS_SCD41(sensor_type);
+    default:
+        return true;
+    }
+}
+
+bool co2_settings_start(Co2SettingsMode mode) {
+    switch(mode) {
+    case Co2SettingsModeLowPower:
+        return startLowPowerPeriodicMeasurement();
+    case Co2SettingsModeHybrid:
+        return true;
+    default:
+        return startPeriodicMeasurement();
+    }
+}
+
+uint32_t co2_settings_get_interval_ms(const Co2Settings* settings) {
+    switch(settings->mode) {
+    case Co2SettingsModeLowPower:
+        return SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS;
+    case Co2SettingsModeHybrid:
+        return CO2_HYBRID_RHT_INTERVAL_MS;
+    default:
+        return SCD4x_PERIODIC_INTERVAL_MS;
+    }
+}
+
+const char* co2_settings_get_mode_name(Co2SettingsMode mode) {
+    switch(mode) {
+    case Co2SettingsModeLowPower:
+        return "Low power";
+    case Co2SettingsModeHybrid:
+        return "Hybrid";
+    default:
+        return "Periodic";
+    }
+}
+
+const char* co2_settings_get_radio_name(Co2SettingsRadio radio) {
+    switch(radio) {
+    case Co2SettingsRadioBroadcast:
+        return "Broadcast";
+    case Co2SettingsRadioCollector:
+        return "Collector";
+    default:
+        return "Off";
+    }
+}
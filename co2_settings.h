@@ -0,0 +1,90 @@
+/*
+  Sensor settings, edited on the settings screen.
+
+  Sensor type and measurement mode are choices of the app. Temperature offset, altitude and
+  automatic self-calibration live in the sensor RAM, and the sensor only accepts writes to them
+  while measurements are stopped. A stop costs 500 ms plus a whole measurement interval before the
+  next sample, so the screen edits a pending copy and co2_settings_apply() writes the change set
+  with a single stop / restart.
+  The settings are saved on the SD card and applied at every start instead of being persisted in
+  the sensor EEPROM, which is only rated for 2000 writes.
+*/
+
+#ifndef __CO2_SETTINGS_H__
+#define __CO2_SETTINGS_H__
+
+#include <furi.h>
+#include <storage/storage.h>
+#include "scd4x.h"
+#include "co2_i2c.h"
+
+#define CO2_SETTINGS_PATH EXT_PATH("apps_data/co2_sensor/settings")
+#define CO2_SETTINGS_MAGIC 0xC2
+#define CO2_SETTINGS_VERSION 1
+
+#define CO2_SETTINGS_OFFSET_MAX 10.0f // C
+#define CO2_SETTINGS_OFFSET_STEP 0.5f
+#define CO2_SETTINGS_ALTITUDE_MAX 3000 // m
+#define CO2_SETTINGS_ALTITUDE_STEP 100
+
+typedef enum {
+    Co2SettingsModePeriodic,
+    Co2SettingsModeLowPower,
+    Co2SettingsModeHybrid, // SCD41 only, single shots scheduled by the app (co2_hybrid.h)
+    Co2SettingsModeNum,
+} Co2SettingsMode;
+
+// Role of the app on the Sub-GHz link, see co2_radio_link.h. Not a sensor setting
+typedef enum {
+    Co2SettingsRadioOff,
+    Co2SettingsRadioBroadcast,
+    Co2SettingsRadioCollector,
+    Co2SettingsRadioNum,
+} Co2SettingsRadio;
+
+typedef struct {
+    uint8_t sensor_type; // scd4x_sensor_type_e
+    uint8_t mode; // Co2SettingsMode
+    bool asc; // Automatic self-calibration
+    uint8_t radio; // Co2SettingsRadio
+    float temperature_offset; // C
+    uint16_t altitude; // m above sea level
+    uint8_t i2c_speed; // Co2I2cSpeed, in what was padding (saved as 0) before it
+} Co2Settings;
+
+// What the app ran with before there were settings: SCD40, periodic, sensor defaults, ASC off
+void co2_settings_default(Co2Settings* settings);
+
+// Load the saved settings, the defaults if there are none
+void co2_settings_load(Co2Settings* settings);
+bool co2_settings_save(const Co2Settings* settings);
+
+// Read the settings stored in the sensor into settings, with the rest of its configuration (the
+// serial number) in config. Measurements must be stopped. Sensor type and mode are left alone
+bool co2_settings_read(Co2Settings* settings, scd4x_config_t* config);
+
+// Compares what the sensor runs with, the radio role and the bus speed are left out
+bool co2_settings_equal(const Co2Settings* a, const Co2Settings* b);
+
+// Write the fields of pending that differ from current to the sensor, stopping the measurements
+// first if running, then (re)start them in the pending mode. current follows every successful
+// write and start, so it always describes the sensor: if the pending mode does not start, the
+// previous one is restarted. A mode that is not supported falls back to periodic. In hybrid mode
+// a pending single shot must be finished first (co2_hybrid_finish())
+bool co2_settings_apply(Co2Settings* current, const Co2Settings* pending, bool running);
+
+// Hybrid needs a SCD41, and the driver may be built without single shots or low power mode
+bool co2_settings_is_mode_supported(Co2SettingsMode mode, scd4x_sensor_type_e sensor_type);
+
+// Start the periodic measurements of the mode. Nothing to start in hybrid mode, whose single
+// shots are taken by the app
+bool co2_settings_start(Co2SettingsMode mode);
+
+// Time between two samples in the settings' mode, T/RH samples in hybrid mode
+uint32_t co2_settings_get_interval_ms(const Co2Settings* settings);
+
+const char* co2_settings_get_mode_name(Co2SettingsMode mode);
+
+const char* co2_settings_get_radio_name(Co2SettingsRadio radio);
+
+#endif
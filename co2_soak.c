@@ -0,0 +1,264 @@
+#include "co2_soak.h"
+#include <core/log.h>
+#include <furi_hal.h>
+#include "co2_memory.h"
+
+// CO2 / T / RH of update n: T and RH carry its 22 low bits, CO2 a check value of the full number.
+// All of them stay in the comfortable range, the alarms never fire
+#define CO2_SOAK_UPDATE_BITS 22
+#define CO2_SOAK_UPDATE_MASK ((1UL << CO2_SOAK_UPDATE_BITS) - 1)
+#define CO2_SOAK_T_BASE 0x6000 // 20.6 C
+#define CO2_SOAK_RH_BASE 0x7000 // 43.8 %
+#define CO2_SOAK_CO2_BASE 450
+#define CO2_SOAK_CO2_SPAN 251
+
+static void co2_soak_put(uint8_t* data, uint16_t word) {
+    data[0] = word >> 8;
+    data[1] = word & 0xFF;
+    data[2] = computeCRC8(data, 2);
+}
+
+static uint32_t co2_soak_get_update(const Co2Soak* soak) {
+    return soak->measuring ? (furi_get_tick() - soak->start_tick) / soak->interval : 0;
+}
+
+static bool co2_soak_tx(void* context, const uint8_t* data, uint8_t size) {
+    Co2Soak* soak = context;
+    soak->command = (uint16_t)data[0] << 8 | data[1];
+    uint16_t argument = size >= 4 ? (uint16_t)data[2] << 8 | data[3] : 0;
+
+    switch(soak->command) {
+    case SCD4x_COMMAND_START_PERIODIC_MEASUREMENT:
+    case SCD4x_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT:
+        soak->measuring = true;
+        soak->interval = furi_ms_to_ticks(
+            soak->command == SCD4x_COMMAND_START_PERIODIC_MEASUREMENT ?
+                SCD4x_PERIODIC_INTERVAL_MS :
+                SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS);
+        soak->start_tick = furi_get_tick();
+        soak->read_update = 0;
+        break;
+    case SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT:
+        soak->measuring = false;
+        break;
+    case SCD4x_COMMAND_SET_TEMPERATURE_OFFSET:
+        soak->words[0] = argument;
+        break;
+    case SCD4x_COMMAND_SET_SENSOR_ALTITUDE:
+        soak->words[1] = argument;
+        break;
+    case SCD4x_COMMAND_SET_AUTOMATIC_SELF_CALIBRATION_ENABLED:
+        soak->words[2] = argument;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+static bool co2_soak_rx(void* context, uint8_t* data, uint8_t size) {
+    Co2Soak* soak = context;
+    uint32_t update = co2_soak_get_update(soak);
+    uint16_t words[3] = {0};
+
+    switch(soak->command) {
+    case SCD4x_COMMAND_GET_DATA_READY_STATUS:
+        words[0] = update > soak->read_update ? 0x8006 : 0x8000;
+        break;
+    case SCD4x_COMMAND_READ_MEASUREMENT:
+        // The sensor NACKs when it has nothing new
+        if(update <= soak->read_update) return false;
+        // Updates before the first read after a start are not the driver's to count
+        if(soak->read_update) soak->missed += update - soak->read_update - 1;
+        soak->read_update = update;
+        words[0] = CO2_SOAK_CO2_BASE + update % CO2_SOAK_CO2_SPAN;
+        words[1] = CO2_SOAK_T_BASE + ((update & CO2_SOAK_UPDATE_MASK) >> 12);
+        words[2] = CO2_SOAK_RH_BASE + (update & 0xFFF);
+        break;
+    case SCD4x_COMMAND_GET_TEMPERATURE_OFFSET:
+        words[0] = soak->words[0];
+        break;
+    case SCD4x_COMMAND_GET_SENSOR_ALTITUDE:
+        words[0] = soak->words[1];
+        break;
+    case SCD4x_COMMAND_GET_AUTOMATIC_SELF_CALIBRATION_ENABLED:
+        words[0] = soak->words[2];
+        break;
+    case SCD4x_COMMAND_GET_SERIAL_NUMBER:
+        words[0] = 0x5C0A;
+        words[1] = 0x4B00;
+        words[2] = 0x0001;
+        break;
+    case SCD4x_COMMAND_GET_SENSOR_VARIANT:
+        words[0] = 0x1000; // SCD41
+        break;
+    case SCD4x_COMMAND_PERFORM_FORCED_CALIBRATION:
+        words[0] = 0x8000; // No correction
+        break;
+    default:
+        break; // Self-test passed, and zeros for anything else
+    }
+
+    for(uint8_t i = 0; i + 3 <= size && i < 9; i += 3) {
+        co2_soak_put(&data[i], words[i / 3]);
+    }
+    return true;
+}
+
+// Execution waits are skipped, only the update interval runs on the real clock
+static void co2_soak_delay(void* context, uint32_t delayMillis) {
+    UNUSED(context);
+    UNUSED(delayMillis);
+}
+
+Co2Soak* co2_soak_alloc(uint32_t tick_ms) {
+    Co2Soak* soak = co2_memory_alloc(sizeof(Co2Soak));
+    memset(soak, 0, sizeof(Co2Soak));
+    soak->transport.tx = co2_soak_tx;
+    soak->transport.rx = co2_soak_rx;
+    soak->transport.delay = co2_soak_delay;
+    soak->transport.context = soak;
+    soak->words[0] = (uint16_t)(4.0f * 65536 / 175); // Sensor defaults
+    soak->interval = furi_ms_to_ticks(SCD4x_PERIODIC_INTERVAL_MS);
+    soak->tick_micros = tick_ms * 1000;
+    soak->start = furi_get_tick();
+    return soak;
+}
+
+void co2_soak_free(Co2Soak* soak) {
+    co2_memory_free(soak, sizeof(Co2Soak));
+}
+
+void co2_soak_tick_posted(Co2Soak* soak, bool coalesced) {
+    if(coalesced) {
+        soak->ticks_coalesced++;
+    } else {
+        soak->tick_posted = DWT->CYCCNT;
+    }
+}
+
+void co2_soak_tick_handled(Co2Soak* soak) {
+    uint32_t micros =
+        (DWT->CYCCNT - soak->tick_posted) / furi_hal_cortex_instructions_per_microsecond();
+    uint8_t bucket = 0;
+    while(bucket < CO2_SOAK_LATENCY_BUCKETS - 1 && micros >= (16UL << bucket)) {
+        bucket++;
+    }
+    soak->latency[bucket]++;
+    soak->latency_max_micros = MAX(soak->latency_max_micros, micros);
+    soak->ticks++;
+}
+
+// Upper bound of the bucket holding the percent-th percentile of the tick latency
+static uint32_t co2_soak_get_percentile(const Co2Soak* soak, uint32_t percent) {
+    uint64_t count = 0;
+    for(uint8_t i = 0; i < CO2_SOAK_LATENCY_BUCKETS; i++) {
+        count += soak->latency[i];
+        if(count * 100 >= (uint64_t)soak->ticks * percent) {
+            return i < CO2_SOAK_LATENCY_BUCKETS - 1 ? 16UL << i : soak->latency_max_micros;
+        }
+    }
+    return soak->latency_max_micros;
+}
+
+static void co2_soak_fail(Co2Soak* soak, const char* what) {
+    soak->failures++;
+    furi_log_print_format(
+        FuriLogLevelError, "SCD4x", "soak: %s after %lu samples", what, soak->samples);
+}
+
+// The report checks see the totals so far: a failure stays until the end, count it once
+static void co2_soak_fail_once(Co2Soak* soak, Co2SoakCheck check, bool failed, const char* what) {
+    if(!failed || (soak->failed_checks & check)) return;
+    soak->failed_checks |= check;
+    co2_soak_fail(soak, what);
+}
+
+void co2_soak_check(Co2Soak* soak, const scd4x_sample_t* sample) {
+    uint32_t low = ((uint32_t)(sample->temperature - CO2_SOAK_T_BASE) << 12) |
+                   (uint16_t)(sample->humidity - CO2_SOAK_RH_BASE);
+    uint32_t previous = soak->update_base + (soak->samples ? 1 : 0);
+    uint32_t update = (previous & ~CO2_SOAK_UPDATE_MASK) | (low & CO2_SOAK_UPDATE_MASK);
+    if(update < previous) update += CO2_SOAK_UPDATE_MASK + 1;
+
+    // A word that does not belong to its update, or an update read again as a new sample
+    bool valid = sample->temperature >= CO2_SOAK_T_BASE && sample->humidity >= CO2_SOAK_RH_BASE &&
+                 sample->humidity < CO2_SOAK_RH_BASE + 0x1000 &&
+                 sample->co2 == CO2_SOAK_CO2_BASE + update % CO2_SOAK_CO2_SPAN &&
+                 (!soak->samples || update > soak->update_base);
+    if(!valid) co2_soak_fail(soak, "inconsistent sample");
+
+    // The inferred sensor sequence must follow the updates. A slip is a late read the driver put
+    // on the wrong update, resynced after
+    uint32_t sequence_delta = sample->sensorSequence - soak->sequence_base;
+    if(soak->synced && sequence_delta != update - soak->update_base) {
+        soak->mismatches++;
+        co2_soak_fail(soak, "sensor sequence mismatch");
+    }
+    soak->synced = true;
+    soak->sequence_base = sample->sensorSequence;
+    soak->update_base = update;
+
+    soak->samples++;
+    if(soak->samples % CO2_SOAK_REPORT_SAMPLES == 0) co2_soak_report(soak);
+}
+
+void co2_soak_report(Co2Soak* soak) {
+    uint32_t elapsed = (furi_get_tick() - soak->start) / furi_ms_to_ticks(1000);
+    size_t heap_free = memmgr_get_free_heap();
+    size_t memory = co2_memory_get()->used;
+
+    // The first report is the baseline, everything is allocated by then
+    if(!soak->heap_free_base) {
+        soak->heap_free_base = heap_free;
+        soak->memory_base = memory;
+    }
+
+    scd4x_timing_stats_t timing;
+    getTimingStats(&timing);
+
+    co2_soak_fail_once(
+        soak,
+        Co2SoakCheckHeap,
+        heap_free + CO2_SOAK_HEAP_SLACK < soak->heap_free_base,
+        "heap leak");
+    co2_soak_fail_once(soak, Co2SoakCheckMemory, memory != soak->memory_base, "app objects leak");
+    // A tick still waiting when the next one comes means the loop fell a whole tick behind
+    co2_soak_fail_once(
+        soak,
+        Co2SoakCheckLatency,
+        soak->latency_max_micros >= soak->tick_micros,
+        "tick latency over a tick period");
+    // The driver infers the updates it never saw, the simulation knows them
+    co2_soak_fail_once(
+        soak, Co2SoakCheckDropped, timing.dropped != soak->missed, "dropped count off");
+
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "soak: %lu samples in %lu s (%lu/s, %lu h of sensor time), %lu failures",
+        soak->samples,
+        elapsed,
+        elapsed ? soak->samples / elapsed : 0,
+        soak->samples * (SCD4x_PERIODIC_INTERVAL_MS * CO2_SOAK_SPEEDUP / 1000) / 3600,
+        soak->failures);
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "soak: tick latency p50 %lu us, p90 %lu, p99 %lu, max %lu, %lu of %lu ticks coalesced",
+        co2_soak_get_percentile(soak, 50),
+        co2_soak_get_percentile(soak, 90),
+        co2_soak_get_percentile(soak, 99),
+        soak->latency_max_micros,
+        soak->ticks_coalesced,
+        soak->ticks + soak->ticks_coalesced);
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "soak: heap %ld B, app %ld B since the first report, dropped %lu (missed %lu), %lu slips",
+        (int32_t)heap_free - (int32_t)soak->heap_free_base,
+        (int32_t)memory - (int32_t)soak->memory_base,
+        timing.dropped,
+        soak->missed,
+        soak->mismatches);
+}
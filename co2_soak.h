@@ -0,0 +1,90 @@
+/*
+  Soak test of the app against a simulated sensor, for problems that only show after days.
+
+  Built with CO2_SENSOR_SOAK=1, the app talks to a simulated SCD4x transport instead of the bus
+  and the signal update intervals are divided by CO2_SOAK_SPEEDUP (the driver reads them from
+  SCD4x_PERIODIC_INTERVAL_MS, the tick timer follows), so a day of samples goes by in minutes:
+  the event loop, timer ticks, driver, filters, statistics, alarms and views run unchanged.
+  Command execution waits are skipped. Leave it running on the live view and watch the log.
+
+  The simulated sensor derives CO2 / T / RH from its update number. Every sample read is checked
+  against the update its inferred sensor sequence points to, and the driver's dropped count
+  against the updates the simulation knows were never read. Every CO2_SOAK_REPORT_SAMPLES samples
+  (and at exit) a report is logged: throughput, tick latency percentiles (timer callback to
+  handler), coalesced ticks, heap and app memory against the first report. A check that fails
+  is logged as an error and counted in the report; a report check (leaks, latency, dropped
+  count) is counted the first time it fails, not again at every report.
+  tests/test_co2_soak.c runs the same checks on a PC for millions of samples.
+*/
+
+#ifndef __CO2_SOAK_H__
+#define __CO2_SOAK_H__
+
+#include <furi.h>
+#include "scd4x.h"
+
+#ifndef CO2_SENSOR_SOAK
+#define CO2_SENSOR_SOAK 0
+#endif
+
+#define CO2_SOAK_SPEEDUP SCD4x_INTERVAL_DIVIDER // 5 s updates every 20 ms
+#define CO2_SOAK_REPORT_SAMPLES 10000
+#define CO2_SOAK_HEAP_SLACK 2048 // Bytes the free heap may move by, other apps and services
+#define CO2_SOAK_LATENCY_BUCKETS 18 // Powers of two from 16 us
+
+typedef enum {
+    Co2SoakCheckHeap = 1 << 0,
+    Co2SoakCheckMemory = 1 << 1,
+    Co2SoakCheckLatency = 1 << 2,
+    Co2SoakCheckDropped = 1 << 3,
+} Co2SoakCheck;
+
+typedef struct {
+    scd4x_transport_t transport; // Install with SCD4x_setTransport(&soak->transport)
+
+    // Simulated sensor
+    uint16_t command;
+    bool measuring;
+    uint32_t interval; // Ticks
+    uint32_t start_tick;
+    uint32_t read_update; // Newest update read
+    uint16_t words[3]; // Temperature offset, altitude, ASC
+    uint32_t missed; // Updates never read
+
+    // Checks
+    uint32_t tick_micros; // Period of the app tick
+    bool synced;
+    uint32_t sequence_base; // Sensor sequence and update of the first sample
+    uint32_t update_base;
+    uint32_t samples;
+    uint32_t mismatches;
+    uint32_t failures;
+    uint8_t failed_checks; // Co2SoakCheck bits of the report checks that failed
+
+    uint32_t tick_posted; // DWT cycles
+    uint32_t ticks;
+    uint32_t ticks_coalesced;
+    uint32_t latency[CO2_SOAK_LATENCY_BUCKETS];
+    uint32_t latency_max_micros;
+
+    uint32_t start;
+    size_t heap_free_base; // At the first report
+    size_t memory_base;
+} Co2Soak;
+
+// tick_ms: period of the app tick, a tick handled a whole period late fails the latency check
+Co2Soak* co2_soak_alloc(uint32_t tick_ms);
+void co2_soak_free(Co2Soak* soak);
+
+// From the timer callback: a tick was posted, or not because one was still queued
+void co2_soak_tick_posted(Co2Soak* soak, bool coalesced);
+
+// From the app thread when the tick is handled
+void co2_soak_tick_handled(Co2Soak* soak);
+
+// Check a sample the app read. Logs a report every CO2_SOAK_REPORT_SAMPLES samples
+void co2_soak_check(Co2Soak* soak, const scd4x_sample_t* sample);
+
+void co2_soak_report(Co2Soak* soak);
+
+#endif
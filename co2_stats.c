@@ -0,0 +1,187 @@
+#include "co2_stats.h"
+#include <math.h>
+
+#define CO2_STATS_SECONDS_PER_DAY (24 * 60 * 60)
+
+static void co2_quantile_init(Co2Quantile* quantile, float p) {
+    memset(quantile, 0, sizeof(Co2Quantile));
+    quantile->p = p;
+
+    quantile->desired[0] = 0;
+    quantile->desired[1] = 2 * p;
+    quantile->desired[2] = 4 * p;
+    quantile->desired[3] = 2 + 2 * p;
+    quantile->desired[4] = 4;
+
+    quantile->increment[0] = 0;
+    quantile->increment[1] = p / 2;
+    quantile->increment[2] = p;
+    quantile->increment[3] = (1 + p) / 2;
+    quantile->increment[4] = 1;
+
+    for(uint8_t i = 0; i < CO2_STATS_P2_MARKERS; i++) {
+        quantile->position[i] = i;
+    }
+}
+
+// Piecewise-parabolic prediction of marker i moved by d (+1 or -1)
+static float co2_quantile_parabolic(const Co2Quantile* quantile, uint8_t i, int32_t d) {
+    const float* q = quantile->height;
+    const int32_t* n = quantile->position;
+    return q[i] + (float)d / (n[i + 1] - n[i - 1]) *
+                      ((n[i] - n[i - 1] + d) * (q[i + 1] - q[i]) / (n[i + 1] - n[i]) +
+                       (n[i + 1] - n[i] - d) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+static void co2_quantile_update(Co2Quantile* quantile, float value) {
+    float* q = quantile->height;
+    int32_t* n = quantile->position;
+
+    // The first samples initialize the markers, kept sorted by insertion
+    if(quantile->count < CO2_STATS_P2_MARKERS) {
+        uint8_t i = quantile->count++;
+        while(i > 0 && q[i - 1] > value) {
+            q[i] = q[i - 1];
+            i--;
+        }
+        q[i] = value;
+        return;
+    }
+    quantile->count++;
+
+    // Find the cell the sample falls in, extending the extremes if needed
+    uint8_t k;
+    if(value < q[0]) {
+        q[0] = value;
+        k = 0;
+    } else if(value >= q[4]) {
+        q[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while(value >= q[k + 1]) {
+            k++;
+        }
+    }
+
+    for(uint8_t i = k + 1; i < CO2_STATS_P2_MARKERS; i++) {
+        n[i]++;
+    }
+    for(uint8_t i = 0; i < CO2_STATS_P2_MARKERS; i++) {
+        quantile->desired[i] += quantile->increment[i];
+    }
+
+    // Move the middle markers back towards their desired positions
+    for(uint8_t i = 1; i < CO2_STATS_P2_MARKERS - 1; i++) {
+        float delta = quantile->desired[i] - n[i];
+        if((delta >= 1 && n[i + 1] - n[i] > 1) || (delta <= -1 && n[i - 1] - n[i] < -1)) {
+            int32_t d = delta > 0 ? 1 : -1;
+            float height = co2_quantile_parabolic(quantile, i, d);
+            if(q[i - 1] < height && height < q[i + 1]) {
+                q[i] = height;
+            } else {
+                // Parabola out of bounds, fall back to linear interpolation
+                q[i] += d * (q[i + d] - q[i]) / (n[i + d] - n[i]);
+            }
+            n[i] += d;
+        }
+    }
+}
+
+float co2_stats_get_quantile(const Co2Quantile* quantile) {
+    if(quantile->count == 0) return 0;
+    if(quantile->count < CO2_STATS_P2_MARKERS) {
+        // Markers still hold the sorted samples, use the nearest rank
+        uint32_t rank = (uint32_t)(quantile->p * (quantile->count - 1) + 0.5f);
+        return quantile->height[rank];
+    }
+    return quantile->height[2];
+}
+
+static void co2_stats_channel_init(Co2StatsChannel* channel) {
+    memset(channel, 0, sizeof(Co2StatsChannel));
+    co2_quantile_init(&channel->p50, 0.5f);
+    co2_quantile_init(&channel->p95, 0.95f);
+}
+
+static void co2_stats_channel_update(Co2StatsChannel* channel, float value) {
+    if(channel->count == 0) {
+        channel->min = value;
+        channel->max = value;
+    } else {
+        channel->min = MIN(channel->min, value);
+        channel->max = MAX(channel->max, value);
+    }
+
+    channel->count++;
+    float delta = value - channel->mean;
+    channel->mean += delta / channel->count;
+    channel->m2 += delta * (value - channel->mean);
+
+    co2_quantile_update(&channel->p50, value);
+    co2_quantile_update(&channel->p95, value);
+}
+
+float co2_stats_get_stddev(const Co2StatsChannel* channel) {
+    if(channel->count < 2) return 0;
+    return sqrtf(channel->m2 / (channel->count - 1));
+}
+
+static void co2_stats_day_init(Co2StatsDayData* data, uint32_t day) {
+    memset(data, 0, sizeof(Co2StatsDayData));
+    data->day = day;
+    for(uint8_t i = 0; i < Co2FilterChannelNum; i++) {
+        co2_stats_channel_init(&data->channels[i]);
+    }
+}
+
+void co2_stats_init(Co2Stats* stats, const uint16_t thresholds[Co2AlarmLevelNum - 1]) {
+    memset(stats, 0, sizeof(Co2Stats));
+    memcpy(stats->thresholds, thresholds, sizeof(stats->thresholds));
+    for(uint8_t i = 0; i < Co2StatsDayNum; i++) {
+        co2_stats_day_init(&stats->days[i], 0);
+    }
+}
+
+void co2_stats_update(
+    Co2Stats* stats,
+    const float values[Co2FilterChannelNum],
+    bool co2,
+    uint32_t timestamp) {
+    uint32_t day = timestamp / CO2_STATS_SECONDS_PER_DAY;
+    Co2StatsDayData* today = &stats->days[Co2StatsDayToday];
+
+    // T and RH come with every sample, CO2 not always
+    if(today->channels[Co2FilterChannelTemperature].count == 0) {
+        today->day = day;
+    } else if(day != today->day) {
+        // Midnight: today becomes yesterday, unless the app slept through a whole day
+        if(day == today->day + 1) {
+            stats->days[Co2StatsDayYesterday] = *today;
+        } else {
+            co2_stats_day_init(&stats->days[Co2StatsDayYesterday], day - 1);
+        }
+        co2_stats_day_init(today, day);
+    }
+
+    // The interval since the previous sample is credited to the state of that sample
+    uint32_t elapsed = timestamp - stats->last_timestamp;
+    if(stats->last_timestamp != 0 && timestamp > stats->last_timestamp &&
+       elapsed <= CO2_STATS_MAX_GAP_S) {
+        for(uint8_t i = 0; i < Co2AlarmLevelNum - 1; i++) {
+            if(stats->above[i]) today->seconds_above[i] += elapsed;
+        }
+    }
+    stats->last_timestamp = timestamp;
+    if(co2) {
+        for(uint8_t i = 0; i < Co2AlarmLevelNum - 1; i++) {
+            stats->above[i] = values[Co2FilterChannelCO2] >= stats->thresholds[i];
+        }
+        co2_stats_channel_update(
+            &today->channels[Co2FilterChannelCO2], values[Co2FilterChannelCO2]);
+    }
+
+    for(uint8_t i = Co2FilterChannelTemperature; i < Co2FilterChannelNum; i++) {
+        co2_stats_channel_update(&today->channels[i], values[i]);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+  Streaming daily statistics of the measurements.
+
+  Every channel keeps count/min/max and the mean and variance (Welford), plus approximate p50 and
+  p95 estimated with the P² algorithm (Jain & Chlamtac, five markers per quantile). All of it is
+  O(1) per sample with a fixed amount of memory, nothing is kept per sample.
+  The time spent above each alarm threshold is accumulated from the RTC timestamps of the samples.
+  Statistics roll over at midnight (RTC time), the previous day is kept for the stats screen.
+*/
+
+#ifndef __CO2_STATS_H__
+#define __CO2_STATS_H__
+
+#include <furi.h>
+#include "co2_filter.h"
+#include "co2_alarm.h"
+
+#define CO2_STATS_P2_MARKERS 5
+// A longer gap between two samples (e.g. the app was closed) is not counted as time above
+#define CO2_STATS_MAX_GAP_S 60
+
+typedef enum {
+    Co2StatsDayToday,
+    Co2StatsDayYesterday,
+    Co2StatsDayNum,
+} Co2StatsDay;
+
+typedef struct {
+    float p; // Target quantile, 0..1
+    float height[CO2_STATS_P2_MARKERS]; // Marker values, the middle one is the estimate
+    float desired[CO2_STATS_P2_MARKERS]; // Desired marker positions
+    float increment[CO2_STATS_P2_MARKERS]; // Desired position increments per sample
+    int32_t position[CO2_STATS_P2_MARKERS]; // Actual marker positions
+    uint32_t count;
+} Co2Quantile;
+
+typedef struct {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float m2; // Sum of the squared differences from the mean
+    Co2Quantile p50;
+    Co2Quantile p95;
+} Co2StatsChannel;
+
+typedef struct {
+    uint32_t day; // Days since the epoch, RTC time
+    Co2StatsChannel channels[Co2FilterChannelNum];
+    uint32_t seconds_above[Co2AlarmLevelNum - 1]; // Time spent at or above each CO2 threshold
+} Co2StatsDayData;
+
+typedef struct {
+    Co2StatsDayData days[Co2StatsDayNum];
+    uint16_t thresholds[Co2AlarmLevelNum - 1];
+    uint32_t last_timestamp;
+    bool above[Co2AlarmLevelNum - 1]; // State of the previous sample
+} Co2Stats;
+
+// Thresholds (ppm) for the time-above counters, usually the alarm ones
+void co2_stats_init(Co2Stats* stats, const uint16_t thresholds[Co2AlarmLevelNum - 1]);
+
+// Add one measurement: CO2 in ppm, temperature in C, humidity in %RH, RTC timestamp in seconds.
+// co2 false for a T/RH-only sample, whose CO2 is held from the last full measurement: only T and
+// RH are counted, the time above goes on with the state of the last CO2
+void co2_stats_update(
+    Co2Stats* stats,
+    const float values[Co2FilterChannelNum],
+    bool co2,
+    uint32_t timestamp);
+
+float co2_stats_get_stddev(const Co2StatsChannel* channel);
+
+// Current estimate of the quantile, exact while fewer than CO2_STATS_P2_MARKERS samples were seen
+float co2_stats_get_quantile(const Co2Quantile* quantile);
+
+#endif
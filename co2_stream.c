@@ -0,0 +1,165 @@
+#include "co2_stream.h"
+#include "scd4x.h"
+#include "co2_memory.h"
+#include <toolbox/args.h>
+
+#define CO2_STREAM_FRAME_SIZE (2 + sizeof(Co2StreamRecord) + 1)
+#define CO2_STREAM_BATCH 4 // Records written out per CLI write
+#define CO2_STREAM_POLL_MS 100 // How often the CLI thread checks for Ctrl+C when idle
+
+static void co2_stream_usage(void) {
+    cli_print_usage(CO2_STREAM_COMMAND, "stream [csv|bin] [interval_s]", "");
+}
+
+static void co2_stream_write_csv(Cli* cli, const Co2StreamRecord* record) {
+    char line[64];
+    int length = snprintf(
+        line,
+        sizeof(line),
+        "%lu,%lu,%u,%.2f,%.2f\r\n",
+        record->sequence,
+        record->tick,
+        record->co2,
+        (double)convertTemperature(record->temperature),
+        (double)convertHumidity(record->humidity));
+    cli_write(cli, (uint8_t*)line, length);
+}
+
+static void co2_stream_write_binary(Cli* cli, const Co2StreamRecord* records, size_t count) {
+    uint8_t frames[CO2_STREAM_BATCH * CO2_STREAM_FRAME_SIZE];
+    uint8_t* frame = frames;
+    for(size_t i = 0; i < count; i++) {
+        frame[0] = CO2_STREAM_SYNC_0;
+        frame[1] = CO2_STREAM_SYNC_1;
+        memcpy(&frame[2], &records[i], sizeof(Co2StreamRecord));
+        frame[2 + sizeof(Co2StreamRecord)] = computeCRC8(&frame[2], sizeof(Co2StreamRecord));
+        frame += CO2_STREAM_FRAME_SIZE;
+    }
+    cli_write(cli, frames, frame - frames);
+}
+
+static void co2_stream_command(Cli* cli, FuriString* args, void* context) {
+    Co2Stream* stream = context;
+
+    FuriString* word = furi_string_alloc();
+    bool binary = false;
+    int interval = 0;
+    bool valid = args_read_string_and_trim(args, word) &&
+                 furi_string_cmp_str(word, "stream") == 0;
+    if(valid && args_read_string_and_trim(args, word)) {
+        if(furi_string_cmp_str(word, "bin") == 0) {
+            binary = true;
+        } else if(furi_string_cmp_str(word, "csv") != 0) {
+            valid = false;
+        }
+        if(valid && furi_string_size(args) > 0) {
+            valid = args_read_int_and_trim(args, &interval) && interval >= 0;
+        }
+    }
+    furi_string_free(word);
+
+    if(!valid) {
+        co2_stream_usage();
+        return;
+    }
+    // Held until the command returns, co2_stream_free() waits for it before freeing the stream
+    if(furi_mutex_acquire(stream->mutex, 0) != FuriStatusOk) {
+        if(!stream->exiting) printf("Already streaming\r\n");
+        return;
+    }
+    if(stream->exiting) {
+        furi_mutex_release(stream->mutex);
+        return;
+    }
+
+    // Start from fresh samples, whatever was left from a previous session is stale
+    Co2StreamRecord records[CO2_STREAM_BATCH];
+    while(furi_stream_buffer_receive(stream->buffer, records, sizeof(records), 0) > 0) {
+    }
+    uint32_t dropped = stream->dropped;
+    stream->interval = interval * 1000;
+    stream->running = true;
+
+    if(!binary) {
+        printf("seq,ms,co2,temperature,humidity\r\n");
+    }
+
+    while(!stream->exiting && !cli_cmd_interrupt_received(cli)) {
+        size_t size = furi_stream_buffer_receive(
+            stream->buffer, records, sizeof(records), furi_ms_to_ticks(CO2_STREAM_POLL_MS));
+        // The producer only sends whole records, so whole records come out
+        size_t count = size / sizeof(Co2StreamRecord);
+        if(count == 0) continue;
+
+        if(binary) {
+            co2_stream_write_binary(cli, records, count);
+        } else {
+            for(size_t i = 0; i < count; i++) {
+                co2_stream_write_csv(cli, &records[i]);
+            }
+        }
+    }
+
+    dropped = stream->dropped - dropped;
+    stream->running = false;
+    furi_mutex_release(stream->mutex);
+    if(!binary) {
+        printf("# %lu samples dropped\r\n", dropped);
+    }
+}
+
+Co2Stream* co2_stream_alloc(void) {
+    Co2Stream* stream = co2_memory_alloc(sizeof(Co2Stream));
+    memset(stream, 0, sizeof(Co2Stream));
+    stream->mutex = furi_mutex_alloc(FuriMutexTypeNormal);
+    stream->buffer = furi_stream_buffer_alloc(
+        CO2_STREAM_BUFFER_RECORDS * sizeof(Co2StreamRecord), sizeof(Co2StreamRecord));
+    stream->cli = furi_record_open(RECORD_CLI);
+    cli_add_command(
+        stream->cli, CO2_STREAM_COMMAND, CliCommandFlagParallelSafe, co2_stream_command, stream);
+    return stream;
+}
+
+void co2_stream_free(Co2Stream* stream) {
+    // No new command after the delete. One still running in the CLI thread sees exiting at its
+    // next poll and returns, release included: only then the stream goes away
+    stream->exiting = true;
+    cli_delete_command(stream->cli, CO2_STREAM_COMMAND);
+    furi_check(furi_mutex_acquire(stream->mutex, FuriWaitForever) == FuriStatusOk);
+    furi_mutex_release(stream->mutex);
+    furi_mutex_free(stream->mutex);
+    furi_record_close(RECORD_CLI);
+    furi_stream_buffer_free(stream->buffer);
+    co2_memory_free(stream, sizeof(Co2Stream));
+}
+
+void co2_stream_push(
+    Co2Stream* stream,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity,
+    uint8_t flags) {
+    if(!stream->running) return;
+
+    uint32_t now = furi_get_tick();
+    if(stream->pushed > 0 && now - stream->last_tick < furi_ms_to_ticks(stream->interval)) return;
+    stream->last_tick = now;
+    stream->pushed++;
+
+    Co2StreamRecord record = {
+        .sequence = stream->sequence++,
+        .tick = (uint32_t)((uint64_t)now * 1000 / furi_kernel_get_tick_frequency()),
+        .co2 = co2,
+        .temperature = temperature,
+        .humidity = humidity,
+        .flags = flags,
+    };
+
+    // Only this thread sends, so the room checked here cannot shrink before the send. Never
+    // send a partial record: the reader relies on whole records
+    if(furi_stream_buffer_spaces_available(stream->buffer) < sizeof(record)) {
+        stream->dropped++;
+        return;
+    }
+    furi_stream_buffer_send(stream->buffer, &record, sizeof(record), 0);
+}
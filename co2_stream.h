@@ -0,0 +1,69 @@
+/*
+  Live sample streaming over the Flipper CLI (USB CDC).
+
+  The app registers a "co2" CLI command while it runs:
+    co2 stream [csv|bin] [interval_s]
+  Every sample the app reads is offered to co2_stream_push() as a fixed-size record. The push never
+  blocks: it copies the record into a stream buffer if there is room and drops it otherwise, so a
+  slow or stalled host costs samples on the host side, never sampling on the device. The CLI thread
+  drains the buffer, formats the records and writes them out until Ctrl+C.
+
+  CSV: a "seq,ms,co2,temperature,humidity" header, then one line per sample.
+  Binary frames, little-endian: u8[2] CO2_STREAM_SYNC, the Co2StreamRecord fields, u8 CRC-8
+  (the SCD4x one: polynomial 0x31, init 0xFF) of the record.
+  Sequence numbers count every offered sample, dropped ones included, so gaps show the drops.
+  tools/co2_stream.py reads either format.
+*/
+
+#ifndef __CO2_STREAM_H__
+#define __CO2_STREAM_H__
+
+#include <furi.h>
+#include <cli/cli.h>
+
+#define CO2_STREAM_COMMAND "co2"
+#define CO2_STREAM_SYNC_0 0xA5
+#define CO2_STREAM_SYNC_1 0x5A
+#define CO2_STREAM_BUFFER_RECORDS 32 // 160 s of samples at the 5 s periodic interval
+
+typedef struct __attribute__((packed)) {
+    uint32_t sequence;
+    uint32_t tick; // ms
+    uint16_t co2; // Raw SCD4x words
+    uint16_t temperature;
+    uint16_t humidity;
+    uint8_t flags; // SCD4x_SAMPLE_FLAG_*
+} Co2StreamRecord;
+
+typedef struct {
+    Cli* cli;
+    FuriStreamBuffer* buffer;
+    FuriMutex* mutex; // Held by the CLI command while it runs
+
+    // Set by the CLI thread, read by the producer
+    volatile bool running;
+    volatile bool exiting;
+    volatile uint32_t interval; // ms, 0 for every sample
+
+    // Producer side
+    uint32_t sequence;
+    uint32_t last_tick;
+    uint32_t pushed;
+    volatile uint32_t dropped;
+} Co2Stream;
+
+// Registers the CLI command
+Co2Stream* co2_stream_alloc(void);
+
+// Ends a running stream, then unregisters the command
+void co2_stream_free(Co2Stream* stream);
+
+// Offer a sample, from the sampling thread. Never blocks
+void co2_stream_push(
+    Co2Stream* stream,
+    uint16_t co2,
+    uint16_t temperature,
+    uint16_t humidity,
+    uint8_t flags);
+
+#endif
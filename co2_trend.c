@@ -0,0 +1,88 @@
+#include "co2_trend.h"
+#include <math.h>
+
+void co2_trend_init(Co2Trend* trend) {
+    memset(trend, 0, sizeof(Co2Trend));
+}
+
+static uint8_t co2_trend_oldest(const Co2Trend* trend) {
+    return (trend->head + CO2_TREND_WINDOW - trend->count) % CO2_TREND_WINDOW;
+}
+
+// Drop the oldest reading, then move the time origin to the one after it
+static void co2_trend_remove_oldest(Co2Trend* trend) {
+    uint8_t oldest = co2_trend_oldest(trend);
+    trend->sum_y -= trend->values[oldest];
+    trend->count--;
+    if(!trend->count) return;
+
+    // Sums of t - d from the sums of t, (t - d)² = t² - 2dt + d²
+    int64_t n = trend->count;
+    int64_t d = trend->ticks[(oldest + 1) % CO2_TREND_WINDOW] - trend->ticks[oldest];
+    trend->sum_tt += n * d * d - 2 * d * trend->sum_t;
+    trend->sum_ty -= d * trend->sum_y;
+    trend->sum_t -= n * d;
+}
+
+void co2_trend_update(Co2Trend* trend, uint16_t co2, uint32_t now) {
+    if(trend->count) {
+        uint32_t newest = trend->ticks[(trend->head + CO2_TREND_WINDOW - 1) % CO2_TREND_WINDOW];
+        if(now - newest > furi_ms_to_ticks(CO2_TREND_MAX_GAP_MS)) co2_trend_init(trend);
+    }
+    if(trend->count == CO2_TREND_WINDOW) co2_trend_remove_oldest(trend);
+
+    int64_t t = trend->count ? now - trend->ticks[co2_trend_oldest(trend)] : 0;
+    trend->values[trend->head] = co2;
+    trend->ticks[trend->head] = now;
+    trend->head = (trend->head + 1) % CO2_TREND_WINDOW;
+    trend->count++;
+
+    trend->sum_t += t;
+    trend->sum_y += co2;
+    trend->sum_tt += t * t;
+    trend->sum_ty += t * co2;
+}
+
+void co2_trend_forecast(
+    const Co2Trend* trend,
+    const uint16_t* thresholds,
+    size_t count,
+    Co2TrendForecast* forecast) {
+    memset(forecast, 0, sizeof(Co2TrendForecast));
+    if(trend->count < CO2_TREND_MIN_SAMPLES) return;
+
+    int64_t n = trend->count;
+    int64_t denominator = n * trend->sum_tt - trend->sum_t * trend->sum_t;
+    if(denominator <= 0) return;
+
+    // ppm per tick, and the fitted value at the newest reading. The sums are exact, only the
+    // results are single precision: float, as the Cortex-M4 FPU has no double
+    float slope = (float)(n * trend->sum_ty - trend->sum_t * trend->sum_y) / (float)denominator;
+    uint8_t newest = (trend->head + CO2_TREND_WINDOW - 1) % CO2_TREND_WINDOW;
+    int64_t t = trend->ticks[newest] - trend->ticks[co2_trend_oldest(trend)];
+    float level = ((float)trend->sum_y + slope * (float)(n * t - trend->sum_t)) / (float)n;
+
+    float ticks_per_hour = furi_ms_to_ticks(3600 * 1000);
+    forecast->slope = (int32_t)(slope * ticks_per_hour);
+    if(forecast->slope >= CO2_TREND_STEADY_PPM_H) {
+        forecast->direction = Co2TrendDirectionRising;
+    } else if(forecast->slope <= -CO2_TREND_STEADY_PPM_H) {
+        forecast->direction = Co2TrendDirectionFalling;
+    } else {
+        forecast->direction = Co2TrendDirectionSteady;
+    }
+    if(forecast->direction != Co2TrendDirectionRising) return;
+
+    for(size_t i = 0; i < count; i++) {
+        if(thresholds[i] <= level) continue;
+        // Rise of the bent line after t: slope * tau (1 - e^(-t / tau)), at most slope * tau
+        float rise = (thresholds[i] - level) / (slope * ticks_per_hour / 3600 * CO2_TREND_TAU_S);
+        if(rise >= 1) break;
+        float eta = -CO2_TREND_TAU_S * logf(1 - rise);
+        if(eta <= CO2_TREND_MAX_ETA_S) {
+            forecast->target = thresholds[i];
+            forecast->eta = (uint32_t)eta;
+        }
+        break;
+    }
+}
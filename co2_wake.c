@@ -0,0 +1,65 @@
+#include "co2_wake.h"
+#include <math.h>
+
+void co2_wake_start(Co2Wake* wake, uint32_t interval_ms) {
+    memset(wake, 0, sizeof(Co2Wake));
+    wake->period = furi_ms_to_ticks(interval_ms);
+    wake->probe_gap = 1;
+    wake->lead = furi_ms_to_ticks(CO2_WAKE_PROBE_MS);
+}
+
+// The update just read became ready between the previous poll and now: move the grid there, and
+// measure the period of the sensor clock from the previous such read
+static void co2_wake_sync(Co2Wake* wake, uint32_t now) {
+    if(wake->synced) {
+        float elapsed = (float)(now - wake->sync);
+        float updates = roundf(elapsed / wake->period);
+        if(updates >= 1) wake->period = elapsed / updates;
+    }
+    wake->sync = now;
+    wake->ready = now;
+    wake->synced = true;
+}
+
+uint32_t co2_wake_update(Co2Wake* wake, bool fresh, uint32_t now) {
+    if(!fresh) {
+        wake->not_ready = true;
+        return furi_ms_to_ticks(wake->synced ? CO2_WAKE_POLL_MS : CO2_WAKE_SEARCH_MS);
+    }
+
+    bool probe = wake->probing;
+    if(wake->not_ready) {
+        co2_wake_sync(wake, now);
+        if(probe) {
+            wake->lead = furi_ms_to_ticks(CO2_WAKE_PROBE_MS);
+            wake->probe_gap = MIN(wake->probe_gap * 2, CO2_WAKE_PROBE_SAMPLES);
+        }
+    } else if(!wake->synced) {
+        // Ready for an unknown time already, find out on the next update
+        wake->ready = now;
+        wake->samples = wake->probe_gap;
+    } else {
+        // Next point of the grid before now, or now if the update came earlier than that
+        float updates = MAX(floorf((float)(now - wake->ready) / wake->period), 1.0f);
+        uint32_t grid = wake->ready + (uint32_t)(updates * wake->period);
+        wake->ready = (int32_t)(grid - now) > 0 ? now : grid;
+        // A probe that found the update ready came too late: the clock runs fast by more than
+        // its lead, probe again earlier
+        if(probe) {
+            wake->lead = MIN(wake->lead * 2, (uint32_t)(wake->period / 4));
+            wake->samples = wake->probe_gap;
+        }
+    }
+    wake->not_ready = false;
+
+    uint32_t next = wake->ready + (uint32_t)wake->period;
+    wake->probing = ++wake->samples >= wake->probe_gap;
+    if(wake->probing) {
+        wake->samples = 0;
+        next -= wake->lead;
+    } else {
+        next += furi_ms_to_ticks(CO2_WAKE_MARGIN_MS);
+    }
+    int32_t wait = (int32_t)(next - now);
+    return wait > 0 ? (uint32_t)wait : 1;
+}
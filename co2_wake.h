@@ -0,0 +1,51 @@
+/*
+  Wake-up schedule of headless mode, aligned to the sensor updates.
+
+  The sensor makes a new measurement every interval on its own clock. Waking up a fixed interval
+  after each read adds the read and scheduling time to every period, so the wake-ups slide along
+  the updates and skip one whenever they have slid by a whole interval. Instead the ready instant
+  of the update just read is estimated and the next wake-up is placed on its grid, a margin after
+  the next update.
+  The ready instant is only known when a not-ready answer came just before the read: a wake-up
+  that finds nothing polls again after CO2_WAKE_POLL_MS, which also re-syncs the grid on a sensor
+  clock running slow. Some wake-ups come early on purpose (probes) to catch a clock running fast,
+  every sample at first and then every 2, 4.. up to CO2_WAKE_PROBE_SAMPLES samples. The period
+  of the sensor clock is measured between the reads found between two polls.
+
+  Over a simulated day with the sensor clock exact, 0.5% or 2% fast or slow and up to 30 ms of
+  wake-up jitter (tests/test_co2_wake.c): no update skipped, reads 80 ms after the update on
+  average, 1.07 wake-ups per sample at 5 s and 1.17 at 30 s. Waking up the interval plus 50 ms
+  after each read skipped one update in 75 at 5 s with an exact clock, one in 30 at 2% fast.
+*/
+
+#ifndef __CO2_WAKE_H__
+#define __CO2_WAKE_H__
+
+#include <furi.h>
+
+#define CO2_WAKE_MARGIN_MS 50 // After the estimated ready instant
+#define CO2_WAKE_POLL_MS 25 // Between polls while synced
+#define CO2_WAKE_SEARCH_MS 100 // Between polls while the grid is unknown
+#define CO2_WAKE_PROBE_SAMPLES 24
+#define CO2_WAKE_PROBE_MS 50
+
+typedef struct {
+    float period; // Ticks between updates, measured on the sensor clock
+    bool synced; // sync is known
+    uint32_t sync; // Ready instant of the last update found between two polls
+    uint32_t ready; // Estimated ready instant of the last update read
+    bool not_ready; // The previous wake-up found nothing
+    bool probing; // This wake-up comes lead early
+    uint32_t lead;
+    uint8_t probe_gap; // Samples between probes, doubles up to CO2_WAKE_PROBE_SAMPLES
+    uint8_t samples; // Since the last probe
+} Co2Wake;
+
+// Forget the grid, for a sensor (re)started with updates every interval_ms
+void co2_wake_start(Co2Wake* wake, uint32_t interval_ms);
+
+// After a read attempt at now, fresh when it returned a measurement. Returns the ticks until the
+// next wake-up, at least 1
+uint32_t co2_wake_update(Co2Wake* wake, bool fresh, uint32_t now);
+
+#endif
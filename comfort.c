@@ -0,0 +1,83 @@
+#include "comfort.h"
+#include <math.h>
+
+#define COMFORT_TABLE_SIZE ((COMFORT_TABLE_MAX_C - COMFORT_TABLE_MIN_C) / COMFORT_TABLE_STEP_C + 1)
+
+// Magnus saturation vapour pressure in hPa at COMFORT_TABLE_MIN_C + i * COMFORT_TABLE_STEP_C
+static const float comfort_saturation_table[COMFORT_TABLE_SIZE] = {
+    0.0638208f, 0.0715465f, 0.0801136f, 0.0896032f, 0.100103f, 0.111708f, 0.124521f, 0.138654f,
+    0.154225f, 0.171365f, 0.190212f, 0.210916f, 0.233638f, 0.258551f, 0.285841f, 0.315707f,
+    0.348362f, 0.384035f, 0.42297f, 0.465428f, 0.511689f, 0.56205f, 0.616829f, 0.676365f,
+    0.741017f, 0.811171f, 0.887233f, 0.969638f, 1.05885f, 1.15534f, 1.25965f, 1.37232f,
+    1.49392f, 1.62508f, 1.76645f, 1.91871f, 2.08259f, 2.25886f, 2.44833f, 2.65184f,
+    2.87031f, 3.10468f, 3.35593f, 3.62514f, 3.91339f, 4.22185f, 4.55173f, 4.90431f,
+    5.28093f, 5.68301f, 6.112f, 6.56946f, 7.057f, 7.57632f, 8.12918f, 8.71743f,
+    9.343f, 10.0079f, 10.7143f, 11.4643f, 12.2603f, 13.1046f, 13.9998f, 14.9483f,
+    15.9531f, 17.0167f, 18.1423f, 19.3327f, 20.5913f, 21.9212f, 23.326f, 24.809f,
+    26.3742f, 28.0251f, 29.7659f, 31.6006f, 33.5334f, 35.5689f, 37.7115f, 39.966f,
+    42.3372f, 44.8303f, 47.4505f, 50.2031f, 53.0939f, 56.1284f, 59.3128f, 62.6531f,
+    66.1558f, 69.8274f, 73.6746f, 77.7044f, 81.9241f, 86.3409f, 90.9627f, 95.7971f,
+    100.852f, 106.137f, 111.659f, 117.427f, 123.452f, 129.741f, 136.304f, 143.152f,
+    150.294f, 157.742f, 165.504f, 173.593f, 182.02f, 190.796f, 199.933f,
+};
+
+float comfort_saturation_pressure(float temperature) {
+    float position = (temperature - COMFORT_TABLE_MIN_C) / COMFORT_TABLE_STEP_C;
+    if(position <= 0) return comfort_saturation_table[0];
+    if(position >= COMFORT_TABLE_SIZE - 1) return comfort_saturation_table[COMFORT_TABLE_SIZE - 1];
+
+    uint8_t i = (uint8_t)position;
+    float fraction = position - i;
+    return comfort_saturation_table[i] +
+           fraction * (comfort_saturation_table[i + 1] - comfort_saturation_table[i]);
+}
+
+// Temperature at which the saturation vapour pressure equals pressure (hPa), the table inverted
+static float comfort_saturation_temperature(float pressure) {
+    if(pressure <= comfort_saturation_table[0]) return COMFORT_TABLE_MIN_C;
+    if(pressure >= comfort_saturation_table[COMFORT_TABLE_SIZE - 1]) return COMFORT_TABLE_MAX_C;
+
+    // Last entry <= pressure
+    uint8_t lo = 0;
+    uint8_t hi = COMFORT_TABLE_SIZE - 1;
+    while(hi - lo > 1) {
+        uint8_t mid = (lo + hi) / 2;
+        if(comfort_saturation_table[mid] <= pressure) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    float fraction = (pressure - comfort_saturation_table[lo]) /
+                     (comfort_saturation_table[lo + 1] - comfort_saturation_table[lo]);
+    return COMFORT_TABLE_MIN_C + (lo + fraction) * COMFORT_TABLE_STEP_C;
+}
+
+// NWS heat index (Rothfusz regression and adjustments), in and out in F
+static float comfort_heat_index_f(float t, float rh) {
+    float simple = 0.5f * (t + 61.0f + (t - 68.0f) * 1.2f + rh * 0.094f);
+    if((simple + t) / 2 < 80.0f) return simple;
+
+    float hi = -42.379f + 2.04901523f * t + 10.14333127f * rh - 0.22475541f * t * rh -
+               0.00683783f * t * t - 0.05481717f * rh * rh + 0.00122874f * t * t * rh +
+               0.00085282f * t * rh * rh - 0.00000199f * t * t * rh * rh;
+    if(rh < 13.0f && t >= 80.0f && t <= 112.0f) {
+        hi -= (13.0f - rh) / 4 * sqrtf((17.0f - fabsf(t - 95.0f)) / 17);
+    } else if(rh > 85.0f && t >= 80.0f && t <= 87.0f) {
+        hi += (rh - 85.0f) / 10 * (87.0f - t) / 5;
+    }
+    return hi;
+}
+
+void comfort_compute(ComfortMetrics* metrics, float temperature, float humidity) {
+    humidity = CLAMP(humidity, 100.0f, 0.0f);
+    float vapour_pressure = comfort_saturation_pressure(temperature) * humidity / 100;
+
+    metrics->dew_point = comfort_saturation_temperature(vapour_pressure);
+    // Ideal gas: 100 Pa/hPa * 1000 g/kg / 461.5 J/(kg K), water vapour gas constant
+    metrics->absolute_humidity = 216.68f * vapour_pressure / (temperature + 273.15f);
+
+    float fahrenheit = temperature * 9 / 5 + 32;
+    metrics->heat_index = (comfort_heat_index_f(fahrenheit, humidity) - 32) * 5 / 9;
+}
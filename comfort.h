@@ -0,0 +1,41 @@
+/*
+  Derived comfort metrics: dew point, absolute humidity and heat index.
+
+  The saturation vapour pressure over water follows the Magnus formula
+  es(T) = 6.112 hPa * exp(17.62 T / (243.12 + T)). Instead of expf/logf it is read from a table
+  covering COMFORT_TABLE_MIN_C..COMFORT_TABLE_MAX_C in COMFORT_TABLE_STEP_C steps with linear
+  interpolation, and the dew point is found by inverting the same table (binary search + linear
+  interpolation). Heat index is the NWS Rothfusz regression with its adjustments, polynomials only.
+
+  Error against the exact Magnus formula (libm), for T -10..60 C and RH 0..100% (the SCD4x
+  operating range), checked on every temperature word and every 16th humidity word by
+  tests/test_comfort.c:
+  * saturation vapour pressure: < 0.07% relative
+  * absolute humidity: < 0.03 g/m3
+  * dew point: < 0.015 C (dew points below COMFORT_TABLE_MIN_C, RH < 2.3% at -10 C, are clamped)
+  * heat index: < 0.001 C against the regression in double, off the point where the NWS procedure
+    switches to the regression (it jumps there by up to 1.2 C)
+*/
+
+#ifndef __COMFORT_H__
+#define __COMFORT_H__
+
+#include <furi.h>
+
+#define COMFORT_TABLE_MIN_C -50
+#define COMFORT_TABLE_MAX_C 60
+#define COMFORT_TABLE_STEP_C 1
+
+typedef struct {
+    float dew_point; // C
+    float absolute_humidity; // g/m3
+    float heat_index; // C, apparent temperature
+} ComfortMetrics;
+
+// Saturation vapour pressure over water in hPa, temperature clamped to the table range
+float comfort_saturation_pressure(float temperature);
+
+// Compute all the metrics from a temperature (C) and relative humidity (%) pair
+void comfort_compute(ComfortMetrics* metrics, float temperature, float humidity);
+
+#endif
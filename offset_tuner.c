@@ -0,0 +1,76 @@
+#include "offset_tuner.h"
+#include <math.h>
+
+void offset_tuner_reset(OffsetTuner* tuner, uint32_t now) {
+    memset(tuner, 0, sizeof(OffsetTuner));
+    tuner->start_tick = now;
+}
+
+void offset_tuner_feed(OffsetTuner* tuner, float sensor, float reference, uint32_t now) {
+    int32_t d = (int32_t)lroundf((sensor - reference) * 100.0f);
+    d = CLAMP(d, INT16_MAX, INT16_MIN);
+    int64_t t = (now - tuner->start_tick) / furi_ms_to_ticks(1000);
+
+    if(tuner->count == OFFSET_TUNER_WINDOW) {
+        int64_t old_t = tuner->time[tuner->head];
+        int64_t old_d = tuner->difference[tuner->head];
+        tuner->sum_t -= old_t;
+        tuner->sum_tt -= old_t * old_t;
+        tuner->sum_d -= old_d;
+        tuner->sum_dd -= old_d * old_d;
+        tuner->sum_td -= old_t * old_d;
+    } else {
+        tuner->count++;
+    }
+
+    tuner->time[tuner->head] = t;
+    tuner->difference[tuner->head] = d;
+    tuner->sum_t += t;
+    tuner->sum_tt += t * t;
+    tuner->sum_d += d;
+    tuner->sum_dd += d * d;
+    tuner->sum_td += t * d;
+    tuner->head = (tuner->head + 1) % OFFSET_TUNER_WINDOW;
+
+    tuner->sensor = sensor;
+    tuner->reference = reference;
+}
+
+bool offset_tuner_get_fit(const OffsetTuner* tuner, OffsetTunerFit* fit) {
+    if(tuner->count < 3) return false;
+
+    uint8_t newest = (tuner->head + OFFSET_TUNER_WINDOW - 1) % OFFSET_TUNER_WINDOW;
+    uint8_t oldest = tuner->count == OFFSET_TUNER_WINDOW ? tuner->head : 0;
+    float span = (float)(tuner->time[newest] - tuner->time[oldest]);
+
+    // Integer sums are exact, only the final divisions are rounded
+    int64_t n = tuner->count;
+    float sxx = (float)(n * tuner->sum_tt - tuner->sum_t * tuner->sum_t);
+    float sxy = (float)(n * tuner->sum_td - tuner->sum_t * tuner->sum_d);
+    float syy = (float)(n * tuner->sum_dd - tuner->sum_d * tuner->sum_d);
+    float slope = sxx > 0 ? sxy / sxx : 0; // Centidegrees per second
+
+    float mean_t = (float)tuner->sum_t / (float)n;
+    float mean_d = (float)tuner->sum_d / (float)n;
+    float sse = sxx > 0 ? (syy - sxy * slope) / (float)n : syy / (float)n;
+
+    fit->difference = (mean_d + slope * ((float)tuner->time[newest] - mean_t)) / 100.0f;
+    fit->drift = slope * span / 100.0f;
+    fit->noise = sqrtf(MAX(sse, 0.0f) / (float)(n - 2)) / 100.0f;
+    return true;
+}
+
+bool offset_tuner_is_settled(const OffsetTuner* tuner) {
+    OffsetTunerFit fit;
+    return tuner->count == OFFSET_TUNER_WINDOW && offset_tuner_get_fit(tuner, &fit) &&
+           fabsf(fit.drift) <= OFFSET_TUNER_MAX_DRIFT_C && fit.noise <= OFFSET_TUNER_MAX_NOISE_C;
+}
+
+float offset_tuner_get_offset(const OffsetTuner* tuner, float current_offset, float max_offset) {
+    OffsetTunerFit fit;
+    if(!offset_tuner_get_fit(tuner, &fit)) return current_offset;
+    // The sensor reports its temperature minus the offset, a positive difference is heat the
+    // offset does not account for yet
+    float offset = current_offset + fit.difference;
+    return CLAMP(offset, max_offset, 0.0f);
+}
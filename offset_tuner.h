@@ -0,0 +1,64 @@
+/*
+  Temperature offset tuning against a reference thermometer.
+
+  The SCD4x reads warmer than the air around it by its self-heating (and that of whatever it is
+  mounted next to), minus the temperature offset it is configured with. After a start the
+  difference to a reference thermometer placed next to it settles over tens of minutes.
+
+  Every SCD4x sample is paired with a reference reading, and the differences of the last
+  OFFSET_TUNER_WINDOW pairs are fitted with a least squares line. The sums are kept as integers
+  (centidegrees, seconds since the tuner was reset), so sliding the window is O(1) and exact.
+  The difference has settled once the window is full, the fitted line moves by at most
+  OFFSET_TUNER_MAX_DRIFT_C across the window and the residuals stay within
+  OFFSET_TUNER_MAX_NOISE_C. The offset to configure is then the current one plus the fitted
+  difference at the newest sample.
+*/
+
+#ifndef __OFFSET_TUNER_H__
+#define __OFFSET_TUNER_H__
+
+#include <furi.h>
+
+#define OFFSET_TUNER_WINDOW 120 // 10 minutes at the 5 s periodic interval
+#define OFFSET_TUNER_MAX_DRIFT_C 0.05f
+#define OFFSET_TUNER_MAX_NOISE_C 0.2f
+
+typedef struct {
+    int16_t difference[OFFSET_TUNER_WINDOW]; // SCD4x - reference, centidegrees
+    uint32_t time[OFFSET_TUNER_WINDOW]; // s since the reset
+    uint8_t head;
+    uint8_t count;
+    uint32_t start_tick;
+
+    // Sums over the window
+    int64_t sum_t;
+    int64_t sum_tt;
+    int64_t sum_d;
+    int64_t sum_dd;
+    int64_t sum_td;
+
+    // Last pair, C
+    float sensor;
+    float reference;
+} OffsetTuner;
+
+typedef struct {
+    float difference; // Fitted SCD4x - reference at the newest sample, C
+    float drift; // Change of the fitted line across the window, C
+    float noise; // Standard deviation of the residuals, C
+} OffsetTunerFit;
+
+void offset_tuner_reset(OffsetTuner* tuner, uint32_t now);
+
+// Add a pair of readings in C, taken at tick now
+void offset_tuner_feed(OffsetTuner* tuner, float sensor, float reference, uint32_t now);
+
+// Fit the window. Returns false if there are fewer than 3 pairs
+bool offset_tuner_get_fit(const OffsetTuner* tuner, OffsetTunerFit* fit);
+
+bool offset_tuner_is_settled(const OffsetTuner* tuner);
+
+// Offset to configure instead of current_offset, clamped to [0, max_offset]
+float offset_tuner_get_offset(const OffsetTuner* tuner, float current_offset, float max_offset);
+
+#endif
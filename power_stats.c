@@ -0,0 +1,39 @@
+#include "power_stats.h"
+#include <furi_hal_power.h>
+
+void power_stats_reset(PowerStats* stats, uint32_t now) {
+    memset(stats, 0, sizeof(PowerStats));
+    stats->start_tick = now;
+    stats->last_sample_tick = now;
+}
+
+void power_stats_wakeup(PowerStats* stats, uint32_t now) {
+    stats->wakeups++;
+
+    if(now - stats->last_sample_tick < furi_ms_to_ticks(POWER_STATS_SAMPLE_INTERVAL_MS)) return;
+    stats->last_sample_tick = now;
+
+    // The fuel gauge reports the current in A, negative while discharging
+    float current = -furi_hal_power_get_battery_current(FuriHalPowerICFuelGauge) * 1000.0f;
+    if(current > 0) {
+        stats->current_sum += current;
+        stats->current_samples++;
+    }
+}
+
+uint32_t power_stats_get_wakeups_per_hour(const PowerStats* stats, uint32_t now) {
+    uint32_t elapsed = now - stats->start_tick;
+    if(elapsed == 0) return 0;
+    return (uint32_t)((uint64_t)stats->wakeups * furi_ms_to_ticks(60 * 60 * 1000) / elapsed);
+}
+
+float power_stats_get_current(const PowerStats* stats) {
+    if(stats->current_samples == 0) return 0;
+    return stats->current_sum / stats->current_samples;
+}
+
+float power_stats_get_battery_hours(const PowerStats* stats) {
+    float current = power_stats_get_current(stats);
+    if(current <= 0) return 0;
+    return furi_hal_power_get_battery_remaining_capacity() / current;
+}
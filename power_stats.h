@@ -0,0 +1,36 @@
+/*
+  Wakeup and battery drain accounting for the main loop.
+
+  Every processed event counts as a wakeup. The battery current is sampled from the fuel gauge at
+  most every POWER_STATS_SAMPLE_INTERVAL_MS and averaged to estimate the remaining battery life
+  in the current mode.
+*/
+
+#ifndef __POWER_STATS_H__
+#define __POWER_STATS_H__
+
+#include <furi.h>
+
+#define POWER_STATS_SAMPLE_INTERVAL_MS (10 * 1000)
+
+typedef struct {
+    uint32_t start_tick;
+    uint32_t wakeups;
+    uint32_t last_sample_tick;
+    uint32_t current_samples;
+    float current_sum; // mA, positive when discharging
+} PowerStats;
+
+void power_stats_reset(PowerStats* stats, uint32_t now);
+
+void power_stats_wakeup(PowerStats* stats, uint32_t now);
+
+uint32_t power_stats_get_wakeups_per_hour(const PowerStats* stats, uint32_t now);
+
+// Average discharge current in mA, 0 if unknown or charging
+float power_stats_get_current(const PowerStats* stats);
+
+// Estimated hours left on the remaining battery capacity at the average current, 0 if unknown
+float power_stats_get_battery_hours(const PowerStats* stats);
+
+#endif
@@ -0,0 +1,73 @@
+#include "pressure_comp.h"
+
+#define PRESSURE_COMP_HOUR_MS (60 * 60 * 1000)
+
+static void pressure_comp_roll_hour(PressureComp* comp, uint32_t now) {
+    uint32_t hour_ticks = furi_ms_to_ticks(PRESSURE_COMP_HOUR_MS);
+    if(now - comp->hour_start_tick < hour_ticks) return;
+
+    // If more than one hour went by without any sample the last hour had no writes
+    comp->writes_last_hour =
+        (now - comp->hour_start_tick < 2 * hour_ticks) ? comp->writes_this_hour : 0;
+    comp->writes_this_hour = 0;
+    comp->hour_start_tick = now;
+}
+
+void pressure_comp_reset(PressureComp* comp, uint32_t now) {
+    memset(comp, 0, sizeof(PressureComp));
+    comp->hour_start_tick = now;
+    comp->writes_last_hour = UINT16_MAX; // No full hour yet
+}
+
+bool pressure_comp_feed(PressureComp* comp, uint32_t pressure, uint32_t now) {
+    pressure_comp_roll_hour(comp, now);
+
+    if(pressure < PRESSURE_COMP_MIN_PA || pressure > PRESSURE_COMP_MAX_PA) return false;
+
+    if(!comp->primed) {
+        comp->filtered = pressure << PRESSURE_COMP_FILTER_SHIFT;
+        comp->primed = true;
+    } else {
+        // filtered += (sample - filtered) / 2^shift, kept in fixed point to avoid losing the fraction
+        comp->filtered -= comp->filtered >> PRESSURE_COMP_FILTER_SHIFT;
+        comp->filtered += pressure;
+    }
+
+    bool attempted = comp->written || comp->write_errors > 0;
+    if(attempted && now - comp->last_write_tick < furi_ms_to_ticks(PRESSURE_COMP_MIN_INTERVAL_MS))
+        return false;
+
+    // The first value is always written, the sensor may hold an unrelated altitude setting
+    if(!comp->written) return true;
+
+    uint32_t filtered = pressure_comp_get_pressure(comp);
+    uint32_t delta = filtered > comp->last_written ? filtered - comp->last_written :
+                                                     comp->last_written - filtered;
+    return delta >= PRESSURE_COMP_THRESHOLD_PA;
+}
+
+uint32_t pressure_comp_get_pressure(const PressureComp* comp) {
+    // Round to the nearest Pa
+    return (comp->filtered + (1 << (PRESSURE_COMP_FILTER_SHIFT - 1))) >>
+           PRESSURE_COMP_FILTER_SHIFT;
+}
+
+void pressure_comp_commit(PressureComp* comp, bool success, uint32_t now) {
+    // Failed writes are rate limited too, so a flaky bus is not hammered every poll
+    comp->last_write_tick = now;
+
+    if(!success) {
+        comp->write_errors++;
+        return;
+    }
+
+    comp->written = true;
+    comp->last_written = pressure_comp_get_pressure(comp);
+    comp->writes_total++;
+    if(comp->writes_this_hour < UINT16_MAX) comp->writes_this_hour++;
+}
+
+uint16_t pressure_comp_get_writes_per_hour(const PressureComp* comp) {
+    if(comp->writes_last_hour == UINT16_MAX) return comp->writes_this_hour;
+    return comp->writes_last_hour;
+}
@@ -0,0 +1,55 @@
+/*
+  Ambient pressure compensation feed for the SCD4x.
+
+  Pressure samples from an external barometer are low-pass filtered and pushed to the sensor with
+  setAmbientPressure() only when the filtered value moved by more than PRESSURE_COMP_THRESHOLD_PA
+  since the last write, and never more often than once every PRESSURE_COMP_MIN_INTERVAL_MS.
+  The SCD4x accepts set_ambient_pressure during periodic measurements, so no stop/start is needed.
+*/
+
+#ifndef __PRESSURE_COMP_H__
+#define __PRESSURE_COMP_H__
+
+#include <furi.h>
+
+// The sensor takes the pressure in 100 Pa steps, smaller thresholds would only cause redundant writes
+#define PRESSURE_COMP_THRESHOLD_PA 200
+#define PRESSURE_COMP_MIN_INTERVAL_MS (60 * 1000)
+#define PRESSURE_COMP_POLL_INTERVAL_MS (10 * 1000)
+// EMA weight of a new sample is 1 / 2^PRESSURE_COMP_FILTER_SHIFT
+#define PRESSURE_COMP_FILTER_SHIFT 3
+
+// Plausible range for the barometer, anything outside is treated as a bad read
+#define PRESSURE_COMP_MIN_PA 30000
+#define PRESSURE_COMP_MAX_PA 110000
+
+typedef struct {
+    bool primed;
+    uint32_t filtered; // Filtered pressure in Pa << PRESSURE_COMP_FILTER_SHIFT
+    uint32_t last_written; // Last pressure pushed to the sensor, in Pa
+    uint32_t last_write_tick;
+    bool written;
+
+    // Compensation write statistics
+    uint32_t writes_total;
+    uint32_t write_errors;
+    uint32_t hour_start_tick;
+    uint16_t writes_this_hour;
+    uint16_t writes_last_hour;
+} PressureComp;
+
+void pressure_comp_reset(PressureComp* comp, uint32_t now);
+
+// Feed a new barometer sample (Pa). Returns true if the filtered pressure should be written to the sensor.
+bool pressure_comp_feed(PressureComp* comp, uint32_t pressure, uint32_t now);
+
+// Filtered pressure in Pa
+uint32_t pressure_comp_get_pressure(const PressureComp* comp);
+
+// Record the outcome of a setAmbientPressure() call issued after pressure_comp_feed() returned true
+void pressure_comp_commit(PressureComp* comp, bool success, uint32_t now);
+
+// Compensation writes during the last full hour, or the running count if no hour has elapsed yet
+uint16_t pressure_comp_get_writes_per_hour(const PressureComp* comp);
+
+#endif
@@ -18,20 +18,36 @@
 */
 
 #include "scd4x.h"
+#include "seqlock.h"
 
 uint32_t TIMEOUT;
-#define I2C_BUS &furi_hal_i2c_handle_external
+static FuriHalI2cBusHandle* _i2cBus = &furi_hal_i2c_handle_external;
 
 bool _printDebug = false;
 
-//Sensor type
+//Sensor type, fixed at compile time unless SCD4x_VARIANT is SCD4x_VARIANT_RUNTIME
+#if SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME
 scd4x_sensor_type_e _sensorType;
+#else
+#define _sensorType \
+    (SCD4x_VARIANT == SCD4x_VARIANT_SCD41 ? SCD4x_SENSOR_SCD41 : SCD4x_SENSOR_SCD40)
+#endif
 
 //Global main datums
 float _co2 = 0;
 float _temperature = 0;
 float _humidity = 0;
 
+//Raw output words of the last measurement
+uint16_t _co2Raw = 0;
+uint16_t _temperatureRaw = 0;
+uint16_t _humidityRaw = 0;
+
+//Latest measurement, published for readers on other threads
+static scd4x_sample_t _sample = {0};
+static SeqLock _sampleLock = {0};
+static uint32_t _sampleSequence = 0;
+
 //These track the staleness of the current data
 //This allows us to avoid calling readMeasurement() every time individual datums are requested
 bool co2HasBeenReported = true;
@@ -41,9 +57,49 @@ bool temperatureHasBeenReported = true;
 //Keep track of whether periodic measurements are in progress
 bool periodicMeasurementsAreRunning = false;
 
+//The last single shot measured T and RH only, its CO2 word reads 0. The CO2 of the last full
+//measurement is carried over instead, with the time it was read
+static bool _singleShotRHTOnly = false;
+static uint32_t _co2Timestamp = 0;
+
+//Bus access, see SCD4x_setTransport()
+static const scd4x_transport_t* _transport = &scd4x_i2c_transport;
+static void transportDelay(uint32_t delayMillis);
+
+//Bus statistics, published for readers on other threads
+static scd4x_bus_stats_t _busStats = {0};
+static SeqLock _busStatsLock = {0};
+static void busStatsTransfer(bool command, bool success, uint32_t startCycles);
+static void busStatsCrcFailure(void);
+
+//Sample timing, see scd4x_timing_stats_t
+#define SCD4x_CLOCK_TOLERANCE_DIVIDER 50 // The sensor update interval is within 2%
+static uint32_t _sampleInterval = 0; // Ticks, 0 while measurements are stopped
+static bool _sampleTimed = false; // A read since the start the next one can be placed after
+static uint32_t _sampleReadyLo = 0; // When the update read last became ready, at the earliest
+static uint32_t _sampleReadyHi = 0; // and at the latest
+static uint32_t _sampleNotReadyTick = 0;
+static bool _sampleNotReadySeen = false; // A not-ready answer since the last read
+static bool _sampleAmbiguous = false; // The last read may have been one update earlier
+static uint32_t _sensorSequence = 0;
+static scd4x_timing_stats_t _timingStats = {0};
+static SeqLock _timingStatsLock = {0};
+static const uint16_t _latencyLimitsMillis[SCD4x_LATENCY_BUCKETS - 1] =
+    {100, 250, 500, 1000, 2000};
+static void sampleTimingStart(uint32_t intervalMillis);
+static void sampleTimingNotReady(uint32_t timestamp);
+static bool readSerialNumber(char* serialNumber, uint16_t delayMillis);
+static bool transportBegin(void);
+static void transportEnd(void);
+static uint16_t sampleTimingUpdate(uint32_t timestamp);
+
 void SCD4x_init(scd4x_sensor_type_e sensorType) {
     // Constructor
+#if SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME
     _sensorType = sensorType;
+#else
+    UNUSED(sensorType);
+#endif
     TIMEOUT = furi_ms_to_ticks(100);
 }
 
@@ -92,6 +148,24 @@ void enableDebugging() {
 #endif // if SCD4x_ENABLE_DEBUGLOG
 }
 
+void getBusStats(scd4x_bus_stats_t* stats) {
+    seqlock_read(&_busStatsLock, stats, &_busStats, sizeof(scd4x_bus_stats_t));
+}
+
+void resetBusStats(void) {
+    scd4x_bus_stats_t empty = {0};
+    seqlock_write(&_busStatsLock, &_busStats, &empty, sizeof(scd4x_bus_stats_t));
+}
+
+void getTimingStats(scd4x_timing_stats_t* stats) {
+    seqlock_read(&_timingStatsLock, stats, &_timingStats, sizeof(scd4x_timing_stats_t));
+}
+
+void resetTimingStats(void) {
+    scd4x_timing_stats_t empty = {0};
+    seqlock_write(&_timingStatsLock, &_timingStats, &empty, sizeof(scd4x_timing_stats_t));
+}
+
 //Start periodic measurements. See 3.5.1
 //signal update interval is 5 seconds.
 bool startPeriodicMeasurement(void) {
@@ -108,7 +182,11 @@ bool startPeriodicMeasurement(void) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_START_PERIODIC_MEASUREMENT);
-    if(success) periodicMeasurementsAreRunning = true;
+    if(success) {
+        periodicMeasurementsAreRunning = true;
+        _singleShotRHTOnly = false;
+        sampleTimingStart(SCD4x_PERIODIC_INTERVAL_MS);
+    }
     return success;
 }
 
@@ -121,10 +199,13 @@ bool stopPeriodicMeasurement(uint16_t delayMillis) {
     bool i2cResult = sendCommand(SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT);
 
     if(i2cResult == true) {
+#if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
             furi_log_print_format(FuriLogLevelDebug, "SCD4x", "stopPeriodicMeasurement: tx ok");
+#endif // if SCD4x_ENABLE_DEBUGLOG
         periodicMeasurementsAreRunning = false;
-        if(delayMillis > 0) furi_delay_ms(delayMillis);
+        sampleTimingStart(0);
+        if(delayMillis > 0) transportDelay(delayMillis);
         return true;
     }
 
@@ -157,7 +238,7 @@ bool readMeasurement(void) {
     bool success = sendCommand(SCD4x_COMMAND_READ_MEASUREMENT);
     if(!success) return false;
 
-    furi_delay_ms(100);
+    transportDelay(1); //Datasheet: execution time 1 ms
 
     uint8_t data[9] = {0x00};
     bool rx_success = recvData(data, 9);
@@ -224,6 +305,7 @@ bool readMeasurement(void) {
     }
 
     if(error) {
+        busStatsCrcFailure();
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
             furi_log_print_format(
@@ -233,10 +315,34 @@ bool readMeasurement(void) {
 #endif // if SCD4x_ENABLE_DEBUGLOG
         return false;
     }
-    //Now copy the int16s into their associated floats
+    uint32_t timestamp = furi_get_tick();
+    uint16_t flags = sampleTimingUpdate(timestamp);
+    if(_singleShotRHTOnly) {
+        tempCO2.unsigned16 = _co2Raw;
+        flags |= SCD4x_SAMPLE_FLAG_RHT_ONLY;
+    } else {
+        _co2Timestamp = timestamp;
+    }
+
+    //Keep the raw words, then convert the int16s into their associated floats
+    _co2Raw = tempCO2.unsigned16;
+    _temperatureRaw = tempTemperature.unsigned16;
+    _humidityRaw = tempHumidity.unsigned16;
     _co2 = (float)tempCO2.unsigned16;
-    _temperature = -45 + (((float)tempTemperature.unsigned16) * 175 / 65536);
-    _humidity = ((float)tempHumidity.unsigned16) * 100 / 65536;
+    _temperature = convertTemperature(tempTemperature.unsigned16);
+    _humidity = convertHumidity(tempHumidity.unsigned16);
+
+    scd4x_sample_t sample = {
+        .co2 = tempCO2.unsigned16,
+        .temperature = tempTemperature.unsigned16,
+        .humidity = tempHumidity.unsigned16,
+        .flags = SCD4x_SAMPLE_FLAG_VALID | flags,
+        .timestamp = timestamp,
+        .co2Timestamp = _co2Timestamp,
+        .sequence = ++_sampleSequence,
+        .sensorSequence = _sensorSequence,
+    };
+    seqlock_write(&_sampleLock, &_sample, &sample, sizeof(sample));
 
     //Mark our global variables as fresh
     co2HasBeenReported = false;
@@ -279,6 +385,30 @@ float getTemperature(void) {
     return _temperature;
 }
 
+//Copies the latest measurement published by readMeasurement()
+bool getLatestSample(scd4x_sample_t* sample) {
+    seqlock_read(&_sampleLock, sample, &_sample, sizeof(scd4x_sample_t));
+    return sample->flags & SCD4x_SAMPLE_FLAG_VALID;
+}
+
+//Returns the raw words of the latest measurement, without triggering a new read
+//The words can be converted with convertTemperature() and convertHumidity()
+void getRawMeasurement(uint16_t* co2, uint16_t* temperature, uint16_t* humidity) {
+    *co2 = _co2Raw;
+    *temperature = _temperatureRaw;
+    *humidity = _humidityRaw;
+}
+
+//T = -45 + 175 * word / 2^16
+float convertTemperature(uint16_t temperatureWord) {
+    return -45 + (((float)temperatureWord) * 175 / 65536);
+}
+
+//RH = 100 * word / 2^16
+float convertHumidity(uint16_t humidityWord) {
+    return ((float)humidityWord) * 100 / 65536;
+}
+
 //Set the temperature offset (C). See 3.6.1
 //Max command duration: 1ms
 //The user can set delayMillis to zero f they want the function to return immediately.
@@ -318,7 +448,7 @@ bool setTemperatureOffset(float offset, uint16_t delayMillis) {
     }
     uint16_t offsetWord = (uint16_t)(offset * 65536 / 175); // Toffset [°C] * 2^16 / 175
     bool success = sendCommandArgs(SCD4x_COMMAND_SET_TEMPERATURE_OFFSET, offsetWord);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -363,7 +493,7 @@ bool setSensorAltitude(uint16_t altitude, uint16_t delayMillis) {
     }
 
     bool success = sendCommandArgs(SCD4x_COMMAND_SET_SENSOR_ALTITUDE, altitude);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -410,7 +540,7 @@ bool setAmbientPressure(float pressure, uint16_t delayMillis) {
     }
     uint16_t pressureWord = (uint16_t)(pressure / 100);
     bool success = sendCommandArgs(SCD4x_COMMAND_SET_AMBIENT_PRESSURE, pressureWord);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -423,6 +553,7 @@ bool setAmbientPressure(float pressure, uint16_t delayMillis) {
 //3. Subsequently issue the perform_forced_recalibration command and optionally read out the FRC correction
 //   (i.e. the magnitude of the correction) after waiting for 400 ms for the command to complete.
 //A return value of 0xffff indicates that the forced recalibration has failed.
+#if SCD4x_ENABLE_FRC
 bool performForcedRecalibration(uint16_t concentration, float* correction) {
     if(periodicMeasurementsAreRunning) {
 #if SCD4x_ENABLE_DEBUGLOG
@@ -442,7 +573,7 @@ bool performForcedRecalibration(uint16_t concentration, float* correction) {
 
     if(success == false) return false;
 
-    furi_delay_ms(400); //Datasheet specifies this
+    transportDelay(400); //Datasheet specifies this
 
     uint8_t data[3] = {0x00};
     bool rx_success = recvData(data, 3);
@@ -482,6 +613,7 @@ bool performForcedRecalibration(uint16_t concentration, float* correction) {
     }
 
     if(error) {
+        busStatsCrcFailure();
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
             furi_log_print_format(
@@ -500,6 +632,13 @@ bool performForcedRecalibration(uint16_t concentration, float* correction) {
 
     return true;
 }
+#else
+bool performForcedRecalibration(uint16_t concentration, float* correction) {
+    UNUSED(concentration);
+    UNUSED(correction);
+    return false; // Not built, see SCD4x_ENABLE_FRC
+}
+#endif // if SCD4x_ENABLE_FRC
 
 //Enable/disable automatic self calibration. See 3.7.2
 //Set the current state (enabled / disabled) of the automatic self-calibration. By default, ASC is enabled.
@@ -520,7 +659,7 @@ bool setAutomaticSelfCalibrationEnabled(bool enabled, uint16_t delayMillis) {
     uint16_t enabledWord = enabled == true ? 0x0001 : 0x0000;
     bool success =
         sendCommandArgs(SCD4x_COMMAND_SET_AUTOMATIC_SELF_CALIBRATION_ENABLED, enabledWord);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -572,6 +711,7 @@ bool getAutomaticSelfCalibrationEnabledExt(uint16_t* enabled) {
 
 //Start low power periodic measurements. See 3.8.1
 //Signal update interval will be 30 seconds instead of 5
+#if SCD4x_ENABLE_LOW_POWER
 bool startLowPowerPeriodicMeasurement(void) {
     if(periodicMeasurementsAreRunning) {
 #if SCD4x_ENABLE_DEBUGLOG
@@ -586,9 +726,18 @@ bool startLowPowerPeriodicMeasurement(void) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT);
-    if(success) periodicMeasurementsAreRunning = true;
+    if(success) {
+        periodicMeasurementsAreRunning = true;
+        _singleShotRHTOnly = false;
+        sampleTimingStart(SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS);
+    }
     return success;
 }
+#else
+bool startLowPowerPeriodicMeasurement(void) {
+    return false; // Not built, see SCD4x_ENABLE_LOW_POWER
+}
+#endif // if SCD4x_ENABLE_LOW_POWER
 
 //Returns true when data is available. See 3.8.2
 bool getDataReadyStatus(void) {
@@ -599,7 +748,10 @@ bool getDataReadyStatus(void) {
 
     //If the least significant 11 bits of word[0] are 0 → data not ready
     //else → data ready for read-out
-    if((response & 0x07ff) == 0x0000) return false;
+    if((response & 0x07ff) == 0x0000) {
+        sampleTimingNotReady(furi_get_tick());
+        return false;
+    }
     return true;
 }
 
@@ -624,7 +776,7 @@ bool persistSettings(uint16_t delayMillis) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_PERSIST_SETTINGS);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -644,17 +796,64 @@ bool getSerialNumber(char* serialNumber) {
         return false;
     }
 
+    return readSerialNumber(serialNumber, 100);
+}
+
+//Get the sensor variant. Bits 15:12 of the word: 0 for the SCD40, 1 for the SCD41
+//Not known to the first SCD40 firmwares, which NACK it
+bool getSensorVariant(scd4x_sensor_type_e* sensorType) {
+#if SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME
+    if(periodicMeasurementsAreRunning) {
+#if SCD4x_ENABLE_DEBUGLOG
+        if(_printDebug == true) {
+            furi_log_print_format(
+                FuriLogLevelDebug,
+                "SCD4x",
+                "getSensorVariant: periodic measurements are running. Aborting");
+        }
+#endif // if SCD4x_ENABLE_DEBUGLOG
+        return false;
+    }
+
+    uint16_t response;
+    if(!readRegister(SCD4x_COMMAND_GET_SENSOR_VARIANT, &response, 1)) return false;
+    switch(response >> 12) {
+    case 0:
+        *sensorType = SCD4x_SENSOR_SCD40;
+        return true;
+    case 1:
+        *sensorType = SCD4x_SENSOR_SCD41;
+        return true;
+    default:
+#if SCD4x_ENABLE_DEBUGLOG
+        if(_printDebug == true) {
+            furi_log_print_format(
+                FuriLogLevelDebug, "SCD4x", "getSensorVariant: unknown variant 0x%04x", response);
+        }
+#endif // if SCD4x_ENABLE_DEBUGLOG
+        return false;
+    }
+#else
+    *sensorType = _sensorType;
+    return true;
+#endif // if SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME
+}
+
+//Serial number transfer of getSerialNumber and readConfig, which waits less
+static bool readSerialNumber(char* serialNumber, uint16_t delayMillis) {
     bool success = sendCommand(SCD4x_COMMAND_GET_SERIAL_NUMBER);
     if(!success) return false;
 
-    furi_delay_ms(100); //Datasheet specifies this
+    transportDelay(delayMillis);
 
     uint8_t data[9] = {0x00};
     bool rx_success = recvData(data, 9);
     bool error = false;
     if(rx_success) {
+#if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
             furi_log_print_format(FuriLogLevelDebug, "SCD4x", "getSerialNumber: rx ok");
+#endif // if SCD4x_ENABLE_DEBUGLOG
         uint8_t bytesToCrc[2];
         uint8_t foundCrc;
         int digit = 0;
@@ -707,6 +906,7 @@ bool getSerialNumber(char* serialNumber) {
     }
 
     if(error) {
+        busStatsCrcFailure();
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
             furi_log_print_format(
@@ -720,6 +920,73 @@ bool getSerialNumber(char* serialNumber) {
     return true; //Success!
 }
 
+//Read the whole configuration in one bus session: the bus is acquired and the sensor probed once,
+//the 1 ms execution times are the only waits. Periodic measurements must be stopped
+bool readConfig(scd4x_config_t* config) {
+    if(periodicMeasurementsAreRunning) {
+#if SCD4x_ENABLE_DEBUGLOG
+        if(_printDebug == true) {
+            furi_log_print_format(
+                FuriLogLevelDebug,
+                "SCD4x",
+                "readConfig: periodic measurements are running. Aborting");
+        }
+#endif // if SCD4x_ENABLE_DEBUGLOG
+        return false;
+    }
+
+    if(!transportBegin()) return false;
+    bool success =
+        readRegister(SCD4x_COMMAND_GET_TEMPERATURE_OFFSET, &config->temperatureOffset, 1) &&
+        readRegister(SCD4x_COMMAND_GET_SENSOR_ALTITUDE, &config->altitude, 1) &&
+        readRegister(SCD4x_COMMAND_GET_AUTOMATIC_SELF_CALIBRATION_ENABLED, &config->asc, 1) &&
+        readSerialNumber(config->serialNumber, 1);
+    transportEnd();
+    return success;
+}
+
+//Write the fields of config that differ from current in one bus session. current follows every
+//successful write; the serial number is not written. Periodic measurements must be stopped
+bool writeConfig(scd4x_config_t* current, const scd4x_config_t* config) {
+    if(periodicMeasurementsAreRunning) {
+#if SCD4x_ENABLE_DEBUGLOG
+        if(_printDebug == true) {
+            furi_log_print_format(
+                FuriLogLevelDebug,
+                "SCD4x",
+                "writeConfig: periodic measurements are running. Aborting");
+        }
+#endif // if SCD4x_ENABLE_DEBUGLOG
+        return false;
+    }
+
+    if(current->temperatureOffset == config->temperatureOffset &&
+       current->altitude == config->altitude && current->asc == config->asc) {
+        return true;
+    }
+
+    if(!transportBegin()) return false;
+    bool success = true;
+    if(current->temperatureOffset != config->temperatureOffset) {
+        success = sendCommandArgs(SCD4x_COMMAND_SET_TEMPERATURE_OFFSET, config->temperatureOffset);
+        transportDelay(1);
+        if(success) current->temperatureOffset = config->temperatureOffset;
+    }
+    if(success && current->altitude != config->altitude) {
+        success = sendCommandArgs(SCD4x_COMMAND_SET_SENSOR_ALTITUDE, config->altitude);
+        transportDelay(1);
+        if(success) current->altitude = config->altitude;
+    }
+    if(success && current->asc != config->asc) {
+        success =
+            sendCommandArgs(SCD4x_COMMAND_SET_AUTOMATIC_SELF_CALIBRATION_ENABLED, config->asc);
+        transportDelay(1);
+        if(success) current->asc = config->asc;
+    }
+    transportEnd();
+    return success;
+}
+
 //PRIVATE: Convert serial number digit to ASCII
 char convertHexToASCII(uint8_t digit) {
     if(digit <= 9)
@@ -732,6 +999,13 @@ char convertHexToASCII(uint8_t digit) {
 //The perform_self_test feature can be used as an end-of-line test to check sensor functionality
 //and the customer power supply to the sensor.
 bool performSelfTest(void) {
+    uint16_t response;
+    return performSelfTestExt(&response) && (response == 0x0000);
+}
+
+//Same as performSelfTest, but tells a malfunction (word[0] != 0, returned in response) apart from
+//a sensor that did not answer (returns false)
+bool performSelfTestExt(uint16_t* response) {
     if(periodicMeasurementsAreRunning) {
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true) {
@@ -744,24 +1018,29 @@ bool performSelfTest(void) {
         return false;
     }
 
-    uint16_t response;
-
 #if SCD4x_ENABLE_DEBUGLOG
     if(_printDebug == true)
         furi_log_print_format(
             FuriLogLevelDebug, "SCD4x", "performSelfTest: delaying for 10 seconds...");
 #endif // if SCD4x_ENABLE_DEBUGLOG
 
-    bool success = readRegister(SCD4x_COMMAND_PERFORM_SELF_TEST, &response, 10000);
+    bool success = readRegister(SCD4x_COMMAND_PERFORM_SELF_TEST, response, 10000);
 
 #if SCD4x_ENABLE_DEBUGLOG
     if(_printDebug == true) {
-        furi_log_print_format(
-            FuriLogLevelDebug, "SCD4x", "performSelfTest: sensor response is 0x%04x", response);
+        if(success) {
+            furi_log_print_format(
+                FuriLogLevelDebug,
+                "SCD4x",
+                "performSelfTest: sensor response is 0x%04x",
+                *response);
+        } else {
+            furi_log_print_format(FuriLogLevelDebug, "SCD4x", "performSelfTest: no response");
+        }
     }
 #endif // if SCD4x_ENABLE_DEBUGLOG
 
-    return success && (response == 0x0000); // word[0] = 0 → no malfunction detected
+    return success; // word[0] = 0 → no malfunction detected
 }
 
 //Peform factory reset. See 3.9.4
@@ -781,7 +1060,7 @@ bool performFactoryReset(uint16_t delayMillis) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_PERFORM_FACTORY_RESET);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -802,7 +1081,7 @@ bool reInit(uint16_t delayMillis) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_REINIT);
-    if(delayMillis > 0) furi_delay_ms(delayMillis);
+    if(delayMillis > 0) transportDelay(delayMillis);
     return success;
 }
 
@@ -814,8 +1093,9 @@ bool reInit(uint16_t delayMillis) {
 //2. The I2C master sends a single shot command and waits for the indicated max. command duration time.
 //3. The I2C master reads out data with the read measurement sequence (chapter 3.5.2).
 //4. Steps 2-3 are repeated as required by the application.
+#if SCD4x_ENABLE_SINGLE_SHOT
 bool measureSingleShot(void) {
-    if(_sensorType != SCD4x_SENSOR_SCD41) {
+    if(!SCD4x_IS_SCD41(_sensorType)) {
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true) {
             furi_log_print_format(
@@ -844,6 +1124,7 @@ bool measureSingleShot(void) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_MEASURE_SINGLE_SHOT);
+    if(success) _singleShotRHTOnly = false;
 
 #if SCD4x_ENABLE_DEBUGLOG
     if(success && (_printDebug == true)) {
@@ -859,9 +1140,10 @@ bool measureSingleShot(void) {
 
 //On-demand measurement of relative humidity and temperature only.
 //The sensor output is read using the read_measurement command (chapter 3.5.2).
-//CO2 output is returned as 0 ppm.
+//CO2 output is returned as 0 ppm. readMeasurement() keeps the CO2 of the last full measurement
+//instead and flags the sample SCD4x_SAMPLE_FLAG_RHT_ONLY.
 bool measureSingleShotRHTOnly(void) {
-    if(_sensorType != SCD4x_SENSOR_SCD41) {
+    if(!SCD4x_IS_SCD41(_sensorType)) {
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true) {
             furi_log_print_format(
@@ -890,6 +1172,7 @@ bool measureSingleShotRHTOnly(void) {
     }
 
     bool success = sendCommand(SCD4x_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY);
+    if(success) _singleShotRHTOnly = true;
 
 #if SCD4x_ENABLE_DEBUGLOG
     if(success && (_printDebug == true)) {
@@ -900,6 +1183,15 @@ bool measureSingleShotRHTOnly(void) {
 
     return success;
 }
+#else
+bool measureSingleShot(void) {
+    return false; // Not built, see SCD4x_ENABLE_SINGLE_SHOT
+}
+
+bool measureSingleShotRHTOnly(void) {
+    return false;
+}
+#endif // if SCD4x_ENABLE_SINGLE_SHOT
 
 //Sends a command along with arguments and CRC
 bool sendCommandArgs(uint16_t command, uint16_t arguments) {
@@ -910,16 +1202,6 @@ bool sendCommandArgs(uint16_t command, uint16_t arguments) {
 
     uint8_t buffer[5] = {0x00};
 
-    bool success = true;
-    // Acquire BUS
-    furi_hal_i2c_acquire(I2C_BUS);
-    if(!furi_hal_i2c_is_device_ready(I2C_BUS, SCD4x_ADDRESS, TIMEOUT)) {
-        if(_printDebug == true)
-            furi_log_print_format(FuriLogLevelDebug, "SCD4x", "sendCommandArgs: device not ready");
-        furi_hal_i2c_release(I2C_BUS);
-        return false;
-    }
-
     // Data to send
     buffer[0] = (command & 0xFF00) >> 8; //MSB
     buffer[1] = (command & 0x00FF) >> 0; //LSB
@@ -927,13 +1209,14 @@ bool sendCommandArgs(uint16_t command, uint16_t arguments) {
     buffer[3] = (arguments & 0x00FF) >> 0; //LSB
     buffer[4] = crc;
 
-    success &= furi_hal_i2c_tx(I2C_BUS, SCD4x_ADDRESS, buffer, 5, TIMEOUT);
+    uint32_t startCycles = DWT->CYCCNT;
+    bool success = _transport->tx(_transport->context, buffer, 5);
+    busStatsTransfer(true, success, startCycles);
+#if SCD4x_ENABLE_DEBUGLOG
     if(_printDebug == true)
         furi_log_print_format(
             FuriLogLevelDebug, "SCD4x", "sendCommandArgs: tx success %d", success);
-
-    // Release BUS
-    furi_hal_i2c_release(I2C_BUS);
+#endif // if SCD4x_ENABLE_DEBUGLOG
     return success;
 }
 
@@ -945,48 +1228,267 @@ bool sendCommand(uint16_t command) {
     buffer[0] = (command & 0xFF00) >> 8; //MSB
     buffer[1] = (command & 0x00FF) >> 0; //LSB
 
-    bool success = false;
-    // Acquire BUS
-    furi_hal_i2c_acquire(I2C_BUS);
-    if(!furi_hal_i2c_is_device_ready(I2C_BUS, SCD4x_ADDRESS, TIMEOUT)) {
-        if(_printDebug == true)
-            furi_log_print_format(FuriLogLevelDebug, "SCD4x", "sendCommand: device not ready");
-        furi_hal_i2c_release(I2C_BUS);
-        return false;
-    }
-
-    // Transmit
-    success = furi_hal_i2c_tx(I2C_BUS, SCD4x_ADDRESS, buffer, 2, TIMEOUT);
+    uint32_t startCycles = DWT->CYCCNT;
+    bool success = _transport->tx(_transport->context, buffer, 2);
+    busStatsTransfer(true, success, startCycles);
+#if SCD4x_ENABLE_DEBUGLOG
     if(_printDebug == true)
         furi_log_print_format(FuriLogLevelDebug, "SCD4x", "sendCommand: tx success %d", success);
-
-    // Release BUS
-    furi_hal_i2c_release(I2C_BUS);
+#endif // if SCD4x_ENABLE_DEBUGLOG
     return success;
 }
 
 bool recvData(uint8_t* data, uint8_t size) {
-    furi_hal_i2c_acquire(I2C_BUS);
-    if(!furi_hal_i2c_is_device_ready(I2C_BUS, SCD4x_ADDRESS, TIMEOUT)) {
-        furi_hal_i2c_release(I2C_BUS);
+    uint32_t startCycles = DWT->CYCCNT;
+    bool rx_success = _transport->rx(_transport->context, data, size);
+    busStatsTransfer(false, rx_success, startCycles);
+#if SCD4x_ENABLE_DEBUGLOG
+    if(_printDebug == true)
+        furi_log_print_format(FuriLogLevelDebug, "SCD4x", "recvData: rx success %d", rx_success);
+#endif // if SCD4x_ENABLE_DEBUGLOG
+    return rx_success;
+}
+
+//Default transport: the sensor on the external I2C bus
+//Each transfer acquires the bus and probes the sensor address first, unless a session holds it
+static FuriHalI2cBusHandle* _i2cSession = NULL;
+
+static bool i2cTransportAcquire(const char* direction) {
+    if(_i2cSession) return true;
+
+    furi_hal_i2c_acquire(_i2cBus);
+    if(!furi_hal_i2c_is_device_ready(_i2cBus, SCD4x_ADDRESS, TIMEOUT)) {
+        furi_hal_i2c_release(_i2cBus);
+#if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true)
-            furi_log_print_format(FuriLogLevelDebug, "SCD4x", "recvData: device not ready");
+            furi_log_print_format(FuriLogLevelDebug, "SCD4x", "%s: device not ready", direction);
+#else
+        UNUSED(direction);
+#endif // if SCD4x_ENABLE_DEBUGLOG
         return false;
     }
+    return true;
+}
+
+static void i2cTransportRelease(void) {
+    if(!_i2cSession) furi_hal_i2c_release(_i2cBus);
+}
+
+static bool i2cTransportTx(void* context, const uint8_t* data, uint8_t size) {
+    UNUSED(context);
+    if(!i2cTransportAcquire("tx")) return false;
+    bool success = furi_hal_i2c_tx(_i2cBus, SCD4x_ADDRESS, data, size, TIMEOUT);
+    i2cTransportRelease();
+    return success;
+}
 
-    bool rx_success = furi_hal_i2c_rx(I2C_BUS, SCD4x_ADDRESS, data, size, TIMEOUT);
-    furi_hal_i2c_release(I2C_BUS);
-    if(_printDebug == true) furi_log_print_format(FuriLogLevelDebug, "SCD4x", "recvData: rx ok");
+static bool i2cTransportRx(void* context, uint8_t* data, uint8_t size) {
+    UNUSED(context);
+    if(!i2cTransportAcquire("rx")) return false;
+    bool rx_success = furi_hal_i2c_rx(_i2cBus, SCD4x_ADDRESS, data, size, TIMEOUT);
+    i2cTransportRelease();
     return rx_success;
 }
 
+//Hold the bus, the sensor address is probed once for the whole session
+static bool i2cTransportBegin(void* context) {
+    UNUSED(context);
+    if(!i2cTransportAcquire("session")) return false;
+    _i2cSession = _i2cBus;
+    return true;
+}
+
+static void i2cTransportEnd(void* context) {
+    UNUSED(context);
+    furi_hal_i2c_release(_i2cSession);
+    _i2cSession = NULL;
+}
+
+const scd4x_transport_t scd4x_i2c_transport = {
+    .tx = i2cTransportTx,
+    .rx = i2cTransportRx,
+    .delay = NULL,
+    .begin = i2cTransportBegin,
+    .end = i2cTransportEnd,
+    .context = NULL,
+};
+
+//Route all sensor traffic through another transport (capture, replay...). NULL restores the I2C bus
+void SCD4x_setTransport(const scd4x_transport_t* transport) {
+    _transport = transport ? transport : &scd4x_i2c_transport;
+}
+
+//Talk to the sensor through another handle of the I2C bus (its own speed). NULL restores the
+//firmware's external bus handle
+void SCD4x_setBus(FuriHalI2cBusHandle* handle) {
+    _i2cBus = handle ? handle : &furi_hal_i2c_handle_external;
+}
+
+//Hold the bus for several transfers if the transport can, see readConfig()
+static bool transportBegin(void) {
+    return _transport->begin ? _transport->begin(_transport->context) : true;
+}
+
+static void transportEnd(void) {
+    if(_transport->end) _transport->end(_transport->context);
+}
+
+//All command execution times go through the transport, so a replay can skip them
+static void transportDelay(uint32_t delayMillis) {
+    if(_transport->delay) {
+        _transport->delay(_transport->context, delayMillis);
+    } else {
+        furi_delay_ms(delayMillis);
+    }
+}
+
+//Count one transfer that started at startCycles (DWT cycle counter)
+static void busStatsTransfer(bool command, bool success, uint32_t startCycles) {
+    uint32_t micros =
+        (DWT->CYCCNT - startCycles) / furi_hal_cortex_instructions_per_microsecond();
+    seqlock_write_begin(&_busStatsLock);
+    if(command) _busStats.commands++;
+    _busStats.transactions++;
+    if(!success) {
+        _busStats.nacks++;
+    } else if(!command) {
+        _busStats.reads++;
+    }
+    _busStats.busyMicros += micros;
+    seqlock_write_end(&_busStatsLock);
+}
+
+//Count a response read that arrived with a bad CRC
+static void busStatsCrcFailure(void) {
+    seqlock_write_begin(&_busStatsLock);
+    _busStats.crcFailures++;
+    seqlock_write_end(&_busStatsLock);
+}
+
+//Measurements were started with this signal update interval, or stopped (0)
+//The first read after a start has nothing to be placed after
+static void sampleTimingStart(uint32_t intervalMillis) {
+    _sampleInterval = furi_ms_to_ticks(intervalMillis);
+    _sampleTimed = false;
+    _sampleNotReadySeen = false;
+    _sampleAmbiguous = false;
+}
+
+//The sensor had no new update at timestamp
+static void sampleTimingNotReady(uint32_t timestamp) {
+    _sampleNotReadyTick = timestamp;
+    _sampleNotReadySeen = true;
+}
+
+//Division rounding towards minus infinity, for times before and after a read
+static int32_t floorDiv(int32_t a, int32_t b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+//Find the update read at timestamp on the grid of the previous one, advance the sensor sequence
+//by the updates in between and account for them. Returns the SCD4x_SAMPLE_FLAG_* of the read
+//Times are relative to timestamp: the update read became ready in (-interval, 0], it is the
+//newest one, and after the last not-ready answer since the previous read
+static uint16_t sampleTimingUpdate(uint32_t timestamp) {
+    int32_t interval = _sampleInterval;
+    int32_t notReady = _sampleNotReadySeen ? (int32_t)(_sampleNotReadyTick - timestamp) :
+                                             INT32_MIN / 2;
+    int32_t lo = MAX(-interval, notReady);
+    int32_t hi = 0;
+    uint32_t updates = 1;
+    uint16_t flags = 0;
+    bool timed = _sampleTimed && interval > 0;
+    bool revised = false;
+    bool offGrid = false;
+
+    if(timed) {
+        // Ready window of the previous update, widened by what the sensor clock may have drifted
+        int32_t previousLo = (int32_t)(_sampleReadyLo - timestamp);
+        int32_t previousHi = (int32_t)(_sampleReadyHi - timestamp);
+        int32_t slack = -previousLo / SCD4x_CLOCK_TOLERANCE_DIVIDER;
+        previousLo -= slack;
+        previousHi += slack;
+
+        // The new update may be ready by now, the one after it may not, and it may come after the
+        // last not-ready answer. Several counts fit only when a read came late and close to an
+        // update: the one whose projected window overlaps the new one the most is the likeliest.
+        // If none fits (the clock drifted more than allowed), the centres of the windows decide.
+        // The sensor empties its buffer on a read, so this is a new update: 0 only fits when the
+        // previous read may have been counted one too far
+        int32_t fewest = _sampleAmbiguous ? 0 : 1;
+        int32_t most = floorDiv(-previousLo, interval);
+        int32_t least =
+            MAX(floorDiv(-previousHi, interval), floorDiv(lo - previousHi, interval) + 1);
+        int32_t count = MAX(
+            floorDiv(lo + hi - previousLo - previousHi + interval, 2 * interval), fewest);
+        int32_t bestOverlap = -1;
+        for(int32_t n = MAX(least, fewest); n <= most; n++) {
+            int32_t overlap = MIN(hi, previousHi + n * interval) -
+                              MAX(lo, previousLo + n * interval);
+            if(overlap > bestOverlap) {
+                bestOverlap = overlap;
+                count = n;
+            }
+        }
+        updates = MAX(count, 0);
+        offGrid = bestOverlap < 0;
+
+        // No update in between right after a read that may have been an update earlier: it was,
+        // and was counted one too far. Only revised when that count had dropped updates to take
+        // back
+        revised = updates == 0 && _sampleAmbiguous;
+        _sampleAmbiguous = count > 1 && count > MAX(least, 0);
+
+        // Narrow the window with where the previous one puts this update
+        int32_t projectedLo = previousLo + (int32_t)updates * interval;
+        int32_t projectedHi = previousHi + (int32_t)updates * interval;
+        if(projectedLo <= hi && projectedHi >= lo) {
+            lo = MAX(lo, projectedLo);
+            hi = MIN(hi, projectedHi);
+        }
+    }
+    _sampleTimed = interval > 0;
+    _sampleReadyLo = timestamp + lo;
+    _sampleReadyHi = timestamp + hi;
+    _sampleNotReadySeen = false;
+    _sensorSequence += updates;
+
+    seqlock_write_begin(&_timingStatsLock);
+    _timingStats.samples++;
+    if(revised) {
+        _timingStats.dropped--;
+    } else if(timed) {
+        if(offGrid) {
+            _timingStats.offGrid++;
+            flags |= SCD4x_SAMPLE_FLAG_OFF_GRID;
+        }
+        if(updates > 1) {
+            _timingStats.dropped += updates - 1;
+            flags |= SCD4x_SAMPLE_FLAG_GAP;
+        }
+        // Read latency from the middle of the window
+        uint32_t latencyMillis =
+            (uint32_t)(-(lo + hi) / 2) * 1000 / furi_kernel_get_tick_frequency();
+        uint8_t bucket = 0;
+        while(bucket < SCD4x_LATENCY_BUCKETS - 1 &&
+              latencyMillis >= _latencyLimitsMillis[bucket]) {
+            bucket++;
+        }
+        _timingStats.timed++;
+        _timingStats.latency[bucket]++;
+        _timingStats.latencyMaxMillis = MAX(_timingStats.latencyMaxMillis, latencyMillis);
+    }
+    seqlock_write_end(&_timingStatsLock);
+    return flags;
+}
+
 //Gets two bytes from SCD4x plus CRC.
 //Returns true if endTransmission returns zero _and_ the CRC check is valid
 bool readRegister(uint16_t registerAddress, uint16_t* response, uint16_t delayMillis) {
     bool success = sendCommand(registerAddress);
     if(!success) return false;
 
-    furi_delay_ms(delayMillis);
+    transportDelay(delayMillis);
 
     uint8_t data[3] = {0x00};
     bool rx_success = recvData(data, 3);
@@ -997,6 +1499,7 @@ bool readRegister(uint16_t registerAddress, uint16_t* response, uint16_t delayMi
         uint8_t expectedCRC = computeCRC8(data, 2);
         if(crc == expectedCRC) // Return true if CRC check is OK
             return true;
+        busStatsCrcFailure();
 #if SCD4x_ENABLE_DEBUGLOG
         if(_printDebug == true) {
             furi_log_print_format(
@@ -39,6 +39,31 @@
 #endif
 #endif
 
+//Sensor variant the driver is built for. SCD4x_VARIANT_RUNTIME (default): set by SCD4x_init()
+//and detected by getSensorVariant(). A fixed variant compiles the sensor type checks out
+#define SCD4x_VARIANT_RUNTIME 0
+#define SCD4x_VARIANT_SCD40 1
+#define SCD4x_VARIANT_SCD41 2
+#ifndef SCD4x_VARIANT
+#define SCD4x_VARIANT SCD4x_VARIANT_RUNTIME
+#endif
+
+//Enable/disable including optional commands (to allow saving some space). A disabled command
+//stays declared and fails without touching the bus
+#ifndef SCD4x_ENABLE_SINGLE_SHOT // The SCD40 has no single shots
+#define SCD4x_ENABLE_SINGLE_SHOT (SCD4x_VARIANT != SCD4x_VARIANT_SCD40)
+#endif
+#ifndef SCD4x_ENABLE_LOW_POWER
+#define SCD4x_ENABLE_LOW_POWER 1
+#endif
+#ifndef SCD4x_ENABLE_FRC
+#define SCD4x_ENABLE_FRC 1
+#endif
+
+#if SCD4x_VARIANT == SCD4x_VARIANT_SCD40 && SCD4x_ENABLE_SINGLE_SHOT
+#error "The SCD40 has no single shots, build with SCD4x_ENABLE_SINGLE_SHOT=0"
+#endif
+
 //The default I2C address for the SCD4x is 0x62.
 #define SCD4x_ADDRESS (0x62 << 1)
 //Available commands
@@ -67,6 +92,7 @@
 //Advanced features
 #define SCD4x_COMMAND_PERSIST_SETTINGS 0x3615 // execution time: 800ms
 #define SCD4x_COMMAND_GET_SERIAL_NUMBER 0x3682 // execution time: 1ms
+#define SCD4x_COMMAND_GET_SENSOR_VARIANT 0x202f // execution time: 1ms
 #define SCD4x_COMMAND_PERFORM_SELF_TEST 0x3639 // execution time: 10000ms
 #define SCD4x_COMMAND_PERFORM_FACTORY_RESET 0x3632 // execution time: 1200ms
 #define SCD4x_COMMAND_REINIT 0x3646 // execution time: 20ms
@@ -75,6 +101,15 @@
 #define SCD4x_COMMAND_MEASURE_SINGLE_SHOT 0x219d // execution time: 5000ms
 #define SCD4x_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY 0x2196 // execution time: 50ms
 
+//Signal update intervals, shortened in the soak build of the app (co2_soak.h)
+#if defined(CO2_SENSOR_SOAK) && CO2_SENSOR_SOAK
+#define SCD4x_INTERVAL_DIVIDER 250
+#else
+#define SCD4x_INTERVAL_DIVIDER 1
+#endif
+#define SCD4x_PERIODIC_INTERVAL_MS (5000 / SCD4x_INTERVAL_DIVIDER)
+#define SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS (30000 / SCD4x_INTERVAL_DIVIDER)
+
 typedef union {
     int16_t signed16;
     uint16_t unsigned16;
@@ -87,14 +122,100 @@ typedef union {
 
 typedef enum { SCD4x_SENSOR_SCD40 = 0, SCD4x_SENSOR_SCD41 } scd4x_sensor_type_e;
 
+//Whether sensorType supports the SCD41 only commands, a constant when the variant is fixed
+#if SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME
+#define SCD4x_IS_SCD41(sensorType) ((sensorType) == SCD4x_SENSOR_SCD41)
+#else
+#define SCD4x_IS_SCD41(sensorType) (SCD4x_VARIANT == SCD4x_VARIANT_SCD41)
+#endif
+
+// Everything the driver puts on or reads from the bus goes through a transport.
+// tx/rx carry whole I2C transfers (command word + optional argument and CRC, response words with CRCs)
+// and return false on NACK/timeout. delay is used for the command execution times, NULL means furi_delay_ms.
+// begin/end (optional, NULL) bracket a sequence of transfers that may hold the bus in between.
+typedef struct {
+    bool (*tx)(void* context, const uint8_t* data, uint8_t size);
+    bool (*rx)(void* context, uint8_t* data, uint8_t size);
+    void (*delay)(void* context, uint32_t delayMillis);
+    bool (*begin)(void* context);
+    void (*end)(void* context);
+    void* context;
+} scd4x_transport_t;
+
+extern const scd4x_transport_t scd4x_i2c_transport; // The sensor on the external I2C bus
+
+#define SCD4x_SAMPLE_FLAG_VALID (1 << 0) // At least one measurement was read
+#define SCD4x_SAMPLE_FLAG_GAP (1 << 1) // Sensor updates were missed since the previous read
+#define SCD4x_SAMPLE_FLAG_OFF_GRID (1 << 2) // Did not fit the update interval, see below
+#define SCD4x_SAMPLE_FLAG_RHT_ONLY (1 << 3) // T/RH single shot, CO2 of the last full measurement
+
+// One measurement as published by readMeasurement(). Raw output words, converted on demand
+typedef struct {
+    uint16_t co2;
+    uint16_t temperature;
+    uint16_t humidity;
+    uint16_t flags; // SCD4x_SAMPLE_FLAG_*
+    uint32_t timestamp; // furi_get_tick() when the read completed
+    uint32_t co2Timestamp; // Same for the CO2 word, older than timestamp after a T/RH single shot
+    uint32_t sequence; // Incremented for every measurement read
+    uint32_t sensorSequence; // Sensor updates since the driver started, inferred from timestamps
+} scd4x_sample_t;
+
+// The sensor overwrites its measurement every signal update interval whether it was read or not,
+// and the driver cannot ask how many it produced. Instead it keeps a window of when the update it
+// read last became ready: no later than the read, after the last not-ready answer before it and
+// less than an interval before the read (it was the newest). The next read is placed on the
+// interval grid of that window, which gives the number of updates in between: more than one
+// means updates were lost. Each read narrows the window further, allowing for 2% of sensor clock
+// drift. A read that fits no count is off the grid (the clock drifted more, or the sensor was
+// restarted behind the driver's back) and takes the nearest one. A late read close to an update
+// may fit two counts: the likelier one is taken, and taken back if the next read fits none in
+// between (the sensor empties its buffer on a read, it never returns an update twice).
+// Reads a little more than an interval apart with no not-ready answer in between look the same as
+// a slow sensor clock: the updates they skip now and then are not counted. The latency is the
+// time from the middle of the window to the read, the scheduling delay of the reads.
+// Reads are only timed between a start of periodic measurements and the next stop.
+#define SCD4x_LATENCY_BUCKETS 6 // Latency < 100, 250, 500, 1000, 2000 ms, and the rest
+
+typedef struct {
+    uint32_t samples; // Measurements read
+    uint32_t timed; // Of which placed on the interval grid
+    uint32_t dropped; // Sensor updates never read
+    uint32_t offGrid; // Timed reads that fit no number of updates since the previous one
+    uint32_t latencyMaxMillis;
+    uint32_t latency[SCD4x_LATENCY_BUCKETS]; // Timed reads by latency
+} scd4x_timing_stats_t;
+
+// Bus traffic since the app started (or resetBusStats()), as seen by the driver through its
+// transport. busyMicros is the time spent inside tx/rx, the command execution waits are not in it
+typedef struct {
+    uint32_t commands; // Command writes, each followed by its response read if it has one
+    uint32_t transactions; // Transfers, writes and reads
+    uint32_t nacks; // Transfers that failed: NACK, timeout, device not ready
+    uint32_t reads; // Response reads that made it through the bus
+    uint32_t crcFailures; // Response reads with at least one bad CRC
+    uint32_t busyMicros;
+} scd4x_bus_stats_t;
+
 bool recvData(uint8_t* data, uint8_t size);
 
-void SCD4x_init(scd4x_sensor_type_e sensorType);
+void SCD4x_init(scd4x_sensor_type_e sensorType); // sensorType is ignored when the variant is fixed
+
+void SCD4x_setTransport(const scd4x_transport_t* transport); // NULL restores scd4x_i2c_transport
+void SCD4x_setBus(FuriHalI2cBusHandle* handle); // Used by scd4x_i2c_transport. NULL: external
 
 bool SCD4x_begin(bool measBegin, bool autoCalibrate, bool skipStopPeriodicMeasurements);
 
 void enableDebugging(); //Turn on debug printing.
 
+// Copy the bus statistics. Safe to call from any thread (seqlock)
+void getBusStats(scd4x_bus_stats_t* stats);
+void resetBusStats(void);
+
+// Copy the sample timing statistics. Safe to call from any thread (seqlock)
+void getTimingStats(scd4x_timing_stats_t* stats);
+void resetTimingStats(void);
+
 bool startPeriodicMeasurement(void); // Signal update interval is 5 seconds
 
 // stopPeriodicMeasurement can be called before .begin if required
@@ -110,6 +231,15 @@ float getHumidity(void); // Return the RH. Automatically request fresh data is t
 float getTemperature(
     void); // Return the temperature. Automatically request fresh data is the data is 'stale'
 
+// Copy the latest measurement. Safe to call from any thread (seqlock), never blocks the driver.
+// Returns false if no measurement was read yet
+bool getLatestSample(scd4x_sample_t* sample);
+
+// Return the raw CO2/T/RH words of the latest measurement. Does not request fresh data
+void getRawMeasurement(uint16_t* co2, uint16_t* temperature, uint16_t* humidity);
+float convertTemperature(uint16_t temperatureWord); // Raw T word to C
+float convertHumidity(uint16_t humidityWord); // Raw RH word to %
+
 // Define how warm the sensor is compared to ambient, so RH and T are temperature compensated. Has no effect on the CO2 reading
 // Default offset is 4C
 bool setTemperatureOffset(
@@ -140,7 +270,27 @@ bool getDataReadyStatus(void); // Returns true if fresh data is available
 
 bool persistSettings(uint16_t delayMillis); // Copy sensor settings from RAM to EEPROM
 bool getSerialNumber(char* serialNumber); // Returns true if serial number is read correctly
+// Read the variant from the sensor (runtime variant build), measurements must be stopped. Returns
+// false if it did not answer (older firmware) or is not a SCD40/SCD41. The fixed variant otherwise
+bool getSensorVariant(scd4x_sensor_type_e* sensorType);
+
+// Sensor configuration as raw words, plus the serial number
+typedef struct {
+    uint16_t temperatureOffset; // Toffset [C] * 65536 / 175
+    uint16_t altitude; // m above sea level
+    uint16_t asc; // Automatic self-calibration, 1: enabled
+    char serialNumber[13]; // 12 hex digits
+} scd4x_config_t;
+
+// The whole configuration in one bus session instead of one per getter. Measurements must be
+// stopped
+bool readConfig(scd4x_config_t* config);
+// Write the fields that differ from current in one bus session. current follows every successful
+// write
+bool writeConfig(scd4x_config_t* current, const scd4x_config_t* config);
+
 bool performSelfTest(void); // Takes 10 seconds to complete. Returns true if the test is successful
+bool performSelfTestExt(uint16_t* response); // Returns true if the sensor answered, 0 means pass
 bool performFactoryReset(uint16_t delayMillis); // Reset all settings to the factory values
 bool reInit(uint16_t delayMillis); // Re-initialize the sensor, load settings from EEPROM
 
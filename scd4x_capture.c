@@ -0,0 +1,278 @@
+#include "scd4x_capture.h"
+#include <furi_hal_rtc.h>
+#include <core/log.h>
+#include "co2_memory.h"
+
+// How many captured records the replay looks ahead to resynchronize with the driver
+#define SCD4x_REPLAY_LOOKAHEAD 8
+
+static uint32_t scd4x_capture_ticks_to_ms(uint32_t ticks) {
+    return (uint32_t)((uint64_t)ticks * 1000 / furi_kernel_get_tick_frequency());
+}
+
+static void scd4x_capture_flush(Scd4xCapture* capture) {
+    if(capture->used == 0 || capture->error) return;
+    if(storage_file_write(capture->file, capture->buffer, capture->used) != capture->used) {
+        // Keep passing the traffic through, just stop recording it
+        capture->error = true;
+        furi_log_print_format(FuriLogLevelError, "SCD4x", "capture: write failed");
+    } else {
+        capture->bytes += capture->used;
+    }
+    capture->used = 0;
+}
+
+static void scd4x_capture_append(
+    Scd4xCapture* capture,
+    bool rx,
+    bool success,
+    const uint8_t* data,
+    uint8_t size) {
+    if(!capture->file || capture->error) return;
+
+    size = MIN(size, SCD4x_CAPTURE_MAX_DATA);
+    if(capture->used + sizeof(Scd4xCaptureRecord) + size > SCD4x_CAPTURE_BUFFER) {
+        scd4x_capture_flush(capture);
+    }
+
+    uint32_t now = furi_get_tick();
+    Scd4xCaptureRecord record = {
+        .flags = (rx ? SCD4x_CAPTURE_FLAG_RX : 0) | (success ? SCD4x_CAPTURE_FLAG_OK : 0),
+        .size = size,
+        .delta = MIN(scd4x_capture_ticks_to_ms(now - capture->last_tick), UINT16_MAX),
+    };
+    capture->last_tick = now;
+
+    memcpy(&capture->buffer[capture->used], &record, sizeof(record));
+    capture->used += sizeof(record);
+    memcpy(&capture->buffer[capture->used], data, size);
+    capture->used += size;
+    capture->records++;
+}
+
+static bool scd4x_capture_tx(void* context, const uint8_t* data, uint8_t size) {
+    Scd4xCapture* capture = context;
+    bool success = capture->inner->tx(capture->inner->context, data, size);
+    scd4x_capture_append(capture, false, success, data, size);
+    return success;
+}
+
+static bool scd4x_capture_rx(void* context, uint8_t* data, uint8_t size) {
+    Scd4xCapture* capture = context;
+    bool success = capture->inner->rx(capture->inner->context, data, size);
+    scd4x_capture_append(capture, true, success, data, size);
+    return success;
+}
+
+static void scd4x_capture_delay(void* context, uint32_t delayMillis) {
+    Scd4xCapture* capture = context;
+    if(capture->inner->delay) {
+        capture->inner->delay(capture->inner->context, delayMillis);
+    } else {
+        furi_delay_ms(delayMillis);
+    }
+}
+
+// Sessions of the driver hold the bus of the inner transport
+static bool scd4x_capture_begin(void* context) {
+    Scd4xCapture* capture = context;
+    return capture->inner->begin ? capture->inner->begin(capture->inner->context) : true;
+}
+
+static void scd4x_capture_end(void* context) {
+    Scd4xCapture* capture = context;
+    if(capture->inner->end) capture->inner->end(capture->inner->context);
+}
+
+Scd4xCapture* scd4x_capture_alloc(const scd4x_transport_t* inner) {
+    Scd4xCapture* capture = co2_memory_alloc(sizeof(Scd4xCapture));
+    memset(capture, 0, sizeof(Scd4xCapture));
+    capture->inner = inner;
+    capture->transport.tx = scd4x_capture_tx;
+    capture->transport.rx = scd4x_capture_rx;
+    capture->transport.delay = scd4x_capture_delay;
+    capture->transport.begin = scd4x_capture_begin;
+    capture->transport.end = scd4x_capture_end;
+    capture->transport.context = capture;
+    capture->storage = furi_record_open(RECORD_STORAGE);
+    return capture;
+}
+
+void scd4x_capture_free(Scd4xCapture* capture) {
+    scd4x_capture_stop(capture);
+    furi_record_close(RECORD_STORAGE);
+    co2_memory_free(capture, sizeof(Scd4xCapture));
+}
+
+bool scd4x_capture_start(Scd4xCapture* capture, const char* path) {
+    scd4x_capture_stop(capture);
+
+    capture->file = storage_file_alloc(capture->storage);
+    if(!storage_file_open(capture->file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS)) {
+        storage_file_free(capture->file);
+        capture->file = NULL;
+        return false;
+    }
+
+    Scd4xCaptureHeader header = {
+        .magic = SCD4x_CAPTURE_MAGIC,
+        .version = SCD4x_CAPTURE_VERSION,
+        .timestamp = furi_hal_rtc_get_timestamp(),
+    };
+    memcpy(capture->buffer, &header, sizeof(header));
+    capture->used = sizeof(header);
+    capture->last_tick = furi_get_tick();
+    capture->records = 0;
+    capture->bytes = 0;
+    capture->error = false;
+    return true;
+}
+
+void scd4x_capture_stop(Scd4xCapture* capture) {
+    if(!capture->file) return;
+
+    scd4x_capture_flush(capture);
+    storage_file_close(capture->file);
+    storage_file_free(capture->file);
+    capture->file = NULL;
+
+    furi_log_print_format(
+        FuriLogLevelInfo,
+        "SCD4x",
+        "capture: %lu records, %lu bytes%s",
+        capture->records,
+        capture->bytes,
+        capture->error ? ", truncated" : "");
+}
+
+bool scd4x_capture_is_running(const Scd4xCapture* capture) {
+    return capture->file != NULL;
+}
+
+static bool
+    scd4x_replay_read_record(Scd4xReplay* replay, Scd4xCaptureRecord* record, uint8_t* data) {
+    return storage_file_read(replay->file, record, sizeof(Scd4xCaptureRecord)) ==
+               sizeof(Scd4xCaptureRecord) &&
+           record->size <= SCD4x_CAPTURE_MAX_DATA &&
+           storage_file_read(replay->file, data, record->size) == record->size;
+}
+
+// Find the captured transfer matching the one the driver is issuing. Transfers are matched on
+// direction, size and, for tx, the command word; arguments (e.g. pressure) may differ.
+// For rx (tx_data == NULL) the captured bytes are copied to rx_data.
+static bool scd4x_replay_next(
+    Scd4xReplay* replay,
+    const uint8_t* tx_data,
+    uint8_t* rx_data,
+    uint8_t size,
+    Scd4xCaptureRecord* record) {
+    bool rx = tx_data == NULL;
+    if(replay->finished) return false;
+
+    uint8_t captured[SCD4x_CAPTURE_MAX_DATA];
+    uint64_t position = storage_file_tell(replay->file);
+    uint32_t elapsed = replay->elapsed;
+    for(uint8_t i = 0; i < SCD4x_REPLAY_LOOKAHEAD; i++) {
+        if(!scd4x_replay_read_record(replay, record, captured)) {
+            if(i == 0) {
+                replay->finished = true;
+                furi_log_print_format(
+                    FuriLogLevelInfo,
+                    "SCD4x",
+                    "replay: finished, %lu records, %lu mismatches, %lu skipped",
+                    replay->records,
+                    replay->mismatches,
+                    replay->skipped);
+                return false;
+            }
+            break;
+        }
+        elapsed += record->delta;
+
+        bool match = (((record->flags & SCD4x_CAPTURE_FLAG_RX) != 0) == rx) &&
+                     record->size == size;
+        if(match && !rx) match = memcmp(captured, tx_data, 2) == 0;
+        if(!match) continue;
+
+        if(rx) memcpy(rx_data, captured, size);
+        replay->records++;
+        replay->skipped += i;
+        replay->elapsed = elapsed;
+
+        if(replay->realtime) {
+            uint32_t target = replay->start_tick + furi_ms_to_ticks(replay->elapsed);
+            int32_t wait = (int32_t)(target - furi_get_tick());
+            if(wait > 0) furi_delay_tick(wait);
+        }
+        return true;
+    }
+
+    // Not in the capture, leave the file where it was so the next transfer can still match
+    storage_file_seek(replay->file, position, true);
+    replay->mismatches++;
+    return false;
+}
+
+static bool scd4x_replay_tx(void* context, const uint8_t* data, uint8_t size) {
+    Scd4xReplay* replay = context;
+    Scd4xCaptureRecord record;
+    if(!scd4x_replay_next(replay, data, NULL, size, &record)) return false;
+    return record.flags & SCD4x_CAPTURE_FLAG_OK;
+}
+
+static bool scd4x_replay_rx(void* context, uint8_t* data, uint8_t size) {
+    Scd4xReplay* replay = context;
+    Scd4xCaptureRecord record;
+    if(!scd4x_replay_next(replay, NULL, data, size, &record)) return false;
+    return record.flags & SCD4x_CAPTURE_FLAG_OK;
+}
+
+// The captured deltas already hold the execution waits: in real time the pacing happens per
+// record, at full speed nothing is waited for
+static void scd4x_replay_delay(void* context, uint32_t delayMillis) {
+    UNUSED(context);
+    UNUSED(delayMillis);
+}
+
+Scd4xReplay* scd4x_replay_alloc(bool realtime) {
+    Scd4xReplay* replay = co2_memory_alloc(sizeof(Scd4xReplay));
+    memset(replay, 0, sizeof(Scd4xReplay));
+    replay->realtime = realtime;
+    replay->transport.tx = scd4x_replay_tx;
+    replay->transport.rx = scd4x_replay_rx;
+    replay->transport.delay = scd4x_replay_delay;
+    replay->transport.context = replay;
+    replay->storage = furi_record_open(RECORD_STORAGE);
+    return replay;
+}
+
+void scd4x_replay_free(Scd4xReplay* replay) {
+    if(replay->file) {
+        storage_file_close(replay->file);
+        storage_file_free(replay->file);
+    }
+    furi_record_close(RECORD_STORAGE);
+    co2_memory_free(replay, sizeof(Scd4xReplay));
+}
+
+bool scd4x_replay_open(Scd4xReplay* replay, const char* path) {
+    replay->file = storage_file_alloc(replay->storage);
+
+    Scd4xCaptureHeader header;
+    bool success = storage_file_open(replay->file, path, FSAM_READ, FSOM_OPEN_EXISTING) &&
+                   storage_file_read(replay->file, &header, sizeof(header)) == sizeof(header) &&
+                   memcmp(header.magic, SCD4x_CAPTURE_MAGIC, sizeof(header.magic)) == 0 &&
+                   header.version == SCD4x_CAPTURE_VERSION;
+    if(!success) {
+        storage_file_close(replay->file);
+        storage_file_free(replay->file);
+        replay->file = NULL;
+        replay->finished = true;
+        return false;
+    }
+
+    replay->start_tick = furi_get_tick();
+    replay->elapsed = 0;
+    replay->finished = false;
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+  Record and replay of the SCD4x bus traffic.
+
+  The capture transport wraps another transport and appends every transfer to a file on the SD card.
+  The replay transport feeds such a file back to the unmodified driver, either paced like the
+  original session or at full speed (command execution delays skipped).
+
+  File format, little-endian:
+    header: "S4XC", u8 version, u8[3] reserved, u32 RTC timestamp of the capture start
+    record: u8 flags (SCD4x_CAPTURE_FLAG_*), u8 size, u16 ms since the previous record, u8[size] data
+  A tx record holds the bytes written (command word, optional argument word and CRC),
+  an rx record holds the bytes read back (words with their CRCs).
+*/
+
+#ifndef __SCD4X_CAPTURE_H__
+#define __SCD4X_CAPTURE_H__
+
+#include <furi.h>
+#include <storage/storage.h>
+#include "scd4x.h"
+
+#define SCD4x_CAPTURE_PATH EXT_PATH("apps_data/co2_sensor/capture.bin")
+// A capture copied here is replayed instead of talking to the sensor
+#define SCD4x_REPLAY_PATH EXT_PATH("apps_data/co2_sensor/replay.bin")
+
+#define SCD4x_CAPTURE_MAGIC "S4XC"
+#define SCD4x_CAPTURE_VERSION 1
+
+#define SCD4x_CAPTURE_FLAG_RX (1 << 0)
+#define SCD4x_CAPTURE_FLAG_OK (1 << 1)
+
+#define SCD4x_CAPTURE_MAX_DATA 9
+#define SCD4x_CAPTURE_BUFFER 512
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved[3];
+    uint32_t timestamp;
+} Scd4xCaptureHeader;
+
+typedef struct __attribute__((packed)) {
+    uint8_t flags;
+    uint8_t size;
+    uint16_t delta;
+} Scd4xCaptureRecord;
+
+typedef struct {
+    scd4x_transport_t transport; // Install with SCD4x_setTransport(&capture->transport)
+    const scd4x_transport_t* inner;
+
+    Storage* storage;
+    File* file;
+    uint8_t buffer[SCD4x_CAPTURE_BUFFER];
+    uint16_t used;
+    uint32_t last_tick;
+
+    uint32_t records;
+    uint32_t bytes;
+    bool error;
+} Scd4xCapture;
+
+typedef struct {
+    scd4x_transport_t transport; // Install with SCD4x_setTransport(&replay->transport)
+
+    Storage* storage;
+    File* file;
+    bool realtime;
+    uint32_t start_tick;
+    uint32_t elapsed; // Sum of the record deltas so far, ms
+
+    uint32_t records;
+    uint32_t mismatches; // Transfers issued by the driver that are not in the capture
+    uint32_t skipped; // Captured records the driver did not ask for
+    bool finished;
+} Scd4xReplay;
+
+Scd4xCapture* scd4x_capture_alloc(const scd4x_transport_t* inner);
+void scd4x_capture_free(Scd4xCapture* capture);
+bool scd4x_capture_start(Scd4xCapture* capture, const char* path);
+// Flushes the pending records and closes the file
+void scd4x_capture_stop(Scd4xCapture* capture);
+bool scd4x_capture_is_running(const Scd4xCapture* capture);
+
+Scd4xReplay* scd4x_replay_alloc(bool realtime);
+void scd4x_replay_free(Scd4xReplay* replay);
+bool scd4x_replay_open(Scd4xReplay* replay, const char* path);
+
+#endif
@@ -0,0 +1,26 @@
+#include "co2_sensor_scene.h"
+
+#define ADD_SCENE(prefix, name, id) prefix##_scene_##name##_on_enter,
+static void (*const co2_sensor_on_enter_handlers[])(void*) = {
+#include "co2_sensor_scene_config.h"
+};
+#undef ADD_SCENE
+
+#define ADD_SCENE(prefix, name, id) prefix##_scene_##name##_on_event,
+static bool (*const co2_sensor_on_event_handlers[])(void* context, SceneManagerEvent event) = {
+#include "co2_sensor_scene_config.h"
+};
+#undef ADD_SCENE
+
+#define ADD_SCENE(prefix, name, id) prefix##_scene_##name##_on_exit,
+static void (*const co2_sensor_on_exit_handlers[])(void* context) = {
+#include "co2_sensor_scene_config.h"
+};
+#undef ADD_SCENE
+
+const SceneManagerHandlers co2_sensor_scene_handlers = {
+    .on_enter_handlers = co2_sensor_on_enter_handlers,
+    .on_event_handlers = co2_sensor_on_event_handlers,
+    .on_exit_handlers = co2_sensor_on_exit_handlers,
+    .scene_num = Co2SensorSceneNum,
+};
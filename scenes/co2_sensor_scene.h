@@ -0,0 +1,36 @@
+/*
+  Scenes of the app, listed in co2_sensor_scene_config.h.
+*/
+
+#ifndef __CO2_SENSOR_SCENE_H__
+#define __CO2_SENSOR_SCENE_H__
+
+#include <gui/scene_manager.h>
+
+// Scene ids
+#define ADD_SCENE(prefix, name, id) Co2SensorScene##id,
+typedef enum {
+#include "co2_sensor_scene_config.h"
+    Co2SensorSceneNum,
+} Co2SensorScene;
+#undef ADD_SCENE
+
+extern const SceneManagerHandlers co2_sensor_scene_handlers;
+
+// on_enter handlers
+#define ADD_SCENE(prefix, name, id) void prefix##_scene_##name##_on_enter(void* context);
+#include "co2_sensor_scene_config.h"
+#undef ADD_SCENE
+
+// on_event handlers
+#define ADD_SCENE(prefix, name, id) \
+    bool prefix##_scene_##name##_on_event(void* context, SceneManagerEvent event);
+#include "co2_sensor_scene_config.h"
+#undef ADD_SCENE
+
+// on_exit handlers
+#define ADD_SCENE(prefix, name, id) void prefix##_scene_##name##_on_exit(void* context);
+#include "co2_sensor_scene_config.h"
+#undef ADD_SCENE
+
+#endif
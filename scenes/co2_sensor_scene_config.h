@@ -0,0 +1,6 @@
+ADD_SCENE(co2_sensor, live, Live)
+ADD_SCENE(co2_sensor, menu, Menu)
+ADD_SCENE(co2_sensor, settings, Settings)
+ADD_SCENE(co2_sensor, diagnostics, Diagnostics)
+ADD_SCENE(co2_sensor, offset_tuning, OffsetTuning)
+ADD_SCENE(co2_sensor, nodes, Nodes)
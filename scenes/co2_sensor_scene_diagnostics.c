@@ -0,0 +1,328 @@
+#include "../co2_sensor.h"
+#include "../co2_memory.h"
+#include <gui/elements.h>
+
+// Self-test (OK) with its progress, then the sensor identity and settings, bus statistics, I2C
+// speed benchmark (Right), sample timing, event loop, pressure compensation and memory as lines
+// scrolled with Up/Down
+
+#define DIAGNOSTICS_LINES 22
+#define DIAGNOSTICS_LINE_SIZE 32
+#define DIAGNOSTICS_VISIBLE_LINES 4
+
+// Formatted on the app thread (stack and bus statistics are read there), drawn on the GUI thread
+typedef struct {
+    Co2SelfTest* selftest;
+    uint8_t count;
+    uint8_t scroll;
+    char lines[DIAGNOSTICS_LINES][DIAGNOSTICS_LINE_SIZE];
+} DiagnosticsModel;
+
+// Percentage of part in total, 0 if there is no total yet
+static float diagnostics_rate(uint32_t part, uint32_t total) {
+    return total ? (float)part * 100.0f / (float)total : 0.0f;
+}
+
+static void diagnostics_format(Co2SensorApp* app, DiagnosticsModel* model) {
+    const Co2Settings* settings = &app->settings;
+    char(*lines)[DIAGNOSTICS_LINE_SIZE] = model->lines;
+    uint8_t count = 0;
+
+    if(app->status == NoSensor) {
+        snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "No sensor found");
+    } else {
+        snprintf(
+            lines[count++],
+            DIAGNOSTICS_LINE_SIZE,
+            "%s %s",
+            settings->sensor_type == SCD4x_SENSOR_SCD41 ? "SCD41" : "SCD40",
+            app->serial[0] ? app->serial : "serial ?");
+    }
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "%s, ASC %s",
+        co2_settings_get_mode_name(settings->mode),
+        settings->asc ? "on" : "off");
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Offset %.1f C, alt. %u m",
+        (double)settings->temperature_offset,
+        settings->altitude);
+
+    scd4x_bus_stats_t bus;
+    getBusStats(&bus);
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Cmds %lu, avg %lu us",
+        bus.commands,
+        bus.commands ? bus.busyMicros / bus.commands : 0);
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Xfers %lu, NACK %.1f%%",
+        bus.transactions,
+        (double)diagnostics_rate(bus.nacks, bus.transactions));
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Reads %lu, CRC err %.1f%%",
+        bus.reads,
+        (double)diagnostics_rate(bus.crcFailures, bus.reads));
+
+    // Read time and bus time per sample at each speed measured so far
+    const Co2I2cBench* bench = &app->i2c_bench;
+    if(bench->running) {
+        snprintf(
+            lines[count++],
+            DIAGNOSTICS_LINE_SIZE,
+            "I2C bench %s %lu/%u",
+            co2_i2c_get_speed_name(bench->speed),
+            bench->results[bench->speed].samples,
+            CO2_I2C_BENCH_SAMPLES);
+    } else {
+        snprintf(
+            lines[count++],
+            DIAGNOSTICS_LINE_SIZE,
+            "I2C %s, Right: bench",
+            co2_i2c_get_speed_name(settings->i2c_speed));
+    }
+    for(uint8_t i = 0; i < Co2I2cSpeedNum; i++) {
+        const Co2I2cBenchResult* result = &bench->results[i];
+        const char* name = co2_i2c_get_speed_name(i);
+        if(result->samples == 0 && result->errors == 0) continue;
+        if(result->samples == 0) {
+            snprintf(
+                lines[count++],
+                DIAGNOSTICS_LINE_SIZE,
+                "%s: no reads, %lu err",
+                name,
+                result->errors);
+        } else if(result->errors) {
+            snprintf(
+                lines[count++],
+                DIAGNOSTICS_LINE_SIZE,
+                "%s: %.1f ms, %lu err",
+                name,
+                (double)result->latency_micros / result->samples / 1000.0,
+                result->errors);
+        } else {
+            snprintf(
+                lines[count++],
+                DIAGNOSTICS_LINE_SIZE,
+                "%s: %.2f ms, bus %lu us",
+                name,
+                (double)result->latency_micros / result->samples / 1000.0,
+                result->busy_micros / result->samples);
+        }
+    }
+
+    // Updates missed or read twice, and how late the reads come after the update
+    scd4x_timing_stats_t timing;
+    getTimingStats(&timing);
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Samples %lu, dropped %lu",
+        timing.samples,
+        timing.dropped);
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Off grid %lu, lat. max %lu ms",
+        timing.offGrid,
+        timing.latencyMaxMillis);
+    snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "Latency ms <100|250|500|1k|2k|+");
+    char* line = lines[count++];
+    size_t size = 0;
+    for(uint8_t i = 0; i < SCD4x_LATENCY_BUCKETS; i++) {
+        size += snprintf(
+            &line[size],
+            DIAGNOSTICS_LINE_SIZE - size,
+            "%3.0f%%",
+            (double)diagnostics_rate(timing.latency[i], timing.timed));
+    }
+
+    // Keys queued behind the one handled at most, and ticks the sampling was too busy for
+    snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "Key backlog max %lu", app->input_backlog_max);
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Keys lost %lu, lat. %lu ms",
+        app->input_lost,
+        app->key_latency_max);
+    snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "Ticks coalesced %lu", app->ticks_coalesced);
+
+    if(app->barometer.type != BarometerTypeNone) {
+        snprintf(
+            lines[count++],
+            DIAGNOSTICS_LINE_SIZE,
+            "%s %lu Pa",
+            barometer_get_name(&app->barometer),
+            pressure_comp_get_pressure(&app->pressure_comp));
+        snprintf(
+            lines[count++],
+            DIAGNOSTICS_LINE_SIZE,
+            "Pressure %u writes/h",
+            pressure_comp_get_writes_per_hour(&app->pressure_comp));
+    } else {
+        snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "No barometer");
+    }
+
+    const Co2Memory* memory = co2_memory_get();
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Stack free %lu B",
+        (uint32_t)co2_memory_stack_free());
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Heap free %lu B",
+        (uint32_t)memmgr_get_free_heap());
+    snprintf(
+        lines[count++],
+        DIAGNOSTICS_LINE_SIZE,
+        "Heap min %lu B",
+        (uint32_t)memmgr_get_minimum_free_heap());
+    snprintf(lines[count++], DIAGNOSTICS_LINE_SIZE, "App objects %lu B", (uint32_t)memory->used);
+
+    furi_assert(count <= DIAGNOSTICS_LINES);
+    model->count = count;
+    if(model->scroll > count - DIAGNOSTICS_VISIBLE_LINES) {
+        model->scroll = count - DIAGNOSTICS_VISIBLE_LINES;
+    }
+}
+
+static void diagnostics_update(Co2SensorApp* app) {
+    with_view_model(
+        app->diagnostics, DiagnosticsModel * model, { diagnostics_format(app, model); }, true);
+}
+
+static void diagnostics_draw_callback(Canvas* canvas, void* context) {
+    DiagnosticsModel* model = context;
+    const Co2SelfTest* selftest = model->selftest;
+    char buffer[DIAGNOSTICS_LINE_SIZE];
+
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 2, 10, "Self-test");
+    canvas_set_font(canvas, FontSecondary);
+
+    switch(selftest->state) {
+    case Co2SelfTestStateRunning:
+        elements_progress_bar(canvas, 56, 2, 70, co2_selftest_get_progress(selftest));
+        break;
+    case Co2SelfTestStateFailed:
+        snprintf(buffer, sizeof(buffer), "FAILED 0x%04X", selftest->response);
+        canvas_draw_str_aligned(canvas, 126, 10, AlignRight, AlignBottom, buffer);
+        break;
+    case Co2SelfTestStateIdle:
+        canvas_draw_str_aligned(canvas, 126, 10, AlignRight, AlignBottom, "OK: run (10 s)");
+        break;
+    default:
+        canvas_draw_str_aligned(
+            canvas,
+            126,
+            10,
+            AlignRight,
+            AlignBottom,
+            co2_selftest_get_state_name(selftest->state));
+        break;
+    }
+    canvas_draw_line(canvas, 2, 13, 126, 13);
+
+    for(uint8_t i = 0; i < DIAGNOSTICS_VISIBLE_LINES && model->scroll + i < model->count; i++) {
+        canvas_draw_str(canvas, 2, 25 + i * 11, model->lines[model->scroll + i]);
+    }
+    elements_scrollbar(canvas, model->scroll, model->count - DIAGNOSTICS_VISIBLE_LINES + 1);
+}
+
+static bool diagnostics_input_callback(InputEvent* event, void* context) {
+    Co2SensorApp* app = context;
+    if(event->key == InputKeyBack) return false;
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) return true;
+
+    switch(event->key) {
+    case InputKeyOk:
+        // The sensor must be there and free, the sequence stops and restarts its measurements
+        if(event->type == InputTypeShort && app->status != NoSensor &&
+           !co2_sensor_is_busy(app)) {
+            co2_selftest_start(app->selftest);
+            diagnostics_update(app);
+        }
+        break;
+    case InputKeyRight:
+        // Same conditions as the self-test, the replay has no bus to time and the hybrid mode no
+        // periodic reads
+        if(event->type == InputTypeShort && app->status != NoSensor &&
+           !co2_sensor_is_busy(app) && !app->replay && !app->i2c_bench.running &&
+           app->settings.mode != Co2SettingsModeHybrid) {
+            co2_i2c_bench_start(&app->i2c_bench);
+            diagnostics_update(app);
+        }
+        break;
+    case InputKeyUp:
+    case InputKeyDown:
+        with_view_model(
+            app->diagnostics,
+            DiagnosticsModel * model,
+            {
+                if(event->key == InputKeyUp && model->scroll > 0) {
+                    model->scroll--;
+                } else if(
+                    event->key == InputKeyDown &&
+                    model->scroll + DIAGNOSTICS_VISIBLE_LINES < model->count) {
+                    model->scroll++;
+                }
+            },
+            true);
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+void co2_sensor_scene_diagnostics_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    app->diagnostics = view_alloc();
+    view_allocate_model(app->diagnostics, ViewModelTypeLocking, sizeof(DiagnosticsModel));
+    with_view_model(
+        app->diagnostics,
+        DiagnosticsModel * model,
+        {
+            memset(model, 0, sizeof(DiagnosticsModel));
+            model->selftest = app->selftest;
+            diagnostics_format(app, model);
+        },
+        false);
+    view_set_context(app->diagnostics, app);
+    view_set_draw_callback(app->diagnostics, diagnostics_draw_callback);
+    view_set_input_callback(app->diagnostics, diagnostics_input_callback);
+
+    view_dispatcher_add_view(app->view_dispatcher, Co2SensorViewDiagnostics, app->diagnostics);
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewDiagnostics);
+}
+
+bool co2_sensor_scene_diagnostics_on_event(void* context, SceneManagerEvent event) {
+    Co2SensorApp* app = context;
+    if(event.type != SceneManagerEventTypeCustom) return false;
+
+    // Refresh the progress and the statistics every second, and right when the self-test is over
+    if(event.event == Co2SensorEventTick || event.event == Co2SensorEventSelfTestDone) {
+        diagnostics_update(app);
+        return true;
+    }
+    return false;
+}
+
+void co2_sensor_scene_diagnostics_on_exit(void* context) {
+    Co2SensorApp* app = context;
+    // A running self-test carries on, its outcome is shown when the screen is opened again
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewDiagnostics);
+    view_free(app->diagnostics);
+    app->diagnostics = NULL;
+}
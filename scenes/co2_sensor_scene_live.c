@@ -0,0 +1,19 @@
+#include "../co2_sensor.h"
+
+// The live values and every screen reachable with the arrow keys, all drawn by the live view
+
+void co2_sensor_scene_live_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewLive);
+}
+
+bool co2_sensor_scene_live_on_event(void* context, SceneManagerEvent event) {
+    UNUSED(context);
+    UNUSED(event);
+    // The live view handles its keys itself, Back leaves the app
+    return false;
+}
+
+void co2_sensor_scene_live_on_exit(void* context) {
+    UNUSED(context);
+}
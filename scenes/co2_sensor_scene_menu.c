@@ -0,0 +1,60 @@
+#include "../co2_sensor.h"
+
+static void co2_sensor_scene_menu_callback(void* context, uint32_t index) {
+    Co2SensorApp* app = context;
+    view_dispatcher_send_custom_event(app->view_dispatcher, index);
+}
+
+void co2_sensor_scene_menu_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    Submenu* menu = app->menu;
+
+    submenu_add_item(
+        menu, "Settings", Co2SensorEventMenuSettings, co2_sensor_scene_menu_callback, app);
+    submenu_add_item(
+        menu, "Diagnostics", Co2SensorEventMenuDiagnostics, co2_sensor_scene_menu_callback, app);
+    submenu_add_item(
+        menu,
+        "Offset tuning",
+        Co2SensorEventMenuOffsetTuning,
+        co2_sensor_scene_menu_callback,
+        app);
+    submenu_add_item(menu, "Nodes", Co2SensorEventMenuNodes, co2_sensor_scene_menu_callback, app);
+    submenu_set_selected_item(
+        menu, scene_manager_get_scene_state(app->scene_manager, Co2SensorSceneMenu));
+
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewMenu);
+}
+
+bool co2_sensor_scene_menu_on_event(void* context, SceneManagerEvent event) {
+    Co2SensorApp* app = context;
+    if(event.type != SceneManagerEventTypeCustom) return false;
+
+    switch(event.event) {
+    case Co2SensorEventMenuSettings:
+        // Leaving the settings writes them to the sensor, which a running self-test owns
+        if(co2_sensor_is_busy(app)) return true;
+        scene_manager_set_scene_state(app->scene_manager, Co2SensorSceneMenu, event.event);
+        scene_manager_next_scene(app->scene_manager, Co2SensorSceneSettings);
+        return true;
+    case Co2SensorEventMenuDiagnostics:
+        scene_manager_set_scene_state(app->scene_manager, Co2SensorSceneMenu, event.event);
+        scene_manager_next_scene(app->scene_manager, Co2SensorSceneDiagnostics);
+        return true;
+    case Co2SensorEventMenuOffsetTuning:
+        scene_manager_set_scene_state(app->scene_manager, Co2SensorSceneMenu, event.event);
+        scene_manager_next_scene(app->scene_manager, Co2SensorSceneOffsetTuning);
+        return true;
+    case Co2SensorEventMenuNodes:
+        scene_manager_set_scene_state(app->scene_manager, Co2SensorSceneMenu, event.event);
+        scene_manager_next_scene(app->scene_manager, Co2SensorSceneNodes);
+        return true;
+    default:
+        return false;
+    }
+}
+
+void co2_sensor_scene_menu_on_exit(void* context) {
+    Co2SensorApp* app = context;
+    submenu_reset(app->menu);
+}
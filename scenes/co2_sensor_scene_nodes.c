@@ -0,0 +1,185 @@
+#include "../co2_sensor.h"
+#include <gui/elements.h>
+
+// Newest sample of every node the collector heard from, one line each scrolled with Up/Down,
+// then the link statistics
+
+#define NODES_LINES (CO2_RADIO_MAX_NODES + 2)
+#define NODES_LINE_SIZE 32
+#define NODES_VISIBLE_LINES 4
+
+// Formatted on the app thread, which owns the collector, drawn on the GUI thread
+typedef struct {
+    Co2RadioLinkMode mode; // What runs, not what the settings ask for
+    bool failed;
+    uint8_t nodes;
+    uint8_t count;
+    uint8_t scroll;
+    char lines[NODES_LINES][NODES_LINE_SIZE];
+} NodesModel;
+
+static void nodes_format(Co2SensorApp* app, NodesModel* model) {
+    const Co2RadioLink* link = app->radio;
+    const Co2RadioCollector* collector = &link->collector;
+    char(*lines)[NODES_LINE_SIZE] = model->lines;
+    uint32_t now = furi_get_tick();
+    uint8_t count = 0;
+
+    model->mode = link->mode;
+    model->failed = app->radio_failed;
+    model->nodes = collector->count;
+    if(model->mode == Co2RadioLinkModeBroadcast) {
+        snprintf(lines[count++], NODES_LINE_SIZE, "Node %08lX", link->broadcaster.node_id);
+        snprintf(
+            lines[count++],
+            NODES_LINE_SIZE,
+            "Sent %lu, dropped %lu",
+            link->broadcaster.sent,
+            link->send_errors);
+    } else if(model->mode == Co2RadioLinkModeCollector) {
+        uint32_t duplicates = 0;
+        for(uint8_t i = 0; i < collector->count; i++) {
+            const Co2RadioNode* node = &collector->nodes[i];
+            duplicates += node->duplicates;
+            // Short id, CO2 ppm, temperature, age of the sample, samples lost
+            snprintf(
+                lines[count++],
+                NODES_LINE_SIZE,
+                "%04lX %4u %4.1fC %3lus %lu",
+                node->node_id & 0xFFFF,
+                node->sample.co2,
+                (double)convertTemperature(node->sample.temperature),
+                (now - node->last_tick) / furi_ms_to_ticks(1000),
+                node->lost);
+        }
+        snprintf(
+            lines[count++],
+            NODES_LINE_SIZE,
+            "Frames %lu, dup. %lu",
+            collector->frames,
+            duplicates);
+        snprintf(
+            lines[count++],
+            NODES_LINE_SIZE,
+            "Logged %lu (%lu err)",
+            link->logged,
+            link->log_errors);
+    }
+
+    furi_assert(count <= NODES_LINES);
+    model->count = count;
+    if(model->scroll + NODES_VISIBLE_LINES > count) {
+        model->scroll = count > NODES_VISIBLE_LINES ? count - NODES_VISIBLE_LINES : 0;
+    }
+}
+
+static void nodes_update(Co2SensorApp* app) {
+    with_view_model(app->nodes, NodesModel * model, { nodes_format(app, model); }, true);
+}
+
+static void nodes_draw_callback(Canvas* canvas, void* context) {
+    NodesModel* model = context;
+    char buffer[NODES_LINE_SIZE];
+
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 2, 10, "Nodes");
+    canvas_set_font(canvas, FontSecondary);
+    if(model->mode == Co2RadioLinkModeCollector) {
+        snprintf(buffer, sizeof(buffer), "%u/%u", model->nodes, CO2_RADIO_MAX_NODES);
+    } else {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "%s",
+            co2_settings_get_radio_name((Co2SettingsRadio)model->mode));
+    }
+    canvas_draw_str_aligned(canvas, 126, 10, AlignRight, AlignBottom, buffer);
+    canvas_draw_line(canvas, 2, 13, 126, 13);
+
+    if(model->failed) {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "%lu.%02lu MHz",
+            CO2_RADIO_FREQUENCY / 1000000,
+            CO2_RADIO_FREQUENCY / 10000 % 100);
+        canvas_draw_str(canvas, 2, 27, "Radio failed to start:");
+        canvas_draw_str(canvas, 2, 38, buffer);
+        canvas_draw_str(canvas, 2, 49, "not allowed in this region?");
+        return;
+    }
+    if(model->mode == Co2RadioLinkModeOff) {
+        canvas_draw_str(canvas, 2, 27, "Radio off");
+        canvas_draw_str(canvas, 2, 38, "Settings > Radio: Collector");
+        canvas_draw_str(canvas, 2, 49, "to hear other nodes");
+        return;
+    }
+
+    for(uint8_t i = 0; i < NODES_VISIBLE_LINES && model->scroll + i < model->count; i++) {
+        canvas_draw_str(canvas, 2, 25 + i * 11, model->lines[model->scroll + i]);
+    }
+    if(model->count > NODES_VISIBLE_LINES) {
+        elements_scrollbar(canvas, model->scroll, model->count - NODES_VISIBLE_LINES + 1);
+    }
+}
+
+static bool nodes_input_callback(InputEvent* event, void* context) {
+    Co2SensorApp* app = context;
+    if(event->key == InputKeyBack) return false;
+    if(event->type != InputTypeShort && event->type != InputTypeRepeat) return true;
+
+    if(event->key == InputKeyUp || event->key == InputKeyDown) {
+        with_view_model(
+            app->nodes,
+            NodesModel * model,
+            {
+                if(event->key == InputKeyUp && model->scroll > 0) {
+                    model->scroll--;
+                } else if(
+                    event->key == InputKeyDown &&
+                    model->scroll + NODES_VISIBLE_LINES < model->count) {
+                    model->scroll++;
+                }
+            },
+            true);
+    }
+    return true;
+}
+
+void co2_sensor_scene_nodes_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    app->nodes = view_alloc();
+    view_allocate_model(app->nodes, ViewModelTypeLocking, sizeof(NodesModel));
+    with_view_model(
+        app->nodes,
+        NodesModel * model,
+        {
+            memset(model, 0, sizeof(NodesModel));
+            nodes_format(app, model);
+        },
+        false);
+    view_set_context(app->nodes, app);
+    view_set_draw_callback(app->nodes, nodes_draw_callback);
+    view_set_input_callback(app->nodes, nodes_input_callback);
+
+    view_dispatcher_add_view(app->view_dispatcher, Co2SensorViewNodes, app->nodes);
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewNodes);
+}
+
+bool co2_sensor_scene_nodes_on_event(void* context, SceneManagerEvent event) {
+    Co2SensorApp* app = context;
+    // The collector was drained just before the tick got here
+    if(event.type == SceneManagerEventTypeCustom && event.event == Co2SensorEventTick) {
+        nodes_update(app);
+        return true;
+    }
+    return false;
+}
+
+void co2_sensor_scene_nodes_on_exit(void* context) {
+    Co2SensorApp* app = context;
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewNodes);
+    view_free(app->nodes);
+    app->nodes = NULL;
+}
@@ -0,0 +1,171 @@
+#include "../co2_sensor.h"
+
+// Compare the SCD4x temperature with the reference thermometer until the difference settles,
+// then OK writes the offset that cancels it (single stop / set / restart, saved with the settings)
+
+typedef struct {
+    bool reference; // A reference thermometer was found at startup
+    const char* reference_name;
+    uint8_t count;
+    bool has_fit;
+    OffsetTunerFit fit;
+    float sensor;
+    float temperature; // Last reference reading
+    float current_offset;
+    float offset; // Offset that would cancel the fitted difference
+    bool settled;
+    bool applied; // The offset was just written, the window restarted from it
+} OffsetTuningModel;
+
+static void offset_tuning_format(Co2SensorApp* app, OffsetTuningModel* model) {
+    const OffsetTuner* tuner = &app->offset_tuner;
+    model->reference = app->thermometer.type != ThermometerTypeNone;
+    model->reference_name = thermometer_get_name(&app->thermometer);
+    model->count = tuner->count;
+    model->has_fit = offset_tuner_get_fit(tuner, &model->fit);
+    model->sensor = tuner->sensor;
+    model->temperature = tuner->reference;
+    model->current_offset = app->settings.temperature_offset;
+    model->offset =
+        offset_tuner_get_offset(tuner, app->settings.temperature_offset, CO2_SETTINGS_OFFSET_MAX);
+    model->settled = offset_tuner_is_settled(tuner);
+}
+
+static void offset_tuning_update(Co2SensorApp* app) {
+    with_view_model(
+        app->offset_tuning,
+        OffsetTuningModel * model,
+        { offset_tuning_format(app, model); },
+        true);
+}
+
+static void offset_tuning_draw_callback(Canvas* canvas, void* context) {
+    OffsetTuningModel* model = context;
+    char buffer[32];
+
+    canvas_clear(canvas);
+    canvas_set_font(canvas, FontPrimary);
+    canvas_draw_str(canvas, 2, 10, "Offset tuning");
+    canvas_set_font(canvas, FontSecondary);
+    canvas_draw_str_aligned(canvas, 126, 10, AlignRight, AlignBottom, model->reference_name);
+    canvas_draw_line(canvas, 2, 13, 126, 13);
+
+    if(!model->reference) {
+        canvas_draw_str(canvas, 2, 27, "No reference thermometer");
+        canvas_draw_str(canvas, 2, 38, "Connect a SHT3x/SHT4x");
+        canvas_draw_str(canvas, 2, 49, "and restart the app");
+        return;
+    }
+    if(model->count == 0) {
+        canvas_draw_str(canvas, 2, 27, "Waiting for a sample..");
+        return;
+    }
+
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "SCD4x %.2f  Ref %.2f",
+        (double)model->sensor,
+        (double)model->temperature);
+    canvas_draw_str(canvas, 2, 24, buffer);
+
+    if(model->has_fit) {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "Diff %+.2f C, n %u/%u",
+            (double)model->fit.difference,
+            model->count,
+            OFFSET_TUNER_WINDOW);
+        canvas_draw_str(canvas, 2, 35, buffer);
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "Drift %.2f, noise %.2f",
+            (double)model->fit.drift,
+            (double)model->fit.noise);
+        canvas_draw_str(canvas, 2, 46, buffer);
+    }
+
+    if(model->applied && !model->settled) {
+        snprintf(
+            buffer, sizeof(buffer), "Offset %.1f C, verifying..", (double)model->current_offset);
+    } else if(model->settled) {
+        snprintf(
+            buffer,
+            sizeof(buffer),
+            "OK: offset %.1f -> %.1f C",
+            (double)model->current_offset,
+            (double)model->offset);
+    } else {
+        snprintf(buffer, sizeof(buffer), "Settling..");
+    }
+    canvas_draw_str(canvas, 2, 63, buffer);
+}
+
+static bool offset_tuning_input_callback(InputEvent* event, void* context) {
+    Co2SensorApp* app = context;
+    if(event->key == InputKeyBack) return false;
+    if(event->key != InputKeyOk || event->type != InputTypeShort) return true;
+
+    // The offset is written with a stop / restart, not while a worker owns the sensor
+    if(!offset_tuner_is_settled(&app->offset_tuner) || co2_sensor_is_busy(app)) return true;
+
+    app->settings_pending = app->settings;
+    app->settings_pending.temperature_offset = offset_tuner_get_offset(
+        &app->offset_tuner, app->settings.temperature_offset, CO2_SETTINGS_OFFSET_MAX);
+    co2_sensor_apply_settings(app);
+
+    // The differences measured so far were with the old offset
+    offset_tuner_reset(&app->offset_tuner, furi_get_tick());
+    with_view_model(
+        app->offset_tuning,
+        OffsetTuningModel * model,
+        {
+            model->applied = true;
+            offset_tuning_format(app, model);
+        },
+        true);
+    return true;
+}
+
+void co2_sensor_scene_offset_tuning_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    offset_tuner_reset(&app->offset_tuner, furi_get_tick());
+    app->offset_tuning_active = app->thermometer.type != ThermometerTypeNone &&
+                                app->status != NoSensor;
+
+    app->offset_tuning = view_alloc();
+    view_allocate_model(app->offset_tuning, ViewModelTypeLocking, sizeof(OffsetTuningModel));
+    with_view_model(
+        app->offset_tuning,
+        OffsetTuningModel * model,
+        {
+            memset(model, 0, sizeof(OffsetTuningModel));
+            offset_tuning_format(app, model);
+        },
+        false);
+    view_set_context(app->offset_tuning, app);
+    view_set_draw_callback(app->offset_tuning, offset_tuning_draw_callback);
+    view_set_input_callback(app->offset_tuning, offset_tuning_input_callback);
+
+    view_dispatcher_add_view(app->view_dispatcher, Co2SensorViewOffsetTuning, app->offset_tuning);
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewOffsetTuning);
+}
+
+bool co2_sensor_scene_offset_tuning_on_event(void* context, SceneManagerEvent event) {
+    Co2SensorApp* app = context;
+    if(event.type == SceneManagerEventTypeCustom && event.event == Co2SensorEventTick) {
+        offset_tuning_update(app);
+        return true;
+    }
+    return false;
+}
+
+void co2_sensor_scene_offset_tuning_on_exit(void* context) {
+    Co2SensorApp* app = context;
+    app->offset_tuning_active = false;
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewOffsetTuning);
+    view_free(app->offset_tuning);
+    app->offset_tuning = NULL;
+}
@@ -0,0 +1,143 @@
+#include "../co2_sensor.h"
+#include <math.h>
+
+// The items edit app->settings_pending, the whole change set is written to the sensor when the
+// scene is left. The radio role and the I2C speed are not written to the sensor, the radio
+// restarts in the role and the driver switches to the bus handle of the speed
+
+#define SETTINGS_OFFSET_COUNT ((uint8_t)(CO2_SETTINGS_OFFSET_MAX / CO2_SETTINGS_OFFSET_STEP) + 1)
+#define SETTINGS_ALTITUDE_COUNT (CO2_SETTINGS_ALTITUDE_MAX / CO2_SETTINGS_ALTITUDE_STEP + 1)
+
+static const char* const sensor_names[] = {"SCD40", "SCD41"};
+static const char* const off_on_names[] = {"Off", "On"};
+
+// A value read from the sensor may be off the steps, it is shown as is until changed
+static void settings_set_offset_text(VariableItem* item, float offset) {
+    char text[8];
+    snprintf(text, sizeof(text), "%.1f C", (double)offset);
+    variable_item_set_current_value_text(item, text);
+}
+
+static void settings_set_altitude_text(VariableItem* item, uint16_t altitude) {
+    char text[8];
+    snprintf(text, sizeof(text), "%u m", altitude);
+    variable_item_set_current_value_text(item, text);
+}
+
+static void settings_sensor_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.sensor_type = index;
+    variable_item_set_current_value_text(item, sensor_names[index]);
+}
+
+static void settings_mode_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.mode = index;
+    variable_item_set_current_value_text(item, co2_settings_get_mode_name(index));
+}
+
+static void settings_offset_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.temperature_offset = index * CO2_SETTINGS_OFFSET_STEP;
+    settings_set_offset_text(item, app->settings_pending.temperature_offset);
+}
+
+static void settings_altitude_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.altitude = index * CO2_SETTINGS_ALTITUDE_STEP;
+    settings_set_altitude_text(item, app->settings_pending.altitude);
+}
+
+static void settings_asc_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.asc = index;
+    variable_item_set_current_value_text(item, off_on_names[index]);
+}
+
+static void settings_radio_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.radio = index;
+    variable_item_set_current_value_text(item, co2_settings_get_radio_name(index));
+}
+
+static void settings_i2c_speed_changed(VariableItem* item) {
+    Co2SensorApp* app = variable_item_get_context(item);
+    uint8_t index = variable_item_get_current_value_index(item);
+    app->settings_pending.i2c_speed = index;
+    variable_item_set_current_value_text(item, co2_i2c_get_speed_name(index));
+}
+
+void co2_sensor_scene_settings_on_enter(void* context) {
+    Co2SensorApp* app = context;
+    const Co2Settings* settings = &app->settings;
+    app->settings_pending = *settings;
+    app->settings_list = variable_item_list_alloc();
+    VariableItemList* list = app->settings_list;
+    VariableItem* item;
+
+    // Nothing to choose when the driver is built for one variant
+    if(SCD4x_VARIANT == SCD4x_VARIANT_RUNTIME) {
+        item = variable_item_list_add(
+            list, "Sensor", COUNT_OF(sensor_names), settings_sensor_changed, app);
+        variable_item_set_current_value_index(item, settings->sensor_type);
+        variable_item_set_current_value_text(item, sensor_names[settings->sensor_type]);
+    }
+
+    item = variable_item_list_add(list, "Mode", Co2SettingsModeNum, settings_mode_changed, app);
+    variable_item_set_current_value_index(item, settings->mode);
+    variable_item_set_current_value_text(item, co2_settings_get_mode_name(settings->mode));
+
+    item = variable_item_list_add(
+        list, "Temp. offset", SETTINGS_OFFSET_COUNT, settings_offset_changed, app);
+    variable_item_set_current_value_index(
+        item,
+        roundf(
+            CLAMP(settings->temperature_offset, CO2_SETTINGS_OFFSET_MAX, 0) /
+            CO2_SETTINGS_OFFSET_STEP));
+    settings_set_offset_text(item, settings->temperature_offset);
+
+    item = variable_item_list_add(
+        list, "Altitude", SETTINGS_ALTITUDE_COUNT, settings_altitude_changed, app);
+    variable_item_set_current_value_index(
+        item, MIN(settings->altitude, CO2_SETTINGS_ALTITUDE_MAX) / CO2_SETTINGS_ALTITUDE_STEP);
+    settings_set_altitude_text(item, settings->altitude);
+
+    item = variable_item_list_add(
+        list, "Auto calib.", COUNT_OF(off_on_names), settings_asc_changed, app);
+    variable_item_set_current_value_index(item, settings->asc);
+    variable_item_set_current_value_text(item, off_on_names[settings->asc]);
+
+    item = variable_item_list_add(list, "Radio", Co2SettingsRadioNum, settings_radio_changed, app);
+    variable_item_set_current_value_index(item, settings->radio);
+    variable_item_set_current_value_text(item, co2_settings_get_radio_name(settings->radio));
+
+    item = variable_item_list_add(
+        list, "I2C speed", Co2I2cSpeedNum, settings_i2c_speed_changed, app);
+    variable_item_set_current_value_index(item, settings->i2c_speed);
+    variable_item_set_current_value_text(item, co2_i2c_get_speed_name(settings->i2c_speed));
+
+    view_dispatcher_add_view(
+        app->view_dispatcher, Co2SensorViewSettings, variable_item_list_get_view(list));
+    view_dispatcher_switch_to_view(app->view_dispatcher, Co2SensorViewSettings);
+}
+
+bool co2_sensor_scene_settings_on_event(void* context, SceneManagerEvent event) {
+    UNUSED(context);
+    UNUSED(event);
+    return false;
+}
+
+void co2_sensor_scene_settings_on_exit(void* context) {
+    Co2SensorApp* app = context;
+    co2_sensor_apply_settings(app);
+
+    view_dispatcher_remove_view(app->view_dispatcher, Co2SensorViewSettings);
+    variable_item_list_free(app->settings_list);
+    app->settings_list = NULL;
+}
@@ -0,0 +1,61 @@
+/*
+  Single writer sequence lock.
+
+  The writer makes the sequence odd while it updates the protected data and even again once done.
+  A reader copies the data and retries if the sequence was odd or changed meanwhile, so it never
+  blocks the writer and never sees a torn copy.
+
+  Readers may run at a higher priority than the writer (the GUI thread reading what the app thread
+  publishes). A reader finding a write in progress sleeps for a tick instead of spinning, otherwise
+  the preempted writer would never get to finish.
+*/
+
+#ifndef __SEQLOCK_H__
+#define __SEQLOCK_H__
+
+#include <furi.h>
+
+typedef struct {
+    uint32_t sequence;
+} SeqLock;
+
+static inline void seqlock_write_begin(SeqLock* lock) {
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqlock_write_end(SeqLock* lock) {
+    __atomic_store_n(&lock->sequence, lock->sequence + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seqlock_read_begin(const SeqLock* lock) {
+    uint32_t sequence;
+    while((sequence = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE)) & 1) {
+        furi_delay_tick(1);
+    }
+    return sequence;
+}
+
+// True if the data read since seqlock_read_begin() may be torn and must be read again
+static inline bool seqlock_read_retry(const SeqLock* lock, uint32_t sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED) != sequence;
+}
+
+// Copy size bytes from the protected data at src
+static inline void seqlock_read(const SeqLock* lock, void* dst, const void* src, size_t size) {
+    uint32_t sequence;
+    do {
+        sequence = seqlock_read_begin(lock);
+        memcpy(dst, src, size);
+    } while(seqlock_read_retry(lock, sequence));
+}
+
+// Copy size bytes to the protected data at dst
+static inline void seqlock_write(SeqLock* lock, void* dst, const void* src, size_t size) {
+    seqlock_write_begin(lock);
+    memcpy(dst, src, size);
+    seqlock_write_end(lock);
+}
+
+#endif
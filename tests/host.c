@@ -0,0 +1,1038 @@
+#include "host.h"
+#include <furi_hal.h>
+#include <furi_hal_random.h>
+#include <lib/subghz/subghz_tx_rx_worker.h>
+#include <storage/storage.h>
+#include <notification/notification_messages.h>
+#include <toolbox/saved_struct.h>
+#include <toolbox/args.h>
+#include <cli/cli.h>
+#include "co2_memory.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+volatile uint32_t host_tick = 0;
+uint32_t host_rtc = 1700000000;
+FuriLogLevel host_log_level = FuriLogLevelWarn;
+uint32_t host_log_errors = 0;
+
+uint32_t furi_ms_to_ticks(uint32_t ms) {
+    return ms;
+}
+
+uint32_t furi_get_tick(void) {
+    return __atomic_load_n(&host_tick, __ATOMIC_RELAXED);
+}
+
+uint32_t furi_kernel_get_tick_frequency(void) {
+    return 1000;
+}
+
+// Cycle counter at 64 cycles/us. The delays and the transfers on the external bus advance it,
+// the tests advancing the clock do not
+static DWT_Type host_dwt;
+DWT_Type* DWT = &host_dwt;
+
+uint32_t furi_hal_cortex_instructions_per_microsecond(void) {
+    return 64;
+}
+
+static void host_dwt_advance(uint32_t cycles) {
+    __atomic_add_fetch(&host_dwt.CYCCNT, cycles, __ATOMIC_RELAXED);
+}
+
+// Let the other threads run, as a sleeping thread would on the Flipper
+void furi_delay_tick(uint32_t ticks) {
+    host_advance(ticks);
+    host_dwt_advance(ticks * 64000);
+    sched_yield();
+}
+
+void furi_delay_ms(uint32_t ms) {
+    host_advance(ms);
+    host_dwt_advance(ms * 64000);
+}
+
+void furi_delay_us(uint32_t us) {
+    UNUSED(us);
+}
+
+uint32_t furi_hal_rtc_get_timestamp(void) {
+    return host_rtc;
+}
+
+void furi_hal_rtc_get_datetime(FuriHalRtcDateTime* datetime) {
+    time_t now = host_rtc;
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    datetime->year = tm.tm_year + 1900;
+    datetime->month = tm.tm_mon + 1;
+    datetime->day = tm.tm_mday;
+    datetime->hour = tm.tm_hour;
+    datetime->minute = tm.tm_min;
+    datetime->second = tm.tm_sec;
+    datetime->weekday = tm.tm_wday ? tm.tm_wday : 7;
+}
+
+void furi_log_print_format(FuriLogLevel level, const char* tag, const char* format, ...) {
+    if(level == FuriLogLevelError) host_log_errors++;
+    va_list args;
+    va_start(args, format);
+    // Formatted whatever the level, as the firmware does at its default level, so that it counts
+    // in the stack use of the caller
+    va_list copy;
+    va_copy(copy, args);
+    vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    if(level <= host_log_level) {
+        fprintf(stderr, "[%s] ", tag);
+        vfprintf(stderr, format, args);
+        fputc('\n', stderr);
+    }
+    va_end(args);
+}
+
+// External bus: acquiring it sets it up for the handle, whose TIMINGR gives the SCL period. A
+// transfer takes its bits (start, address and data bytes with their ACK, stop) on the cycle
+// counter. Above host_i2c_max_hz the wiring fails one transfer in 4
+#define HOST_I2C_KERNEL_HZ 64000000
+#define HOST_I2C_SYNC_CYCLES 16 // SCL rise and synchronisation, about 250 ns per period
+
+static I2C_TypeDef host_i2c3;
+FuriHalI2cBus furi_hal_i2c_bus_external = {.i2c = &host_i2c3};
+
+// 100 kHz, the timing of the firmware handle
+static void host_i2c_external_event(FuriHalI2cBusHandle* handle, FuriHalI2cBusHandleEvent event) {
+    if(event == FuriHalI2cBusHandleEventActivate) handle->bus->i2c->TIMINGR = 0x10707DBC;
+}
+
+FuriHalI2cBusHandle furi_hal_i2c_handle_external = {
+    .bus = &furi_hal_i2c_bus_external,
+    .callback = host_i2c_external_event,
+};
+
+const GpioPin gpio_ext_pc0 = {.pin = 0};
+const GpioPin gpio_ext_pc1 = {.pin = 1};
+
+void furi_hal_gpio_init_ex(
+    const GpioPin* gpio,
+    GpioMode mode,
+    GpioPull pull,
+    GpioSpeed speed,
+    GpioAltFn alt_fn) {
+    UNUSED(gpio);
+    UNUSED(mode);
+    UNUSED(pull);
+    UNUSED(speed);
+    UNUSED(alt_fn);
+}
+
+void furi_hal_gpio_write(const GpioPin* gpio, bool state) {
+    UNUSED(gpio);
+    UNUSED(state);
+}
+
+uint32_t host_i2c_max_hz = 0;
+uint32_t host_i2c_acquires = 0;
+uint32_t host_i2c_probes = 0;
+uint32_t host_i2c_failures = 0;
+static pthread_mutex_t host_i2c_mutex = PTHREAD_MUTEX_INITIALIZER;
+static FuriHalI2cBusHandle* host_i2c_owner = NULL;
+static uint32_t host_i2c_random = 1;
+
+void furi_hal_i2c_acquire(FuriHalI2cBusHandle* handle) {
+    pthread_mutex_lock(&host_i2c_mutex);
+    host_i2c_owner = handle;
+    host_i2c_acquires++;
+    if(handle->callback) handle->callback(handle, FuriHalI2cBusHandleEventActivate);
+}
+
+void furi_hal_i2c_release(FuriHalI2cBusHandle* handle) {
+    HOST_CHECK(host_i2c_owner == handle);
+    if(handle->callback) handle->callback(handle, FuriHalI2cBusHandleEventDeactivate);
+    host_i2c_owner = NULL;
+    pthread_mutex_unlock(&host_i2c_mutex);
+}
+
+uint32_t host_i2c_get_scl_hz(void) {
+    uint32_t timing = host_i2c3.TIMINGR;
+    uint32_t period = ((timing >> 28) + 1) * ((timing & 0xFF) + 1 + ((timing >> 8) & 0xFF) + 1) +
+                      HOST_I2C_SYNC_CYCLES;
+    return HOST_I2C_KERNEL_HZ / period;
+}
+
+// Clock the bits of a transfer of size data bytes, false if the wiring lost it
+static bool host_i2c_transfer(FuriHalI2cBusHandle* handle, uint8_t size) {
+    HOST_CHECK(host_i2c_owner == handle);
+    uint32_t scl_hz = host_i2c_get_scl_hz();
+    uint32_t bits = 9 * (size + 1) + 2;
+    host_dwt_advance((uint32_t)((uint64_t)bits * HOST_I2C_KERNEL_HZ / scl_hz));
+    if(host_i2c_max_hz && scl_hz > host_i2c_max_hz) {
+        host_i2c_random = host_i2c_random * 1103515245 + 12345;
+        if((host_i2c_random >> 16) % 4 == 0) {
+            host_i2c_failures++;
+            return false;
+        }
+    }
+    return true;
+}
+
+// At most one device on the host bus, attached by the test. Tests of the SCD4x either install
+// their own driver transport or attach the simulated sensor here, behind the driver's I2C one
+static const HostI2cDevice* host_i2c_device = NULL;
+
+void host_i2c_attach(const HostI2cDevice* device) {
+    host_i2c_device = device;
+}
+
+bool furi_hal_i2c_is_device_ready(FuriHalI2cBusHandle* handle, uint8_t address, uint32_t timeout) {
+    UNUSED(timeout);
+    host_i2c_probes++;
+    return host_i2c_transfer(handle, 0) && host_i2c_device && host_i2c_device->address == address;
+}
+
+bool furi_hal_i2c_tx(
+    FuriHalI2cBusHandle* handle,
+    uint8_t address,
+    const uint8_t* data,
+    uint8_t size,
+    uint32_t timeout) {
+    UNUSED(timeout);
+    if(!host_i2c_transfer(handle, size)) return false;
+    if(!host_i2c_device || host_i2c_device->address != address) return false;
+    return host_i2c_device->tx(host_i2c_device->context, data, size);
+}
+
+bool furi_hal_i2c_rx(
+    FuriHalI2cBusHandle* handle,
+    uint8_t address,
+    uint8_t* data,
+    uint8_t size,
+    uint32_t timeout) {
+    UNUSED(timeout);
+    if(!host_i2c_transfer(handle, size)) return false;
+    if(!host_i2c_device || host_i2c_device->address != address) return false;
+    return host_i2c_device->rx(host_i2c_device->context, data, size);
+}
+
+// Register access: the register address is written, then read from or written to in the same
+// transfer, as the firmware does with a repeated start
+bool furi_hal_i2c_read_mem(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t mem_addr,
+    uint8_t* data,
+    size_t len,
+    uint32_t timeout) {
+    return furi_hal_i2c_tx(handle, i2c_addr, &mem_addr, 1, timeout) &&
+           furi_hal_i2c_rx(handle, i2c_addr, data, (uint8_t)len, timeout);
+}
+
+bool furi_hal_i2c_read_reg_8(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t reg_addr,
+    uint8_t* data,
+    uint32_t timeout) {
+    return furi_hal_i2c_read_mem(handle, i2c_addr, reg_addr, data, 1, timeout);
+}
+
+bool furi_hal_i2c_write_reg_8(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t reg_addr,
+    uint8_t data,
+    uint32_t timeout) {
+    uint8_t buffer[2] = {reg_addr, data};
+    return furi_hal_i2c_tx(handle, i2c_addr, buffer, sizeof(buffer), timeout);
+}
+
+// Sub-GHz: the running workers share one channel. A packet written by one of them is copied at
+// once to the RX buffer of every other one, unless the channel drops it
+#define HOST_RADIO_WORKERS 16
+#define HOST_RADIO_RX_SIZE 2048 // Stream buffer of the firmware worker
+
+struct SubGhzDevice {
+    const char* name;
+};
+
+struct SubGhzTxRxWorker {
+    bool running;
+    uint8_t rx[HOST_RADIO_RX_SIZE];
+    size_t rx_size;
+};
+
+bool host_radio_allowed = true;
+uint32_t host_radio_overruns = 0;
+static SubGhzTxRxWorker* host_radio_workers[HOST_RADIO_WORKERS];
+static HostRadioChannel host_radio_channel = NULL;
+static void* host_radio_context = NULL;
+static uint32_t host_random_state = 1;
+
+void host_radio_set_channel(HostRadioChannel channel, void* context) {
+    host_radio_channel = channel;
+    host_radio_context = context;
+}
+
+uint32_t furi_hal_random_get(void) {
+    host_random_state = host_random_state * 1103515245 + 12345;
+    return host_random_state;
+}
+
+void subghz_devices_init(void) {
+}
+
+void subghz_devices_deinit(void) {
+}
+
+const SubGhzDevice* subghz_devices_get_by_name(const char* device_name) {
+    static const SubGhzDevice cc1101_int = {.name = "cc1101_int"};
+    return strcmp(device_name, cc1101_int.name) ? NULL : &cc1101_int;
+}
+
+SubGhzTxRxWorker* subghz_tx_rx_worker_alloc(void) {
+    return calloc(1, sizeof(SubGhzTxRxWorker));
+}
+
+void subghz_tx_rx_worker_free(SubGhzTxRxWorker* instance) {
+    HOST_CHECK(!instance->running);
+    free(instance);
+}
+
+bool subghz_tx_rx_worker_start(
+    SubGhzTxRxWorker* instance,
+    const SubGhzDevice* device,
+    uint32_t frequency) {
+    UNUSED(device);
+    UNUSED(frequency);
+    if(!host_radio_allowed) return false;
+    for(size_t i = 0; i < HOST_RADIO_WORKERS; i++) {
+        if(!host_radio_workers[i]) {
+            host_radio_workers[i] = instance;
+            instance->running = true;
+            instance->rx_size = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void subghz_tx_rx_worker_stop(SubGhzTxRxWorker* instance) {
+    for(size_t i = 0; i < HOST_RADIO_WORKERS; i++) {
+        if(host_radio_workers[i] == instance) host_radio_workers[i] = NULL;
+    }
+    instance->running = false;
+}
+
+bool subghz_tx_rx_worker_is_running(SubGhzTxRxWorker* instance) {
+    return instance->running;
+}
+
+bool subghz_tx_rx_worker_write(SubGhzTxRxWorker* instance, uint8_t* data, size_t size) {
+    HOST_CHECK(instance->running);
+    uint8_t packet[64];
+    HOST_CHECK(size <= sizeof(packet));
+    memcpy(packet, data, size);
+    if(host_radio_channel && !host_radio_channel(host_radio_context, packet, size)) return true;
+
+    for(size_t i = 0; i < HOST_RADIO_WORKERS; i++) {
+        SubGhzTxRxWorker* receiver = host_radio_workers[i];
+        if(!receiver || receiver == instance) continue;
+        if(receiver->rx_size + size > HOST_RADIO_RX_SIZE) {
+            host_radio_overruns++;
+            continue;
+        }
+        memcpy(&receiver->rx[receiver->rx_size], packet, size);
+        receiver->rx_size += size;
+    }
+    return true;
+}
+
+size_t subghz_tx_rx_worker_read(SubGhzTxRxWorker* instance, uint8_t* data, size_t size) {
+    size = MIN(size, instance->rx_size);
+    memcpy(data, instance->rx, size);
+    instance->rx_size -= size;
+    memmove(instance->rx, &instance->rx[size], instance->rx_size);
+    return size;
+}
+
+void* furi_record_open(const char* name) {
+    UNUSED(name);
+    return (void*)1;
+}
+
+void furi_record_close(const char* name) {
+    UNUSED(name);
+}
+
+// Notifications go nowhere
+
+struct NotificationMessage {
+    uint8_t unused;
+};
+
+const NotificationMessage message_red_255, message_green_255, message_blue_255;
+const NotificationMessage message_vibro_on, message_vibro_off, message_note_a5, message_sound_off;
+const NotificationMessage message_delay_100, message_delay_250;
+const NotificationSequence sequence_blink_green_100 = {
+    &message_green_255,
+    &message_delay_100,
+    NULL,
+};
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence) {
+    UNUSED(app);
+    UNUSED(sequence);
+}
+
+// Memory
+
+static size_t host_memory_current = 0;
+static size_t host_memory_max = 0;
+// What the firmware would take from the heap: the app objects and the stacks of the running
+// threads
+static size_t host_heap_current = 0;
+static size_t host_heap_max = 0;
+
+static void host_heap_add(size_t size) {
+    host_heap_current += size;
+    host_heap_max = MAX(host_heap_max, host_heap_current);
+}
+
+void* co2_memory_alloc(size_t size) {
+    host_memory_current += size;
+    host_memory_max = MAX(host_memory_max, host_memory_current);
+    host_heap_add(size);
+    return malloc(size);
+}
+
+void co2_memory_free(void* ptr, size_t size) {
+    host_memory_current -= size;
+    host_heap_current -= size;
+    free(ptr);
+}
+
+const Co2Memory* co2_memory_get(void) {
+    static Co2Memory memory;
+    memory.used = host_memory_current;
+    memory.peak = host_memory_max;
+    return &memory;
+}
+
+size_t co2_memory_stack_free(void) {
+    return furi_thread_get_stack_space(furi_thread_get_current_id());
+}
+
+size_t host_memory_used(void) {
+    return host_memory_current;
+}
+
+size_t host_memory_peak(void) {
+    return host_memory_max;
+}
+
+size_t host_heap_used(void) {
+    return host_heap_current;
+}
+
+size_t host_heap_peak(void) {
+    return host_heap_max;
+}
+
+void host_memory_reset_peak(void) {
+    host_memory_max = host_memory_current;
+    host_heap_max = host_heap_current;
+}
+
+size_t memmgr_get_free_heap(void) {
+    return 128 * 1024 - host_heap_current;
+}
+
+size_t memmgr_get_minimum_free_heap(void) {
+    return 128 * 1024 - host_heap_max;
+}
+
+// Mutexes and threads
+
+struct FuriMutex {
+    pthread_mutex_t mutex;
+};
+
+FuriMutex* furi_mutex_alloc(FuriMutexType type) {
+    FuriMutex* mutex = malloc(sizeof(FuriMutex));
+    pthread_mutexattr_t attributes;
+    pthread_mutexattr_init(&attributes);
+    if(type == FuriMutexTypeRecursive) {
+        pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+    }
+    pthread_mutex_init(&mutex->mutex, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+    return mutex;
+}
+
+void furi_mutex_free(FuriMutex* mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout) {
+    if(timeout == FuriWaitForever) {
+        return pthread_mutex_lock(&mutex->mutex) ? FuriStatusError : FuriStatusOk;
+    }
+    return pthread_mutex_trylock(&mutex->mutex) ? FuriStatusErrorTimeout : FuriStatusOk;
+}
+
+FuriStatus furi_mutex_release(FuriMutex* mutex) {
+    return pthread_mutex_unlock(&mutex->mutex) ? FuriStatusError : FuriStatusOk;
+}
+
+// A thread runs on a stack filled with a pattern, as FreeRTOS does, so that the bytes it used at
+// most can be told from the untouched end. The host stack is larger than the firmware one
+// (the C library has a minimum), furi_thread_get_stack_space() compares the use to the firmware
+// size and returns 0 when it is exceeded
+#define HOST_THREAD_STACK_SIZE (256 * 1024)
+#define HOST_THREAD_STACK_FILL 0xA5
+
+struct FuriThread {
+    pthread_t thread;
+    bool started;
+    FuriThreadCallback callback;
+    void* context;
+    uint32_t stack_size; // Firmware stack size
+    uint8_t* stack;
+};
+
+static __thread FuriThread* host_thread_current = NULL;
+
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context) {
+    UNUSED(name);
+    FuriThread* thread = calloc(1, sizeof(FuriThread));
+    thread->callback = callback;
+    thread->context = context;
+    thread->stack_size = stack_size;
+    thread->stack = aligned_alloc(4096, HOST_THREAD_STACK_SIZE);
+    return thread;
+}
+
+void furi_thread_free(FuriThread* thread) {
+    furi_thread_join(thread);
+    free(thread->stack);
+    free(thread);
+}
+
+static void* host_thread_body(void* context) {
+    FuriThread* thread = context;
+    host_thread_current = thread;
+    thread->callback(thread->context);
+    return NULL;
+}
+
+void furi_thread_start(FuriThread* thread) {
+    // The firmware allocates the stack when the thread starts, and frees it once it is over
+    host_heap_add(thread->stack_size);
+    thread->started = true;
+    memset(thread->stack, HOST_THREAD_STACK_FILL, HOST_THREAD_STACK_SIZE);
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, thread->stack, HOST_THREAD_STACK_SIZE);
+    pthread_create(&thread->thread, &attributes, host_thread_body, thread);
+    pthread_attr_destroy(&attributes);
+}
+
+bool furi_thread_join(FuriThread* thread) {
+    if(thread->started) {
+        pthread_join(thread->thread, NULL);
+        host_heap_current -= thread->stack_size;
+    }
+    thread->started = false;
+    return true;
+}
+
+FuriThreadId furi_thread_get_current_id(void) {
+    return host_thread_current;
+}
+
+FuriThreadId furi_thread_get_id(FuriThread* thread) {
+    return thread;
+}
+
+static uint32_t host_thread_get_stack_touched(FuriThread* thread) {
+    // The stack grows down from the end of the buffer
+    size_t untouched = 0;
+    while(untouched < HOST_THREAD_STACK_SIZE &&
+          thread->stack[untouched] == HOST_THREAD_STACK_FILL) {
+        untouched++;
+    }
+    return HOST_THREAD_STACK_SIZE - untouched;
+}
+
+static int32_t host_thread_empty(void* context) {
+    UNUSED(context);
+    return 0;
+}
+
+uint32_t host_thread_get_stack_used(FuriThread* thread) {
+    // The C library keeps the thread control block and TLS at the top of the stack, what an
+    // empty thread touches is not the thread's own
+    static uint32_t baseline = 0;
+    if(!baseline) {
+        FuriThread* empty = furi_thread_alloc_ex("Empty", 0, host_thread_empty, NULL);
+        furi_thread_start(empty);
+        furi_thread_join(empty);
+        baseline = host_thread_get_stack_touched(empty);
+        furi_thread_free(empty);
+    }
+    uint32_t touched = host_thread_get_stack_touched(thread);
+    return touched > baseline ? touched - baseline : 0;
+}
+
+uint32_t furi_thread_get_stack_space(FuriThreadId id) {
+    FuriThread* thread = id;
+    if(!thread) return 0; // Not a FuriThread: the main thread of the test
+    uint32_t used = host_thread_get_stack_used(thread);
+    return used < thread->stack_size ? thread->stack_size - used : 0;
+}
+
+// Strings
+
+struct FuriString {
+    char* data;
+    size_t size;
+};
+
+FuriString* furi_string_alloc(void) {
+    FuriString* string = calloc(1, sizeof(FuriString));
+    string->data = calloc(1, 1);
+    return string;
+}
+
+void furi_string_free(FuriString* string) {
+    free(string->data);
+    free(string);
+}
+
+const char* furi_string_get_cstr(const FuriString* string) {
+    return string->data;
+}
+
+size_t furi_string_size(const FuriString* string) {
+    return string->size;
+}
+
+static void host_string_vcat(FuriString* string, const char* format, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+    string->data = realloc(string->data, string->size + length + 1);
+    vsnprintf(&string->data[string->size], length + 1, format, args);
+    string->size += length;
+}
+
+void furi_string_printf(FuriString* string, const char* format, ...) {
+    furi_string_reset(string);
+    va_list args;
+    va_start(args, format);
+    host_string_vcat(string, format, args);
+    va_end(args);
+}
+
+void furi_string_cat_printf(FuriString* string, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    host_string_vcat(string, format, args);
+    va_end(args);
+}
+
+void furi_string_cat_str(FuriString* string, const char* str) {
+    furi_string_cat_printf(string, "%s", str);
+}
+
+void furi_string_reset(FuriString* string) {
+    string->size = 0;
+    string->data[0] = '\0';
+}
+
+void furi_string_set_str(FuriString* string, const char* str) {
+    furi_string_printf(string, "%s", str);
+}
+
+int furi_string_cmp_str(const FuriString* string, const char* str) {
+    return strcmp(string->data, str);
+}
+
+// The next space separated word of args, removed from it with the spaces that follow
+bool args_read_string_and_trim(FuriString* args, FuriString* word) {
+    const char* start = args->data;
+    while(*start == ' ') {
+        start++;
+    }
+    size_t length = strcspn(start, " ");
+    if(length == 0) return false;
+
+    char* copy = strndup(start, length);
+    furi_string_set_str(word, copy);
+    free(copy);
+    const char* rest = &start[length];
+    while(*rest == ' ') {
+        rest++;
+    }
+    args->size -= rest - args->data;
+    memmove(args->data, rest, args->size + 1);
+    return true;
+}
+
+bool args_read_int_and_trim(FuriString* args, int* value) {
+    FuriString* word = furi_string_alloc();
+    char end;
+    bool success = args_read_string_and_trim(args, word) &&
+                   sscanf(word->data, "%d%c", value, &end) == 1;
+    furi_string_free(word);
+    return success;
+}
+
+// Stream buffers. A send takes what fits without waiting, a receive waits for the trigger level
+// at most timeout ms of wall time: nothing moves the simulated clock while a thread sleeps
+
+struct FuriStreamBuffer {
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    uint8_t* data;
+    size_t size;
+    size_t trigger_level;
+    size_t head; // Oldest byte
+    size_t count;
+};
+
+FuriStreamBuffer* furi_stream_buffer_alloc(size_t size, size_t trigger_level) {
+    FuriStreamBuffer* buffer = calloc(1, sizeof(FuriStreamBuffer));
+    pthread_mutex_init(&buffer->mutex, NULL);
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&buffer->changed, &attributes);
+    pthread_condattr_destroy(&attributes);
+    buffer->data = malloc(size);
+    buffer->size = size;
+    buffer->trigger_level = MAX(trigger_level, 1U);
+    return buffer;
+}
+
+void furi_stream_buffer_free(FuriStreamBuffer* buffer) {
+    pthread_cond_destroy(&buffer->changed);
+    pthread_mutex_destroy(&buffer->mutex);
+    free(buffer->data);
+    free(buffer);
+}
+
+size_t furi_stream_buffer_send(
+    FuriStreamBuffer* buffer,
+    const void* data,
+    size_t length,
+    uint32_t timeout) {
+    UNUSED(timeout);
+    const uint8_t* bytes = data;
+    pthread_mutex_lock(&buffer->mutex);
+    size_t sent = MIN(length, buffer->size - buffer->count);
+    for(size_t i = 0; i < sent; i++) {
+        buffer->data[(buffer->head + buffer->count + i) % buffer->size] = bytes[i];
+    }
+    buffer->count += sent;
+    pthread_cond_broadcast(&buffer->changed);
+    pthread_mutex_unlock(&buffer->mutex);
+    return sent;
+}
+
+size_t furi_stream_buffer_receive(
+    FuriStreamBuffer* buffer,
+    void* data,
+    size_t length,
+    uint32_t timeout) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout / 1000;
+    deadline.tv_nsec += (long)(timeout % 1000) * 1000000;
+    if(deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&buffer->mutex);
+    size_t wanted = MIN(length, buffer->trigger_level);
+    while(timeout > 0 && buffer->count < wanted) {
+        if(timeout == FuriWaitForever) {
+            pthread_cond_wait(&buffer->changed, &buffer->mutex);
+        } else if(pthread_cond_timedwait(&buffer->changed, &buffer->mutex, &deadline)) {
+            break;
+        }
+    }
+    size_t received = MIN(length, buffer->count);
+    for(size_t i = 0; i < received; i++) {
+        ((uint8_t*)data)[i] = buffer->data[(buffer->head + i) % buffer->size];
+    }
+    buffer->head = (buffer->head + received) % buffer->size;
+    buffer->count -= received;
+    pthread_mutex_unlock(&buffer->mutex);
+    return received;
+}
+
+size_t furi_stream_buffer_bytes_available(FuriStreamBuffer* buffer) {
+    pthread_mutex_lock(&buffer->mutex);
+    size_t count = buffer->count;
+    pthread_mutex_unlock(&buffer->mutex);
+    return count;
+}
+
+size_t furi_stream_buffer_spaces_available(FuriStreamBuffer* buffer) {
+    return buffer->size - furi_stream_buffer_bytes_available(buffer);
+}
+
+FuriStatus furi_stream_buffer_reset(FuriStreamBuffer* buffer) {
+    pthread_mutex_lock(&buffer->mutex);
+    buffer->head = 0;
+    buffer->count = 0;
+    pthread_mutex_unlock(&buffer->mutex);
+    return FuriStatusOk;
+}
+
+// CLI: one command, run by host_cli_run() on the calling thread
+
+static char host_cli_name[16];
+static CliCallback host_cli_callback;
+static void* host_cli_context;
+int host_cli_fd = -1;
+volatile bool host_cli_interrupt;
+volatile bool host_cli_writing;
+
+void cli_add_command(
+    Cli* cli,
+    const char* name,
+    CliCommandFlag flags,
+    CliCallback callback,
+    void* context) {
+    UNUSED(cli);
+    UNUSED(flags);
+    snprintf(host_cli_name, sizeof(host_cli_name), "%s", name);
+    host_cli_callback = callback;
+    host_cli_context = context;
+}
+
+void cli_delete_command(Cli* cli, const char* name) {
+    UNUSED(cli);
+    if(!strcmp(host_cli_name, name)) host_cli_callback = NULL;
+}
+
+void cli_write(Cli* cli, const uint8_t* buffer, size_t size) {
+    UNUSED(cli);
+    if(host_cli_fd < 0) return;
+    host_cli_writing = true;
+    while(size > 0) {
+        ssize_t written = write(host_cli_fd, buffer, size);
+        if(written <= 0) break;
+        buffer += written;
+        size -= written;
+    }
+    host_cli_writing = false;
+}
+
+bool cli_cmd_interrupt_received(Cli* cli) {
+    UNUSED(cli);
+    return host_cli_interrupt;
+}
+
+void cli_print_usage(const char* cmd, const char* usage, const char* arg) {
+    printf("%s: illegal option -- %s\r\nusage: %s %s\r\n", cmd, arg, cmd, usage);
+}
+
+bool host_cli_run(const char* line) {
+    size_t length = strcspn(line, " ");
+    if(!host_cli_callback || length != strlen(host_cli_name) ||
+       strncmp(line, host_cli_name, length)) {
+        return false;
+    }
+    FuriString* args = furi_string_alloc();
+    furi_string_set_str(args, &line[length]);
+    host_cli_callback(furi_record_open(RECORD_CLI), args, host_cli_context);
+    furi_string_free(args);
+    return true;
+}
+
+// Files
+
+#define HOST_FILES 8
+
+typedef struct {
+    char path[128];
+    uint8_t* data;
+    size_t size;
+    bool exists;
+} HostFile;
+
+static HostFile host_files[HOST_FILES];
+
+struct File {
+    HostFile* file;
+    size_t position;
+    bool write;
+};
+
+static HostFile* host_file_find(const char* path, bool create) {
+    HostFile* free_slot = NULL;
+    for(size_t i = 0; i < HOST_FILES; i++) {
+        if(host_files[i].exists && !strcmp(host_files[i].path, path)) return &host_files[i];
+        if(!host_files[i].exists && !free_slot) free_slot = &host_files[i];
+    }
+    if(!create || !free_slot) return NULL;
+    snprintf(free_slot->path, sizeof(free_slot->path), "%s", path);
+    free_slot->exists = true;
+    free_slot->size = 0;
+    return free_slot;
+}
+
+const uint8_t* host_file_get(const char* path, size_t* size) {
+    HostFile* file = host_file_find(path, false);
+    if(!file) return NULL;
+    *size = file->size;
+    return file->data;
+}
+
+void host_file_remove_all(void) {
+    for(size_t i = 0; i < HOST_FILES; i++) {
+        free(host_files[i].data);
+        memset(&host_files[i], 0, sizeof(HostFile));
+    }
+}
+
+File* storage_file_alloc(Storage* storage) {
+    UNUSED(storage);
+    return calloc(1, sizeof(File));
+}
+
+void storage_file_free(File* file) {
+    free(file);
+}
+
+bool storage_file_open(File* file, const char* path, FS_AccessMode access, FS_OpenMode mode) {
+    bool create = mode != FSOM_OPEN_EXISTING;
+    HostFile* host_file = host_file_find(path, create);
+    if(!host_file) return false;
+    if(mode == FSOM_CREATE_ALWAYS) host_file->size = 0;
+    file->file = host_file;
+    file->write = access & FSAM_WRITE;
+    file->position = mode == FSOM_OPEN_APPEND ? host_file->size : 0;
+    return true;
+}
+
+bool storage_file_close(File* file) {
+    file->file = NULL;
+    return true;
+}
+
+size_t storage_file_write(File* file, const void* buff, size_t bytes_to_write) {
+    HostFile* host_file = file->file;
+    if(!host_file || !file->write) return 0;
+    size_t end = file->position + bytes_to_write;
+    if(end > host_file->size) {
+        host_file->data = realloc(host_file->data, end);
+        host_file->size = end;
+    }
+    memcpy(host_file->data + file->position, buff, bytes_to_write);
+    file->position = end;
+    return bytes_to_write;
+}
+
+size_t storage_file_read(File* file, void* buff, size_t bytes_to_read) {
+    HostFile* host_file = file->file;
+    if(!host_file || file->position >= host_file->size) return 0;
+    size_t size = MIN(bytes_to_read, host_file->size - file->position);
+    memcpy(buff, host_file->data + file->position, size);
+    file->position += size;
+    return size;
+}
+
+bool storage_file_seek(File* file, uint32_t offset, bool from_start) {
+    if(!file->file) return false;
+    size_t position = from_start ? offset : file->position + offset;
+    if(position > file->file->size) return false;
+    file->position = position;
+    return true;
+}
+
+uint64_t storage_file_tell(File* file) {
+    return file->position;
+}
+
+uint64_t storage_file_size(File* file) {
+    return file->file ? file->file->size : 0;
+}
+
+bool storage_file_sync(File* file) {
+    UNUSED(file);
+    return true;
+}
+
+bool storage_file_eof(File* file) {
+    return !file->file || file->position >= file->file->size;
+}
+
+bool storage_simply_mkdir(Storage* storage, const char* path) {
+    UNUSED(storage);
+    UNUSED(path);
+    return true;
+}
+
+bool storage_common_exists(Storage* storage, const char* path) {
+    UNUSED(storage);
+    return host_file_find(path, false) != NULL;
+}
+
+FS_Error storage_common_remove(Storage* storage, const char* path) {
+    UNUSED(storage);
+    HostFile* file = host_file_find(path, false);
+    if(file) {
+        free(file->data);
+        memset(file, 0, sizeof(HostFile));
+    }
+    return FSE_OK;
+}
+
+FS_Error storage_common_rename(Storage* storage, const char* old_path, const char* new_path) {
+    UNUSED(storage);
+    HostFile* file = host_file_find(old_path, false);
+    if(!file) return FSE_EXIST;
+    storage_common_remove(storage, new_path);
+    snprintf(file->path, sizeof(file->path), "%s", new_path);
+    return FSE_OK;
+}
+
+// Saved structs: a magic and version byte before the data
+
+bool saved_struct_load(const char* path, void* data, size_t size, uint8_t magic, uint8_t version) {
+    size_t file_size;
+    const uint8_t* file = host_file_get(path, &file_size);
+    if(!file || file_size != size + 2 || file[0] != magic || file[1] != version) return false;
+    memcpy(data, file + 2, size);
+    return true;
+}
+
+bool saved_struct_save(
+    const char* path,
+    const void* data,
+    size_t size,
+    uint8_t magic,
+    uint8_t version) {
+    File* file = storage_file_alloc(NULL);
+    uint8_t header[2] = {magic, version};
+    bool success = storage_file_open(file, path, FSAM_WRITE, FSOM_CREATE_ALWAYS) &&
+                   storage_file_write(file, header, sizeof(header)) == sizeof(header) &&
+                   storage_file_write(file, data, size) == size;
+    storage_file_close(file);
+    storage_file_free(file);
+    return success;
+}
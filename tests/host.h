@@ -0,0 +1,94 @@
+/*
+  Host side of the tests: a simulated clock and the firmware services the tested modules use.
+
+  Time only moves when a test (or a delay in the code under test) advances it: 1 tick = 1 ms.
+  Threads are POSIX threads, files live in memory. Log lines at or above host_log_level are
+  printed, errors are counted in host_log_errors whatever the level.
+*/
+
+#pragma once
+
+#include <furi.h>
+#include <core/log.h>
+#include <time.h>
+
+extern volatile uint32_t host_tick;
+extern uint32_t host_rtc; // furi_hal_rtc_get_timestamp(), seconds
+extern FuriLogLevel host_log_level;
+extern uint32_t host_log_errors;
+
+static inline void host_advance(uint32_t ms) {
+    __atomic_add_fetch(&host_tick, ms, __ATOMIC_RELAXED);
+}
+
+// Monotonic wall clock for the benchmarks, in ns
+static inline uint64_t host_nanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Bytes currently held / at most through co2_memory_alloc()
+size_t host_memory_used(void);
+size_t host_memory_peak(void);
+
+// The same with the firmware stack sizes of the running threads, what memmgr_get_free_heap()
+// follows
+size_t host_heap_used(void);
+size_t host_heap_peak(void);
+
+// Start a new peak from what is held now
+void host_memory_reset_peak(void);
+
+// Bytes of its stack a thread used at most so far, on the host
+uint32_t host_thread_get_stack_used(FuriThread* thread);
+
+// A device on the external bus of furi_hal_i2c, at its 8-bit (shifted) address
+typedef struct {
+    uint8_t address;
+    bool (*tx)(void* context, const uint8_t* data, uint8_t size);
+    bool (*rx)(void* context, uint8_t* data, uint8_t size);
+    void* context;
+} HostI2cDevice;
+
+// Put a device on the bus, NULL: none (the default)
+void host_i2c_attach(const HostI2cDevice* device);
+
+// The bus runs at the speed the handle that acquired it set up, its transfers advance the DWT
+// cycle counter by their bit time. Wiring that cannot keep up fails one transfer in 4 above
+// host_i2c_max_hz (0, the default: no limit)
+extern uint32_t host_i2c_max_hz;
+extern uint32_t host_i2c_acquires;
+extern uint32_t host_i2c_probes; // Address-only transfers, furi_hal_i2c_is_device_ready()
+extern uint32_t host_i2c_failures; // Transfers the wiring failed
+uint32_t host_i2c_get_scl_hz(void); // Of the last setup
+
+// Sub-GHz loopback: what a running TX/RX worker writes reaches the RX buffer of every other
+// running one. The channel sees each packet first: it may corrupt it in place, or return false
+// to drop it. NULL (the default) is a perfect channel
+typedef bool (*HostRadioChannel)(void* context, uint8_t* data, size_t size);
+void host_radio_set_channel(HostRadioChannel channel, void* context);
+extern bool host_radio_allowed; // false: the workers fail to start, as out of region
+extern uint32_t host_radio_overruns; // Packets a full RX buffer dropped
+
+// CLI: the registered command writes to host_cli_fd (-1, the default: nowhere), blocking as the
+// USB CDC does when the host does not read. host_cli_writing is set while cli_write() waits,
+// host_cli_interrupt is the Ctrl+C the command polls for
+extern int host_cli_fd;
+extern volatile bool host_cli_interrupt;
+extern volatile bool host_cli_writing;
+
+// Run a command line ("co2 stream bin") on the calling thread, false if no such command
+bool host_cli_run(const char* line);
+
+// Contents of an in-memory file, NULL if it does not exist
+const uint8_t* host_file_get(const char* path, size_t* size);
+void host_file_remove_all(void);
+
+#define HOST_CHECK(condition)                                                         \
+    do {                                                                              \
+        if(!(condition)) {                                                            \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            exit(1);                                                                  \
+        }                                                                             \
+    } while(0)
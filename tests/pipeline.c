@@ -0,0 +1,68 @@
+#include "pipeline.h"
+#include <furi_hal_rtc.h>
+
+void host_pipeline_init(HostPipeline* pipeline, Co2FilterType filter) {
+    memset(pipeline, 0, sizeof(HostPipeline));
+    co2_filter_init(&pipeline->filter, filter);
+    co2_alarm_init(&pipeline->alarm);
+    co2_trend_init(&pipeline->trend);
+    co2_stats_init(&pipeline->stats, pipeline->alarm.thresholds);
+    co2_ach_init(&pipeline->ach, CO2_ACH_OUTDOOR_PPM);
+}
+
+void host_pipeline_push(HostPipeline* pipeline, const scd4x_sample_t* sample) {
+    uint16_t raw[Co2FilterChannelNum] = {sample->co2, sample->temperature, sample->humidity};
+    float values[Co2FilterChannelNum] = {
+        raw[Co2FilterChannelCO2],
+        convertTemperature(raw[Co2FilterChannelTemperature]),
+        convertHumidity(raw[Co2FilterChannelHumidity]),
+    };
+    uint32_t timestamp = furi_hal_rtc_get_timestamp();
+    uint32_t now = furi_get_tick();
+    bool co2 = !(sample->flags & SCD4x_SAMPLE_FLAG_RHT_ONLY);
+
+    co2_stats_update(&pipeline->stats, values, co2, timestamp);
+    if(co2 && co2_ach_update(&pipeline->ach, raw[Co2FilterChannelCO2], timestamp)) {
+        pipeline->ach_results++;
+    }
+
+    uint16_t filtered[Co2FilterChannelNum];
+    if(co2) {
+        co2_filter_update(&pipeline->filter, raw, filtered);
+    } else {
+        co2_filter_update_rht(&pipeline->filter, raw, filtered);
+    }
+    comfort_compute(
+        &pipeline->comfort,
+        convertTemperature(filtered[Co2FilterChannelTemperature]),
+        convertHumidity(filtered[Co2FilterChannelHumidity]));
+    if(co2) co2_trend_update(&pipeline->trend, filtered[Co2FilterChannelCO2], now);
+    co2_trend_forecast(
+        &pipeline->trend,
+        pipeline->alarm.thresholds,
+        COUNT_OF(pipeline->alarm.thresholds),
+        &pipeline->forecast);
+    if(co2) {
+        uint8_t events = co2_alarm_update(&pipeline->alarm, filtered[Co2FilterChannelCO2], now);
+        if(events != Co2AlarmEventNone) pipeline->alarm_events++;
+    }
+
+    snprintf(
+        pipeline->text[0],
+        sizeof(pipeline->text[0]),
+        "%.2f",
+        (double)convertTemperature(filtered[Co2FilterChannelTemperature]));
+    snprintf(
+        pipeline->text[1],
+        sizeof(pipeline->text[1]),
+        "%.2f",
+        (double)convertHumidity(filtered[Co2FilterChannelHumidity]));
+    snprintf(pipeline->text[2], sizeof(pipeline->text[2]), "%u", filtered[Co2FilterChannelCO2]);
+    snprintf(
+        pipeline->text[3],
+        sizeof(pipeline->text[3]),
+        "%u in %lum",
+        pipeline->forecast.target,
+        pipeline->forecast.eta / 60);
+    pipeline->samples++;
+}
@@ -0,0 +1,37 @@
+/*
+  The work the app does per sample, without the GUI: what live_tick() hands a fresh measurement
+  to (daily statistics, ventilation estimate, filter, comfort metrics, trend and forecast, alarm)
+  and the strings the live view formats from the result. A T/RH-only sample of the hybrid mode
+  only reaches the T/RH side, as in the app.
+*/
+
+#pragma once
+
+#include "scd4x.h"
+#include "co2_filter.h"
+#include "co2_alarm.h"
+#include "co2_stats.h"
+#include "co2_ach.h"
+#include "co2_trend.h"
+#include "comfort.h"
+
+typedef struct {
+    Co2Filter filter;
+    Co2Alarm alarm;
+    Co2Stats stats;
+    Co2Ach ach;
+    Co2Trend trend;
+    ComfortMetrics comfort;
+    Co2TrendForecast forecast;
+
+    char text[4][16]; // Temperature, humidity, CO2, forecast
+
+    uint32_t samples;
+    uint32_t alarm_events;
+    uint32_t ach_results;
+} HostPipeline;
+
+void host_pipeline_init(HostPipeline* pipeline, Co2FilterType filter);
+
+// Feed the sample the driver published last, as the app does after a fresh read
+void host_pipeline_push(HostPipeline* pipeline, const scd4x_sample_t* sample);
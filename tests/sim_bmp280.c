@@ -0,0 +1,110 @@
+#include "sim_bmp280.h"
+
+#define SIM_BMP280_CHIP_ID 0x58
+#define SIM_BMP280_ADC_T 519888 // 25.08 C with the example calibration
+
+// dig_T1 .. dig_P9, datasheet section 8.2
+static const int32_t sim_bmp280_calib[12] = {
+    27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000};
+
+uint32_t sim_bmp280_compensate(int32_t adc_p) {
+    const int32_t* c = sim_bmp280_calib;
+    int32_t adc_t = SIM_BMP280_ADC_T;
+    int32_t var1 = (((adc_t >> 3) - (c[0] << 1)) * c[1]) >> 11;
+    int32_t var2 = (((((adc_t >> 4) - c[0]) * ((adc_t >> 4) - c[0])) >> 12) * c[2]) >> 14;
+    int32_t t_fine = var1 + var2;
+
+    var1 = (t_fine >> 1) - 64000;
+    var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * c[8];
+    var2 = var2 + ((var1 * c[7]) << 1);
+    var2 = (var2 >> 2) + (c[6] << 16);
+    var1 = (((c[5] * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((c[4] * var1) >> 1)) >> 18;
+    var1 = ((32768 + var1) * c[3]) >> 15;
+    uint32_t p = ((uint32_t)(1048576 - adc_p) - (var2 >> 12)) * 3125;
+    if(p < 0x80000000) {
+        p = (p << 1) / (uint32_t)var1;
+    } else {
+        p = (p / (uint32_t)var1) * 2;
+    }
+    var1 = (c[11] * (int32_t)(((p >> 3) * (p >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(p >> 2) * c[10]) >> 13;
+    return (uint32_t)((int32_t)p + ((var1 + var2 + c[9]) >> 4));
+}
+
+// The pressure falls as the raw word rises: bisect for the word closest to the pressure
+static int32_t sim_bmp280_adc_p(uint32_t pressure) {
+    int32_t lo = 1;
+    int32_t hi = (1 << 20) - 1;
+    while(lo < hi) {
+        int32_t mid = (lo + hi) / 2;
+        if(sim_bmp280_compensate(mid) > pressure) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool sim_bmp280_tx(void* context, const uint8_t* data, uint8_t size) {
+    SimBmp280* sim = context;
+    if(sim->fail) {
+        sim->failures++;
+        return false;
+    }
+    sim->reg = data[0];
+    if(size < 2) return true;
+
+    if(sim->reg == 0xF4) {
+        sim->ctrl_meas = data[1];
+        if((data[1] & 0x03) == 0x01) {
+            // Forced mode: one conversion, then back to sleep
+            sim->ready = furi_get_tick() + sim->conversion_ms;
+            sim->adc_p = sim_bmp280_adc_p(sim->pressure);
+            sim->conversions++;
+        }
+    }
+    return true;
+}
+
+static void sim_bmp280_put20(uint8_t* data, int32_t word) {
+    data[0] = (word >> 12) & 0xFF;
+    data[1] = (word >> 4) & 0xFF;
+    data[2] = (word << 4) & 0xF0;
+}
+
+static bool sim_bmp280_rx(void* context, uint8_t* data, uint8_t size) {
+    SimBmp280* sim = context;
+    if(sim->fail) {
+        sim->failures++;
+        return false;
+    }
+
+    // Auto-increment from the register pointer
+    uint8_t regs[256] = {0};
+    regs[0xD0] = SIM_BMP280_CHIP_ID;
+    for(uint8_t i = 0; i < COUNT_OF(sim_bmp280_calib); i++) {
+        regs[0x88 + i * 2] = sim_bmp280_calib[i] & 0xFF;
+        regs[0x89 + i * 2] = (sim_bmp280_calib[i] >> 8) & 0xFF;
+    }
+    bool measuring = (int32_t)(furi_get_tick() - sim->ready) < 0;
+    regs[0xF3] = measuring ? 0x08 : 0x00;
+    regs[0xF4] = sim->ctrl_meas;
+    sim_bmp280_put20(&regs[0xF7], sim->adc_p);
+    sim_bmp280_put20(&regs[0xFA], SIM_BMP280_ADC_T);
+
+    for(uint8_t i = 0; i < size; i++) {
+        data[i] = regs[(uint8_t)(sim->reg + i)];
+    }
+    return true;
+}
+
+void sim_bmp280_init(SimBmp280* sim) {
+    memset(sim, 0, sizeof(SimBmp280));
+    sim->device.address = SIM_BMP280_ADDRESS;
+    sim->device.tx = sim_bmp280_tx;
+    sim->device.rx = sim_bmp280_rx;
+    sim->device.context = sim;
+    sim->pressure = 101325;
+    sim->conversion_ms = 7; // osrs_p x4, osrs_t x1: 6.4 ms typical
+}
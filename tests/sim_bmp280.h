@@ -0,0 +1,39 @@
+/*
+  Simulated BMP280 on the host bus, behind barometer.c.
+
+  Chip ID, the calibration words of the datasheet example (section 8.2) and forced mode
+  conversions that take conversion_ms, during which the status register reports measuring. The
+  pressure set by the test is turned into the raw word the compensation of the datasheet maps
+  back to it, at the temperature word of the example (25.08 C). Reads and writes can be made to
+  fail, as a flaky bus or an unplugged part would.
+*/
+
+#pragma once
+
+#include "host.h"
+
+#define SIM_BMP280_ADDRESS (0x76 << 1)
+
+typedef struct {
+    HostI2cDevice device; // Install with host_i2c_attach(&sim->device)
+
+    // Behaviour, set by the test
+    uint32_t pressure; // Pa
+    uint32_t conversion_ms;
+    bool fail; // Every transfer is NACKed
+
+    // Device state
+    uint8_t reg; // Register pointer
+    uint8_t ctrl_meas;
+    uint32_t ready; // Tick the running conversion is done
+    int32_t adc_p; // Of the last conversion
+
+    // Counters
+    uint32_t conversions;
+    uint32_t failures; // Transfers NACKed
+} SimBmp280;
+
+void sim_bmp280_init(SimBmp280* sim);
+
+// The pressure (Pa) the datasheet compensation gives for a raw pressure word
+uint32_t sim_bmp280_compensate(int32_t adc_p);
@@ -0,0 +1,207 @@
+#include "sim_scd4x.h"
+#include "host.h"
+
+#define SIM_SCD4X_SINGLE_SHOT_MS 5000
+#define SIM_SCD4X_SINGLE_SHOT_RHT_MS 50
+
+static void sim_scd4x_put(uint8_t* data, uint16_t word) {
+    data[0] = word >> 8;
+    data[1] = word & 0xFF;
+    data[2] = computeCRC8(data, 2);
+}
+
+static void sim_scd4x_produce_one(SimScd4x* sim, bool rht_only) {
+    // The previous update is overwritten
+    if(sim->produced && sim->read_update < sim->produced) sim->missed++;
+    sim->produced++;
+    if(sim->update) sim->update(sim, sim->produced);
+    sim->words[0] = rht_only ? 0 : sim->co2;
+    sim->words[1] = sim->temperature;
+    sim->words[2] = sim->humidity;
+}
+
+// Bring the sensor up to the current time
+static void sim_scd4x_produce(SimScd4x* sim) {
+    uint32_t now = furi_get_tick();
+    if(sim->single_shot && (int32_t)(now - sim->single_shot_ready) >= 0) {
+        sim->single_shot = false;
+        sim_scd4x_produce_one(sim, sim->single_shot_rht);
+    }
+    if(sim->measuring) {
+        uint32_t latest =
+            (uint32_t)((double)(now - sim->start) * (1.0 + sim->drift) / sim->interval);
+        while(sim->produced < latest) {
+            sim_scd4x_produce_one(sim, false);
+        }
+    }
+}
+
+uint32_t sim_scd4x_get_update(SimScd4x* sim) {
+    sim_scd4x_produce(sim);
+    return sim->produced;
+}
+
+static uint32_t sim_scd4x_get_execution_ms(uint16_t command) {
+    switch(command) {
+    case SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT:
+        return 500;
+    case SCD4x_COMMAND_PERFORM_FORCED_CALIBRATION:
+        return 400;
+    case SCD4x_COMMAND_PERSIST_SETTINGS:
+        return 800;
+    case SCD4x_COMMAND_PERFORM_SELF_TEST:
+        return 10000;
+    case SCD4x_COMMAND_PERFORM_FACTORY_RESET:
+        return 1200;
+    case SCD4x_COMMAND_REINIT:
+        return 20;
+    default:
+        return 0;
+    }
+}
+
+// Commands the sensor takes while it measures periodically, or runs a single shot
+static bool sim_scd4x_is_allowed(const SimScd4x* sim, uint16_t command) {
+    bool polling = command == SCD4x_COMMAND_READ_MEASUREMENT ||
+                   command == SCD4x_COMMAND_GET_DATA_READY_STATUS;
+    if(sim->single_shot) return polling;
+    if(sim->measuring) {
+        return polling || command == SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT ||
+               command == SCD4x_COMMAND_SET_AMBIENT_PRESSURE;
+    }
+    return true;
+}
+
+static bool sim_scd4x_tx(void* context, const uint8_t* data, uint8_t size) {
+    SimScd4x* sim = context;
+    DWT->CYCCNT += sim->transfer_micros * furi_hal_cortex_instructions_per_microsecond();
+    sim_scd4x_produce(sim);
+
+    uint32_t now = furi_get_tick();
+    uint16_t command = (uint16_t)data[0] << 8 | data[1];
+    uint16_t argument = size >= 5 ? (uint16_t)data[2] << 8 | data[3] : 0;
+    if((int32_t)(now - sim->busy_until) < 0 || !sim_scd4x_is_allowed(sim, command)) {
+        sim->refused++;
+        return false;
+    }
+    sim->command = command;
+    sim->commands++;
+    sim->busy_until = now + sim_scd4x_get_execution_ms(command);
+
+    switch(command) {
+    case SCD4x_COMMAND_START_PERIODIC_MEASUREMENT:
+    case SCD4x_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT:
+        sim->measuring = true;
+        sim->interval = command == SCD4x_COMMAND_START_PERIODIC_MEASUREMENT ?
+                            SCD4x_PERIODIC_INTERVAL_MS :
+                            SCD4x_LOW_POWER_PERIODIC_INTERVAL_MS;
+        sim->start = now;
+        sim->produced = 0;
+        sim->read_update = 0;
+        break;
+    case SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT:
+        sim->measuring = false;
+        break;
+    case SCD4x_COMMAND_MEASURE_SINGLE_SHOT:
+    case SCD4x_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY:
+        sim->single_shot = true;
+        sim->single_shot_rht = command == SCD4x_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY;
+        sim->single_shot_ready = now + (sim->single_shot_rht ? SIM_SCD4X_SINGLE_SHOT_RHT_MS :
+                                                               SIM_SCD4X_SINGLE_SHOT_MS);
+        break;
+    case SCD4x_COMMAND_SET_TEMPERATURE_OFFSET:
+        sim->temperature_offset = argument;
+        break;
+    case SCD4x_COMMAND_SET_SENSOR_ALTITUDE:
+        sim->altitude = argument;
+        break;
+    case SCD4x_COMMAND_SET_AMBIENT_PRESSURE:
+        sim->pressure = argument;
+        break;
+    case SCD4x_COMMAND_SET_AUTOMATIC_SELF_CALIBRATION_ENABLED:
+        sim->asc = argument;
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+static bool sim_scd4x_rx(void* context, uint8_t* data, uint8_t size) {
+    SimScd4x* sim = context;
+    DWT->CYCCNT += sim->transfer_micros * furi_hal_cortex_instructions_per_microsecond();
+    sim_scd4x_produce(sim);
+
+    // The answer of a long command comes when it is done
+    if((int32_t)(furi_get_tick() - sim->busy_until) < 0) return false;
+    if(sim->nack_reads) {
+        sim->faults++;
+        return false;
+    }
+
+    uint16_t words[3] = {0};
+    switch(sim->command) {
+    case SCD4x_COMMAND_GET_DATA_READY_STATUS:
+        words[0] = sim->produced > sim->read_update ? 0x8006 : 0x8000;
+        break;
+    case SCD4x_COMMAND_READ_MEASUREMENT:
+        if(sim->produced <= sim->read_update) return false;
+        sim->read_update = sim->produced;
+        sim->reads++;
+        memcpy(words, sim->words, sizeof(words));
+        break;
+    case SCD4x_COMMAND_GET_TEMPERATURE_OFFSET:
+        words[0] = sim->temperature_offset;
+        break;
+    case SCD4x_COMMAND_GET_SENSOR_ALTITUDE:
+        words[0] = sim->altitude;
+        break;
+    case SCD4x_COMMAND_GET_AUTOMATIC_SELF_CALIBRATION_ENABLED:
+        words[0] = sim->asc;
+        break;
+    case SCD4x_COMMAND_GET_SERIAL_NUMBER:
+        words[0] = 0x5C0A;
+        words[1] = 0x4B00;
+        words[2] = 0x0001;
+        break;
+    case SCD4x_COMMAND_GET_SENSOR_VARIANT:
+        words[0] = 0x1000; // SCD41
+        break;
+    case SCD4x_COMMAND_PERFORM_SELF_TEST:
+        words[0] = sim->selftest_response;
+        break;
+    case SCD4x_COMMAND_PERFORM_FORCED_CALIBRATION:
+        words[0] = (uint16_t)(sim->frc_correction + 0x8000);
+        break;
+    default:
+        return false; // Nothing to read back
+    }
+
+    for(uint8_t i = 0; i + 3 <= size && i < 9; i += 3) {
+        sim_scd4x_put(&data[i], words[i / 3]);
+    }
+    if(sim->corrupt_reads) {
+        sim->faults++;
+        data[2] ^= 0x01;
+    }
+    return true;
+}
+
+static void sim_scd4x_delay(void* context, uint32_t delayMillis) {
+    UNUSED(context);
+    host_advance(delayMillis);
+}
+
+void sim_scd4x_init(SimScd4x* sim) {
+    memset(sim, 0, sizeof(SimScd4x));
+    sim->transport.tx = sim_scd4x_tx;
+    sim->transport.rx = sim_scd4x_rx;
+    sim->transport.delay = sim_scd4x_delay;
+    sim->transport.context = sim;
+    sim->co2 = 600;
+    sim->temperature = 0x6667; // 25 C
+    sim->humidity = 0x5EB8; // 37 %
+    sim->temperature_offset = (uint16_t)(4.0f * 65536 / 175); // Sensor defaults
+    sim->asc = 1;
+    sim->interval = SCD4x_PERIODIC_INTERVAL_MS;
+}
@@ -0,0 +1,63 @@
+/*
+  Simulated SCD4x on the host clock, a transport for the unmodified driver.
+
+  Periodic measurements produce update k at start + k * interval / (1 + drift), single shots are
+  ready 5000 ms (T/RH only: 50 ms) after the command. A read with nothing new is NACKed, as is
+  every command the sensor would refuse: while it executes the previous one, settings while it
+  measures, anything but the data-ready status and the read during a single shot.
+  Execution waits of the driver advance the clock. The words of an update are the ones in the
+  struct when it is produced, the update callback may set them first.
+*/
+
+#pragma once
+
+#include "scd4x.h"
+
+typedef struct SimScd4x SimScd4x;
+typedef void (*SimScd4xUpdate)(SimScd4x* sim, uint32_t update);
+
+struct SimScd4x {
+    scd4x_transport_t transport; // Install with SCD4x_setTransport(&sim->transport)
+
+    // Behaviour, set by the test
+    float drift; // Clock error, 0.02: updates come 2% early
+    uint16_t co2; // ppm
+    uint16_t temperature; // Raw words
+    uint16_t humidity;
+    SimScd4xUpdate update; // Called before an update is produced, NULL: the words stay
+    void* context;
+    uint16_t selftest_response; // 0: passed
+    int16_t frc_correction; // ppm
+    uint32_t transfer_micros; // Added to the DWT cycle counter per transfer
+    bool nack_reads; // Faults: every response read is NACKed
+    bool corrupt_reads; // or comes with a bad CRC on its first word
+
+    // Sensor state
+    uint16_t command;
+    bool measuring;
+    uint32_t interval; // ms
+    uint32_t start;
+    uint32_t busy_until; // Execution of the last command
+    uint32_t produced; // Updates produced since the start, or single shots
+    uint32_t read_update; // Newest update read
+    bool single_shot;
+    bool single_shot_rht;
+    uint32_t single_shot_ready;
+    uint16_t words[3]; // Of the newest update
+    uint16_t temperature_offset;
+    uint16_t altitude;
+    uint16_t asc;
+    uint16_t pressure;
+
+    // Counters
+    uint32_t commands;
+    uint32_t reads;
+    uint32_t missed; // Updates overwritten before they were read
+    uint32_t refused; // Commands NACKed
+    uint32_t faults; // Reads NACKed or corrupted on purpose
+};
+
+void sim_scd4x_init(SimScd4x* sim);
+
+// Updates produced since the last start, for the checks of the tests
+uint32_t sim_scd4x_get_update(SimScd4x* sim);
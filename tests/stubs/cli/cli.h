@@ -0,0 +1,25 @@
+#pragma once
+
+#include <furi.h>
+
+typedef struct Cli Cli;
+
+#define RECORD_CLI "cli"
+
+typedef enum {
+    CliCommandFlagDefault = 0,
+    CliCommandFlagParallelSafe = (1 << 0),
+} CliCommandFlag;
+
+typedef void (*CliCallback)(Cli* cli, FuriString* args, void* context);
+
+void cli_add_command(
+    Cli* cli,
+    const char* name,
+    CliCommandFlag flags,
+    CliCallback callback,
+    void* context);
+void cli_delete_command(Cli* cli, const char* name);
+void cli_write(Cli* cli, const uint8_t* buffer, size_t size);
+bool cli_cmd_interrupt_received(Cli* cli);
+void cli_print_usage(const char* cmd, const char* usage, const char* arg);
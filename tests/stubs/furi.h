@@ -0,0 +1,100 @@
+/*
+  Host stand-ins for the firmware headers the tested modules include: declarations only, with the
+  types and macros they need. tests/host.c defines what the tests link against.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNUSED(x) (void)(x)
+#define COUNT_OF(x) (sizeof(x) / sizeof(x[0]))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define CLAMP(x, upper, lower) (MIN(upper, MAX(x, lower)))
+#define furi_assert(x) (void)(x)
+#define furi_check(x) (void)(x)
+#define furi_crash(x) abort()
+#define FURI_CRITICAL_ENTER() do {
+#define FURI_CRITICAL_EXIT() \
+    }                        \
+    while(0)
+
+#define FuriWaitForever 0xFFFFFFFFU
+#define FuriFlagWaitAny 0
+#define FuriFlagError 0x80000000U
+
+typedef enum {
+    FuriStatusOk = 0,
+    FuriStatusError = -1,
+    FuriStatusErrorTimeout = -2,
+} FuriStatus;
+
+// Time: 1 tick = 1 ms, simulated (see host.h)
+uint32_t furi_ms_to_ticks(uint32_t ms);
+uint32_t furi_get_tick(void);
+uint32_t furi_kernel_get_tick_frequency(void);
+void furi_delay_tick(uint32_t ticks);
+void furi_delay_ms(uint32_t ms);
+void furi_delay_us(uint32_t us);
+
+void* furi_record_open(const char* name);
+void furi_record_close(const char* name);
+
+typedef struct FuriMutex FuriMutex;
+typedef enum { FuriMutexTypeNormal, FuriMutexTypeRecursive } FuriMutexType;
+FuriMutex* furi_mutex_alloc(FuriMutexType type);
+void furi_mutex_free(FuriMutex* mutex);
+FuriStatus furi_mutex_acquire(FuriMutex* mutex, uint32_t timeout);
+FuriStatus furi_mutex_release(FuriMutex* mutex);
+
+typedef struct FuriThread FuriThread;
+typedef void* FuriThreadId;
+typedef int32_t (*FuriThreadCallback)(void* context);
+FuriThread* furi_thread_alloc_ex(
+    const char* name,
+    uint32_t stack_size,
+    FuriThreadCallback callback,
+    void* context);
+void furi_thread_free(FuriThread* thread);
+void furi_thread_start(FuriThread* thread);
+bool furi_thread_join(FuriThread* thread);
+FuriThreadId furi_thread_get_current_id(void);
+FuriThreadId furi_thread_get_id(FuriThread* thread);
+uint32_t furi_thread_get_stack_space(FuriThreadId id);
+uint32_t furi_thread_flags_set(FuriThreadId id, uint32_t flags);
+uint32_t furi_thread_flags_wait(uint32_t flags, uint32_t options, uint32_t timeout);
+
+typedef struct FuriString FuriString;
+FuriString* furi_string_alloc(void);
+void furi_string_free(FuriString* string);
+const char* furi_string_get_cstr(const FuriString* string);
+size_t furi_string_size(const FuriString* string);
+void furi_string_printf(FuriString* string, const char* format, ...);
+void furi_string_cat_printf(FuriString* string, const char* format, ...);
+void furi_string_cat_str(FuriString* string, const char* str);
+void furi_string_reset(FuriString* string);
+void furi_string_set_str(FuriString* string, const char* str);
+int furi_string_cmp_str(const FuriString* string, const char* str);
+
+typedef struct FuriStreamBuffer FuriStreamBuffer;
+FuriStreamBuffer* furi_stream_buffer_alloc(size_t size, size_t trigger_level);
+void furi_stream_buffer_free(FuriStreamBuffer* buffer);
+size_t furi_stream_buffer_send(
+    FuriStreamBuffer* buffer,
+    const void* data,
+    size_t length,
+    uint32_t timeout);
+size_t
+    furi_stream_buffer_receive(FuriStreamBuffer* buffer, void* data, size_t length, uint32_t timeout);
+size_t furi_stream_buffer_bytes_available(FuriStreamBuffer* buffer);
+size_t furi_stream_buffer_spaces_available(FuriStreamBuffer* buffer);
+FuriStatus furi_stream_buffer_reset(FuriStreamBuffer* buffer);
+
+size_t memmgr_get_free_heap(void);
+size_t memmgr_get_minimum_free_heap(void);
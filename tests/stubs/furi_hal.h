@@ -0,0 +1,43 @@
+#pragma once
+
+#include <furi.h>
+#include <furi_hal_i2c.h>
+#include <furi_hal_rtc.h>
+
+typedef struct {
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+extern DWT_Type* DWT;
+uint32_t furi_hal_cortex_instructions_per_microsecond(void);
+
+typedef struct {
+    uint8_t pin;
+} GpioPin;
+
+typedef enum {
+    GpioModeAnalog,
+    GpioModeAltFunctionOpenDrain,
+} GpioMode;
+
+typedef enum {
+    GpioPullNo,
+} GpioPull;
+
+typedef enum {
+    GpioSpeedLow,
+} GpioSpeed;
+
+typedef enum {
+    GpioAltFnUnused,
+    GpioAltFn4I2c3,
+} GpioAltFn;
+
+extern const GpioPin gpio_ext_pc0;
+extern const GpioPin gpio_ext_pc1;
+void furi_hal_gpio_init_ex(
+    const GpioPin* gpio,
+    GpioMode mode,
+    GpioPull pull,
+    GpioSpeed speed,
+    GpioAltFn alt_fn);
+void furi_hal_gpio_write(const GpioPin* gpio, bool state);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <furi.h>
+#include <stm32wbxx_ll_i2c.h>
+
+typedef struct FuriHalI2cBus {
+    I2C_TypeDef* i2c;
+} FuriHalI2cBus;
+
+typedef struct FuriHalI2cBusHandle FuriHalI2cBusHandle;
+
+typedef enum {
+    FuriHalI2cBusHandleEventActivate,
+    FuriHalI2cBusHandleEventDeactivate,
+} FuriHalI2cBusHandleEvent;
+
+typedef void (*FuriHalI2cBusHandleEventCallback)(
+    FuriHalI2cBusHandle* handle,
+    FuriHalI2cBusHandleEvent event);
+
+struct FuriHalI2cBusHandle {
+    FuriHalI2cBus* bus;
+    FuriHalI2cBusHandleEventCallback callback;
+};
+
+extern FuriHalI2cBus furi_hal_i2c_bus_external;
+extern FuriHalI2cBusHandle furi_hal_i2c_handle_external;
+void furi_hal_i2c_acquire(FuriHalI2cBusHandle* handle);
+void furi_hal_i2c_release(FuriHalI2cBusHandle* handle);
+bool furi_hal_i2c_is_device_ready(FuriHalI2cBusHandle* handle, uint8_t address, uint32_t timeout);
+bool furi_hal_i2c_tx(
+    FuriHalI2cBusHandle* handle,
+    uint8_t address,
+    const uint8_t* data,
+    uint8_t size,
+    uint32_t timeout);
+bool furi_hal_i2c_rx(
+    FuriHalI2cBusHandle* handle,
+    uint8_t address,
+    uint8_t* data,
+    uint8_t size,
+    uint32_t timeout);
+bool furi_hal_i2c_read_mem(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t mem_addr,
+    uint8_t* data,
+    size_t len,
+    uint32_t timeout);
+bool furi_hal_i2c_read_reg_8(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t reg_addr,
+    uint8_t* data,
+    uint32_t timeout);
+bool furi_hal_i2c_write_reg_8(
+    FuriHalI2cBusHandle* handle,
+    uint8_t i2c_addr,
+    uint8_t reg_addr,
+    uint8_t data,
+    uint32_t timeout);
@@ -0,0 +1,3 @@
+#pragma once
+
+#define SUBGHZ_DEVICE_CC1101_INT_NAME "cc1101_int"
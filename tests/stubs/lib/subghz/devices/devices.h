@@ -0,0 +1,9 @@
+#pragma once
+
+#include <furi.h>
+
+typedef struct SubGhzDevice SubGhzDevice;
+
+void subghz_devices_init(void);
+void subghz_devices_deinit(void);
+const SubGhzDevice* subghz_devices_get_by_name(const char* device_name);
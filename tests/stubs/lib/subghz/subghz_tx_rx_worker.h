@@ -0,0 +1,18 @@
+#pragma once
+
+#include <furi.h>
+#include "devices/devices.h"
+
+// A loopback in tests/host.c, see host_radio_set_channel()
+typedef struct SubGhzTxRxWorker SubGhzTxRxWorker;
+
+SubGhzTxRxWorker* subghz_tx_rx_worker_alloc(void);
+void subghz_tx_rx_worker_free(SubGhzTxRxWorker* instance);
+bool subghz_tx_rx_worker_start(
+    SubGhzTxRxWorker* instance,
+    const SubGhzDevice* device,
+    uint32_t frequency);
+void subghz_tx_rx_worker_stop(SubGhzTxRxWorker* instance);
+bool subghz_tx_rx_worker_is_running(SubGhzTxRxWorker* instance);
+bool subghz_tx_rx_worker_write(SubGhzTxRxWorker* instance, uint8_t* data, size_t size);
+size_t subghz_tx_rx_worker_read(SubGhzTxRxWorker* instance, uint8_t* data, size_t size);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <furi.h>
+
+typedef struct NotificationApp NotificationApp;
+typedef struct NotificationMessage NotificationMessage;
+typedef const NotificationMessage* NotificationSequence[];
+
+#define RECORD_NOTIFICATION "notification"
+
+void notification_message(NotificationApp* app, const NotificationSequence* sequence);
+
+extern const NotificationSequence sequence_blink_green_100;
+
+extern const NotificationMessage message_red_255;
+extern const NotificationMessage message_green_255;
+extern const NotificationMessage message_blue_255;
+extern const NotificationMessage message_vibro_on;
+extern const NotificationMessage message_vibro_off;
+extern const NotificationMessage message_note_a5;
+extern const NotificationMessage message_sound_off;
+extern const NotificationMessage message_delay_100;
+extern const NotificationMessage message_delay_250;
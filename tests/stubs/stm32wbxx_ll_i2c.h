@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// The I2C peripheral as far as the host bus models it: the timing of the handle that set it up
+typedef struct {
+    uint32_t TIMINGR;
+    uint32_t CR1;
+} I2C_TypeDef;
+
+typedef struct {
+    uint32_t PeripheralMode;
+    uint32_t Timing;
+    uint32_t AnalogFilter;
+    uint32_t DigitalFilter;
+    uint32_t OwnAddress1;
+    uint32_t TypeAcknowledge;
+    uint32_t OwnAddrSize;
+} LL_I2C_InitTypeDef;
+
+#define LL_I2C_MODE_I2C 0
+#define LL_I2C_ANALOGFILTER_ENABLE 0
+#define LL_I2C_ACK 0
+#define LL_I2C_OWNADDRESS1_7BIT 0
+#define LL_I2C_OWNADDRESS2_NOMASK 0
+
+static inline uint32_t LL_I2C_Init(I2C_TypeDef* i2c, LL_I2C_InitTypeDef* init) {
+    i2c->TIMINGR = init->Timing;
+    return 0;
+}
+
+static inline void LL_I2C_Enable(I2C_TypeDef* i2c) {
+    i2c->CR1 |= 1;
+}
+
+static inline void LL_I2C_Disable(I2C_TypeDef* i2c) {
+    i2c->CR1 &= ~1U;
+}
+
+static inline void LL_I2C_EnableAutoEndMode(I2C_TypeDef* i2c) {
+    (void)i2c;
+}
+
+static inline void LL_I2C_SetOwnAddress2(I2C_TypeDef* i2c, uint32_t address, uint32_t mask) {
+    (void)i2c;
+    (void)address;
+    (void)mask;
+}
+
+static inline void LL_I2C_DisableOwnAddress2(I2C_TypeDef* i2c) {
+    (void)i2c;
+}
+
+static inline void LL_I2C_DisableGeneralCall(I2C_TypeDef* i2c) {
+    (void)i2c;
+}
+
+static inline void LL_I2C_EnableClockStretching(I2C_TypeDef* i2c) {
+    (void)i2c;
+}
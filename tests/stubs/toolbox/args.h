@@ -0,0 +1,6 @@
+#pragma once
+
+#include <furi.h>
+
+bool args_read_string_and_trim(FuriString* args, FuriString* word);
+bool args_read_int_and_trim(FuriString* args, int* value);
@@ -0,0 +1,75 @@
+/*
+  Ventilation estimate from CO2 decays, in single precision.
+
+  A room fills up for an hour, is left and decays exponentially towards the outdoor level, then
+  fills up again, which ends the segment. The reported air changes per hour must match the
+  simulated ones within a few percent at every noise level, including a slow decay followed for a
+  whole day (thousands of samples, where sums of squares would lose the slope in float).
+*/
+
+#include "host.h"
+#include "co2_ach.h"
+#include <math.h>
+
+#define INTERVAL_S 5
+
+static uint32_t random_state = 3;
+
+// Roughly normal, unit variance
+static float random_noise(void) {
+    float sum = 0;
+    for(uint8_t i = 0; i < 12; i++) {
+        random_state = random_state * 1103515245 + 12345;
+        sum += (float)((random_state >> 8) & 0xFFFF) / 65536;
+    }
+    return sum - 6;
+}
+
+static void check_decay(float ach_true, float noise, uint32_t decay_s) {
+    Co2Ach ach;
+    co2_ach_init(&ach, CO2_ACH_OUTDOOR_PPM);
+    uint32_t timestamp = 1700000000;
+    uint32_t ended = 0;
+
+    for(uint32_t t = 0; t < 3600; t += INTERVAL_S, timestamp += INTERVAL_S) {
+        float co2 = CO2_ACH_OUTDOOR_PPM + 1380.0f * t / 3600 + noise * random_noise();
+        ended += co2_ach_update(&ach, (uint16_t)lroundf(co2), timestamp);
+    }
+    float excess = 0;
+    for(uint32_t t = 0; t < decay_s; t += INTERVAL_S, timestamp += INTERVAL_S) {
+        excess = 1380.0f * expf(-ach_true * t / 3600);
+        float co2 = CO2_ACH_OUTDOOR_PPM + excess + noise * random_noise();
+        ended += co2_ach_update(&ach, (uint16_t)lroundf(co2), timestamp);
+    }
+    for(uint32_t i = 0; i < 100; i++, timestamp += INTERVAL_S) {
+        float co2 = CO2_ACH_OUTDOOR_PPM + excess + i * 10;
+        ended += co2_ach_update(&ach, (uint16_t)lroundf(co2), timestamp);
+    }
+
+    const Co2AchResult* result = &ach.result;
+    printf(
+        "%.2f ACH, noise %2.0f ppm, %2lu h: %.3f +- %.3f, R2 %.3f, %lu samples over %lu min\n",
+        (double)ach_true,
+        (double)noise,
+        decay_s / 3600,
+        (double)result->ach,
+        (double)result->error,
+        (double)result->r2,
+        result->samples,
+        result->duration / 60);
+    HOST_CHECK(ended >= 1 && ach.has_result);
+    HOST_CHECK(fabsf(result->ach - ach_true) <= 0.03f * ach_true + 2 * result->error);
+    HOST_CHECK(result->r2 > 0.5f);
+}
+
+int main(void) {
+    const float rates[] = {0.3f, 1, 2, 4, 8};
+    const float noises[] = {0, 5, 10, 20};
+    for(size_t i = 0; i < COUNT_OF(rates); i++) {
+        for(size_t j = 0; j < COUNT_OF(noises); j++) {
+            check_decay(rates[i], noises[j], 2 * 3600);
+        }
+    }
+    check_decay(0.08f, 5, 24 * 3600);
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+  Block log round trip, with the RTC set back.
+
+  Batches of samples are appended the way the logger flushes them, with app restarts (a new
+  writer picking up the file) and the clock stepping back now and then, within a batch and
+  between two. Every sample must decode back in order, timestamps must only increase within a
+  block, and the blocks must form runs sorted by start time, each run after the first one
+  opened by a block flagged CO2_BLOCK_FLAG_CLOCK_BACK.
+*/
+
+#include "host.h"
+#include "co2_blocklog.h"
+
+#define PATH "/ext/log.bin"
+#define BATCHES 400
+#define BATCH 60
+#define BATCHES_PER_RESTART 30
+
+static Co2BlockSample samples[BATCHES * BATCH];
+
+int main(void) {
+    uint32_t seed = 1;
+    uint32_t now = 1700000000;
+    uint16_t words[CO2_BLOCKLOG_CHANNELS] = {600, 26000, 30000};
+    uint32_t steps_back = 0;
+    Co2BlockLog log;
+    File* file = storage_file_alloc(NULL);
+
+    for(uint32_t batch = 0; batch < BATCHES; batch++) {
+        if(batch % BATCHES_PER_RESTART == 0) co2_blocklog_init(&log);
+        Co2BlockSample* samples_batch = &samples[batch * BATCH];
+        for(uint32_t i = 0; i < BATCH; i++) {
+            seed = seed * 1103515245 + 12345;
+            words[0] += (int)((seed >> 16) % 21) - 10;
+            words[1] += (int)((seed >> 8) % 41) - 20;
+            words[2] += (int)(seed % 81) - 40;
+            if((seed >> 12) % 997 == 0) {
+                // Set back by up to a day, sometimes to before the start of the file
+                now -= 60 + (seed >> 4) % 86400;
+                steps_back++;
+            } else {
+                now += 5 + ((seed >> 20) % 50 == 0 ? 3600 : 0);
+            }
+            samples_batch[i].timestamp = now;
+            memcpy(samples_batch[i].words, words, sizeof(words));
+        }
+        HOST_CHECK(storage_file_open(file, PATH, FSAM_READ_WRITE, FSOM_OPEN_ALWAYS));
+        HOST_CHECK(co2_blocklog_write(&log, file, samples_batch, BATCH));
+        storage_file_close(file);
+    }
+    storage_file_free(file);
+
+    size_t size;
+    const uint8_t* data = host_file_get(PATH, &size);
+    HOST_CHECK(data && (size - sizeof(Co2BlockLogHeader)) % CO2_BLOCKLOG_BLOCK_SIZE == 0);
+    uint32_t blocks = (size - sizeof(Co2BlockLogHeader)) / CO2_BLOCKLOG_BLOCK_SIZE;
+
+    uint32_t decoded = 0;
+    uint32_t runs = 0;
+    uint32_t previous_end = 0;
+    for(uint32_t index = 0; index < blocks; index++) {
+        Co2Block block;
+        memcpy(
+            &block,
+            data + sizeof(Co2BlockLogHeader) + index * CO2_BLOCKLOG_BLOCK_SIZE,
+            sizeof(block));
+        bool clock_back = block.header.flags & CO2_BLOCK_FLAG_CLOCK_BACK;
+        if(index == 0 || clock_back) {
+            runs++;
+        }
+        // A run is sorted: only a flagged block may start before the previous one ended
+        HOST_CHECK(index == 0 || clock_back == (block.header.start < previous_end));
+        previous_end = block.header.end;
+
+        Co2BlockReader reader;
+        co2_block_reader_init(&reader, &block);
+        uint32_t last = block.header.start;
+        while(co2_block_reader_next(&reader)) {
+            HOST_CHECK(decoded < COUNT_OF(samples));
+            HOST_CHECK(!memcmp(&reader.sample, &samples[decoded], sizeof(Co2BlockSample)));
+            HOST_CHECK(reader.sample.timestamp >= last);
+            last = reader.sample.timestamp;
+            decoded++;
+        }
+        HOST_CHECK(last == block.header.end);
+    }
+
+    printf(
+        "%lu samples in %lu blocks (%.2f bytes/sample), clock set back %lu times, %lu runs\n",
+        decoded,
+        blocks,
+        (double)size / decoded,
+        steps_back,
+        runs);
+    HOST_CHECK(decoded == COUNT_OF(samples));
+    HOST_CHECK(runs == steps_back + 1);
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+  co2_filter: the median and Hampel outputs against a sort of the window on random input, the step
+  response and spike rejection the header promises, and the time per update of every type.
+*/
+
+#include "host.h"
+#include "co2_filter.h"
+
+#define RANDOM_SAMPLES 200000
+#define BENCH_SAMPLES 2000000
+#define STEP_LOW 400
+#define STEP_HIGH 1400
+
+static int compare_words(const void* a, const void* b) {
+    return (int)*(const uint16_t*)a - (int)*(const uint16_t*)b;
+}
+
+// Median of the window ending at history[i], and the MAD around it
+static uint16_t reference_median(const uint16_t* history, int i, uint16_t* mad) {
+    uint16_t window[CO2_FILTER_WINDOW];
+    uint16_t deviations[CO2_FILTER_WINDOW];
+    int n = MIN(i + 1, CO2_FILTER_WINDOW);
+    memcpy(window, &history[i + 1 - n], n * sizeof(uint16_t));
+    qsort(window, n, sizeof(uint16_t), compare_words);
+    uint16_t median = window[n / 2];
+    for(int k = 0; k < n; k++) {
+        deviations[k] = abs((int)window[k] - (int)median);
+    }
+    qsort(deviations, n, sizeof(uint16_t), compare_words);
+    *mad = deviations[n / 2];
+    return median;
+}
+
+static void test_reference(Co2FilterType type) {
+    static uint16_t history[RANDOM_SAMPLES];
+    Co2Filter filter;
+    co2_filter_init(&filter, type);
+    srand(type);
+    for(int i = 0; i < RANDOM_SAMPLES; i++) {
+        // A noisy level with spikes, so that both Hampel branches are taken
+        uint16_t co2 = 800 + rand() % 20 + (rand() % 16 == 0 ? rand() % 3000 : 0);
+        uint16_t input[Co2FilterChannelNum] = {co2, rand(), rand()};
+        uint16_t output[Co2FilterChannelNum];
+        history[i] = co2;
+        co2_filter_update(&filter, input, output);
+
+        uint16_t mad;
+        uint16_t median = reference_median(history, i, &mad);
+        if(type == Co2FilterTypeMedian) {
+            HOST_CHECK(output[Co2FilterChannelCO2] == median);
+        } else {
+            uint32_t threshold = ((uint32_t)MAX(mad, 5) * 71) >> 4;
+            uint32_t deviation = abs((int)co2 - (int)median);
+            HOST_CHECK(output[Co2FilterChannelCO2] == (deviation > threshold ? median : co2));
+        }
+    }
+    printf("%-6s = reference on %d random samples\n", co2_filter_get_name(type), RANDOM_SAMPLES);
+}
+
+// Settle on STEP_LOW, then feed STEP_HIGH. Returns the samples until the output reached percent
+// of the step
+static int step_samples(Co2FilterType type, int percent) {
+    Co2Filter filter;
+    co2_filter_init(&filter, type);
+    uint16_t input[Co2FilterChannelNum] = {STEP_LOW, 0x6000, 0x7000};
+    uint16_t output[Co2FilterChannelNum];
+    for(int i = 0; i < 2 * CO2_FILTER_WINDOW; i++) {
+        co2_filter_update(&filter, input, output);
+    }
+    input[Co2FilterChannelCO2] = STEP_HIGH;
+    uint16_t target = STEP_LOW + (STEP_HIGH - STEP_LOW) * percent / 100;
+    for(int i = 1; i < 100; i++) {
+        co2_filter_update(&filter, input, output);
+        if(output[Co2FilterChannelCO2] >= target) return i;
+    }
+    return -1;
+}
+
+// Output for a single spike of +2000 ppm on a flat level
+static uint16_t spike_output(Co2FilterType type) {
+    Co2Filter filter;
+    co2_filter_init(&filter, type);
+    uint16_t input[Co2FilterChannelNum] = {STEP_LOW, 0x6000, 0x7000};
+    uint16_t output[Co2FilterChannelNum];
+    for(int i = 0; i < 2 * CO2_FILTER_WINDOW; i++) {
+        co2_filter_update(&filter, input, output);
+    }
+    input[Co2FilterChannelCO2] = STEP_LOW + 2000;
+    co2_filter_update(&filter, input, output);
+    return output[Co2FilterChannelCO2];
+}
+
+static void test_step_response(void) {
+    for(Co2FilterType type = Co2FilterTypeEMA; type < Co2FilterTypeNum; type++) {
+        printf(
+            "%-6s step: 63%% after %d samples, 95%% after %d, 100%% after %d; "
+            "+2000 ppm spike -> %+d ppm\n",
+            co2_filter_get_name(type),
+            step_samples(type, 63),
+            step_samples(type, 95),
+            step_samples(type, 100),
+            spike_output(type) - STEP_LOW);
+    }
+    HOST_CHECK(step_samples(Co2FilterTypeEMA, 63) <= 4);
+    HOST_CHECK(step_samples(Co2FilterTypeEMA, 95) <= 11);
+    HOST_CHECK(step_samples(Co2FilterTypeMedian, 100) == (CO2_FILTER_WINDOW + 1) / 2);
+    HOST_CHECK(step_samples(Co2FilterTypeHampel, 100) == (CO2_FILTER_WINDOW + 1) / 2);
+    HOST_CHECK(spike_output(Co2FilterTypeMedian) == STEP_LOW);
+    HOST_CHECK(spike_output(Co2FilterTypeHampel) == STEP_LOW);
+}
+
+static void bench(Co2FilterType type) {
+    static uint16_t samples[4096][Co2FilterChannelNum];
+    srand(1);
+    for(int i = 0; i < 4096; i++) {
+        samples[i][0] = 800 + rand() % 40;
+        samples[i][1] = 0x6000 + rand() % 200;
+        samples[i][2] = 0x7000 + rand() % 2000;
+    }
+    Co2Filter filter;
+    co2_filter_init(&filter, type);
+    uint16_t output[Co2FilterChannelNum];
+    uint32_t checksum = 0;
+    uint64_t start = host_nanos();
+    for(int i = 0; i < BENCH_SAMPLES; i++) {
+        co2_filter_update(&filter, samples[i & 4095], output);
+        checksum += output[0];
+    }
+    uint64_t elapsed = host_nanos() - start;
+    printf(
+        "%-6s %.1f ns per update of the 3 channels (checksum %u)\n",
+        co2_filter_get_name(type),
+        (double)elapsed / BENCH_SAMPLES,
+        checksum);
+}
+
+int main(void) {
+    test_reference(Co2FilterTypeMedian);
+    test_reference(Co2FilterTypeHampel);
+    test_step_response();
+    for(Co2FilterType type = Co2FilterTypeNone; type < Co2FilterTypeNum; type++) {
+        bench(type);
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+  Guided forced recalibration against the simulated SCD41.
+
+  The stability window is fed from periodic readings of the sensor following a flat, a ramping
+  and two noisy curves: only a full window within CO2_FRC_MAX_STDDEV_PPM and
+  CO2_FRC_MAX_DRIFT_PPM may start, its standard deviation must match a double two-pass over the
+  same readings, and a window that is not full yet is refused whatever it holds.
+  The sequence must send stop, then the FRC at least 500 ms later, then restart the periodic
+  measurements at least 400 ms after that, report the correction of the sensor, and end Failed
+  on the 0xFFFF answer, measuring again either way. Low power and hybrid mode are refused
+  without a command sent.
+
+  Printed: the window of each curve, the commands of each sequence with their times.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "co2_frc.h"
+#include "co2_settings.h"
+#include <math.h>
+
+#define COMMANDS_MAX 16
+
+typedef enum {
+    CurveFlat,
+    CurveRamp, // 1 ppm per reading
+    CurveNoisy, // 3 ppm of noise
+    CurveNoisier, // 15 ppm
+} Curve;
+
+static SimScd4x sim;
+static Curve curve;
+static uint32_t random_state = 7;
+static uint32_t callbacks;
+
+static uint16_t commands[COMMANDS_MAX];
+static uint32_t command_ticks[COMMANDS_MAX];
+static uint32_t command_count;
+
+static bool logging_tx(void* context, const uint8_t* data, uint8_t size) {
+    if(command_count < COMMANDS_MAX) {
+        commands[command_count] = (uint16_t)data[0] << 8 | data[1];
+        command_ticks[command_count++] = furi_get_tick();
+    }
+    return sim.transport.tx(context, data, size);
+}
+
+// Roughly normal, unit variance
+static float random_noise(void) {
+    float sum = 0;
+    for(uint8_t i = 0; i < 12; i++) {
+        random_state = random_state * 1103515245 + 12345;
+        sum += (float)((random_state >> 8) & 0xFFFF) / 65536;
+    }
+    return sum - 6;
+}
+
+static void curve_update(SimScd4x* sim, uint32_t update) {
+    switch(curve) {
+    case CurveFlat:
+        sim->co2 = 425;
+        break;
+    case CurveRamp:
+        sim->co2 = 425 + update;
+        break;
+    case CurveNoisy:
+        sim->co2 = (uint16_t)lroundf(425 + 3 * random_noise());
+        break;
+    case CurveNoisier:
+        sim->co2 = (uint16_t)lroundf(425 + 15 * random_noise());
+        break;
+    }
+}
+
+static void frc_callback(void* context) {
+    UNUSED(context);
+    callbacks++;
+}
+
+// Read count periodic samples into the window, the stddev must follow the readings
+static void feed(Co2Frc* frc, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++) {
+        host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+        HOST_CHECK(readMeasurement());
+        co2_frc_feed(frc, getCO2());
+    }
+
+    double sum = 0;
+    for(uint8_t i = 0; i < frc->count; i++) {
+        sum += frc->window[i];
+    }
+    double mean = sum / frc->count;
+    double squares = 0;
+    for(uint8_t i = 0; i < frc->count; i++) {
+        squares += (frc->window[i] - mean) * (frc->window[i] - mean);
+    }
+    double stddev = frc->count < 2 ? 0 : sqrt(squares / (frc->count - 1));
+    HOST_CHECK(fabs(co2_frc_get_stddev(frc) - stddev) <= 1e-3 * stddev + 1e-3);
+}
+
+// A fresh window over a new measurement start, as the app does when the FRC screen opens
+static Co2Frc* window(Curve shape, uint32_t count) {
+    curve = shape;
+    HOST_CHECK(stopPeriodicMeasurement(CO2_FRC_STOP_DELAY_MS) && startPeriodicMeasurement());
+    Co2Frc* frc = co2_frc_alloc(frc_callback, NULL);
+    frc->mode = Co2SettingsModePeriodic;
+    feed(frc, count);
+    return frc;
+}
+
+static void check_window(const char* name, Curve shape, bool stable) {
+    Co2Frc* frc = window(shape, CO2_FRC_WINDOW - 1);
+    HOST_CHECK(!co2_frc_is_stable(frc) && !co2_frc_start(frc));
+    feed(frc, 1);
+    printf(
+        "%-8s %u readings, sd %5.2f ppm, drift %+3ld ppm: %s\n",
+        name,
+        frc->count,
+        (double)co2_frc_get_stddev(frc),
+        co2_frc_get_drift(frc),
+        co2_frc_is_stable(frc) ? "stable" : "not stable");
+    HOST_CHECK(co2_frc_is_stable(frc) == stable);
+    if(!stable) {
+        command_count = 0;
+        HOST_CHECK(!co2_frc_start(frc) && command_count == 0);
+    }
+    co2_frc_free(frc);
+}
+
+static void run_sequence(const char* name, int16_t correction, Co2FrcState expected) {
+    Co2Frc* frc = window(CurveFlat, CO2_FRC_WINDOW);
+    frc->target = 420;
+    sim.frc_correction = correction;
+    callbacks = 0;
+    command_count = 0;
+    uint32_t start = furi_get_tick();
+    HOST_CHECK(co2_frc_start(frc));
+    furi_thread_join(frc->thread);
+
+    printf(
+        "%-8s %-6s correction %+.0f ppm:",
+        name,
+        expected == Co2FrcStateDone ? "done" : "failed",
+        (double)frc->correction);
+    for(uint32_t i = 0; i < command_count; i++) {
+        printf(" 0x%04X at %lu ms", commands[i], command_ticks[i] - start);
+    }
+    printf("\n");
+
+    HOST_CHECK(frc->state == expected && callbacks == 1);
+    HOST_CHECK(command_count == 3);
+    HOST_CHECK(commands[0] == SCD4x_COMMAND_STOP_PERIODIC_MEASUREMENT);
+    HOST_CHECK(commands[1] == SCD4x_COMMAND_PERFORM_FORCED_CALIBRATION);
+    HOST_CHECK(commands[2] == SCD4x_COMMAND_START_PERIODIC_MEASUREMENT);
+    HOST_CHECK(command_ticks[1] - command_ticks[0] >= CO2_FRC_STOP_DELAY_MS);
+    HOST_CHECK(command_ticks[2] - command_ticks[1] >= 400);
+    HOST_CHECK(sim.refused == 0);
+    if(expected == Co2FrcStateDone) HOST_CHECK(frc->correction == correction);
+
+    // Measuring again whatever the outcome, from an empty window
+    HOST_CHECK(sim.measuring && sim.interval == SCD4x_PERIODIC_INTERVAL_MS);
+    HOST_CHECK(frc->count == 0 && !co2_frc_is_stable(frc));
+    host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+    HOST_CHECK(readMeasurement());
+    co2_frc_free(frc);
+}
+
+static void check_mode(Co2SettingsMode mode) {
+    Co2Frc* frc = window(CurveFlat, CO2_FRC_WINDOW);
+    HOST_CHECK(co2_frc_is_stable(frc));
+    frc->mode = mode;
+    command_count = 0;
+    HOST_CHECK(!co2_frc_start(frc));
+    HOST_CHECK(command_count == 0 && frc->state == Co2FrcStateMonitoring);
+    printf("%s mode: refused\n", co2_settings_get_mode_name(mode));
+    co2_frc_free(frc);
+}
+
+int main(void) {
+    sim_scd4x_init(&sim);
+    sim.update = curve_update;
+    scd4x_transport_t transport = sim.transport;
+    transport.tx = logging_tx;
+    SCD4x_setTransport(&transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+
+    check_window("flat", CurveFlat, true);
+    check_window("ramp", CurveRamp, false);
+    check_window("noisy", CurveNoisy, true);
+    check_window("noisier", CurveNoisier, false);
+
+    run_sequence("FRC", -37, Co2FrcStateDone);
+    run_sequence("0xFFFF", 0x7FFF, Co2FrcStateFailed);
+
+    check_mode(Co2SettingsModeLowPower);
+    check_mode(Co2SettingsModeHybrid);
+
+    SCD4x_setTransport(NULL);
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
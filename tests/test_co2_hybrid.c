@@ -0,0 +1,142 @@
+/*
+  Hybrid mode against the simulated SCD41: the schedule of co2_hybrid on the 1 s ticks of the
+  live view with the per-sample work of the app, then settings applied while a shot runs.
+
+  The CO2 consumers must only take the full shots: the CO2 statistics count one sample per full
+  shot and T/RH one per sample, while the filtered CO2, the trend and the ventilation estimate
+  stay put across the T/RH-only samples. The sensor refuses a stop during a full shot: applying
+  settings after co2_hybrid_finish() must not have a command refused. A mode that does not start
+  must not be taken, the settings keep describing the mode that runs.
+
+  Printed: samples of each kind, what the statistics counted, refused commands.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "pipeline.h"
+#include "co2_hybrid.h"
+#include "co2_settings.h"
+
+#define HOUR_MS (3600UL * 1000)
+#define TICK_MS 1000
+
+static SimScd4x sim;
+static bool refuse_start; // The sensor NACKs the start of periodic measurements
+
+static bool start_refusing_tx(void* context, const uint8_t* data, uint8_t size) {
+    uint16_t command = (uint16_t)data[0] << 8 | data[1];
+    if(refuse_start && command == SCD4x_COMMAND_START_PERIODIC_MEASUREMENT) return false;
+    return sim.transport.tx(context, data, size);
+}
+
+// CO2 rises by 1 ppm per full shot, T/RH-only shots carry no CO2 word
+static void count_update(SimScd4x* sim, uint32_t update) {
+    sim->co2 = 600 + update;
+}
+
+// Step the schedule on the live ticks until a shot of that kind is pending
+static void wait_for_shot(Co2Hybrid* hybrid, Co2HybridShot shot) {
+    for(uint32_t i = 0; i < 100 && hybrid->pending != shot; i++) {
+        host_advance(TICK_MS);
+        co2_hybrid_step(hybrid, furi_get_tick());
+    }
+    HOST_CHECK(hybrid->pending == shot);
+}
+
+static void run_schedule(Co2Hybrid* hybrid) {
+    static HostPipeline pipeline;
+    host_pipeline_init(&pipeline, Co2FilterTypeEMA);
+    co2_hybrid_start(hybrid);
+
+    uint32_t end = furi_get_tick() + HOUR_MS;
+    while(furi_get_tick() < end) {
+        host_advance(TICK_MS);
+        host_rtc++;
+        if(!co2_hybrid_step(hybrid, furi_get_tick())) continue;
+
+        scd4x_sample_t sample;
+        HOST_CHECK(getLatestSample(&sample));
+        bool rht_only = sample.flags & SCD4x_SAMPLE_FLAG_RHT_ONLY;
+        uint16_t co2 = pipeline.filter.channels[Co2FilterChannelCO2].output;
+        uint8_t trend = pipeline.trend.count;
+        uint32_t ach = pipeline.ach.ema;
+        host_pipeline_push(&pipeline, &sample);
+        if(rht_only) {
+            HOST_CHECK(pipeline.filter.channels[Co2FilterChannelCO2].output == co2);
+            HOST_CHECK(pipeline.trend.count == trend && pipeline.ach.ema == ach);
+        }
+    }
+
+    const Co2StatsDayData* today = &pipeline.stats.days[Co2StatsDayToday];
+    uint32_t co2_count = today->channels[Co2FilterChannelCO2].count;
+    uint32_t rht_count = today->channels[Co2FilterChannelTemperature].count;
+    printf(
+        "1 h on 1 s ticks: %lu CO2 and %lu T/RH-only samples, %lu failed shots; statistics: %lu "
+        "CO2, %lu T/RH\n",
+        hybrid->co2_samples,
+        hybrid->rht_samples,
+        hybrid->failures,
+        co2_count,
+        rht_count);
+    HOST_CHECK(hybrid->failures == 0 && hybrid->rht_samples > hybrid->co2_samples);
+    HOST_CHECK(co2_count == hybrid->co2_samples);
+    HOST_CHECK(rht_count == hybrid->co2_samples + hybrid->rht_samples);
+    HOST_CHECK(pipeline.samples == rht_count);
+    HOST_CHECK(sim.refused == 0);
+}
+
+int main(void) {
+    sim_scd4x_init(&sim);
+    sim.update = count_update;
+    scd4x_transport_t transport = sim.transport;
+    transport.tx = start_refusing_tx;
+    SCD4x_setTransport(&transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+
+    Co2Settings current;
+    co2_settings_default(&current);
+    current.sensor_type = SCD4x_SENSOR_SCD41;
+    current.mode = Co2SettingsModeHybrid;
+    Co2Hybrid hybrid = {0};
+    run_schedule(&hybrid);
+
+    // A stop in the middle of a full shot is refused
+    wait_for_shot(&hybrid, Co2HybridShotFull);
+    uint32_t refused = sim.refused;
+    HOST_CHECK(!stopPeriodicMeasurement(500));
+    HOST_CHECK(sim.refused > refused);
+
+    // Finished first, the settings go through
+    co2_hybrid_start(&hybrid);
+    wait_for_shot(&hybrid, Co2HybridShotFull);
+    uint32_t samples = hybrid.co2_samples;
+    refused = sim.refused;
+    co2_hybrid_finish(&hybrid);
+    HOST_CHECK(hybrid.pending == Co2HybridShotNone && hybrid.co2_samples == samples + 1);
+    Co2Settings pending = current;
+    pending.mode = Co2SettingsModePeriodic;
+    pending.altitude = 300;
+    HOST_CHECK(co2_settings_apply(&current, &pending, true));
+    HOST_CHECK(sim.refused == refused);
+    HOST_CHECK(current.mode == Co2SettingsModePeriodic && sim.measuring && sim.altitude == 300);
+
+    // Back to hybrid, then a periodic start the sensor refuses: the hybrid mode stays
+    pending.mode = Co2SettingsModeHybrid;
+    HOST_CHECK(co2_settings_apply(&current, &pending, true));
+    HOST_CHECK(current.mode == Co2SettingsModeHybrid && !sim.measuring);
+    co2_hybrid_start(&hybrid);
+    wait_for_shot(&hybrid, Co2HybridShotRht);
+    co2_hybrid_finish(&hybrid);
+    refuse_start = true;
+    pending.mode = Co2SettingsModePeriodic;
+    uint32_t errors = host_log_errors;
+    HOST_CHECK(!co2_settings_apply(&current, &pending, true));
+    HOST_CHECK(current.mode == Co2SettingsModeHybrid && !sim.measuring);
+    HOST_CHECK(host_log_errors == errors + 1);
+    refuse_start = false;
+    printf("refused: %lu commands, the stop sent during the full shot\n", sim.refused);
+
+    SCD4x_setTransport(NULL);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+  I2C bus speed benchmark of co2_i2c against the simulated SCD4x on the host bus.
+
+  The driver talks through its I2C transport, every transfer acquires the bus and probes the
+  sensor address first; the bus clocks the bits at the speed of the handle that acquired it. The
+  benchmark runs as the live view does, a read attempt per second, on wiring that keeps up with
+  fast mode and on wiring that fails above 200 kHz: the bus time per sample must follow the bit
+  rate, fast mode must be given up on the bad wiring after CO2_I2C_BENCH_MAX_ERRORS errors, and
+  the driver must be back on the restore speed once done.
+
+  Printed per run and speed: samples, read latency (data-ready poll, command, execution wait,
+  response), bus time per sample and errors.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "co2_i2c.h"
+
+#define TICK_MS 1000
+#define POLLS_MAX 1000
+#define BAD_WIRING_HZ 200000
+
+static void run(uint32_t wiring_hz, Co2I2cSpeed restore) {
+    host_i2c_max_hz = wiring_hz;
+    Co2I2cBench bench;
+    co2_i2c_bench_start(&bench);
+    uint32_t polls = 0;
+    while(bench.running && polls < POLLS_MAX) {
+        host_advance(TICK_MS);
+        co2_i2c_bench_read(&bench, restore);
+        polls++;
+    }
+    HOST_CHECK(!bench.running);
+
+    printf(
+        "wiring %s, restore %s:\n",
+        wiring_hz ? "up to 200 kHz" : "perfect",
+        co2_i2c_get_speed_name(restore));
+    for(Co2I2cSpeed speed = 0; speed < Co2I2cSpeedNum; speed++) {
+        const Co2I2cBenchResult* result = &bench.results[speed];
+        printf(
+            "  %s: %lu samples, read %lu us avg %lu us max, bus %lu us/sample, %lu errors\n",
+            co2_i2c_get_speed_name(speed),
+            result->samples,
+            result->samples ? result->latency_micros / result->samples : 0,
+            result->latency_max_micros,
+            result->samples ? result->busy_micros / result->samples : 0,
+            result->errors);
+    }
+
+    const Co2I2cBenchResult* standard = &bench.results[Co2I2cSpeedStandard];
+    const Co2I2cBenchResult* fast = &bench.results[Co2I2cSpeedFast];
+    HOST_CHECK(standard->samples == CO2_I2C_BENCH_SAMPLES && standard->errors == 0);
+    if(wiring_hz) {
+        HOST_CHECK(fast->errors == CO2_I2C_BENCH_MAX_ERRORS);
+        HOST_CHECK(host_i2c_failures > 0);
+    } else {
+        HOST_CHECK(fast->samples == CO2_I2C_BENCH_SAMPLES && fast->errors == 0);
+        // 99 against 385 kHz with the bus overhead, the execution wait is the same at both
+        HOST_CHECK(fast->busy_micros * 3 < standard->busy_micros);
+        HOST_CHECK(fast->latency_micros < standard->latency_micros);
+    }
+
+    // The next reads go through the restore handle
+    host_i2c_max_hz = 0;
+    host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+    HOST_CHECK(readMeasurement());
+    uint32_t scl_hz = host_i2c_get_scl_hz();
+    printf("  then reading at %lu Hz\n", scl_hz);
+    HOST_CHECK(restore == Co2I2cSpeedFast ? scl_hz > 300000 : scl_hz < 100000);
+}
+
+int main(void) {
+    host_log_level = FuriLogLevelError; // The benchmark logs its results at the info level
+    static SimScd4x sim;
+    sim_scd4x_init(&sim);
+    HostI2cDevice device = {
+        .address = SCD4x_ADDRESS,
+        .tx = sim.transport.tx,
+        .rx = sim.transport.rx,
+        .context = &sim,
+    };
+    host_i2c_attach(&device);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+    HOST_CHECK(startPeriodicMeasurement());
+
+    run(0, Co2I2cSpeedStandard);
+    run(BAD_WIRING_HZ, Co2I2cSpeedStandard);
+    run(0, Co2I2cSpeedFast);
+    SCD4x_setBus(NULL);
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
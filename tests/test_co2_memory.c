@@ -0,0 +1,169 @@
+/*
+  Memory budget of the app per feature configuration.
+
+  Heap: the objects the app allocates through co2_memory_alloc() and the stacks of the worker
+  threads, for a session against the sensor, one replaying a capture and one capturing the bus.
+  The peak of each must be exactly what the configuration allocates (no other allocation sneaks
+  in) and everything must be given back at the end.
+
+  Stack: the app thread work with a sensor (bring-up, settings, then the per-sample reads,
+  pipeline with its float formatting and logging) runs on a thread with the application.fam
+  stack size, and so do the FRC and self-test sequences on their workers. The stacks are measured
+  on the host, whose frames and C library (printf above all) are bigger than the firmware ones:
+  fitting here is a conservative answer for the Flipper, the stack sizes are set from it.
+*/
+
+#include "host.h"
+#include "pipeline.h"
+#include "sim_scd4x.h"
+#include "scd4x_capture.h"
+#include "co2_frc.h"
+#include "co2_selftest.h"
+#include "co2_settings.h"
+#include "co2_logger.h"
+
+#define APP_STACK_SIZE (4 * 1024) // application.fam
+#define WORKER_STACK_SIZE (3 * 1024) // CO2_FRC_ and CO2_SELFTEST_THREAD_STACK_SIZE
+#define SAMPLES 1000
+#define TICK_MS 1000 // CO2_SENSOR_TICK_MS
+#define HEAP_BUDGET (8 * 1024) // Stacks and objects, whatever the configuration
+
+typedef enum {
+    ConfigSensor,
+    ConfigCapture,
+    ConfigReplay, // Of the session captured before
+    ConfigNum,
+} Config;
+
+static const char* const config_names[ConfigNum] = {"sensor", "capture", "replay"};
+
+static SimScd4x sim;
+static bool warm_up; // Nothing measured
+
+// The app thread: what co2_sensor_app() allocates for the configuration, then a short session
+static int32_t app_thread(void* context) {
+    Config config = *(Config*)context;
+    sim_scd4x_init(&sim);
+
+    Scd4xReplay* replay = NULL;
+    Scd4xCapture* capture = NULL;
+    if(config == ConfigReplay) {
+        replay = scd4x_replay_alloc(false);
+        HOST_CHECK(scd4x_replay_open(replay, SCD4x_CAPTURE_PATH));
+        SCD4x_setTransport(&replay->transport);
+    } else if(config == ConfigCapture) {
+        capture = scd4x_capture_alloc(&sim.transport);
+        HOST_CHECK(scd4x_capture_start(capture, SCD4x_CAPTURE_PATH));
+        SCD4x_setTransport(&capture->transport);
+    } else {
+        SCD4x_setTransport(&sim.transport);
+    }
+
+    // sensor_start()
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+    HOST_CHECK(stopPeriodicMeasurement(500));
+    Co2Settings current;
+    Co2Settings pending;
+    scd4x_config_t sensor_config;
+    co2_settings_default(&current);
+    current.sensor_type = SCD4x_SENSOR_SCD41;
+    HOST_CHECK(co2_settings_read(&current, &sensor_config));
+    pending = current;
+    pending.temperature_offset = 2.5f;
+    pending.altitude = 300;
+    HOST_CHECK(co2_settings_apply(&current, &pending, false));
+
+    Co2Frc* frc = co2_frc_alloc(NULL, NULL);
+    Co2SelfTest* selftest = co2_selftest_alloc(NULL, NULL);
+
+    static HostPipeline pipeline;
+    static Co2Logger logger;
+    host_pipeline_init(&pipeline, Co2FilterTypeEMA);
+    co2_logger_init(&logger);
+    for(uint32_t read = 0; read < SAMPLES && !(replay && replay->finished);) {
+        host_advance(TICK_MS);
+        if(!readMeasurement()) continue;
+        scd4x_sample_t sample;
+        getLatestSample(&sample);
+        host_pipeline_push(&pipeline, &sample);
+        co2_frc_feed(frc, sample.co2);
+        if(co2_logger_push(&logger, sample.co2, sample.temperature, sample.humidity)) {
+            HOST_CHECK(co2_logger_flush(&logger));
+        }
+        read++;
+    }
+    HOST_CHECK(pipeline.samples > 0);
+
+    // The sequences need a sensor, the replayed one only answers what was captured
+    if(config != ConfigReplay) {
+        HOST_CHECK(co2_frc_is_stable(frc) && co2_frc_start(frc));
+        furi_thread_join(frc->thread);
+        HOST_CHECK(frc->state == Co2FrcStateDone);
+        HOST_CHECK(co2_selftest_start(selftest));
+        furi_thread_join(selftest->thread);
+        HOST_CHECK(selftest->state == Co2SelfTestStatePassed);
+        uint32_t frc_stack = host_thread_get_stack_used(frc->thread);
+        uint32_t selftest_stack = host_thread_get_stack_used(selftest->thread);
+        if(!warm_up) {
+            printf(
+                "  workers: FRC stack %lu/%u bytes, self-test %lu/%u bytes\n",
+                frc_stack,
+                WORKER_STACK_SIZE,
+                selftest_stack,
+                WORKER_STACK_SIZE);
+            HOST_CHECK(frc_stack < WORKER_STACK_SIZE && selftest_stack < WORKER_STACK_SIZE);
+        }
+    }
+
+    // The sequences run one at a time, their stacks are only allocated meanwhile
+    size_t expected = APP_STACK_SIZE + sizeof(Co2Frc) + sizeof(Co2SelfTest) +
+                      (config != ConfigReplay ? WORKER_STACK_SIZE : 0) +
+                      (replay ? sizeof(Scd4xReplay) : 0) + (capture ? sizeof(Scd4xCapture) : 0);
+    if(!warm_up) {
+        printf(
+            "  heap: %zu bytes peak with the app stack, app objects %zu bytes\n",
+            host_heap_peak(),
+            host_memory_peak());
+        HOST_CHECK(host_heap_peak() == expected);
+        HOST_CHECK(host_heap_peak() <= HEAP_BUDGET);
+    }
+
+    co2_frc_free(frc);
+    co2_selftest_free(selftest);
+    SCD4x_setTransport(NULL);
+    if(capture) {
+        scd4x_capture_stop(capture);
+        scd4x_capture_free(capture);
+    }
+    if(replay) scd4x_replay_free(replay);
+    return 0;
+}
+
+static void run(Config config) {
+    host_memory_reset_peak();
+    FuriThread* thread = furi_thread_alloc_ex("App", APP_STACK_SIZE, app_thread, &config);
+    furi_thread_start(thread);
+    furi_thread_join(thread);
+    uint32_t used = host_thread_get_stack_used(thread);
+    if(!warm_up) {
+        printf("  app thread: stack %lu/%u bytes\n", used, APP_STACK_SIZE);
+        HOST_CHECK(used < APP_STACK_SIZE);
+    }
+    furi_thread_free(thread);
+    HOST_CHECK(host_heap_used() == 0);
+}
+
+int main(void) {
+    // The first calls into the C library (lazy binding, locale) take more stack than the app
+    warm_up = true;
+    run(ConfigSensor);
+    warm_up = false;
+
+    for(Config config = 0; config < ConfigNum; config++) {
+        printf("%s:\n", config_names[config]);
+        run(config);
+    }
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
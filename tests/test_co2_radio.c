@@ -0,0 +1,215 @@
+/*
+  Sub-GHz link between nodes, over the loopback radio of host.c.
+
+  Four broadcast nodes and a collector run co2_radio_link as the app does: every node sends a
+  sample per measurement interval, every link is drained on the app tick. The channel drops 20%
+  of the packets and flips a bit in 2% of them, and one node restarts halfway with a new session.
+  Every frame sent must be received once or counted lost (it is only gone when both packets
+  carrying it are), the repeated copies must be counted as duplicates and the CSV log must hold a
+  line per sample received. A radio that does not start (out of region) must leave the link off.
+
+  The benchmark is the collector side, what a tick costs per frame heard: stream parser, CRC,
+  duplicate window and the CSV log line, for 8 nodes on a perfect channel.
+*/
+
+#include "host.h"
+#include "co2_radio_link.h"
+#include "scd4x.h"
+#include <storage/storage.h>
+
+#define NODES 4
+#define ROUNDS 2000
+#define RESTART_NODE 2
+#define LOSS_PERCENT 20
+#define CORRUPT_PERCENT 2
+#define BENCH_NODES 8
+#define BENCH_ROUNDS 20000
+
+typedef struct {
+    bool perfect; // Around the restart and at the end, see run()
+    uint32_t random;
+    uint32_t packets;
+    uint32_t dropped;
+    uint32_t corrupted;
+} Channel;
+
+static uint32_t channel_random(Channel* channel, uint32_t range) {
+    channel->random = channel->random * 1103515245 + 12345;
+    return (channel->random >> 8) % range;
+}
+
+static bool lossy_channel(void* context, uint8_t* data, size_t size) {
+    Channel* channel = context;
+    channel->packets++;
+    if(channel->perfect) return true;
+    uint32_t draw = channel_random(channel, 100);
+    if(draw < LOSS_PERCENT) {
+        channel->dropped++;
+        return false;
+    }
+    if(draw < LOSS_PERCENT + CORRUPT_PERCENT) {
+        data[channel_random(channel, size)] ^= 1 << channel_random(channel, 8);
+        channel->corrupted++;
+    }
+    return true;
+}
+
+static uint32_t node_id(uint32_t index) {
+    char serial[13];
+    snprintf(serial, sizeof(serial), "5C0A4B%06lX", index + 1);
+    return co2_radio_get_node_id(serial);
+}
+
+static uint32_t count_lines(const char* path) {
+    size_t size;
+    const uint8_t* data = host_file_get(path, &size);
+    HOST_CHECK(data);
+    uint32_t lines = 0;
+    for(size_t i = 0; i < size; i++) {
+        lines += data[i] == '\n';
+    }
+    return lines;
+}
+
+// Out of region: the worker does not start, nothing is sent or received
+static void run_refused(void) {
+    Co2RadioLink* link = co2_radio_link_alloc();
+    uint32_t errors = host_log_errors;
+    host_log_level = FuriLogLevelNone; // Expected, counted below
+    host_radio_allowed = false;
+    HOST_CHECK(!co2_radio_link_start(link, Co2RadioLinkModeCollector, node_id(0)));
+    host_radio_allowed = true;
+    host_log_level = FuriLogLevelWarn;
+    HOST_CHECK(link->mode == Co2RadioLinkModeOff && !link->worker);
+    HOST_CHECK(host_log_errors - errors == 1);
+    co2_radio_link_send(link, 400, 26000, 30000);
+    HOST_CHECK(co2_radio_link_tick(link, furi_get_tick()) == 0);
+    co2_radio_link_free(link);
+    printf("out of region: link off, 1 error logged\n");
+}
+
+static void run(void) {
+    Channel channel = {.random = 1};
+    host_radio_set_channel(lossy_channel, &channel);
+
+    Co2RadioLink* collector = co2_radio_link_alloc();
+    HOST_CHECK(co2_radio_link_start(collector, Co2RadioLinkModeCollector, node_id(NODES)));
+    Co2RadioLink* nodes[NODES];
+    uint32_t sent[NODES] = {0};
+    for(uint32_t i = 0; i < NODES; i++) {
+        nodes[i] = co2_radio_link_alloc();
+        HOST_CHECK(co2_radio_link_start(nodes[i], Co2RadioLinkModeBroadcast, node_id(i)));
+    }
+
+    size_t added = 0;
+    for(uint32_t round = 0; round < ROUNDS; round++) {
+        // The frames of a session are only accounted from its first one on: the last packet of
+        // the old session and the first one of the new session get through
+        channel.perfect = round == ROUNDS / 2 - 1 || round == ROUNDS / 2 || round == ROUNDS - 1;
+        if(round == ROUNDS / 2) {
+            HOST_CHECK(co2_radio_link_start(
+                nodes[RESTART_NODE], Co2RadioLinkModeBroadcast, node_id(RESTART_NODE)));
+        }
+        host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+        for(uint32_t i = 0; i < NODES; i++) {
+            co2_radio_link_send(nodes[i], 400 + round % 1000, 26000 + i, 30000);
+            sent[i]++;
+        }
+        // Broadcast nodes hear each other and drop it all
+        for(uint32_t i = 0; i < NODES; i++) {
+            HOST_CHECK(co2_radio_link_tick(nodes[i], furi_get_tick()) == 0);
+        }
+        added += co2_radio_link_tick(collector, furi_get_tick());
+    }
+
+    const Co2RadioCollector* collected = &collector->collector;
+    HOST_CHECK(collected->count == NODES);
+    uint32_t received = 0;
+    uint32_t lost = 0;
+    uint32_t duplicates = 0;
+    for(uint32_t i = 0; i < NODES; i++) {
+        const Co2RadioNode* node = &collected->nodes[i];
+        HOST_CHECK(node->node_id == node_id(i));
+        HOST_CHECK(node->received + node->lost == sent[i]);
+        HOST_CHECK(node->restarts == (i == RESTART_NODE));
+        HOST_CHECK(node->sample.co2 == 400 + (ROUNDS - 1) % 1000);
+        received += node->received;
+        lost += node->lost;
+        duplicates += node->duplicates;
+    }
+    HOST_CHECK(added == received);
+    HOST_CHECK(collected->frames == received + duplicates);
+    HOST_CHECK(collected->unknown == 0);
+    for(uint32_t i = 0; i < NODES; i++) {
+        HOST_CHECK(nodes[i]->send_errors == 0);
+        co2_radio_link_free(nodes[i]);
+    }
+
+    // Stopping flushes the log
+    co2_radio_link_stop(collector);
+    uint32_t lines = count_lines(CO2_RADIO_LOG_PATH);
+    printf(
+        "%u nodes, %lu packets (%lu dropped, %lu corrupted): %lu frames received, %lu lost, "
+        "%lu duplicates, %lu bytes skipped, %lu log lines\n",
+        NODES,
+        channel.packets,
+        channel.dropped,
+        channel.corrupted,
+        received,
+        lost,
+        duplicates,
+        collected->skipped,
+        lines - 1);
+    HOST_CHECK(collector->logged == received && lines == received + 1);
+    HOST_CHECK(collector->log_errors == 0);
+    // A frame is gone when the packets of two samples in a row are
+    HOST_CHECK(lost > 0 && lost < received / 10);
+    HOST_CHECK(collected->skipped > 0);
+    co2_radio_link_free(collector);
+    host_radio_set_channel(NULL, NULL);
+}
+
+static void run_bench(void) {
+    host_file_remove_all();
+    Co2RadioLink* collector = co2_radio_link_alloc();
+    HOST_CHECK(co2_radio_link_start(collector, Co2RadioLinkModeCollector, node_id(BENCH_NODES)));
+    Co2RadioLink* nodes[BENCH_NODES];
+    for(uint32_t i = 0; i < BENCH_NODES; i++) {
+        nodes[i] = co2_radio_link_alloc();
+        HOST_CHECK(co2_radio_link_start(nodes[i], Co2RadioLinkModeBroadcast, node_id(i)));
+    }
+
+    uint64_t wall = 0;
+    for(uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+        for(uint32_t i = 0; i < BENCH_NODES; i++) {
+            co2_radio_link_send(nodes[i], 400 + round % 1000, 26000, 30000);
+            co2_radio_link_tick(nodes[i], furi_get_tick());
+        }
+        uint64_t start = host_nanos();
+        co2_radio_link_tick(collector, furi_get_tick());
+        wall += host_nanos() - start;
+    }
+
+    uint32_t frames = collector->collector.frames;
+    printf(
+        "collector: %lu frames from %u nodes, %.0f frames/s, %.2f us/frame with the log line\n",
+        frames,
+        BENCH_NODES,
+        frames / (wall / 1e9),
+        wall / 1e3 / frames);
+    HOST_CHECK(collector->logged == BENCH_ROUNDS * BENCH_NODES);
+    HOST_CHECK(host_radio_overruns == 0);
+    for(uint32_t i = 0; i < BENCH_NODES; i++) {
+        co2_radio_link_free(nodes[i]);
+    }
+    co2_radio_link_free(collector);
+}
+
+int main(void) {
+    run_refused();
+    run();
+    run_bench();
+    HOST_CHECK(host_memory_used() == 0);
+    return 0;
+}
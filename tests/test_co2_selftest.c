@@ -0,0 +1,144 @@
+/*
+  Self-test in the background against a simulated sensor.
+
+  The sequence runs on its worker while the caller keeps going: a second start is refused, the
+  progress follows the clock and stops short of the end until the sensor answered. The outcome
+  is checked for a passing sensor, a malfunction response, a NACKed and a corrupted answer, and
+  the periodic measurements must be running again after every one of them. The bus statistics
+  of the diagnostics screen must count the commands, the NACKs and the CRC failures.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "co2_selftest.h"
+#include "co2_settings.h"
+
+static SimScd4x sim;
+static FuriMutex* gate; // Held by the test to keep the worker in its first transfer
+static uint32_t callbacks;
+
+static bool gated_tx(void* context, const uint8_t* data, uint8_t size) {
+    furi_mutex_acquire(gate, FuriWaitForever);
+    furi_mutex_release(gate);
+    return sim.transport.tx(context, data, size);
+}
+
+static void selftest_callback(void* context) {
+    UNUSED(context);
+    callbacks++;
+}
+
+// The sensor answers response, or the faults get in the way
+static void run(
+    const char* name,
+    uint16_t response,
+    bool nack,
+    bool corrupt,
+    Co2SelfTestState expected) {
+    Co2SelfTest* selftest = co2_selftest_alloc(selftest_callback, NULL);
+    selftest->mode = Co2SettingsModePeriodic;
+    HOST_CHECK(co2_selftest_get_progress(selftest) == 0.0f);
+    HOST_CHECK(startPeriodicMeasurement());
+    host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+    HOST_CHECK(readMeasurement());
+    resetBusStats();
+    callbacks = 0;
+    uint32_t errors = host_log_errors;
+    sim.selftest_response = response;
+    sim.nack_reads = nack;
+    sim.corrupt_reads = corrupt;
+
+    furi_mutex_acquire(gate, FuriWaitForever);
+    HOST_CHECK(co2_selftest_start(selftest));
+    HOST_CHECK(co2_selftest_is_running(selftest));
+    HOST_CHECK(!co2_selftest_start(selftest));
+    // Half the datasheet time, what the app shows while the worker waits for the sensor
+    host_advance((CO2_SELFTEST_STOP_DELAY_MS + CO2_SELFTEST_DURATION_MS) / 2);
+    float half = co2_selftest_get_progress(selftest);
+    host_advance(CO2_SELFTEST_STOP_DELAY_MS + CO2_SELFTEST_DURATION_MS);
+    float late = co2_selftest_get_progress(selftest);
+    uint32_t start = furi_get_tick();
+    furi_mutex_release(gate);
+    furi_thread_join(selftest->thread);
+
+    uint32_t elapsed = furi_get_tick() - start;
+    scd4x_bus_stats_t stats;
+    getBusStats(&stats);
+    printf(
+        "%-11s %-11s response 0x%04X, %lu ms, %lu commands, %lu NACKs, %lu CRC failures\n",
+        name,
+        co2_selftest_get_state_name(selftest->state),
+        selftest->response,
+        elapsed,
+        stats.commands,
+        stats.nacks,
+        stats.crcFailures);
+
+    HOST_CHECK(half > 0.49f && half < 0.51f);
+    HOST_CHECK(late == 0.99f);
+    HOST_CHECK(selftest->state == expected);
+    HOST_CHECK(co2_selftest_get_progress(selftest) == 1.0f);
+    HOST_CHECK(callbacks == 1);
+    HOST_CHECK(selftest->response == (expected == Co2SelfTestStateFailed ? response : 0));
+    // The worker waited for the sensor, not for the test
+    HOST_CHECK(elapsed >= CO2_SELFTEST_STOP_DELAY_MS + CO2_SELFTEST_DURATION_MS);
+    HOST_CHECK(host_log_errors - errors == (expected == Co2SelfTestStatePassed ? 0 : 1));
+
+    // Measuring again whatever the outcome
+    sim.nack_reads = false;
+    sim.corrupt_reads = false;
+    HOST_CHECK(sim.measuring && sim.interval == SCD4x_PERIODIC_INTERVAL_MS);
+    host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+    HOST_CHECK(readMeasurement());
+    co2_selftest_free(selftest);
+}
+
+int main(void) {
+    host_log_level = FuriLogLevelNone; // The failed self-tests are expected, they are counted
+    gate = furi_mutex_alloc(FuriMutexTypeNormal);
+    sim_scd4x_init(&sim);
+    scd4x_transport_t transport = sim.transport;
+    transport.tx = gated_tx;
+    SCD4x_setTransport(&transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+
+    char serial[13];
+    HOST_CHECK(getSerialNumber(serial));
+    printf("serial %s\n", serial);
+    HOST_CHECK(!strcmp(serial, "5C0A4B000001"));
+
+    run("pass", 0, false, false, Co2SelfTestStatePassed);
+    run("malfunction", 0x0004, false, false, Co2SelfTestStateFailed);
+    run("NACK", 0, true, false, Co2SelfTestStateNoAnswer);
+    run("bad CRC", 0, false, true, Co2SelfTestStateNoAnswer);
+
+    // Diagnostics: one corrupted and one NACKed answer in 10 reads
+    resetBusStats();
+    uint32_t read = 0;
+    for(uint32_t i = 0; i < 10; i++) {
+        host_advance(SCD4x_PERIODIC_INTERVAL_MS);
+        sim.corrupt_reads = i == 3;
+        sim.nack_reads = i == 6;
+        read += readMeasurement();
+    }
+    sim.corrupt_reads = false;
+    sim.nack_reads = false;
+    scd4x_bus_stats_t stats;
+    getBusStats(&stats);
+    printf(
+        "10 reads: %lu samples, %lu commands, %lu transactions, %lu NACKs, %lu responses, %lu CRC "
+        "failures\n",
+        read,
+        stats.commands,
+        stats.transactions,
+        stats.nacks,
+        stats.reads,
+        stats.crcFailures);
+    HOST_CHECK(read == 8);
+    HOST_CHECK(stats.crcFailures == 1 && stats.nacks == 1);
+    HOST_CHECK(stats.transactions == stats.commands + stats.reads + stats.nacks);
+
+    furi_mutex_free(gate);
+    return 0;
+}
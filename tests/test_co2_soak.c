@@ -0,0 +1,116 @@
+/*
+  Soak of the driver and the per-sample work of the app against the soak sensor of co2_soak.c,
+  built as the soak build of the app is (CO2_SENSOR_SOAK=1: 20 ms updates, 4 ms ticks).
+
+  The loop is the app's: a timer tick is posted, the view draws the last strings meanwhile, the
+  tick is handled with a read attempt and a fresh sample goes through the driver, the pipeline
+  and the soak checks. Every BLOCK_EVERY ticks the loop blocks for BLOCK_TICKS more (a slow SD
+  card write): their ticks are coalesced into the one waiting, a few sensor updates are
+  overwritten unread. Millions of samples (argument, 2 million by default) run on the simulated
+  clock, the tick latency on the CPU time of the loop. No check may fail: every sample
+  consistent with its update, the sensor sequence never slipping, the driver's dropped count
+  equal to the updates the simulation knows were never read, no tick handled a period late or
+  coalesced but while blocked, and the app objects and heap where they were at the first report.
+
+  Printed: samples, throughput, sensor time covered, and the final report of co2_soak with the
+  tick latency percentiles.
+*/
+
+#include "host.h"
+#include "pipeline.h"
+#include "co2_soak.h"
+#include <furi_hal.h>
+
+#define TICK_MS (SCD4x_PERIODIC_INTERVAL_MS / 5) // CO2_SENSOR_TICK_MS
+#define SAMPLES 2000000
+#define BLOCK_EVERY 1000
+#define BLOCK_TICKS 17 // 3.4 sensor intervals
+
+// The soak counts the tick latency in DWT cycles: follow the CPU time of the loop, which the
+// host scheduler preempting the test does not add to
+static void dwt_sync(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    uint64_t nanos = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+    DWT->CYCCNT = (uint32_t)(nanos * furi_hal_cortex_instructions_per_microsecond() / 1000);
+}
+
+// What the live view draws from the strings of the last sample
+static void view_draw(char* canvas, size_t size, const HostPipeline* pipeline) {
+    snprintf(
+        canvas,
+        size,
+        "%s ppm %s C %s %% %s",
+        pipeline->text[2],
+        pipeline->text[0],
+        pipeline->text[1],
+        pipeline->text[3]);
+}
+
+int main(int argc, char** argv) {
+    uint32_t samples = argc > 1 ? strtoul(argv[1], NULL, 10) : SAMPLES;
+
+    Co2Soak* soak = co2_soak_alloc(TICK_MS);
+    SCD4x_setTransport(&soak->transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+    HOST_CHECK(startPeriodicMeasurement());
+    resetTimingStats();
+
+    static HostPipeline pipeline;
+    host_pipeline_init(&pipeline, Co2FilterTypeEMA);
+    char canvas[64] = "";
+    size_t memory = host_memory_used();
+
+    uint32_t ticks = 0;
+    uint64_t start = host_nanos();
+    while(soak->samples < samples) {
+        host_advance(TICK_MS);
+        dwt_sync();
+        co2_soak_tick_posted(soak, false);
+        if(++ticks % BLOCK_EVERY == 0) {
+            for(uint32_t i = 0; i < BLOCK_TICKS; i++) {
+                host_advance(TICK_MS);
+                co2_soak_tick_posted(soak, true);
+            }
+        }
+        view_draw(canvas, sizeof(canvas), &pipeline);
+        dwt_sync();
+        co2_soak_tick_handled(soak);
+
+        if(!readMeasurement()) continue;
+        scd4x_sample_t sample;
+        HOST_CHECK(getLatestSample(&sample));
+        host_pipeline_push(&pipeline, &sample);
+        co2_soak_check(soak, &sample);
+    }
+    double wall = (host_nanos() - start) / 1e9;
+
+    printf(
+        "%lu samples in %.1f s (%.0f samples/s, %.2f us/sample), %.0f days of sensor time at "
+        "5 s\n",
+        soak->samples,
+        wall,
+        soak->samples / wall,
+        wall * 1e6 / soak->samples,
+        soak->samples * 5.0 / 86400);
+    printf("last view: %s\n", canvas);
+    host_log_level = FuriLogLevelInfo;
+    co2_soak_report(soak);
+    host_log_level = FuriLogLevelWarn;
+
+    scd4x_timing_stats_t timing;
+    getTimingStats(&timing);
+    HOST_CHECK(soak->failures == 0 && host_log_errors == 0);
+    HOST_CHECK(soak->mismatches == 0);
+    HOST_CHECK(timing.dropped == soak->missed);
+    HOST_CHECK(timing.dropped > 0);
+    HOST_CHECK(soak->ticks_coalesced == ticks / BLOCK_EVERY * BLOCK_TICKS);
+    HOST_CHECK(pipeline.samples == samples);
+    HOST_CHECK(host_memory_used() == memory);
+
+    SCD4x_setTransport(NULL);
+    co2_soak_free(soak);
+    HOST_CHECK(host_memory_used() == 0);
+    return 0;
+}
@@ -0,0 +1,256 @@
+/*
+  Daily statistics over a synthetic six-day stream, against a brute-force reference.
+
+  Samples come every 5 s from an occupied room: CO2 rising through the working hours, T and RH
+  following the day. The first days are periodic, one is hybrid (one full measurement in five,
+  the others T/RH-only with a CO2 word the statistics must not take), one has the app closed for
+  a few hours and gaps around CO2_STATS_MAX_GAP_S, and one day is slept through entirely.
+
+  The reference keeps every sample of the day. At each midnight the day that ends must match it:
+  count, min, max and the time above each threshold exactly, the mean and the standard deviation
+  to 1e-5 and 1e-4 relative (single precision Welford against a double two-pass). The p50/p95 of
+  P² must sit within 3 % of the rank of their quantile in the sorted day for CO2, whose noise
+  mixes the order of the samples, and within 5 % for T and RH: they drift slowly all day long,
+  the worst order for P². A day slept through leaves an empty yesterday, the day before it is
+  checked on its last sample.
+
+  Printed: the samples and worst errors of each day, and the ns per update.
+*/
+
+#include "host.h"
+#include "co2_stats.h"
+#include <math.h>
+
+#define INTERVAL_S 5
+#define DAY_S (24 * 60 * 60)
+#define DAY_SAMPLES_MAX (DAY_S / INTERVAL_S + 1)
+#define FIRST_DAY 19675 // Days since the epoch
+#define START_S (FIRST_DAY * DAY_S + 18 * 60 * 60) // The first midnight comes after 6 h
+#define DAYS 6
+#define HYBRID_DAY (FIRST_DAY + 2)
+#define GAPS_DAY (FIRST_DAY + 3)
+#define SKIPPED_DAY (FIRST_DAY + 4)
+#define HELD_CO2 5000.0f // Sent with the T/RH-only samples, never counted
+#define MEAN_BOUND 1e-5
+#define STDDEV_BOUND 1e-4
+#define CO2_RANK_BOUND 0.03
+#define RANK_BOUND 0.05
+#define BENCH_SAMPLES 10000000
+
+static const uint16_t thresholds[Co2AlarmLevelNum - 1] = {800, 1000, 1400};
+
+typedef struct {
+    uint32_t day;
+    uint32_t count[Co2FilterChannelNum];
+    float values[Co2FilterChannelNum][DAY_SAMPLES_MAX];
+    uint32_t seconds_above[Co2AlarmLevelNum - 1];
+} Reference;
+
+static Reference references[2]; // Today and yesterday, swapped at midnight
+static double sorted[DAY_SAMPLES_MAX];
+
+static uint32_t random_state = 5;
+
+// Roughly normal, unit variance
+static float random_noise(void) {
+    float sum = 0;
+    for(uint8_t i = 0; i < 12; i++) {
+        random_state = random_state * 1103515245 + 12345;
+        sum += (float)((random_state >> 8) & 0xFFFF) / 65536;
+    }
+    return sum - 6;
+}
+
+static void room(uint32_t timestamp, float values[Co2FilterChannelNum]) {
+    float hour = (float)(timestamp % DAY_S) / 3600;
+    float occupied = hour < 8 || hour > 18 ? 0 : sinf((hour - 8) / 10 * (float)M_PI);
+    values[Co2FilterChannelCO2] = roundf(430 + 1100 * occupied * occupied + 15 * random_noise());
+    values[Co2FilterChannelTemperature] =
+        20.5f + 2 * sinf((hour - 9) / 24 * 2 * (float)M_PI) + 0.05f * random_noise();
+    values[Co2FilterChannelHumidity] =
+        48 - 8 * sinf((hour - 9) / 24 * 2 * (float)M_PI) + 0.5f * random_noise();
+}
+
+// The next sample: the app closed for 2 h, gaps just over and at the limit, a day skipped
+static uint32_t next_timestamp(uint32_t timestamp) {
+    uint32_t day = timestamp / DAY_S;
+    uint32_t second = timestamp % DAY_S;
+    if(day == GAPS_DAY) {
+        if(second == 10 * 3600) return timestamp + 2 * 3600;
+        if(second == 14 * 3600) return timestamp + CO2_STATS_MAX_GAP_S + INTERVAL_S;
+        if(second == 15 * 3600) return timestamp + CO2_STATS_MAX_GAP_S;
+        if(second == 23 * 3600) return (SKIPPED_DAY + 1) * DAY_S + 3600;
+    }
+    return timestamp + INTERVAL_S;
+}
+
+static void reference_day(Reference* reference, uint32_t day) {
+    memset(reference->count, 0, sizeof(reference->count));
+    memset(reference->seconds_above, 0, sizeof(reference->seconds_above));
+    reference->day = day;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Fraction of the samples below the estimate, ties counted half
+static double rank_of(const double* values, uint32_t count, float estimate) {
+    uint32_t below = 0;
+    uint32_t equal = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        below += values[i] < estimate;
+        equal += values[i] == estimate;
+    }
+    return (below + equal / 2.0) / count;
+}
+
+static void check_channel(
+    const Co2StatsChannel* channel,
+    const float* values,
+    uint32_t count,
+    double bound,
+    double* worst_rank) {
+    HOST_CHECK(channel->count == count);
+    if(count == 0) return;
+
+    double sum = 0;
+    float min = values[0];
+    float max = values[0];
+    for(uint32_t i = 0; i < count; i++) {
+        sum += values[i];
+        min = MIN(min, values[i]);
+        max = MAX(max, values[i]);
+    }
+    double mean = sum / count;
+    double squares = 0;
+    for(uint32_t i = 0; i < count; i++) {
+        squares += (values[i] - mean) * (values[i] - mean);
+        sorted[i] = values[i];
+    }
+    double stddev = sqrt(squares / (count - 1));
+    HOST_CHECK(channel->min == min && channel->max == max);
+    HOST_CHECK(fabs(channel->mean - mean) <= MEAN_BOUND * fabs(mean));
+    HOST_CHECK(fabs(co2_stats_get_stddev(channel) - stddev) <= STDDEV_BOUND * stddev);
+
+    qsort(sorted, count, sizeof(double), compare_double);
+    const Co2Quantile* quantiles[] = {&channel->p50, &channel->p95};
+    for(uint8_t i = 0; i < COUNT_OF(quantiles); i++) {
+        double rank = rank_of(sorted, count, co2_stats_get_quantile(quantiles[i]));
+        double error = fabs(rank - quantiles[i]->p);
+        HOST_CHECK(error <= bound);
+        *worst_rank = MAX(*worst_rank, error);
+    }
+}
+
+static void check_day(const Co2StatsDayData* data, const Reference* reference) {
+    HOST_CHECK(data->day == reference->day);
+    double worst_rank = 0;
+    for(uint8_t i = 0; i < Co2FilterChannelNum; i++) {
+        double bound = i == Co2FilterChannelCO2 ? CO2_RANK_BOUND : RANK_BOUND;
+        check_channel(
+            &data->channels[i], reference->values[i], reference->count[i], bound, &worst_rank);
+    }
+    for(uint8_t i = 0; i < Co2AlarmLevelNum - 1; i++) {
+        HOST_CHECK(data->seconds_above[i] == reference->seconds_above[i]);
+    }
+    printf(
+        "day %lu: %5lu CO2, %5lu T/RH samples, above %4u/%4u/%4u ppm %5lu/%5lu/%5lu s, worst "
+        "quantile rank error %.4f\n",
+        data->day - FIRST_DAY,
+        data->channels[Co2FilterChannelCO2].count,
+        data->channels[Co2FilterChannelTemperature].count,
+        thresholds[0],
+        thresholds[1],
+        thresholds[2],
+        data->seconds_above[0],
+        data->seconds_above[1],
+        data->seconds_above[2],
+        worst_rank);
+}
+
+static void run_days(Co2Stats* stats) {
+    Reference* today = &references[0];
+    Reference* yesterday = &references[1];
+    reference_day(today, START_S / DAY_S);
+    uint32_t last_timestamp = 0;
+    float last_co2 = 0;
+    bool started = false;
+    uint32_t samples = 0;
+
+    for(uint32_t timestamp = START_S; timestamp < (FIRST_DAY + DAYS) * DAY_S;
+        timestamp = next_timestamp(timestamp)) {
+        uint32_t day = timestamp / DAY_S;
+        float values[Co2FilterChannelNum];
+        room(timestamp, values);
+        bool co2 = day != HYBRID_DAY || samples % 5 == 0;
+        if(!co2) values[Co2FilterChannelCO2] = HELD_CO2;
+
+        if(day != today->day) {
+            Reference* swap = yesterday;
+            yesterday = today;
+            today = swap;
+            if(yesterday->day != day - 1) reference_day(yesterday, day - 1);
+            reference_day(today, day);
+        }
+        // The time since the previous sample goes to the state of the last CO2
+        uint32_t elapsed = timestamp - last_timestamp;
+        if(started && elapsed <= CO2_STATS_MAX_GAP_S) {
+            for(uint8_t i = 0; i < Co2AlarmLevelNum - 1; i++) {
+                if(last_co2 >= thresholds[i]) today->seconds_above[i] += elapsed;
+            }
+        }
+        for(uint8_t i = 0; i < Co2FilterChannelNum; i++) {
+            if(i == Co2FilterChannelCO2 && !co2) continue;
+            today->values[i][today->count[i]++] = values[i];
+        }
+        if(co2) last_co2 = values[Co2FilterChannelCO2];
+        last_timestamp = timestamp;
+        started = true;
+
+        uint32_t day_before = stats->days[Co2StatsDayToday].day;
+        co2_stats_update(stats, values, co2, timestamp);
+        samples++;
+        if(next_timestamp(timestamp) / DAY_S > day + 1) {
+            // The next day is slept through: this one is dropped at the next sample
+            check_day(&stats->days[Co2StatsDayToday], today);
+        }
+        if(samples > 1 && day != day_before) {
+            // Midnight: the day that ended is yesterday, today has the one sample
+            const Co2StatsDayData* data = &stats->days[Co2StatsDayToday];
+            HOST_CHECK(data->day == day);
+            HOST_CHECK(data->channels[Co2FilterChannelTemperature].count == 1);
+            data = &stats->days[Co2StatsDayYesterday];
+            check_day(data, yesterday);
+            if(day == SKIPPED_DAY + 1) {
+                HOST_CHECK(data->channels[Co2FilterChannelTemperature].count == 0);
+            }
+        }
+    }
+    check_day(&stats->days[Co2StatsDayToday], today);
+}
+
+static void bench(void) {
+    static Co2Stats stats;
+    co2_stats_init(&stats, thresholds);
+    float values[Co2FilterChannelNum];
+    room(START_S, values);
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        values[Co2FilterChannelCO2] = 400 + (i & 1023);
+        co2_stats_update(&stats, values, true, START_S + i * INTERVAL_S);
+    }
+    double ns = (double)(host_nanos() - start) / BENCH_SAMPLES;
+    printf("%.1f ns per update\n", ns);
+    HOST_CHECK(stats.days[Co2StatsDayToday].channels[Co2FilterChannelCO2].count > 0);
+}
+
+int main(void) {
+    static Co2Stats stats;
+    co2_stats_init(&stats, thresholds);
+    run_days(&stats);
+    bench();
+    return 0;
+}
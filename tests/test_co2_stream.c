@@ -0,0 +1,283 @@
+/*
+  Live sample streaming through the CLI into a pty with a deliberately slow reader.
+
+  The command runs on its own thread as in the CLI, writing to the slave side of a pty. While
+  samples are offered the reader takes a few bytes at a time with long pauses, so the pty fills
+  and cli_write() blocks for long stretches; once the samples stop it drains the rest. The
+  sampling side offers a sample every PUSH_INTERVAL_US meanwhile and must never wait for the
+  reader: the slowest push is bounded far below the reader's pauses, and pushes must go on
+  while a write is blocked.
+  What comes out must parse, binary frames (sync, CRC) and CSV lines alike, every record must
+  carry the fields of the sample its sequence number names, the sequence gaps up to the last
+  sample offered must add up to the drop count of the stream exactly, and every offered sample
+  is either delivered or dropped.
+
+  Printed: for each format the samples offered, delivered and dropped, the slowest push, and the
+  samples/s offered and delivered.
+*/
+
+#define _GNU_SOURCE
+#include "host.h"
+#include "scd4x.h"
+#include "co2_stream.h"
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define SAMPLES 20000
+#define PUSH_MS 5 // Simulated time per sample
+#define PUSH_INTERVAL_US 20
+#define PUSH_MAX_NS 10000000 // A push waiting for the reader would take a pause of 20 ms
+#define SLOW_CHUNK 64 // Bytes per read while slow
+#define SLOW_PAUSE_US 20000
+#define FRAME_SIZE (2 + sizeof(Co2StreamRecord) + 1)
+#define OUTPUT_MAX (SAMPLES * 48)
+#define WAIT_MS 10000
+
+static Co2Stream* stream;
+static int pty_master;
+static int pty_slave;
+
+static uint8_t* output;
+static volatile size_t output_size;
+static volatile bool reader_slow;
+static volatile bool reader_done;
+static volatile uint32_t frames_read;
+static bool binary;
+
+static const char* command_line;
+
+static Co2StreamRecord expected_record(uint32_t sequence, uint32_t tick) {
+    Co2StreamRecord record = {
+        .sequence = sequence,
+        .tick = tick,
+        .co2 = 400 + sequence % 1000,
+        .temperature = (uint16_t)(sequence * 3),
+        .humidity = (uint16_t)(sequence * 5 + 7),
+        .flags = sequence % 6 ? SCD4x_SAMPLE_FLAG_VALID :
+                                SCD4x_SAMPLE_FLAG_VALID | SCD4x_SAMPLE_FLAG_RHT_ONLY,
+    };
+    return record;
+}
+
+static int32_t cli_thread(void* context) {
+    UNUSED(context);
+    HOST_CHECK(host_cli_run(command_line));
+    return 0;
+}
+
+static int32_t reader_thread(void* context) {
+    UNUSED(context);
+    struct pollfd descriptor = {.fd = pty_master, .events = POLLIN};
+    while(!reader_done) {
+        if(poll(&descriptor, 1, 10) <= 0) continue;
+        size_t chunk = reader_slow ? SLOW_CHUNK : 4096;
+        size_t room = OUTPUT_MAX - output_size;
+        ssize_t size = read(pty_master, &output[output_size], MIN(chunk, room));
+        if(size <= 0) continue;
+
+        uint32_t frames = 0;
+        if(binary) {
+            frames = (output_size + size) / FRAME_SIZE;
+        } else {
+            frames = frames_read;
+            for(ssize_t i = 0; i < size; i++) {
+                frames += output[output_size + i] == '\n';
+            }
+        }
+        output_size += size;
+        frames_read = frames;
+        if(reader_slow) usleep(SLOW_PAUSE_US);
+    }
+    return 0;
+}
+
+static void wait_for(volatile bool* condition) {
+    uint64_t start = host_nanos();
+    while(!*condition) {
+        HOST_CHECK(host_nanos() - start < WAIT_MS * 1000000ULL);
+        usleep(100);
+    }
+}
+
+// Sequence, tick and fields of a delivered record against the sample it names
+static void check_record(
+    const Co2StreamRecord* record,
+    uint32_t first,
+    uint32_t first_tick,
+    uint32_t* previous,
+    uint32_t* gaps) {
+    HOST_CHECK(record->sequence >= first && record->sequence < first + SAMPLES);
+    HOST_CHECK(*previous == UINT32_MAX || record->sequence > *previous);
+    *gaps += record->sequence - (*previous == UINT32_MAX ? first : *previous + 1);
+    *previous = record->sequence;
+
+    uint32_t tick = first_tick + (record->sequence - first) * PUSH_MS;
+    Co2StreamRecord expected = expected_record(record->sequence, tick);
+    HOST_CHECK(record->tick == expected.tick && record->co2 == expected.co2);
+    if(binary) {
+        HOST_CHECK(record->temperature == expected.temperature);
+        HOST_CHECK(record->humidity == expected.humidity && record->flags == expected.flags);
+    }
+}
+
+static uint32_t parse_binary(uint32_t first, uint32_t first_tick, uint32_t* gaps) {
+    HOST_CHECK(output_size % FRAME_SIZE == 0);
+    uint32_t previous = UINT32_MAX;
+    for(size_t offset = 0; offset < output_size; offset += FRAME_SIZE) {
+        const uint8_t* frame = &output[offset];
+        HOST_CHECK(frame[0] == CO2_STREAM_SYNC_0 && frame[1] == CO2_STREAM_SYNC_1);
+        uint8_t crc = computeCRC8((uint8_t*)&frame[2], sizeof(Co2StreamRecord));
+        HOST_CHECK(frame[FRAME_SIZE - 1] == crc);
+        Co2StreamRecord record;
+        memcpy(&record, &frame[2], sizeof(record));
+        check_record(&record, first, first_tick, &previous, gaps);
+    }
+    *gaps += first + SAMPLES - (previous == UINT32_MAX ? first : previous + 1);
+    return output_size / FRAME_SIZE;
+}
+
+static uint32_t parse_csv(uint32_t first, uint32_t first_tick, uint32_t* gaps) {
+    output[output_size] = '\0';
+    uint32_t previous = UINT32_MAX;
+    uint32_t lines = 0;
+    char* line = (char*)output;
+    char* end;
+    while((end = strstr(line, "\r\n"))) {
+        *end = '\0';
+        unsigned long sequence;
+        unsigned long tick;
+        unsigned co2;
+        float temperature;
+        float humidity;
+        char rest;
+        HOST_CHECK(
+            sscanf(
+                line,
+                "%lu,%lu,%u,%f,%f%c",
+                &sequence,
+                &tick,
+                &co2,
+                &temperature,
+                &humidity,
+                &rest) == 5);
+        Co2StreamRecord record = {.sequence = sequence, .tick = tick, .co2 = co2};
+        check_record(&record, first, first_tick, &previous, gaps);
+
+        Co2StreamRecord expected = expected_record(sequence, tick);
+        HOST_CHECK(fabsf(temperature - convertTemperature(expected.temperature)) <= 0.0051f);
+        HOST_CHECK(fabsf(humidity - convertHumidity(expected.humidity)) <= 0.0051f);
+        lines++;
+        line = end + 2;
+    }
+    HOST_CHECK(*line == '\0'); // Nothing but whole lines
+    *gaps += first + SAMPLES - (previous == UINT32_MAX ? first : previous + 1);
+    return lines;
+}
+
+static void run(const char* line, bool is_binary) {
+    command_line = line;
+    binary = is_binary;
+    output_size = 0;
+    frames_read = 0;
+    reader_slow = true;
+    reader_done = false;
+    host_cli_interrupt = false;
+
+    FuriThread* reader = furi_thread_alloc_ex("Reader", 4096, reader_thread, NULL);
+    FuriThread* cli = furi_thread_alloc_ex("Cli", 4096, cli_thread, NULL);
+    furi_thread_start(reader);
+    furi_thread_start(cli);
+    wait_for((volatile bool*)&stream->running);
+
+    uint32_t first = stream->sequence;
+    uint32_t dropped = stream->dropped;
+    uint32_t first_tick = furi_get_tick() + PUSH_MS;
+    uint64_t slowest = 0;
+    uint32_t blocked_pushes = 0;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < SAMPLES; i++) {
+        host_advance(PUSH_MS);
+        Co2StreamRecord record = expected_record(first + i, 0);
+        bool writing = host_cli_writing;
+        uint64_t push_start = host_nanos();
+        co2_stream_push(stream, record.co2, record.temperature, record.humidity, record.flags);
+        uint64_t push_end = host_nanos();
+        slowest = MAX(slowest, push_end - push_start);
+        blocked_pushes += writing && host_cli_writing;
+        while(host_nanos() - push_end < PUSH_INTERVAL_US * 1000) {
+        }
+    }
+    double push_s = (double)(host_nanos() - start) / 1e9;
+    dropped = stream->dropped - dropped;
+
+    // Everything offered is either dropped or on its way: let the reader catch up
+    reader_slow = false;
+    uint64_t wait_start = host_nanos();
+    while(frames_read + dropped < SAMPLES) {
+        HOST_CHECK(host_nanos() - wait_start < WAIT_MS * 1000000ULL);
+        usleep(1000);
+    }
+    double total_s = (double)(host_nanos() - start) / 1e9;
+    host_cli_interrupt = true;
+    furi_thread_join(cli);
+    reader_done = true;
+    furi_thread_join(reader);
+    furi_thread_free(cli);
+    furi_thread_free(reader);
+
+    uint32_t gaps = 0;
+    uint32_t delivered = binary ? parse_binary(first, first_tick, &gaps) :
+                                  parse_csv(first, first_tick, &gaps);
+    printf(
+        "%-4s %lu offered, %lu delivered, %lu dropped (%lu in sequence gaps), %lu pushes during a "
+        "write, slowest push %.1f us; %.0f samples/s offered, %.0f delivered\n",
+        binary ? "bin" : "csv",
+        (uint32_t)SAMPLES,
+        delivered,
+        dropped,
+        gaps,
+        blocked_pushes,
+        (double)slowest / 1000,
+        SAMPLES / push_s,
+        delivered / total_s);
+    HOST_CHECK(stream->sequence == first + SAMPLES && stream->pushed >= SAMPLES);
+    HOST_CHECK(delivered + dropped == SAMPLES);
+    HOST_CHECK(gaps == dropped);
+    HOST_CHECK(dropped > 0 && blocked_pushes > 0);
+    HOST_CHECK(slowest < PUSH_MAX_NS);
+    HOST_CHECK(!stream->running);
+}
+
+int main(void) {
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    HOST_CHECK(pty_master >= 0 && grantpt(pty_master) == 0 && unlockpt(pty_master) == 0);
+    pty_slave = open(ptsname(pty_master), O_RDWR | O_NOCTTY);
+    HOST_CHECK(pty_slave >= 0);
+    struct termios attributes;
+    HOST_CHECK(tcgetattr(pty_slave, &attributes) == 0);
+    cfmakeraw(&attributes);
+    HOST_CHECK(tcsetattr(pty_slave, TCSANOW, &attributes) == 0);
+    host_cli_fd = pty_slave;
+    output = malloc(OUTPUT_MAX + 1);
+
+    stream = co2_stream_alloc();
+    // Not streaming: nothing offered is counted
+    co2_stream_push(stream, 400, 0, 0, 0);
+    HOST_CHECK(stream->sequence == 0 && stream->dropped == 0);
+    // A wrong format only prints the usage
+    HOST_CHECK(host_cli_run("co2 stream xml") && !stream->running);
+
+    run("co2 stream bin", true);
+    run("co2 stream csv", false);
+
+    co2_stream_free(stream);
+    HOST_CHECK(!host_cli_run("co2 stream bin"));
+    host_cli_fd = -1;
+    close(pty_slave);
+    close(pty_master);
+    free(output);
+    return 0;
+}
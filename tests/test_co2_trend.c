@@ -0,0 +1,204 @@
+/*
+  CO2 trend forecast against simulated occupancy curves, and its cost per sample.
+
+  A room fills up from 450 ppm towards its steady state, C(t) = Css - (Css - C0) e^(-ACH t), at
+  0.3 to 4 air changes per hour and steady states from 900 to 4000 ppm, read every 5 s with
+  10 ppm of noise through the EMA filter of the app. Every forecast of the time to the next alarm
+  threshold is compared with the time the noiseless curve reaches it. The medians must stay
+  within the figures of co2_trend.h, few forecasts may name a threshold the room never reaches,
+  and the single precision forecast must agree with the same fit done in double.
+
+  The benchmark is an update and a forecast per sample, what the app does with every reading;
+  after 10 million of them (the tick counter wraps) the sums must still be exact.
+
+  Printed: median and 90th percentile of the error per horizon, forecasts naming a threshold the
+  room never reaches, the difference to the double fit, and the ns per sample.
+*/
+
+#include "host.h"
+#include "co2_trend.h"
+#include <math.h>
+
+#define INTERVAL_MS 5000
+#define HOURS 4
+#define RUNS 4
+#define NOISE_PPM 10.0
+#define START_PPM 450.0
+#define HORIZONS 3
+#define ERRORS_MAX 100000
+#define BENCH_SAMPLES 10000000
+
+static const double achs[] = {0.3, 0.5, 1, 2, 4};
+static const double steady_states[] = {900, 1300, 1600, 2500, 4000};
+static const uint16_t thresholds[] = {1000, 1400, 2000};
+static const char* const horizon_names[HORIZONS] = {"< 15 min", "15-60 min", "over 1 h"};
+
+static uint32_t random_state = 1;
+
+static double random_gauss(void) {
+    double sum = 0;
+    for(int i = 0; i < 12; i++) {
+        random_state = random_state * 1103515245 + 12345;
+        sum += (double)((random_state >> 8) & 0xFFFF) / 65536.0;
+    }
+    return sum - 6.0;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// The forecast of co2_trend.c from the same sums, in double
+static void reference_forecast(const Co2Trend* trend, Co2TrendForecast* forecast) {
+    memset(forecast, 0, sizeof(Co2TrendForecast));
+    int64_t n = trend->count;
+    int64_t denominator = n * trend->sum_tt - trend->sum_t * trend->sum_t;
+    double slope = (double)(n * trend->sum_ty - trend->sum_t * trend->sum_y) / denominator;
+    uint8_t newest = (trend->head + CO2_TREND_WINDOW - 1) % CO2_TREND_WINDOW;
+    uint8_t oldest = (trend->head + CO2_TREND_WINDOW - trend->count) % CO2_TREND_WINDOW;
+    double t = trend->ticks[newest] - trend->ticks[oldest];
+    double level = ((double)trend->sum_y + slope * (n * t - (double)trend->sum_t)) / n;
+    forecast->slope = (int32_t)(slope * 3600000.0);
+    if(forecast->slope < CO2_TREND_STEADY_PPM_H) return;
+    for(size_t i = 0; i < COUNT_OF(thresholds); i++) {
+        if(thresholds[i] <= level) continue;
+        double rise = (thresholds[i] - level) / (slope * 1000.0 * CO2_TREND_TAU_S);
+        if(rise >= 1) break;
+        double eta = -CO2_TREND_TAU_S * log(1 - rise);
+        if(eta <= CO2_TREND_MAX_ETA_S) {
+            forecast->target = thresholds[i];
+            forecast->eta = (uint32_t)eta;
+        }
+        break;
+    }
+}
+
+static double errors[HORIZONS][ERRORS_MAX]; // Minutes, forecast - actual
+static uint32_t error_count[HORIZONS];
+static uint32_t forecasts;
+static uint32_t unreached;
+static uint32_t disagreements; // Slope, target or ETA off the double fit
+static uint32_t eta_difference_max;
+
+static void run(double ach, double steady) {
+    double rate = ach / 3600;
+    Co2Trend trend;
+    co2_trend_init(&trend);
+    uint32_t ema = 0;
+    for(uint32_t k = 0; k < HOURS * 3600 * 1000 / INTERVAL_MS; k++) {
+        double t = k * INTERVAL_MS / 1000.0;
+        double truth = steady - (steady - START_PPM) * exp(-rate * t);
+        double reading = truth + NOISE_PPM * random_gauss();
+        uint16_t raw = reading < 0 ? 0 : (uint16_t)reading;
+        ema = ema ? ema - (ema >> 2) + raw : (uint32_t)raw << 2;
+        co2_trend_update(&trend, ema >> 2, k * INTERVAL_MS + 12345);
+
+        Co2TrendForecast forecast;
+        co2_trend_forecast(&trend, thresholds, COUNT_OF(thresholds), &forecast);
+        if(forecast.direction == Co2TrendDirectionUnknown) continue;
+        Co2TrendForecast reference;
+        reference_forecast(&trend, &reference);
+        uint32_t eta_difference = abs((int32_t)(forecast.eta - reference.eta));
+        eta_difference_max = MAX(eta_difference_max, eta_difference);
+        disagreements += abs(forecast.slope - reference.slope) > 1 ||
+                         forecast.target != reference.target || eta_difference > 1;
+
+        if(!forecast.target) continue;
+        forecasts++;
+        if(steady <= forecast.target) {
+            unreached++;
+            continue;
+        }
+        double actual = -log((steady - forecast.target) / (steady - START_PPM)) / rate - t;
+        if(actual < 0) continue;
+        int horizon = actual < 900 ? 0 : actual < 3600 ? 1 : 2;
+        if(error_count[horizon] < ERRORS_MAX) {
+            errors[horizon][error_count[horizon]++] = (forecast.eta - actual) / 60.0;
+        }
+    }
+}
+
+// Median (percent 50) and the like of the absolute errors of a horizon, minutes
+static double percentile(int horizon, uint32_t percent) {
+    static double sorted[ERRORS_MAX];
+    uint32_t count = error_count[horizon];
+    for(uint32_t i = 0; i < count; i++) {
+        sorted[i] = fabs(errors[horizon][i]);
+    }
+    qsort(sorted, count, sizeof(double), compare_doubles);
+    return sorted[count * percent / 100];
+}
+
+static void run_bench(void) {
+    Co2Trend trend;
+    co2_trend_init(&trend);
+    Co2TrendForecast forecast;
+    volatile uint32_t sink = 0;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        co2_trend_update(&trend, 600 + i % 97, i * INTERVAL_MS);
+        co2_trend_forecast(&trend, thresholds, COUNT_OF(thresholds), &forecast);
+        sink += forecast.eta;
+    }
+    double nanos = (double)(host_nanos() - start) / BENCH_SAMPLES;
+
+    // The sums from scratch, against the ones updated 10 million times
+    int64_t sum_t = 0;
+    int64_t sum_y = 0;
+    int64_t sum_tt = 0;
+    int64_t sum_ty = 0;
+    uint8_t oldest = (trend.head + CO2_TREND_WINDOW - trend.count) % CO2_TREND_WINDOW;
+    for(uint8_t i = 0; i < trend.count; i++) {
+        uint8_t j = (oldest + i) % CO2_TREND_WINDOW;
+        int64_t t = (uint32_t)(trend.ticks[j] - trend.ticks[oldest]);
+        sum_t += t;
+        sum_y += trend.values[j];
+        sum_tt += t * t;
+        sum_ty += t * trend.values[j];
+    }
+    bool exact = sum_t == trend.sum_t && sum_y == trend.sum_y && sum_tt == trend.sum_tt &&
+                 sum_ty == trend.sum_ty;
+    printf(
+        "update + forecast: %.1f ns/sample over %u samples, sums %s\n",
+        nanos,
+        BENCH_SAMPLES,
+        exact ? "exact" : "DRIFTED");
+    HOST_CHECK(exact);
+}
+
+int main(void) {
+    for(size_t a = 0; a < COUNT_OF(achs); a++) {
+        for(size_t s = 0; s < COUNT_OF(steady_states); s++) {
+            for(int r = 0; r < RUNS; r++) {
+                run(achs[a], steady_states[s]);
+            }
+        }
+    }
+
+    for(int horizon = 0; horizon < HORIZONS; horizon++) {
+        printf(
+            "%-10s %6lu forecasts, |error| median %.1f min, 90%% %.1f min\n",
+            horizon_names[horizon],
+            error_count[horizon],
+            percentile(horizon, 50),
+            percentile(horizon, 90));
+    }
+    printf(
+        "%lu forecasts, %lu (%.1f%%) name a threshold never reached; float against double: %lu "
+        "differ, ETA at most %lu s apart\n",
+        forecasts,
+        unreached,
+        100.0 * unreached / forecasts,
+        disagreements,
+        eta_difference_max);
+    HOST_CHECK(percentile(0, 50) <= 1.0);
+    HOST_CHECK(percentile(1, 50) <= 6.0);
+    HOST_CHECK(unreached * 100 <= forecasts * 15);
+    // A threshold right at the edge of the reach of the bent line may go either way
+    HOST_CHECK(disagreements * 1000 <= forecasts);
+
+    run_bench();
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+  co2_wake against a simulated sensor over a day: updates on the sensor clock (exact, 2% slow or
+  fast, at 5 s and 30 s), wake-ups delayed by up to 30 ms of scheduling jitter and a 2 ms read.
+  No update may be skipped. The fixed interval + margin after each read that headless mode used
+  before is run alongside for comparison.
+*/
+
+#include "host.h"
+#include "co2_wake.h"
+
+#define DAY_MS (24 * 3600 * 1000UL)
+#define JITTER_MS 30
+#define READ_MS 2
+
+typedef struct {
+    uint32_t samples;
+    uint32_t skipped;
+    uint32_t wakeups;
+    uint64_t latency_sum;
+    uint32_t latency_max;
+} Result;
+
+// Index of the newest update at t (ms), -1 before the first one. The sensor runs at
+// interval * (1 + drift)
+static int64_t sensor_update(double t, double interval, double drift) {
+    double period = interval * (1.0 + drift);
+    return t < period ? -1 : (int64_t)(t / period) - 1;
+}
+
+static double sensor_ready(int64_t update, double interval, double drift) {
+    return (update + 1) * interval * (1.0 + drift);
+}
+
+static Result run(uint32_t interval, double drift, bool aligned) {
+    Result result = {0};
+    Co2Wake wake;
+    co2_wake_start(&wake, interval);
+    int64_t read = -1;
+    srand(interval + (int)(drift * 1000));
+    uint32_t now = 100; // Headless mode starts with a search poll
+    while(now < DAY_MS) {
+        now += rand() % (JITTER_MS + 1);
+        result.wakeups++;
+        int64_t update = sensor_update(now, interval, drift);
+        bool fresh = update > read;
+        if(fresh) {
+            if(read >= 0) result.skipped += update - read - 1;
+            uint32_t latency = now - (uint32_t)sensor_ready(update, interval, drift);
+            result.latency_sum += latency;
+            result.latency_max = MAX(result.latency_max, latency);
+            result.samples++;
+            read = update;
+        }
+        now += READ_MS;
+        if(aligned) {
+            now += co2_wake_update(&wake, fresh, now);
+        } else {
+            now += fresh ? interval + 50 : 100;
+        }
+    }
+    return result;
+}
+
+int main(void) {
+    const uint32_t intervals[] = {5000, 30000};
+    const double drifts[] = {-0.02, -0.005, 0, 0.005, 0.02};
+    for(size_t i = 0; i < COUNT_OF(intervals); i++) {
+        for(size_t j = 0; j < COUNT_OF(drifts); j++) {
+            Result aligned = run(intervals[i], drifts[j], true);
+            Result fixed = run(intervals[i], drifts[j], false);
+            printf(
+                "%2lu s, clock %+.1f%%: %lu samples, %lu skipped, %.2f wake-ups/sample, latency "
+                "%llu ms avg %lu max (read + interval: %lu skipped, %llu ms avg)\n",
+                (unsigned long)intervals[i] / 1000,
+                drifts[j] * 100,
+                (unsigned long)aligned.samples,
+                (unsigned long)aligned.skipped,
+                (double)aligned.wakeups / aligned.samples,
+                (unsigned long long)(aligned.latency_sum / aligned.samples),
+                (unsigned long)aligned.latency_max,
+                (unsigned long)fixed.skipped,
+                (unsigned long long)(fixed.latency_sum / fixed.samples));
+            HOST_CHECK(aligned.skipped == 0);
+            HOST_CHECK(aligned.latency_max < intervals[i] / 4);
+            HOST_CHECK((double)aligned.wakeups / aligned.samples < 1.3);
+        }
+    }
+    return 0;
+}
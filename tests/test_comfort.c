@@ -0,0 +1,200 @@
+/*
+  Comfort metrics of the table against the Magnus formula with expf/logf, and the cost of both.
+
+  Every temperature word of the SCD4x from -10 to 60 C is walked with every 16th humidity word
+  (0 to 100 %), converted as the driver does. The error bounds of comfort.h must hold on all of
+  them: the saturation vapour pressure, the absolute humidity, the dew point (clamped to
+  COMFORT_TABLE_MIN_C where the exact one is below it) and the heat index against the same
+  regression evaluated in double. Heat indexes within 0.001 F of the switch to the regression
+  are left out: the NWS procedure jumps there by up to 1.2 C, and float and double may take
+  different sides of it.
+
+  Printed: the worst error of each metric and where it is, and the ns per call of the table and
+  of expf/logf.
+*/
+
+#include "host.h"
+#include "scd4x.h"
+#include "comfort.h"
+#include <math.h>
+
+#define SATURATION_BOUND 0.0007f // Relative
+#define ABSOLUTE_HUMIDITY_BOUND 0.03f // g/m3
+#define DEW_POINT_BOUND 0.015f // C
+#define HEAT_INDEX_BOUND 0.001f // C
+#define SWITCH_MARGIN_F 1e-3
+#define HUMIDITY_WORD_STEP 16
+#define BENCH_CALLS 10000000
+
+typedef struct {
+    float error;
+    float temperature;
+    float humidity;
+} Worst;
+
+static float magnus_saturation(float temperature) {
+    return 6.112f * expf(17.62f * temperature / (243.12f + temperature));
+}
+
+// What comfort_compute() would be with libm
+static void magnus_compute(ComfortMetrics* metrics, float temperature, float humidity) {
+    float vapour_pressure = magnus_saturation(temperature) * humidity / 100;
+    float gamma = logf(vapour_pressure / 6.112f);
+    metrics->dew_point = 243.12f * gamma / (17.62f - gamma);
+    metrics->absolute_humidity = 216.68f * vapour_pressure / (temperature + 273.15f);
+    metrics->heat_index = 0; // The same polynomials, nothing to compare
+}
+
+static double heat_index_simple(double t, double rh) {
+    return 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+}
+
+// On the switch to the regression: the NWS procedure jumps there, float and double may disagree
+static bool heat_index_is_switch(double t, double rh) {
+    return fabs((heat_index_simple(t, rh) + t) / 2 - 80.0) < SWITCH_MARGIN_F;
+}
+
+// NWS heat index, in and out in F
+static double heat_index_f(double t, double rh) {
+    double simple = heat_index_simple(t, rh);
+    if((simple + t) / 2 < 80.0) return simple;
+
+    double hi = -42.379 + 2.04901523 * t + 10.14333127 * rh - 0.22475541 * t * rh -
+                0.00683783 * t * t - 0.05481717 * rh * rh + 0.00122874 * t * t * rh +
+                0.00085282 * t * rh * rh - 0.00000199 * t * t * rh * rh;
+    if(rh < 13.0 && t >= 80.0 && t <= 112.0) {
+        hi -= (13.0 - rh) / 4 * sqrt((17.0 - fabs(t - 95.0)) / 17);
+    } else if(rh > 85.0 && t >= 80.0 && t <= 87.0) {
+        hi += (rh - 85.0) / 10 * (87.0 - t) / 5;
+    }
+    return hi;
+}
+
+static void worst_update(Worst* worst, float error, float temperature, float humidity) {
+    if(error <= worst->error) return;
+    worst->error = error;
+    worst->temperature = temperature;
+    worst->humidity = humidity;
+}
+
+static void worst_print(const char* name, const Worst* worst, const char* unit) {
+    printf(
+        "%-18s worst %.4f %s at %.2f C %.2f %%\n",
+        name,
+        (double)worst->error,
+        unit,
+        (double)worst->temperature,
+        (double)worst->humidity);
+}
+
+static void check_grid(void) {
+    Worst saturation = {0};
+    Worst absolute_humidity = {0};
+    Worst dew_point = {0};
+    Worst heat_index = {0};
+    uint32_t points = 0;
+    uint32_t clamped = 0;
+    uint32_t switches = 0;
+
+    for(uint32_t t_word = 0; t_word <= UINT16_MAX; t_word++) {
+        float temperature = convertTemperature(t_word);
+        if(temperature < -10 || temperature > 60) continue;
+        float exact_saturation = magnus_saturation(temperature);
+        float relative =
+            fabsf(comfort_saturation_pressure(temperature) - exact_saturation) / exact_saturation;
+        HOST_CHECK(relative < SATURATION_BOUND);
+        worst_update(&saturation, relative, temperature, 0);
+
+        for(uint32_t rh_word = 0; rh_word <= UINT16_MAX; rh_word += HUMIDITY_WORD_STEP) {
+            float humidity = convertHumidity(rh_word);
+            ComfortMetrics metrics;
+            ComfortMetrics exact;
+            comfort_compute(&metrics, temperature, humidity);
+            magnus_compute(&exact, temperature, humidity);
+            points++;
+
+            float error = fabsf(metrics.absolute_humidity - exact.absolute_humidity);
+            HOST_CHECK(error < ABSOLUTE_HUMIDITY_BOUND);
+            worst_update(&absolute_humidity, error, temperature, humidity);
+
+            // Clamped below the table, logf(0) is -inf: no dew point at 0 %, clamped as well
+            float expected = exact.dew_point;
+            if(!(expected >= COMFORT_TABLE_MIN_C)) {
+                expected = COMFORT_TABLE_MIN_C;
+                clamped++;
+            }
+            error = fabsf(metrics.dew_point - expected);
+            HOST_CHECK(error < DEW_POINT_BOUND);
+            worst_update(&dew_point, error, temperature, humidity);
+
+            double fahrenheit = (double)temperature * 9 / 5 + 32;
+            double exact_heat_index = (heat_index_f(fahrenheit, humidity) - 32) * 5 / 9;
+            error = (float)fabs(metrics.heat_index - exact_heat_index);
+            if(heat_index_is_switch(fahrenheit, humidity)) {
+                switches++;
+            } else {
+                HOST_CHECK(error < HEAT_INDEX_BOUND);
+                worst_update(&heat_index, error, temperature, humidity);
+            }
+        }
+    }
+
+    printf(
+        "%lu points, %lu dew points clamped, %lu heat indexes on the switch to the regression\n",
+        points,
+        clamped,
+        switches);
+    worst_print("saturation", &saturation, "relative");
+    worst_print("absolute humidity", &absolute_humidity, "g/m3");
+    worst_print("dew point", &dew_point, "C");
+    worst_print("heat index", &heat_index, "C");
+}
+
+static float bench_saturation(float temperature, float humidity) {
+    UNUSED(humidity);
+    return comfort_saturation_pressure(temperature);
+}
+
+static float bench_magnus_saturation(float temperature, float humidity) {
+    UNUSED(humidity);
+    return magnus_saturation(temperature);
+}
+
+// ns per call over a spread of indoor readings
+static double bench_pressure(float (*saturation)(float, float)) {
+    volatile float sink = 0;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < BENCH_CALLS; i++) {
+        sink += saturation(15 + (float)(i & 1023) / 64, 0);
+    }
+    UNUSED(sink);
+    return (double)(host_nanos() - start) / BENCH_CALLS;
+}
+
+static double bench(void (*compute)(ComfortMetrics*, float, float)) {
+    volatile float sink = 0;
+    ComfortMetrics metrics;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < BENCH_CALLS; i++) {
+        float temperature = 15 + (float)(i & 1023) / 64;
+        float humidity = 20 + (float)((i >> 10) & 511) / 8;
+        compute(&metrics, temperature, humidity);
+        sink += metrics.dew_point + metrics.absolute_humidity + metrics.heat_index;
+    }
+    UNUSED(sink);
+    return (double)(host_nanos() - start) / BENCH_CALLS;
+}
+
+int main(void) {
+    check_grid();
+    double table = bench_pressure(bench_saturation);
+    double magnus = bench_pressure(bench_magnus_saturation);
+    printf("saturation pressure: table %.1f ns per call, expf %.1f ns\n", table, magnus);
+    table = bench(comfort_compute);
+    magnus = bench(magnus_compute);
+    printf(
+        "all metrics: comfort_compute %.1f ns per call, expf/logf %.1f ns without heat index\n",
+        table,
+        magnus);
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+  Temperature offset tuning against simulated sensors: convergence time and accuracy.
+
+  The simulated SCD4x warms up after it is powered, its temperature rising by the self-heating
+  towards a plateau with a time constant, minus the offset it is configured with. A simulated
+  SHT4x on the external bus reads the air. Every SCD4x sample is paired with a reference reading
+  through the app's thermometer driver, as the tuning screen does, until the tuner says the
+  difference has settled; the proposed offset is then applied in one stop / write / restart
+  cycle, persisted, and the tuning starts over. It must settle again on a difference close to 0.
+
+  Printed per scenario: the time to settle, the error of the proposed offset against the true
+  self-heating, the difference left once it is applied and the time it took to confirm it.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "offset_tuner.h"
+#include "thermometer.h"
+#include "co2_settings.h"
+#include <math.h>
+
+#define TICK_MS 1000
+#define LIMIT_MS (4UL * 3600 * 1000)
+#define AMBIENT_C 21.0f
+#define TOLERANCE_C 0.2f // Well within a step of the settings screen
+
+typedef struct {
+    const char* name;
+    float heating; // C at the plateau, the offset to find
+    float tau_min; // Warm-up time constant
+    float noise; // SCD4x temperature noise, C
+    float ambient_drift; // C/h
+    Co2SettingsMode mode;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"warm-up 5 min", 6.5f, 5, 0.05f, 0, Co2SettingsModePeriodic},
+    {"warm-up 15 min", 6.5f, 15, 0.05f, 0, Co2SettingsModePeriodic},
+    {"warm-up 30 min", 6.5f, 30, 0.05f, 0, Co2SettingsModePeriodic},
+    {"small heating", 1.5f, 15, 0.05f, 0, Co2SettingsModePeriodic},
+    {"noisy 0.15 C", 6.5f, 15, 0.15f, 0, Co2SettingsModePeriodic},
+    {"ambient 0.5 C/h", 6.5f, 15, 0.05f, 0.5f, Co2SettingsModePeriodic},
+    {"low power 30 s", 6.5f, 15, 0.05f, 0, Co2SettingsModeLowPower},
+};
+
+static const Scenario* scenario;
+static SimScd4x sim;
+static uint32_t power_on;
+static uint32_t random_state = 1;
+
+static float random_gauss(void) {
+    float sum = 0;
+    for(int i = 0; i < 12; i++) {
+        random_state = random_state * 1103515245 + 12345;
+        sum += (float)((random_state >> 8) & 0xFFFF) / 65536.0f;
+    }
+    return sum - 6.0f;
+}
+
+static float ambient(void) {
+    return AMBIENT_C + scenario->ambient_drift * (float)(furi_get_tick() - power_on) / 3600000.0f;
+}
+
+// What the SCD4x measures: the air, its own heating, less the offset it is configured with
+static void scd4x_update(SimScd4x* sim, uint32_t update) {
+    UNUSED(update);
+    float minutes = (float)(furi_get_tick() - power_on) / 60000.0f;
+    float heating = scenario->heating * (1.0f - expf(-minutes / scenario->tau_min));
+    float offset = (float)sim->temperature_offset * 175.0f / 65536.0f;
+    float temperature = ambient() + heating - offset + scenario->noise * random_gauss();
+    sim->temperature = (uint16_t)lroundf((temperature + 45.0f) * 65536.0f / 175.0f);
+}
+
+// SHT4x at 0x44: serial number and high repeatability measurements
+typedef struct {
+    uint8_t command;
+    uint32_t ready; // Tick the measurement is done
+    uint32_t measurements;
+} SimSht4x;
+
+static bool sht4x_tx(void* context, const uint8_t* data, uint8_t size) {
+    SimSht4x* sht = context;
+    if(size != 1 || (data[0] != 0x89 && data[0] != 0xFD)) return false;
+    sht->command = data[0];
+    sht->ready = furi_get_tick() + (data[0] == 0xFD ? 9 : 1); // 8.3 ms, rounded up
+    return true;
+}
+
+static void sht4x_put(uint8_t* data, uint16_t word) {
+    data[0] = word >> 8;
+    data[1] = word & 0xFF;
+    data[2] = computeCRC8(data, 2);
+}
+
+static bool sht4x_rx(void* context, uint8_t* data, uint8_t size) {
+    SimSht4x* sht = context;
+    if(size != 6 || (int32_t)(furi_get_tick() - sht->ready) < 0) return false;
+    if(sht->command == 0x89) {
+        sht4x_put(data, 0x1234);
+        sht4x_put(data + 3, 0x5678);
+    } else {
+        float temperature = ambient() + 0.02f * random_gauss();
+        sht4x_put(data, (uint16_t)lroundf((temperature + 45.0f) * 65535.0f / 175.0f));
+        sht4x_put(data + 3, 0x8000);
+        sht->measurements++;
+    }
+    return true;
+}
+
+// Feed the tuner until it settles. Returns the time it took, 0 if it never did
+static uint32_t tune(OffsetTuner* tuner, Thermometer* thermometer) {
+    uint32_t start = furi_get_tick();
+    offset_tuner_reset(tuner, start);
+    while(furi_get_tick() - start < LIMIT_MS) {
+        host_advance(TICK_MS);
+        if(!readMeasurement()) continue;
+        scd4x_sample_t sample;
+        getLatestSample(&sample);
+        float reference;
+        HOST_CHECK(thermometer_read_temperature(thermometer, &reference));
+        offset_tuner_feed(
+            tuner, convertTemperature(sample.temperature), reference, furi_get_tick());
+        if(offset_tuner_is_settled(tuner)) return furi_get_tick() - start;
+    }
+    return 0;
+}
+
+static void run(const Scenario* run_scenario) {
+    scenario = run_scenario;
+    sim_scd4x_init(&sim);
+    sim.update = scd4x_update;
+    SCD4x_setTransport(&sim.transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    power_on = furi_get_tick();
+    HOST_CHECK(SCD4x_begin(false, true, false));
+
+    Co2Settings current;
+    co2_settings_default(&current);
+    current.sensor_type = SCD4x_SENSOR_SCD41;
+    current.mode = scenario->mode;
+    scd4x_config_t config;
+    HOST_CHECK(co2_settings_read(&current, &config));
+    HOST_CHECK(co2_settings_start(current.mode));
+
+    Thermometer thermometer;
+    HOST_CHECK(thermometer_probe(&thermometer) && thermometer.type == ThermometerTypeSHT4x);
+
+    static OffsetTuner tuner;
+    uint32_t settle = tune(&tuner, &thermometer);
+    HOST_CHECK(settle > 0);
+    Co2Settings pending = current;
+    pending.temperature_offset =
+        offset_tuner_get_offset(&tuner, current.temperature_offset, CO2_SETTINGS_OFFSET_MAX);
+    float error = pending.temperature_offset - scenario->heating;
+
+    uint32_t commands = sim.commands;
+    HOST_CHECK(co2_settings_apply(&current, &pending, true));
+    HOST_CHECK(co2_settings_save(&current));
+    uint32_t cycle_commands = sim.commands - commands;
+
+    uint32_t confirm = tune(&tuner, &thermometer);
+    HOST_CHECK(confirm > 0);
+    OffsetTunerFit fit;
+    HOST_CHECK(offset_tuner_get_fit(&tuner, &fit));
+
+    printf(
+        "%-16s settled in %5.1f min, offset %.2f C (error %+.2f), then %+.2f C left after "
+        "%5.1f min, %lu commands to apply\n",
+        scenario->name,
+        settle / 60000.0,
+        (double)pending.temperature_offset,
+        (double)error,
+        (double)fit.difference,
+        confirm / 60000.0,
+        cycle_commands);
+
+    HOST_CHECK(fabsf(error) <= TOLERANCE_C);
+    HOST_CHECK(fabsf(fit.difference) <= TOLERANCE_C);
+    // In a few time constants, plus the time to fill the window and see it flat
+    uint32_t window = OFFSET_TUNER_WINDOW * co2_settings_get_interval_ms(&current);
+    HOST_CHECK(settle <= (uint32_t)(5 * scenario->tau_min * 60000) + 2 * window);
+    // The offset reached the sensor and its settings file, the measurements run again
+    HOST_CHECK(fabsf(current.temperature_offset - pending.temperature_offset) < 0.01f);
+    Co2Settings saved;
+    co2_settings_load(&saved);
+    HOST_CHECK(fabsf(saved.temperature_offset - pending.temperature_offset) < 0.01f);
+    HOST_CHECK(sim.measuring);
+}
+
+int main(void) {
+    static SimSht4x sht;
+    HostI2cDevice device = {
+        .address = 0x44 << 1,
+        .tx = sht4x_tx,
+        .rx = sht4x_rx,
+        .context = &sht,
+    };
+    host_i2c_attach(&device);
+
+    for(size_t i = 0; i < COUNT_OF(scenarios); i++) {
+        run(&scenarios[i]);
+    }
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+  Ambient pressure compensation from a simulated BMP280 to the simulated SCD4x, polled as
+  sensor_tick() does (every PRESSURE_COMP_POLL_INTERVAL_MS, written with setAmbientPressure()).
+
+  The first pressure is written at once. A change below PRESSURE_COMP_THRESHOLD_PA is never
+  written, a larger one once the filter has followed it, never within
+  PRESSURE_COMP_MIN_INTERVAL_MS of the previous write, failed writes included: while the sensor
+  refuses them they are retried exactly once a minute. Pressures out of the plausible range
+  leave the filter alone. The writes per hour are the running count in the first hour, the
+  count of the last full hour after it, and 0 after hours without a sample.
+
+  Printed: the pressure read against the simulated one, and the writes of each step.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "sim_bmp280.h"
+#include "barometer.h"
+#include "pressure_comp.h"
+
+#define POLL_MS PRESSURE_COMP_POLL_INTERVAL_MS
+#define MINUTE_MS (60 * 1000)
+#define HOUR_MS (60 * MINUTE_MS)
+#define ATTEMPTS_MAX 64
+
+static SimScd4x scd4x;
+static SimBmp280 bmp280;
+static bool refuse_pressure;
+
+static uint32_t attempts[ATTEMPTS_MAX]; // Ticks of the writes tried
+static uint32_t attempt_count;
+
+static bool pressure_refusing_tx(void* context, const uint8_t* data, uint8_t size) {
+    uint16_t command = (uint16_t)data[0] << 8 | data[1];
+    if(refuse_pressure && command == SCD4x_COMMAND_SET_AMBIENT_PRESSURE) return false;
+    return scd4x.transport.tx(context, data, size);
+}
+
+// pressure_comp_poll() of co2_sensor.c
+static void poll(Barometer* barometer, PressureComp* comp) {
+    uint32_t now = furi_get_tick();
+    uint32_t pressure;
+    HOST_CHECK(barometer_read_pressure(barometer, &pressure));
+    if(pressure_comp_feed(comp, pressure, now)) {
+        bool success = setAmbientPressure((float)pressure_comp_get_pressure(comp), 0);
+        pressure_comp_commit(comp, success, now);
+        HOST_CHECK(attempt_count < ATTEMPTS_MAX);
+        attempts[attempt_count++] = now;
+    }
+}
+
+// Poll for a while at a pressure, returns the writes tried meanwhile
+static uint32_t run(Barometer* barometer, PressureComp* comp, uint32_t pressure, uint32_t ms) {
+    bmp280.pressure = pressure;
+    uint32_t count = attempt_count;
+    uint32_t end = furi_get_tick() + ms;
+    while(furi_get_tick() < end) {
+        poll(barometer, comp);
+        host_advance(POLL_MS);
+    }
+    return attempt_count - count;
+}
+
+static void check_gaps(void) {
+    for(uint32_t i = 1; i < attempt_count; i++) {
+        HOST_CHECK(attempts[i] - attempts[i - 1] >= PRESSURE_COMP_MIN_INTERVAL_MS);
+    }
+}
+
+static void test_feed(Barometer* barometer) {
+    PressureComp comp;
+    pressure_comp_reset(&comp, furi_get_tick());
+
+    uint32_t writes = run(barometer, &comp, 101325, 10 * MINUTE_MS);
+    printf("101325 Pa for 10 min: %lu write, sensor at %u hPa\n", writes, scd4x.pressure);
+    HOST_CHECK(writes == 1 && scd4x.pressure == 1013);
+
+    writes = run(barometer, &comp, 101325 + PRESSURE_COMP_THRESHOLD_PA - 50, 10 * MINUTE_MS);
+    printf("+150 Pa for 10 min: %lu writes\n", writes);
+    HOST_CHECK(writes == 0);
+
+    writes = run(barometer, &comp, 101325 + PRESSURE_COMP_THRESHOLD_PA + 150, 10 * MINUTE_MS);
+    printf("+350 Pa for 10 min: %lu write, sensor at %u hPa\n", writes, scd4x.pressure);
+    HOST_CHECK(writes == 1 && comp.last_written - 101325 > PRESSURE_COMP_THRESHOLD_PA);
+    HOST_CHECK(scd4x.pressure == comp.last_written / 100);
+
+    // The sensor refuses the writes: retried on the first poll after a minute, not on every one
+    refuse_pressure = true;
+    uint32_t first = attempt_count;
+    writes = run(barometer, &comp, 102500, 5 * MINUTE_MS);
+    printf(
+        "+1175 Pa, writes refused for 5 min: %lu tried, %lu errors\n", writes, comp.write_errors);
+    HOST_CHECK(writes == 5 && comp.write_errors == writes && comp.writes_total == 2);
+    for(uint32_t i = first + 1; i < attempt_count; i++) {
+        uint32_t gap = attempts[i] - attempts[i - 1];
+        HOST_CHECK(gap >= PRESSURE_COMP_MIN_INTERVAL_MS);
+        HOST_CHECK(gap < PRESSURE_COMP_MIN_INTERVAL_MS + POLL_MS);
+    }
+    refuse_pressure = false;
+    writes = run(barometer, &comp, 102500, 5 * MINUTE_MS);
+    HOST_CHECK(writes == 1 && comp.writes_total == 3);
+    HOST_CHECK(scd4x.pressure == comp.last_written / 100);
+    check_gaps();
+
+    // A burst of large swings: never two writes within the minimum interval
+    for(uint32_t i = 0; i < 20; i++) {
+        run(barometer, &comp, i % 2 ? 99000 : 103000, 30 * 1000);
+    }
+    check_gaps();
+    printf("swings: %lu writes in all, gaps of at least %u s\n", attempt_count, MINUTE_MS / 1000);
+
+    // Out of the plausible range: not fed to the filter
+    uint32_t filtered = pressure_comp_get_pressure(&comp);
+    HOST_CHECK(!pressure_comp_feed(&comp, PRESSURE_COMP_MIN_PA - 1, furi_get_tick() + HOUR_MS));
+    HOST_CHECK(!pressure_comp_feed(&comp, PRESSURE_COMP_MAX_PA + 1, furi_get_tick() + HOUR_MS));
+    HOST_CHECK(!pressure_comp_feed(&comp, 0, furi_get_tick() + HOUR_MS));
+    HOST_CHECK(pressure_comp_get_pressure(&comp) == filtered);
+}
+
+static void test_hours(void) {
+    PressureComp comp;
+    uint32_t start = furi_get_tick();
+    pressure_comp_reset(&comp, start);
+
+    // First hour: the running count
+    uint32_t pressure = 100000;
+    for(uint32_t i = 0; i < 3; i++) {
+        uint32_t now = start + i * 2 * MINUTE_MS;
+        HOST_CHECK(pressure_comp_feed(&comp, pressure, now));
+        pressure_comp_commit(&comp, true, now);
+        HOST_CHECK(pressure_comp_get_writes_per_hour(&comp) == i + 1);
+        // Jump far enough for the filter to pass the threshold with one sample
+        pressure += PRESSURE_COMP_THRESHOLD_PA << (PRESSURE_COMP_FILTER_SHIFT + 1);
+    }
+    // A failed write is not a write
+    HOST_CHECK(pressure_comp_feed(&comp, pressure, start + 10 * MINUTE_MS));
+    pressure_comp_commit(&comp, false, start + 10 * MINUTE_MS);
+    HOST_CHECK(pressure_comp_get_writes_per_hour(&comp) == 3);
+
+    // Second hour: the first hour's count, whatever happens now
+    HOST_CHECK(pressure_comp_feed(&comp, pressure, start + HOUR_MS));
+    pressure_comp_commit(&comp, true, start + HOUR_MS);
+    HOST_CHECK(pressure_comp_get_writes_per_hour(&comp) == 3);
+
+    // Third hour: the one write of the second
+    pressure_comp_feed(&comp, pressure, start + 2 * HOUR_MS);
+    HOST_CHECK(pressure_comp_get_writes_per_hour(&comp) == 1);
+
+    // No sample for more than an hour: the last full hour had no writes
+    pressure_comp_feed(&comp, pressure, start + 4 * HOUR_MS + 1);
+    HOST_CHECK(pressure_comp_get_writes_per_hour(&comp) == 0);
+    printf("writes per hour: 3 running, 3, 1, then 0 after 2 h without a sample\n");
+}
+
+int main(void) {
+    // The example of the datasheet, 100653.27 Pa in floating point, 3 Pa more in 32 bits
+    uint32_t example = sim_bmp280_compensate(415148);
+    HOST_CHECK(example >= 100653 && example <= 100656);
+
+    sim_bmp280_init(&bmp280);
+    host_i2c_attach(&bmp280.device);
+    Barometer barometer;
+    HOST_CHECK(barometer_probe(&barometer) && barometer.type == BarometerTypeBMP280);
+    for(uint32_t pressure = 90000; pressure <= 108000; pressure += 3000) {
+        bmp280.pressure = pressure;
+        uint32_t read;
+        HOST_CHECK(barometer_read_pressure(&barometer, &read));
+        HOST_CHECK(read >= pressure - 1 && read <= pressure + 1);
+    }
+    printf("BMP280: read within 1 Pa from 900 to 1080 hPa\n");
+    bmp280.fail = true;
+    uint32_t read;
+    HOST_CHECK(!barometer_read_pressure(&barometer, &read));
+    bmp280.fail = false;
+
+    sim_scd4x_init(&scd4x);
+    scd4x_transport_t transport = scd4x.transport;
+    transport.tx = pressure_refusing_tx;
+    SCD4x_setTransport(&transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+    HOST_CHECK(startPeriodicMeasurement());
+
+    test_feed(&barometer);
+    test_hours();
+
+    SCD4x_setTransport(NULL);
+    host_i2c_attach(NULL);
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
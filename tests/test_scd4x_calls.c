@@ -0,0 +1,125 @@
+/*
+  Cost per call of the driver itself, for the builds of scd4x.h (make calls runs it for each).
+
+  The transport answers at once from canned words and the execution waits only move the simulated
+  clock: what is timed is the driver's own work around the transfers (guards, command framing,
+  CRCs, sample timing, publishing), not the bus. Single shots must only be taken by the builds
+  that have them.
+
+  Printed: the build and the ns per call of the calls the app makes per sample.
+*/
+
+#include "host.h"
+#include "scd4x.h"
+
+#define CALLS 1000000
+
+static uint16_t command;
+
+static bool canned_tx(void* context, const uint8_t* data, uint8_t size) {
+    command = (uint16_t)data[0] << 8 | data[1];
+    return true;
+}
+
+static void canned_put(uint8_t* data, uint16_t word) {
+    data[0] = word >> 8;
+    data[1] = word & 0xFF;
+    data[2] = computeCRC8(data, 2);
+}
+
+static bool canned_rx(void* context, uint8_t* data, uint8_t size) {
+    uint16_t words[3] = {0};
+    switch(command) {
+    case SCD4x_COMMAND_GET_DATA_READY_STATUS:
+        words[0] = 0x8006;
+        break;
+    case SCD4x_COMMAND_READ_MEASUREMENT:
+        words[0] = 800;
+        words[1] = 0x6666;
+        words[2] = 0x8000;
+        break;
+    default:
+        break;
+    }
+    for(uint8_t i = 0; i + 3 <= size && i < 9; i += 3) {
+        canned_put(&data[i], words[i / 3]);
+    }
+    return true;
+}
+
+static void canned_delay(void* context, uint32_t delayMillis) {
+    host_advance(delayMillis);
+}
+
+static const scd4x_transport_t transport = {
+    .tx = canned_tx,
+    .rx = canned_rx,
+    .delay = canned_delay,
+};
+
+static double bench_read(void) {
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < CALLS; i++) {
+        HOST_CHECK(readMeasurement());
+    }
+    return (double)(host_nanos() - start) / CALLS;
+}
+
+static double bench_sample(void) {
+    scd4x_sample_t sample;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < CALLS; i++) {
+        HOST_CHECK(getLatestSample(&sample));
+    }
+    return (double)(host_nanos() - start) / CALLS;
+}
+
+static double bench_pressure(void) {
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < CALLS; i++) {
+        HOST_CHECK(setAmbientPressure(101325.0f, 0));
+    }
+    return (double)(host_nanos() - start) / CALLS;
+}
+
+static double bench_single_shot(bool* taken) {
+    *taken = true;
+    uint64_t start = host_nanos();
+    for(uint32_t i = 0; i < CALLS; i++) {
+        *taken &= measureSingleShotRHTOnly();
+    }
+    return (double)(host_nanos() - start) / CALLS;
+}
+
+int main(void) {
+    host_log_level = FuriLogLevelError;
+    SCD4x_setTransport(&transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41); // Ignored by a fixed variant
+
+    HOST_CHECK(startPeriodicMeasurement());
+    double read = bench_read();
+    double sample = bench_sample();
+    double pressure = bench_pressure();
+    HOST_CHECK(stopPeriodicMeasurement(0));
+    bool taken;
+    double single_shot = bench_single_shot(&taken);
+
+    printf(
+        "variant %d, single shot %d, low power %d, FRC %d, debug log %d: readMeasurement %.1f ns, "
+        "getLatestSample %.1f ns, setAmbientPressure %.1f ns, measureSingleShotRHTOnly %.1f ns "
+        "(%s)\n",
+        SCD4x_VARIANT,
+        SCD4x_ENABLE_SINGLE_SHOT,
+        SCD4x_ENABLE_LOW_POWER,
+        SCD4x_ENABLE_FRC,
+        SCD4x_ENABLE_DEBUGLOG,
+        read,
+        sample,
+        pressure,
+        single_shot,
+        taken ? "taken" : "refused");
+    HOST_CHECK(taken == SCD4x_ENABLE_SINGLE_SHOT);
+    HOST_CHECK(host_log_errors == 0);
+    SCD4x_setTransport(NULL);
+    return 0;
+}
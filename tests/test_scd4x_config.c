@@ -0,0 +1,141 @@
+/*
+  Sensor configuration in one bus session (readConfig / writeConfig) against the getters and
+  setters, on the host bus with the simulated SCD4x behind the driver's I2C transport.
+
+  Every getter and setter acquires the bus, probes the sensor address and waits its execution
+  time on its own; readConfig() and writeConfig() hold the bus and probe once. Both must read
+  the same values, writeConfig() must only send the fields that changed and nothing at all when
+  none did, and what it writes must reach the sensor as the setters do.
+
+  Printed per bus speed: round-trip time (bus and execution waits), bus acquires, probes and
+  commands.
+*/
+
+#include "host.h"
+#include "sim_scd4x.h"
+#include "co2_i2c.h"
+#include <furi_hal.h>
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t acquires;
+    uint32_t probes;
+    uint32_t commands;
+} Mark;
+
+static SimScd4x sim;
+
+static void mark(Mark* mark) {
+    mark->cycles = DWT->CYCCNT;
+    mark->acquires = host_i2c_acquires;
+    mark->probes = host_i2c_probes;
+    mark->commands = sim.commands;
+}
+
+// Prints the cost since start, returns the time in us
+static uint32_t report(const char* name, const Mark* start, Mark* cost) {
+    Mark now;
+    mark(&now);
+    cost->cycles = now.cycles - start->cycles;
+    cost->acquires = now.acquires - start->acquires;
+    cost->probes = now.probes - start->probes;
+    cost->commands = now.commands - start->commands;
+    uint32_t micros = cost->cycles / furi_hal_cortex_instructions_per_microsecond();
+    printf(
+        "  %-30s %6.2f ms, %2lu acquires, %2lu probes, %lu commands\n",
+        name,
+        micros / 1000.0,
+        cost->acquires,
+        cost->probes,
+        cost->commands);
+    return micros;
+}
+
+static void run(Co2I2cSpeed speed) {
+    SCD4x_setBus(co2_i2c_get_handle(speed));
+    printf("%s:\n", co2_i2c_get_speed_name(speed));
+    sim.temperature_offset = 1497; // 4 C, the factory default
+    sim.altitude = 0;
+    sim.asc = 1;
+
+    Mark start;
+    Mark cost;
+    char serial[13];
+    float offset;
+    uint16_t altitude;
+    uint16_t asc;
+    mark(&start);
+    HOST_CHECK(getSerialNumber(serial));
+    HOST_CHECK(getTemperatureOffset(&offset));
+    HOST_CHECK(getSensorAltitude(&altitude));
+    HOST_CHECK(getAutomaticSelfCalibrationEnabledExt(&asc));
+    uint32_t getters = report("getters", &start, &cost);
+    HOST_CHECK(cost.acquires == 8 && cost.probes == 8); // Command and response
+
+    scd4x_config_t config;
+    mark(&start);
+    HOST_CHECK(readConfig(&config));
+    uint32_t batch = report("readConfig", &start, &cost);
+    HOST_CHECK(cost.acquires == 1 && cost.probes == 1);
+    HOST_CHECK(batch < getters);
+    HOST_CHECK(!strcmp(config.serialNumber, serial));
+    HOST_CHECK(config.temperatureOffset == sim.temperature_offset);
+    HOST_CHECK(config.altitude == altitude && config.asc == asc);
+
+    mark(&start);
+    HOST_CHECK(setTemperatureOffset(5.0f, 1));
+    HOST_CHECK(setSensorAltitude(300, 1));
+    HOST_CHECK(setAutomaticSelfCalibrationEnabled(false, 1));
+    uint32_t setters = report("setters (3 fields)", &start, &cost);
+    HOST_CHECK(cost.acquires == 3 && cost.commands == 3);
+    uint16_t set_offset = sim.temperature_offset;
+    HOST_CHECK(sim.altitude == 300 && sim.asc == 0);
+
+    // The same 3 fields from the defaults again, through writeConfig()
+    sim.temperature_offset = config.temperatureOffset;
+    sim.altitude = config.altitude;
+    sim.asc = config.asc;
+    scd4x_config_t current = config;
+    config.temperatureOffset = set_offset;
+    config.altitude = 300;
+    config.asc = 0;
+    mark(&start);
+    HOST_CHECK(writeConfig(&current, &config));
+    batch = report("writeConfig (3 fields)", &start, &cost);
+    HOST_CHECK(cost.acquires == 1 && cost.probes == 1 && cost.commands == 3);
+    HOST_CHECK(batch < setters);
+    HOST_CHECK(!memcmp(&current, &config, sizeof(scd4x_config_t)));
+    HOST_CHECK(sim.temperature_offset == set_offset && sim.altitude == 300 && sim.asc == 0);
+
+    config.altitude = 400;
+    mark(&start);
+    HOST_CHECK(writeConfig(&current, &config));
+    report("writeConfig (altitude)", &start, &cost);
+    HOST_CHECK(cost.acquires == 1 && cost.commands == 1);
+    HOST_CHECK(sim.altitude == 400 && current.altitude == 400);
+
+    mark(&start);
+    HOST_CHECK(writeConfig(&current, &config));
+    report("writeConfig (nothing changed)", &start, &cost);
+    HOST_CHECK(cost.cycles == 0 && cost.acquires == 0 && cost.commands == 0);
+}
+
+int main(void) {
+    sim_scd4x_init(&sim);
+    HostI2cDevice device = {
+        .address = SCD4x_ADDRESS,
+        .tx = sim.transport.tx,
+        .rx = sim.transport.rx,
+        .context = &sim,
+    };
+    host_i2c_attach(&device);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+
+    for(Co2I2cSpeed speed = 0; speed < Co2I2cSpeedNum; speed++) {
+        run(speed);
+    }
+    SCD4x_setBus(NULL);
+    HOST_CHECK(host_log_errors == 0);
+    return 0;
+}
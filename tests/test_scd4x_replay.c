@@ -0,0 +1,138 @@
+/*
+  Capture and replay of the SCD4x bus traffic.
+
+  A day of a simulated sensor is captured through the unmodified driver, read every app tick like
+  live_tick() does. Replaying the capture must give the driver the same samples in the same
+  order with no unmatched transfer, in real time (the simulated clock must cover the captured
+  day, not twice it) and at full speed. The full speed replay is the benchmark: samples per
+  second through the replay transport, the driver decode and the app's per-sample pipeline.
+*/
+
+#include "host.h"
+#include "pipeline.h"
+#include "sim_scd4x.h"
+#include "scd4x_capture.h"
+
+#define DAY_MS (24UL * 3600 * 1000)
+#define TICK_MS (SCD4x_PERIODIC_INTERVAL_MS / 5)
+#define MAX_SAMPLES (DAY_MS / SCD4x_PERIODIC_INTERVAL_MS * 11 / 10) // Room for a fast clock
+
+static uint32_t random_state = 1;
+
+static uint32_t random_next(uint32_t range) {
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 8) % range;
+}
+
+// An occupied room: CO2 builds up during the day and decays at night, T and RH follow
+static void profile_update(SimScd4x* sim, uint32_t update) {
+    uint32_t hour = (update * SCD4x_PERIODIC_INTERVAL_MS / 3600000) % 24;
+    uint16_t base = hour >= 8 && hour < 18 ? 900 + (hour - 8) * 60 : 500;
+    sim->co2 = base + random_next(40);
+    sim->temperature = 0x6400 + hour * 32 + random_next(16);
+    sim->humidity = 0x5800 + random_next(64);
+}
+
+static scd4x_sample_t samples[MAX_SAMPLES];
+static uint32_t captured_ms; // Length of the captured session
+
+static void sensor_begin(const scd4x_transport_t* transport) {
+    SCD4x_setTransport(transport);
+    SCD4x_init(SCD4x_SENSOR_SCD41);
+    HOST_CHECK(SCD4x_begin(false, true, false));
+    HOST_CHECK(startPeriodicMeasurement());
+}
+
+static uint32_t capture_day(void) {
+    static SimScd4x sim;
+    sim_scd4x_init(&sim);
+    sim.update = profile_update;
+    sim.drift = 0.005f;
+
+    Scd4xCapture* capture = scd4x_capture_alloc(&sim.transport);
+    HOST_CHECK(scd4x_capture_start(capture, SCD4x_CAPTURE_PATH));
+    uint32_t start = furi_get_tick();
+    sensor_begin(&capture->transport);
+
+    uint32_t count = 0;
+    while(furi_get_tick() - start < DAY_MS) {
+        host_advance(TICK_MS);
+        if(readMeasurement()) {
+            HOST_CHECK(count < MAX_SAMPLES);
+            getLatestSample(&samples[count++]);
+        }
+    }
+    captured_ms = furi_get_tick() - start;
+    scd4x_capture_stop(capture);
+    printf(
+        "capture: %lu samples, %lu records, %lu bytes (%.1f bytes/sample)\n",
+        count,
+        capture->records,
+        capture->bytes,
+        (double)capture->bytes / count);
+    HOST_CHECK(!capture->error);
+    scd4x_capture_free(capture);
+    return count;
+}
+
+// Replay the capture and check the samples against the captured ones
+static void replay_day(bool realtime, uint32_t count) {
+    Scd4xReplay* replay = scd4x_replay_alloc(realtime);
+    HOST_CHECK(scd4x_replay_open(replay, SCD4x_CAPTURE_PATH));
+    HostPipeline pipeline;
+    host_pipeline_init(&pipeline, Co2FilterTypeMedian);
+
+    uint32_t start = furi_get_tick();
+    uint64_t wall = host_nanos();
+    sensor_begin(&replay->transport);
+    uint32_t read = 0;
+    while(!replay->finished) {
+        // At full speed the ticks come as fast as the replay answers
+        if(realtime) host_advance(TICK_MS);
+        if(!readMeasurement()) continue;
+
+        scd4x_sample_t sample;
+        getLatestSample(&sample);
+        HOST_CHECK(read < count);
+        HOST_CHECK(sample.co2 == samples[read].co2);
+        HOST_CHECK(sample.temperature == samples[read].temperature);
+        HOST_CHECK(sample.humidity == samples[read].humidity);
+        host_pipeline_push(&pipeline, &sample);
+        read++;
+    }
+    wall = host_nanos() - wall;
+    uint32_t elapsed = furi_get_tick() - start;
+
+    printf(
+        "replay %s: %lu samples, %lu records, %lu mismatches, %lu skipped, %lu s of clock",
+        realtime ? "real time" : "full speed",
+        read,
+        replay->records,
+        replay->mismatches,
+        replay->skipped,
+        elapsed / 1000);
+    if(!realtime) {
+        printf(", %.0f samples/s, %.2f us/sample", read / (wall / 1e9), wall / 1e3 / read);
+    }
+    printf("\n");
+
+    HOST_CHECK(read == count);
+    HOST_CHECK(replay->mismatches == 0);
+    HOST_CHECK(replay->skipped == 0);
+    HOST_CHECK(pipeline.samples == count);
+    if(realtime) {
+        // Paced by the records alone, the ticks after the last one are slack
+        HOST_CHECK(elapsed >= captured_ms && elapsed <= captured_ms + 2 * TICK_MS);
+    } else {
+        HOST_CHECK(elapsed == 0);
+    }
+    scd4x_replay_free(replay);
+}
+
+int main(void) {
+    uint32_t count = capture_day();
+    replay_day(true, count);
+    replay_day(false, count);
+    HOST_CHECK(host_memory_used() == 0);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+  Torn reads of the sequence lock.
+
+  A writer thread publishes records whose words all hold the same counter while the main thread
+  reads them back. A record with differing words is a torn read, a counter going backwards a
+  stale one: neither may ever be seen. The Flipper has a single core, a read only overlaps a
+  write when one of the threads is preempted halfway: both sides sleep in the middle of some of
+  their copies to get there on any host, on a multicore one they also really run concurrently.
+*/
+
+#include "host.h"
+#include "seqlock.h"
+#include <pthread.h>
+#include <time.h>
+
+#define WRITES 1000000
+#define RECORD_WORDS 32 // Bigger than the app's display data, a copy takes many loads
+#define PREEMPT_EVERY 100 // Copies interrupted halfway, one in
+
+typedef struct {
+    uint32_t words[RECORD_WORDS];
+} Record;
+
+static SeqLock lock;
+static Record shared;
+static volatile bool writer_done;
+
+// Give the other thread the core
+static void preempt(void) {
+    struct timespec pause = {.tv_sec = 0, .tv_nsec = 20000};
+    nanosleep(&pause, NULL);
+}
+
+static void* writer(void* context) {
+    UNUSED(context);
+    Record record;
+    for(uint32_t i = 1; i <= WRITES; i++) {
+        for(size_t k = 0; k < RECORD_WORDS; k++) {
+            record.words[k] = i;
+        }
+        if(i % PREEMPT_EVERY) {
+            seqlock_write(&lock, &shared, &record, sizeof(record));
+            // And sometimes between two writes, or the reader would only ever run during one
+            if(i % PREEMPT_EVERY == PREEMPT_EVERY / 2) preempt();
+            continue;
+        }
+        seqlock_write_begin(&lock);
+        memcpy(&shared, &record, sizeof(record) / 2);
+        preempt();
+        memcpy(
+            &shared.words[RECORD_WORDS / 2], &record.words[RECORD_WORDS / 2], sizeof(record) / 2);
+        seqlock_write_end(&lock);
+    }
+    writer_done = true;
+    return NULL;
+}
+
+// Same as seqlock_read(), with the reader preempted in the middle of the copy
+static uint32_t read_interrupted(Record* record) {
+    uint32_t retries = 0;
+    uint32_t sequence;
+    while(true) {
+        sequence = seqlock_read_begin(&lock);
+        memcpy(record, &shared, sizeof(Record) / 2);
+        preempt();
+        memcpy(
+            &record->words[RECORD_WORDS / 2], &shared.words[RECORD_WORDS / 2], sizeof(Record) / 2);
+        if(!seqlock_read_retry(&lock, sequence)) return retries;
+        retries++;
+    }
+}
+
+int main(void) {
+    pthread_t thread;
+    uint64_t start = host_nanos();
+    pthread_create(&thread, NULL, writer, NULL);
+
+    uint32_t reads = 0;
+    uint32_t retries = 0;
+    uint32_t torn = 0;
+    uint32_t stale = 0;
+    uint32_t changes = 0;
+    uint32_t last = 0;
+    while(!writer_done) {
+        Record record;
+        if(reads % PREEMPT_EVERY) {
+            seqlock_read(&lock, &record, &shared, sizeof(record));
+        } else {
+            retries += read_interrupted(&record);
+        }
+        reads++;
+        for(size_t k = 1; k < RECORD_WORDS; k++) {
+            if(record.words[k] != record.words[0]) {
+                torn++;
+                break;
+            }
+        }
+        if(record.words[0] < last) stale++;
+        if(record.words[0] != last) changes++;
+        last = record.words[0];
+    }
+    pthread_join(thread, NULL);
+    uint64_t elapsed = host_nanos() - start;
+
+    printf(
+        "%u writes, %lu reads (%lu saw a new record, %lu retried), %lu torn, %lu stale, %.0f ms\n",
+        WRITES,
+        reads,
+        changes,
+        retries,
+        torn,
+        stale,
+        elapsed / 1e6);
+    HOST_CHECK(torn == 0);
+    HOST_CHECK(stale == 0);
+    // The reads overlapped the writes, and the retry path was taken
+    HOST_CHECK(changes > 100);
+    HOST_CHECK(retries > 0);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "thermometer.h"
+#include "scd4x.h"
+#include <core/log.h>
+
+#define THERMO_I2C_BUS &furi_hal_i2c_handle_external
+#define THERMO_TIMEOUT furi_ms_to_ticks(100)
+
+//SHT4x
+#define SHT4X_ADDRESS_A (0x44 << 1)
+#define SHT4X_ADDRESS_B (0x45 << 1)
+#define SHT4X_ADDRESS_C (0x46 << 1)
+#define SHT4X_COMMAND_MEASURE_HIGH 0xFD // Max measurement time is 8.3 ms
+#define SHT4X_COMMAND_READ_SERIAL 0x89
+#define SHT4X_MEASURE_DELAY_MS 10
+#define SHT4X_SERIAL_DELAY_MS 1
+
+//SHT3x
+#define SHT3X_ADDRESS_A (0x44 << 1)
+#define SHT3X_ADDRESS_B (0x45 << 1)
+#define SHT3X_COMMAND_MEASURE_HIGH 0x2400 // Max measurement time is 15.5 ms
+#define SHT3X_COMMAND_READ_STATUS 0xF32D
+#define SHT3X_MEASURE_DELAY_MS 16
+#define SHT3X_STATUS_DELAY_MS 1
+
+// Send a command, wait for it to execute, then read count words checked against their CRC
+static bool thermometer_transfer(
+    uint8_t address,
+    const uint8_t* command,
+    uint8_t command_size,
+    uint32_t delay_ms,
+    uint16_t* words,
+    uint8_t count) {
+    uint8_t data[6];
+    furi_assert(count * 3 <= sizeof(data));
+
+    furi_hal_i2c_acquire(THERMO_I2C_BUS);
+    bool success = furi_hal_i2c_tx(THERMO_I2C_BUS, address, command, command_size, THERMO_TIMEOUT);
+    furi_hal_i2c_release(THERMO_I2C_BUS);
+    if(!success) return false;
+
+    // Release the bus meanwhile, the SCD4x may be talked to by another thread
+    furi_delay_ms(delay_ms);
+
+    furi_hal_i2c_acquire(THERMO_I2C_BUS);
+    success = furi_hal_i2c_rx(THERMO_I2C_BUS, address, data, count * 3, THERMO_TIMEOUT);
+    furi_hal_i2c_release(THERMO_I2C_BUS);
+    if(!success) return false;
+
+    // Same word + CRC framing and CRC as the SCD4x
+    for(uint8_t i = 0; i < count; i++) {
+        if(computeCRC8(&data[i * 3], 2) != data[i * 3 + 2]) return false;
+        words[i] = (uint16_t)data[i * 3] << 8 | data[i * 3 + 1];
+    }
+    return true;
+}
+
+static bool thermometer_probe_sht4x(Thermometer* thermo, uint8_t address) {
+    const uint8_t command = SHT4X_COMMAND_READ_SERIAL;
+    uint16_t serial[2];
+    if(!thermometer_transfer(address, &command, 1, SHT4X_SERIAL_DELAY_MS, serial, 2)) {
+        return false;
+    }
+    thermo->address = address;
+    return true;
+}
+
+static bool thermometer_probe_sht3x(Thermometer* thermo, uint8_t address) {
+    const uint8_t command[] = {SHT3X_COMMAND_READ_STATUS >> 8, SHT3X_COMMAND_READ_STATUS & 0xFF};
+    uint16_t status;
+    if(!thermometer_transfer(address, command, 2, SHT3X_STATUS_DELAY_MS, &status, 1)) {
+        return false;
+    }
+    thermo->address = address;
+    return true;
+}
+
+static bool thermometer_is_ready(uint8_t address) {
+    furi_hal_i2c_acquire(THERMO_I2C_BUS);
+    bool ready = furi_hal_i2c_is_device_ready(THERMO_I2C_BUS, address, THERMO_TIMEOUT);
+    furi_hal_i2c_release(THERMO_I2C_BUS);
+    return ready;
+}
+
+bool thermometer_probe(Thermometer* thermo) {
+    const uint8_t sht4x_addresses[] = {SHT4X_ADDRESS_A, SHT4X_ADDRESS_B, SHT4X_ADDRESS_C};
+    const uint8_t sht3x_addresses[] = {SHT3X_ADDRESS_A, SHT3X_ADDRESS_B};
+
+    thermo->type = ThermometerTypeNone;
+
+    for(size_t i = 0; i < COUNT_OF(sht4x_addresses); i++) {
+        if(thermometer_is_ready(sht4x_addresses[i]) &&
+           thermometer_probe_sht4x(thermo, sht4x_addresses[i])) {
+            thermo->type = ThermometerTypeSHT4x;
+            break;
+        }
+    }
+
+    for(size_t i = 0; i < COUNT_OF(sht3x_addresses) && thermo->type == ThermometerTypeNone; i++) {
+        if(thermometer_is_ready(sht3x_addresses[i]) &&
+           thermometer_probe_sht3x(thermo, sht3x_addresses[i])) {
+            thermo->type = ThermometerTypeSHT3x;
+        }
+    }
+
+    furi_log_print_format(
+        FuriLogLevelDebug,
+        "Thermo",
+        "probe: %s at 0x%02x",
+        thermometer_get_name(thermo),
+        thermo->address >> 1);
+    return thermo->type != ThermometerTypeNone;
+}
+
+bool thermometer_read_temperature(Thermometer* thermo, float* temperature) {
+    uint16_t words[2]; // T, RH
+    bool success = false;
+
+    switch(thermo->type) {
+    case ThermometerTypeSHT4x: {
+        const uint8_t command = SHT4X_COMMAND_MEASURE_HIGH;
+        success = thermometer_transfer(
+            thermo->address, &command, 1, SHT4X_MEASURE_DELAY_MS, words, 2);
+        break;
+    }
+    case ThermometerTypeSHT3x: {
+        const uint8_t command[] = {
+            SHT3X_COMMAND_MEASURE_HIGH >> 8, SHT3X_COMMAND_MEASURE_HIGH & 0xFF};
+        success =
+            thermometer_transfer(thermo->address, command, 2, SHT3X_MEASURE_DELAY_MS, words, 2);
+        break;
+    }
+    default:
+        return false;
+    }
+    if(!success) return false;
+
+    // Same conversion for both families
+    *temperature = -45.0f + 175.0f * (float)words[0] / 65535.0f;
+    return true;
+}
+
+const char* thermometer_get_name(const Thermometer* thermo) {
+    switch(thermo->type) {
+    case ThermometerTypeSHT4x:
+        return "SHT4x";
+    case ThermometerTypeSHT3x:
+        return "SHT3x";
+    default:
+        return "none";
+    }
+}
@@ -0,0 +1,40 @@
+/*
+  Minimal driver for an external I2C reference thermometer sharing the bus with the SCD4x.
+
+  Supported parts:
+  * Sensirion SHT4x (0x44 / 0x45 / 0x46), single measurement with high repeatability
+  * Sensirion SHT3x (0x44 / 0x45), single shot with high repeatability, no clock stretching
+
+  Both families answer at 0x44, the SHT4x is told apart by its serial number command, which the
+  SHT3x does not know. The thermometer is only used as the reference of the temperature offset
+  tuning.
+*/
+
+#ifndef __THERMOMETER_H__
+#define __THERMOMETER_H__
+
+#include <furi.h>
+#include <furi_hal.h>
+#include <furi_hal_i2c.h>
+
+typedef enum {
+    ThermometerTypeNone = 0,
+    ThermometerTypeSHT4x,
+    ThermometerTypeSHT3x,
+} ThermometerType;
+
+typedef struct {
+    ThermometerType type;
+    uint8_t address; // 8-bit (shifted) I2C address, as expected by furi_hal_i2c
+} Thermometer;
+
+// Look for a supported thermometer on the external I2C bus. Returns true if one was found.
+bool thermometer_probe(Thermometer* thermo);
+
+// Trigger a single measurement and read the temperature in C. Blocks for the measurement time
+// (~16 ms).
+bool thermometer_read_temperature(Thermometer* thermo, float* temperature);
+
+const char* thermometer_get_name(const Thermometer* thermo);
+
+#endif
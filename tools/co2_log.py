@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+"""Read and write the binary sample log of the app (apps_data/co2_sensor/log.bin).
+
+  co2_log.py decode log.bin [--from T] [--to T]
+      Prints the samples as CSV. With a time range (RTC timestamps, seconds) the block headers
+      are binary-searched and only the overlapping blocks are decoded. After the RTC was set
+      back the file holds several runs of blocks in time order, each one is searched on its own
+      and the samples come out in file order.
+  co2_log.py info log.bin
+      One line per block: time range, sample count, payload bytes used and CO2 min/max.
+  co2_log.py encode log.csv log.bin
+      Builds a log from a CSV with the columns written by decode (or the old log.csv).
+  co2_log.py bench [--days N]
+      Encodes N days of synthetic 5 s samples, then reports the size against CSV, the decode
+      throughput and how many blocks a one hour range query touches.
+
+See co2_blocklog.h for the format.
+"""
+
+import argparse
+import bisect
+import random
+import struct
+import sys
+import time
+
+MAGIC = b"C2BL"
+VERSION = 1
+BLOCK_SIZE = 512
+CHANNELS = 3
+FILE_HEADER = struct.Struct("<4sBxHI4x")
+BLOCK_HEADER = struct.Struct("<IIHH3H3H3HH")
+FLAG_CLOCK_BACK = 1 << 0
+PAYLOAD_SIZE = BLOCK_SIZE - BLOCK_HEADER.size
+MAX_SAMPLE_SIZE = 5 + 3 * CHANNELS
+CSV_HEADER = "timestamp,co2_ppm,temperature_c,humidity_pct"
+
+
+def to_csv(sample):
+    timestamp, co2, t, rh = sample
+    return f"{timestamp},{co2},{-45 + 175 * t / 65536:.2f},{100 * rh / 65536:.2f}"
+
+
+def from_csv(line):
+    timestamp, co2, t, rh = line.split(",")
+    t_word = round((float(t) + 45) * 65536 / 175)
+    rh_word = round(float(rh) * 65536 / 100)
+    return int(timestamp), int(co2), min(t_word, 0xFFFF), min(rh_word, 0xFFFF)
+
+
+def zigzag(value):
+    return ((value << 1) ^ (value >> 31)) & 0xFFFFFFFF
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def put_varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+
+
+class Block:
+    def __init__(self, header, payload):
+        (self.start, self.end, self.count, self.size) = header[:4]
+        self.min = header[4:7]
+        self.max = header[7:10]
+        self.first = header[10:13]
+        self.flags = header[13]
+        self.payload = payload
+
+    def samples(self):
+        if self.count == 0:
+            return
+        timestamp, words = self.start, list(self.first)
+        yield (timestamp, *words)
+        payload, position = self.payload, 0
+        for _ in range(self.count - 1):
+            values = []
+            for _ in range(1 + CHANNELS):
+                value = shift = 0
+                while True:
+                    byte = payload[position]
+                    position += 1
+                    value |= (byte & 0x7F) << shift
+                    shift += 7
+                    if not byte & 0x80:
+                        break
+                values.append(unzigzag(value))
+            timestamp = (timestamp + values[0]) & 0xFFFFFFFF
+            for i in range(CHANNELS):
+                words[i] = (words[i] + values[1 + i]) & 0xFFFF
+            yield (timestamp, *words)
+
+
+class Log:
+    def __init__(self, data):
+        magic, version, block_size, self.created = FILE_HEADER.unpack_from(data)
+        if magic != MAGIC or version != VERSION or block_size != BLOCK_SIZE:
+            sys.exit("not a block log")
+        self.data = data
+        self.blocks = (len(data) - FILE_HEADER.size) // BLOCK_SIZE
+        # Header only, the payloads are read on demand. A run of blocks in time order ends where
+        # the RTC was set back: at a flagged block, or one starting before the previous one
+        # ended (written before the flag existed)
+        self.starts = []
+        self.ends = []
+        self.runs = []  # Index of the first block of each run
+        end = None
+        for i in range(self.blocks):
+            header = self.header(i)
+            if end is None or header[13] & FLAG_CLOCK_BACK or header[0] < end:
+                self.runs.append(i)
+            self.starts.append(header[0])
+            self.ends.append(header[1])
+            end = header[1]
+
+    def offset(self, index):
+        return FILE_HEADER.size + index * BLOCK_SIZE
+
+    def header(self, index):
+        return BLOCK_HEADER.unpack_from(self.data, self.offset(index))
+
+    def block(self, index):
+        offset = self.offset(index)
+        return Block(
+            self.header(index),
+            self.data[offset + BLOCK_HEADER.size : offset + BLOCK_SIZE],
+        )
+
+    def run_range(self, run, start=None, end=None):
+        """Indexes of the blocks of a run overlapping [start, end], they are in time order."""
+        low = self.runs[run]
+        high = self.runs[run + 1] if run + 1 < len(self.runs) else self.blocks
+        first = low
+        if start is not None:
+            if self.ends[high - 1] < start:
+                return range(high, high)
+            # The last block starting at or before start may still contain it
+            first = max(bisect.bisect_right(self.starts, start, low, high) - 1, low)
+        last = high
+        if end is not None:
+            last = bisect.bisect_right(self.starts, end, low, high)
+        return range(first, last)
+
+    def range(self, start=None, end=None):
+        """Indexes of the blocks overlapping [start, end], in file order."""
+        return [
+            index for run in range(len(self.runs)) for index in self.run_range(run, start, end)
+        ]
+
+    def samples(self, start=None, end=None):
+        for run in range(len(self.runs)):
+            for index in self.run_range(run, start, end):
+                for sample in self.block(index).samples():
+                    if start is not None and sample[0] < start:
+                        continue
+                    if end is not None and sample[0] > end:
+                        break
+                    yield sample
+
+
+class Writer:
+    """Packs like co2_block_append(): a block is closed once a worst case sample may not fit."""
+
+    def __init__(self, created=0):
+        self.out = bytearray(FILE_HEADER.pack(MAGIC, VERSION, BLOCK_SIZE, created))
+        self.payload = None
+        self.last = None
+
+    def append(self, sample):
+        clock_back = self.last is not None and sample[0] < self.last[0]
+        if self.payload is not None and (
+            clock_back or len(self.payload) + MAX_SAMPLE_SIZE > PAYLOAD_SIZE
+        ):
+            self.close_block()
+        if self.payload is None:
+            self.flags = FLAG_CLOCK_BACK if clock_back else 0
+            self.payload = bytearray()
+            self.start = sample[0]
+            self.first = sample[1:]
+            self.min = list(sample[1:])
+            self.max = list(sample[1:])
+            self.count = 0
+        else:
+            put_varint(self.payload, zigzag(sample[0] - self.last[0]))
+            for i in range(CHANNELS):
+                put_varint(self.payload, zigzag(sample[1 + i] - self.last[1 + i]))
+                self.min[i] = min(self.min[i], sample[1 + i])
+                self.max[i] = max(self.max[i], sample[1 + i])
+        self.count += 1
+        self.last = sample
+
+    def close_block(self):
+        if self.payload is None:
+            return
+        header = BLOCK_HEADER.pack(
+            self.start,
+            self.last[0],
+            self.count,
+            len(self.payload),
+            *self.min,
+            *self.max,
+            *self.first,
+            self.flags,
+        )
+        self.out += header + self.payload + bytes(PAYLOAD_SIZE - len(self.payload))
+        self.payload = None
+
+    def finish(self):
+        self.close_block()
+        return bytes(self.out)
+
+
+def read_file(path):
+    with open(path, "rb") as file:
+        return file.read()
+
+
+def decode(args):
+    log = Log(read_file(args.log))
+    print(CSV_HEADER)
+    for sample in log.samples(args.start, args.end):
+        print(to_csv(sample))
+
+
+def info(args):
+    log = Log(read_file(args.log))
+    print(f"created {log.created}, {log.blocks} blocks")
+    samples = 0
+    for index in range(log.blocks):
+        block = log.block(index)
+        samples += block.count
+        print(
+            f"{index}: {block.start}-{block.end} {block.count} samples, {block.size} bytes, "
+            f"CO2 {block.min[0]}-{block.max[0]} ppm"
+            f"{', clock set back' if block.flags & FLAG_CLOCK_BACK else ''}"
+        )
+    if samples:
+        print(f"{samples} samples, {len(log.data) / samples:.2f} bytes/sample")
+
+
+def encode(args):
+    writer = None
+    with open(args.csv) as file:
+        for line in file:
+            line = line.strip()
+            if not line or line.startswith("timestamp"):
+                continue
+            sample = from_csv(line)
+            if writer is None:
+                writer = Writer(sample[0])
+            writer.append(sample)
+    if writer is None:
+        sys.exit("no samples")
+    with open(args.log, "wb") as file:
+        file.write(writer.finish())
+
+
+def synthetic(days):
+    """5 s samples of a room: a slow daily CO2 cycle, sensor noise, some gaps, the RTC set back
+    by an hour once a day."""
+    rng = random.Random(1)
+    timestamp = 1700000000
+    co2, t, rh = 600.0, 22.0, 45.0
+    for i in range(days * 24 * 720):
+        timestamp += 5 if rng.random() > 0.001 else rng.randint(60, 3600)
+        if i % (24 * 720) == 12 * 720:
+            timestamp -= 3600
+        co2 = min(max(co2 + rng.gauss(0, 3) + (0.4 if (i // 720) % 24 < 10 else -0.3), 400), 3000)
+        t += rng.gauss(0, 0.01)
+        rh = min(max(rh + rng.gauss(0, 0.05), 10), 90)
+        yield (
+            timestamp,
+            round(co2),
+            round((t + 45) * 65536 / 175) & 0xFFFF,
+            round(rh * 65536 / 100) & 0xFFFF,
+        )
+
+
+def bench(args):
+    samples = list(synthetic(args.days))
+    writer = Writer(samples[0][0])
+    for sample in samples:
+        writer.append(sample)
+    log = Log(writer.finish())
+    csv_size = len(CSV_HEADER) + 1 + sum(len(to_csv(sample)) + 1 for sample in samples)
+
+    start = time.perf_counter()
+    decoded = list(log.samples())
+    elapsed = time.perf_counter() - start
+    if decoded != samples:
+        sys.exit("round trip mismatch")
+
+    hour = samples[len(samples) // 2][0]
+    blocks = len(log.range(hour, hour + 3600))
+    expected = [sample for sample in samples if hour <= sample[0] <= hour + 3600]
+    if list(log.samples(hour, hour + 3600)) != expected:
+        sys.exit("range query mismatch")
+    print(
+        f"{len(samples)} samples ({args.days} days at 5 s), {log.blocks} blocks "
+        f"in {len(log.runs)} runs"
+    )
+    print(
+        f"binary {len(log.data)} bytes ({len(log.data) / len(samples):.2f} bytes/sample), "
+        f"CSV {csv_size} bytes: {csv_size / len(log.data):.1f}x smaller"
+    )
+    print(f"decode {len(samples) / elapsed:.0f} samples/s")
+    print(f"one hour range query decodes {blocks} of {log.blocks} blocks")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    decode_parser = commands.add_parser("decode", help="print a log as CSV")
+    decode_parser.add_argument("log")
+    decode_parser.add_argument("--from", dest="start", type=int, help="first RTC timestamp")
+    decode_parser.add_argument("--to", dest="end", type=int, help="last RTC timestamp")
+    info_parser = commands.add_parser("info", help="list the blocks of a log")
+    info_parser.add_argument("log")
+    encode_parser = commands.add_parser("encode", help="build a log from CSV")
+    encode_parser.add_argument("csv")
+    encode_parser.add_argument("log")
+    bench_parser = commands.add_parser("bench", help="size and decode speed on synthetic data")
+    bench_parser.add_argument("--days", type=int, default=30)
+    args = parser.parse_args()
+
+    if args.command == "decode":
+        decode(args)
+    elif args.command == "info":
+        info(args)
+    elif args.command == "encode":
+        encode(args)
+    else:
+        bench(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""Read the live sample stream of the app over the Flipper CLI (USB serial).
+
+  co2_stream.py read /dev/ttyACM0 [--interval S]
+      Starts "co2 stream bin" on the Flipper and prints one CSV line per sample on stdout, with
+      decoded values. Sequence gaps (samples the device dropped because the host was too slow)
+      and bad frames are reported on stderr. Ctrl+C stops the stream on the device too.
+  co2_stream.py bench [--samples N]
+      Throughput benchmark of the parser: a pseudo-terminal stands in for the Flipper and writes
+      N frames (with some line noise mixed in) as fast as it can; reports samples/second.
+
+See co2_stream.h for the frame format. POSIX only (termios, pty).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+SYNC = b"\xa5\x5a"
+RECORD = struct.Struct("<IIHHHB")
+FRAME_SIZE = len(SYNC) + RECORD.size + 1
+
+
+def _crc_table():
+    table = []
+    for value in range(256):
+        crc = value
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x31) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+        table.append(crc)
+    return table
+
+
+CRC_TABLE = _crc_table()
+
+
+def crc8(data):
+    """SCD4x CRC-8: polynomial 0x31, init 0xFF."""
+    crc = 0xFF
+    for byte in data:
+        crc = CRC_TABLE[crc ^ byte]
+    return crc
+
+
+class FrameParser:
+    """Incremental frame parser. Resynchronizes on the sync bytes after garbage or bad CRCs."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.bad_frames = 0
+        self.skipped_bytes = 0
+        self.gaps = 0
+        self.missing = 0
+        self.next_sequence = None
+
+    def feed(self, data):
+        self.buffer += data
+        samples = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # Keep a trailing half sync byte
+                keep = 1 if self.buffer[-1:] == SYNC[:1] else 0
+                self.skipped_bytes += len(self.buffer) - keep
+                del self.buffer[: len(self.buffer) - keep]
+                return samples
+            if start > 0:
+                self.skipped_bytes += start
+                del self.buffer[:start]
+            if len(self.buffer) < FRAME_SIZE:
+                return samples
+
+            payload = bytes(self.buffer[len(SYNC) : FRAME_SIZE - 1])
+            if crc8(payload) != self.buffer[FRAME_SIZE - 1]:
+                # Not a frame after all, look for the next sync
+                self.bad_frames += 1
+                self.skipped_bytes += 1
+                del self.buffer[:1]
+                continue
+            del self.buffer[:FRAME_SIZE]
+
+            sample = RECORD.unpack(payload)
+            sequence = sample[0]
+            if self.next_sequence is not None and sequence != self.next_sequence:
+                self.gaps += 1
+                self.missing += (sequence - self.next_sequence) & 0xFFFFFFFF
+            self.next_sequence = (sequence + 1) & 0xFFFFFFFF
+            samples.append(sample)
+
+
+def decode(sample):
+    sequence, ms, co2, t, rh, flags = sample
+    return sequence, ms, co2, -45 + 175 * t / 65536, 100 * rh / 65536, flags
+
+
+def open_serial(path):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    attrs[6][termios.VMIN] = 0
+    attrs[6][termios.VTIME] = 1  # 100 ms read timeout
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def read(args):
+    fd = open_serial(args.port)
+    os.write(fd, f"co2 stream bin {args.interval}\r".encode())
+    parser = FrameParser()
+    print("seq,ms,co2,temperature,humidity")
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                continue
+            gaps = parser.gaps
+            for sample in parser.feed(data):
+                sequence, ms, co2, t, rh, _ = decode(sample)
+                print(f"{sequence},{ms},{co2},{t:.2f},{rh:.2f}", flush=True)
+            if parser.gaps != gaps:
+                print(f"# {parser.missing} samples dropped by the device so far", file=sys.stderr)
+    except KeyboardInterrupt:
+        os.write(fd, b"\x03")  # Ctrl+C ends the command on the Flipper
+    finally:
+        os.close(fd)
+        print(
+            f"# {parser.bad_frames} bad frames, {parser.skipped_bytes} bytes skipped, "
+            f"{parser.missing} samples dropped",
+            file=sys.stderr,
+        )
+
+
+def make_frame(sequence):
+    payload = RECORD.pack(sequence, sequence * 5000, 400 + sequence % 1000, 26000, 30000, 1)
+    return SYNC + payload + bytes([crc8(payload)])
+
+
+def bench(args):
+    master, slave = os.openpty()
+    tty.setraw(slave)
+
+    def flipper():
+        # The command echo comes first, and every 50th frame is followed by CLI-like text. USB does
+        # not corrupt bytes, the resync is only there to skip such text
+        chunk = bytearray(b"co2 stream bin 0\r\n")
+        for sequence in range(args.samples):
+            chunk += make_frame(sequence)
+            if sequence % 50 == 0:
+                chunk += b"\r\n>: \xa5"
+            if len(chunk) >= 4096:
+                os.write(master, chunk)
+                chunk.clear()
+        os.write(master, chunk)
+
+    parser = FrameParser()
+    received = 0
+    writer = threading.Thread(target=flipper, daemon=True)
+    start = time.perf_counter()
+    writer.start()
+    while received < args.samples:
+        received += len(parser.feed(os.read(slave, 65536)))
+    elapsed = time.perf_counter() - start
+    writer.join()
+    os.close(master)
+    os.close(slave)
+
+    print(f"{received} samples in {elapsed:.2f} s: {received / elapsed:.0f} samples/s")
+    print(
+        f"{parser.bad_frames} bad frames, {parser.skipped_bytes} bytes skipped, "
+        f"{parser.gaps} gaps"
+    )
+    if parser.gaps or received != args.samples:
+        sys.exit("stream corrupted")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    read_parser = commands.add_parser("read", help="stream samples from a Flipper")
+    read_parser.add_argument("port", help="Flipper CLI serial port, e.g. /dev/ttyACM0")
+    read_parser.add_argument(
+        "--interval", type=int, default=0, help="seconds between samples, 0 for all"
+    )
+    bench_parser = commands.add_parser("bench", help="parser throughput over a pseudo-terminal")
+    bench_parser.add_argument("--samples", type=int, default=100000)
+    args = parser.parse_args()
+
+    if args.command == "read":
+        read(args)
+    else:
+        bench(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Dump an SCD4x bus capture recorded by the app (apps_data/co2_sensor/capture.bin).
+
+Prints one line per transfer with its timestamp, the command name, the CRC check of every word and,
+for read_measurement responses, the decoded CO2/T/RH values. See scd4x_capture.h for the format.
+"""
+
+import argparse
+import struct
+import sys
+
+HEADER = struct.Struct("<4sB3xI")
+RECORD = struct.Struct("<BBH")
+FLAG_RX = 1 << 0
+FLAG_OK = 1 << 1
+
+COMMANDS = {
+    0x21B1: "start_periodic_measurement",
+    0xEC05: "read_measurement",
+    0x3F86: "stop_periodic_measurement",
+    0x241D: "set_temperature_offset",
+    0x2318: "get_temperature_offset",
+    0x2427: "set_sensor_altitude",
+    0x2322: "get_sensor_altitude",
+    0xE000: "set_ambient_pressure",
+    0x362F: "perform_forced_recalibration",
+    0x2416: "set_automatic_self_calibration_enabled",
+    0x2313: "get_automatic_self_calibration_enabled",
+    0x21AC: "start_low_power_periodic_measurement",
+    0xE4B8: "get_data_ready_status",
+    0x3615: "persist_settings",
+    0x3682: "get_serial_number",
+    0x3639: "perform_self_test",
+    0x3632: "perform_factory_reset",
+    0x3646: "reinit",
+    0x219D: "measure_single_shot",
+    0x2196: "measure_single_shot_rht_only",
+}
+
+
+def crc8(data):
+    crc = 0xFF
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x31) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def words(data):
+    """Split a response into (word, crc_ok) pairs."""
+    return [
+        ((data[i] << 8) | data[i + 1], crc8(data[i : i + 2]) == data[i + 2])
+        for i in range(0, len(data) - 2, 3)
+    ]
+
+
+def read_records(f):
+    while True:
+        raw = f.read(RECORD.size)
+        if len(raw) < RECORD.size:
+            return
+        flags, size, delta = RECORD.unpack(raw)
+        data = f.read(size)
+        if len(data) < size:
+            return
+        yield flags, delta, data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", type=argparse.FileType("rb"))
+    args = parser.parse_args()
+
+    magic, version, timestamp = HEADER.unpack(args.capture.read(HEADER.size))
+    if magic != b"S4XC" or version != 1:
+        sys.exit("not an SCD4x capture (version 1)")
+    print(f"# capture started at RTC timestamp {timestamp}")
+
+    elapsed = 0
+    command = None
+    for flags, delta, data in read_records(args.capture):
+        elapsed += delta
+        status = "ok" if flags & FLAG_OK else "NACK"
+        if not flags & FLAG_RX:
+            command = (data[0] << 8) | data[1] if len(data) >= 2 else None
+            name = COMMANDS.get(command, f"0x{command:04x}" if command is not None else "?")
+            arg = ""
+            if len(data) == 5:
+                arg = f" arg=0x{(data[2] << 8) | data[3]:04x}"
+                arg += "" if crc8(data[2:4]) == data[4] else " (bad crc)"
+            print(f"{elapsed / 1000:10.3f} tx {status:4} {name}{arg}")
+            continue
+
+        decoded = words(data)
+        text = " ".join(f"0x{w:04x}" + ("" if ok else "!") for w, ok in decoded)
+        if command == 0xEC05 and len(decoded) == 3 and flags & FLAG_OK:
+            co2, t, rh = (w for w, _ in decoded)
+            text += f"  co2={co2} ppm t={-45 + 175 * t / 65536:.2f} C rh={100 * rh / 65536:.2f} %"
+        print(f"{elapsed / 1000:10.3f} rx {status:4} {text}")
+
+
+if __name__ == "__main__":
+    main()